@@ -1,7 +1,15 @@
 #include "pch.h"
+#include <algorithm>
+#include <iostream>
+#include <cerrno>
+#include <cwctype>
+#include <limits>
+#include <string>
 #include <vector>
 #include "Camera/Camera.h"
+#include "Common/MeshCache.h"
 #include "Common/ObjReader.h"
+#include "Common/RasterConfig.h"
 #include "Managers/TimeSettings.h"
 #include "Mesh/TriangleMesh.h"
 #include "Material/Material.h"
@@ -24,18 +32,56 @@
 //#define BUNNY_OBJ
 //#define FAIRYFOREST_OBJ
 
+//#define OBJ_LOADING_BENCHMARK
+
+// Reorders the mesh for vertex reuse, overdraw and fetch locality when the cache is built
+#define OPTIMIZE_MESH
+// Appends simplified levels of detail to the cache, one is picked per frame from the projected mesh size
+#define GENERATE_MESH_LODS
+// The compute pipeline fetches 8 byte quantized vertices instead of the 32 byte MeshVertex
+//#define QUANTIZE_VERTICES
+// The compute pipeline snaps positions to 1/256 pixel and rasterizes with integer edge functions and the top-left rule, without cracks or double shaded edges
+//#define FIXED_POINT_RASTER
+// The fine stage only writes depth and triangle ids, a full screen pass shades every visible pixel once whatever the overdraw
+//#define VISIBILITY_BUFFER
+// The fine stage trivially rejects and accepts the 2x2 pixel quads of a partially covered tile before testing the pixels of the others
+//#define QUAD_COVERAGE
+// Geometry setup culls back faces, and cluster culling back facing meshlets, unless one of these draws both faces or only the back ones
+//#define CULL_NONE
+//#define CULL_FRONT
+
+// Frames between two logs of the compute pipeline counters
+constexpr unsigned int PIPELINE_STATS_LOG_INTERVAL{ 600 };
+
+constexpr uint32_t MESH_LOAD_FLAGS{ 0u
+#if defined(OPTIMIZE_MESH)
+	| MeshCache::FLAG_OPTIMIZED
+#endif
+#if defined(GENERATE_MESH_LODS)
+	| MeshCache::FLAG_LODS
+#endif
+};
+
 void mainDXRaster(const Window& window, Camera& camera, std::wstring meshPath);
-void mainCompuRaster(const Window& window, Camera& camera, std::wstring meshPath);
+void mainCompuRaster(const Window& window, Camera& camera, std::wstring meshPath, const RasterConfig& rasterConfig);
+void benchmarkObjLoading();
+bool parseRasterConfig(int argc, wchar_t* argv[], RasterConfig& rasterConfig);
+void logPipelineStats(const CompuRaster::Pipeline& pipeline, ECullMode cullMode, CompuRaster::ECoverageMode coverageMode);
 
 LRESULT WndProc_Implementation(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
 int wmain(int argc, wchar_t* argv[])
 {
-	UNREFERENCED_PARAMETER(argc);
-	UNREFERENCED_PARAMETER(argv);
-
+	// The window and every buffer of the compute pipeline follow the config, e.g. -w 2560 -h 1440 -tile 16
+	RasterConfig rasterConfig{};
+	if (!parseRasterConfig(argc, argv, rasterConfig))
+		return 1;
+
+#if defined(OBJ_LOADING_BENCHMARK)
+	benchmarkObjLoading();
+#else
 	wchar_t windowName[]{ TEXT("GPU Rasterizer - Dixcit") };
-	Window wnd{ windowName, 1280u, 720u };
+	Window wnd{ windowName, static_cast<uint16_t>(rasterConfig.viewportWidth), static_cast<uint16_t>(rasterConfig.viewportHeight) };
 	wnd.Init(&WndProc_Implementation);
 
 #if defined(VEHICLE_OBJ)
@@ -53,8 +99,58 @@ int wmain(int argc, wchar_t* argv[])
 #if defined(HARDWARE_RENDER)
 	mainDXRaster(wnd, camera, meshPath);
 #elif defined(CUSTOM_RENDER)
-	mainCompuRaster(wnd, camera, meshPath);
+	mainCompuRaster(wnd, camera, meshPath, rasterConfig);
 #endif
+#endif
+	return 0;
+}
+
+bool parseRasterConfig(int argc, wchar_t* argv[], RasterConfig& rasterConfig)
+{
+	for (int argIdx{ 1 }; argIdx < argc; argIdx += 2)
+	{
+		const std::wstring option{ argv[argIdx] };
+		if (argIdx + 1 == argc)
+		{
+			std::wcout << L"Error: option " << option << L" is missing its value" << std::endl;
+			return false;
+		}
+
+		// Digits only up to the end, wcstoul would skip leading spaces, wrap a minus sign and stop at the first other character
+		const wchar_t* pvalue{ argv[argIdx + 1] };
+		wchar_t* pvalueEnd{};
+		errno = 0;
+		const uint32_t value{ static_cast<uint32_t>(std::wcstoul(pvalue, &pvalueEnd, 10)) };
+		if (!std::iswdigit(pvalue[0]) || *pvalueEnd != L'\0' || errno == ERANGE)
+		{
+			std::wcout << L"Error: invalid value " << pvalue << L" for option " << option << L", expected an unsigned integer" << std::endl;
+			return false;
+		}
+
+		if (option == L"-w")
+			rasterConfig.viewportWidth = value;
+		else if (option == L"-h")
+			rasterConfig.viewportHeight = value;
+		else if (option == L"-tile")
+			rasterConfig.tileSize = value;
+		else if (option == L"-bin")
+			rasterConfig.binSize = value;
+		else if (option == L"-queues")
+			rasterConfig.queueCount = value;
+		else
+		{
+			std::wcout << L"Error: unknown option " << option << L", expected -w, -h, -tile, -bin or -queues followed by a value" << std::endl;
+			return false;
+		}
+	}
+
+	if (const wchar_t* error{ rasterConfig.GetError() })
+	{
+		std::wcout << L"Error: " << error << std::endl;
+		return false;
+	}
+
+	return true;
 }
 
 void mainDXRaster(const Window& window, Camera& camera, std::wstring meshPath)
@@ -64,10 +160,7 @@ void mainDXRaster(const Window& window, Camera& camera, std::wstring meshPath)
 	HardwareRenderer hwRenderer{};
 	hwRenderer.Initialize(window);
 
-	std::vector<DirectX::XMFLOAT3> positions{};
-	std::vector<DirectX::XMFLOAT3> normals{};
-	std::vector<DirectX::XMFLOAT2> uvs{};
-	std::vector<uint32_t> indices;
+	MeshData meshData{};
 
 	//std::vector positions{
 	//DirectX::XMFLOAT3{0.f, 5.f, 0.f}
@@ -77,9 +170,9 @@ void mainDXRaster(const Window& window, Camera& camera, std::wstring meshPath)
 
 	//std::vector<uint32_t> indices{ 0, 1, 2 };
 
-	ObjReader::LoadModel(meshPath, positions, normals, uvs, indices);
+	MeshCache::LoadModel(meshPath, meshData, MESH_LOAD_FLAGS);
 
-	TriangleMesh mesh{ std::move(positions), std::move(normals), std::move(uvs), std::move(indices) };
+	TriangleMesh mesh{ std::move(meshData), true };
 	Material mat{ hwRenderer.GetDevice(), L"./Resources/HardwareShader/VS_PosNormUV.hlsl", nullptr, nullptr, nullptr, L"Resources/HardwareShader/PS_LambertDiffuse.hlsl" };
 	mesh.SetMaterial(hwRenderer.GetDevice(), &mat);
 
@@ -98,6 +191,7 @@ void mainDXRaster(const Window& window, Camera& camera, std::wstring meshPath)
 		timeSettings.Update();
 
 		camera.Update(timeSettings.GetElapsed());
+		mesh.SelectLod(&camera, static_cast<float>(window.GetHeight()));
 		hwRenderer.ClearBuffers();
 		hwRenderer.DrawIndexed(&camera, &mesh);
 		hwRenderer.Present();
@@ -106,17 +200,14 @@ void mainDXRaster(const Window& window, Camera& camera, std::wstring meshPath)
 	}
 }
 
-void mainCompuRaster(const Window& window, Camera& camera, std::wstring meshPath)
+void mainCompuRaster(const Window& window, Camera& camera, std::wstring meshPath, const RasterConfig& rasterConfig)
 {
 	TimeSettings& timeSettings = TimeSettings::GetInstance();
 
 	CompuRaster::CompuRenderer dcRenderer{};
-	dcRenderer.Initialize(window);
+	dcRenderer.Initialize(window, rasterConfig);
 
-	std::vector<DirectX::XMFLOAT3> positions{};
-	std::vector<DirectX::XMFLOAT3> normals{};
-	std::vector<DirectX::XMFLOAT2> uvs{};
-	std::vector<uint32_t> indices;
+	MeshData meshData{};
 
 	//std::vector positions{
 	//	DirectX::XMFLOAT3{0.f, 10.f, 0.f}
@@ -139,26 +230,59 @@ void mainCompuRaster(const Window& window, Camera& camera, std::wstring meshPath
 
 	//std::vector<uint32_t> indices{ 0, 1, 2, 0, 3, 1, 4, 0, 2, 4, 3, 0, 2, 5, 1 };
 
-	ObjReader::LoadModel(meshPath, positions, normals, uvs, indices);
+	MeshCache::LoadModel(meshPath, meshData, MESH_LOAD_FLAGS);
 #if defined(CUSTOM_RENDER_NAIVE)
-	CompuRaster::Mesh mesh{ std::move(positions), std::move(normals), std::move(uvs), std::move(indices) };
+	CompuRaster::Mesh mesh{ std::move(meshData), true };
 	CompuRaster::NaiveMaterial mat{ dcRenderer.GetDevice(), L"./Resources/SoftwareShader/TestPipeline.hlsl" };
 	mesh.SetMaterial(dcRenderer.GetDevice(), &mat);
 
 #elif defined(CUSTOM_RENDER_PIPELINE_BINNING)
-	CompuRaster::CompuMesh mesh{ std::move(positions), std::move(normals), std::move(uvs), std::move(indices) };
-	CompuRaster::Material mat{};
-	mat.Init(dcRenderer.GetDevice(), L"./Resources/SoftwareShader/Pipeline/VertexShader.hlsl", L"");
-	mesh.SetMaterial(dcRenderer.GetDevice(), &mat);
+#if defined(QUANTIZE_VERTICES)
+	constexpr CompuRaster::EVertexFormat vertexFormat{ CompuRaster::EVertexFormat::Quantized };
+#else
+	constexpr CompuRaster::EVertexFormat vertexFormat{ CompuRaster::EVertexFormat::Float };
+#endif
+	CompuRaster::CompuMesh mesh{ std::move(meshData), true, vertexFormat };
 
+#if defined(FIXED_POINT_RASTER)
+	constexpr ERasterMode rasterMode{ ERasterMode::FixedPoint };
+#else
+	constexpr ERasterMode rasterMode{ ERasterMode::Float };
+#endif
+#if defined(VISIBILITY_BUFFER)
+	constexpr EShadingMode shadingMode{ EShadingMode::VisibilityBuffer };
+#else
+	constexpr EShadingMode shadingMode{ EShadingMode::Forward };
+#endif
+#if defined(QUAD_COVERAGE)
+	constexpr CompuRaster::ECoverageMode coverageMode{ CompuRaster::ECoverageMode::Quad };
+#else
+	constexpr CompuRaster::ECoverageMode coverageMode{ CompuRaster::ECoverageMode::Pixel };
+#endif
+#if defined(CULL_NONE)
+	constexpr ECullMode cullMode{ ECullMode::None };
+#elif defined(CULL_FRONT)
+	constexpr ECullMode cullMode{ ECullMode::Front };
+#else
+	constexpr ECullMode cullMode{ ECullMode::Back };
+#endif
 	CompuRaster::Pipeline pipeline{};
 	//pipeline.Init(dcRenderer.GetDevice(), mesh.GetVertexCount(), static_cast<UINT>(std::size(indices) / 3), L"./Resources/SoftwareShader/Pipeline/GeometrySetup.hlsl", L"./Resources/SoftwareShader/Pipeline/Rasterizer.hlsl", L"./Resources/SoftwareShader/Pipeline/Rasterizer2.hlsl");
 	//pipeline.Init(dcRenderer.GetDevice(), mesh.GetVertexCount(), static_cast<UINT>(std::size(indices) / 3), L"./Resources/SoftwareShader/Pipeline/GeometrySetup.hlsl", L"./Resources/SoftwareShader/Pipeline/Rasterizer.hlsl", L"./Resources/SoftwareShader/Pipeline/FineRasterizer2.hlsl");
-	pipeline.Init(dcRenderer.GetDevice(), mesh.GetVertexCount(), static_cast<UINT>(std::size(indices) / 3), L"./Resources/SoftwareShader/Pipeline/GeometrySetup.hlsl", L"./Resources/SoftwareShader/Pipeline/BinRasterizer.hlsl", L"./Resources/SoftwareShader/Pipeline/TileRasterizer.hlsl", L"./Resources/SoftwareShader/Pipeline/FineRasterizer3.hlsl");
+	pipeline.Init(dcRenderer.GetDevice(), mesh.GetVertexCount(), mesh.GetMaxVisibleTriangleCount(), mesh.GetIndexFormat(), rasterConfig, rasterMode, shadingMode, cullMode, coverageMode, L"./Resources/SoftwareShader/Pipeline/ClusterCulling.hlsl", L"./Resources/SoftwareShader/Pipeline/GeometrySetup.hlsl", L"./Resources/SoftwareShader/Pipeline/BinRasterizer.hlsl", L"./Resources/SoftwareShader/Pipeline/BinScan.hlsl", L"./Resources/SoftwareShader/Pipeline/TileRasterizer.hlsl", L"./Resources/SoftwareShader/Pipeline/FineRasterizer3.hlsl", L"./Resources/SoftwareShader/Pipeline/VisibilityShading.hlsl");
+
+	// Projects to the viewport of the pipeline config
+	const std::vector<D3D_SHADER_MACRO> vertexDefines{ pipeline.GetShaderDefines(CompuRaster::CompuMesh::GetVertexShaderDefines(vertexFormat)) };
+	CompuRaster::Material mat{};
+	mat.Init(dcRenderer.GetDevice(), L"./Resources/SoftwareShader/Pipeline/VertexShader.hlsl", L"", std::data(vertexDefines));
+	mesh.SetMaterial(dcRenderer.GetDevice(), &mat);
 #endif
 
 	MSG msg;
 	ZeroMemory(&msg, sizeof(MSG));
+#if defined(CUSTOM_RENDER_PIPELINE_BINNING)
+	unsigned int frameIdx{};
+#endif
 
 	while (msg.message != WM_QUIT)
 	{
@@ -173,11 +297,18 @@ void mainCompuRaster(const Window& window, Camera& camera, std::wstring meshPath
 		timeSettings.Update();
 
 		camera.Update(timeSettings.GetElapsed());
+#if defined(CUSTOM_RENDER_PIPELINE_BINNING)
+		mesh.SelectLod(&camera, static_cast<float>(window.GetHeight()));
+#endif
 		dcRenderer.ClearBuffers();
 #if defined(CUSTOM_RENDER_NAIVE)
 		dcRenderer.Draw(&camera, &mesh);
 #elif defined(CUSTOM_RENDER_PIPELINE_BINNING)
 		dcRenderer.DrawPipeline(pipeline, &camera, &mesh);
+		pipeline.UpdateBinCapacity(dcRenderer.GetDevice(), dcRenderer.GetDeviceContext());
+		pipeline.UpdateStats(dcRenderer.GetDeviceContext());
+		if (++frameIdx % PIPELINE_STATS_LOG_INTERVAL == 0)
+			logPipelineStats(pipeline, cullMode, coverageMode);
 #endif
 		dcRenderer.Present();
 
@@ -185,6 +316,62 @@ void mainCompuRaster(const Window& window, Camera& camera, std::wstring meshPath
 	}
 }
 
+void logPipelineStats(const CompuRaster::Pipeline& pipeline, ECullMode cullMode, CompuRaster::ECoverageMode coverageMode)
+{
+	const CompuRaster::Pipeline::Stats& stats{ pipeline.GetStats() };
+	std::wcout << L"[Pipeline stats]\n";
+
+	const wchar_t* pculledFaces{ cullMode == ECullMode::Front ? L" front faces, " : L" back faces, " };
+	std::wcout << L"\tgeometry setup culled " << stats.culledTriangleCount << (cullMode == ECullMode::None ? L" triangles, " : pculledFaces)
+		<< stats.degenerateTriangleCount << L" degenerate triangles.\n";
+
+	const UINT droppedClipTriangleCount{ stats.clipTriangleCount - (std::min)(stats.clipTriangleCount, Clipping::MAX_CLIP_TRIANGLES) };
+	std::wcout << L"\tgeometry setup rejected " << stats.rejectedTriangleCount << L" triangles outside the view volume, clipped "
+		<< stats.clippedTriangleCount << L" into " << stats.clipTriangleCount << L" triangles, " << droppedClipTriangleCount << L" dropped past the clip capacity.\n";
+
+	std::wcout << L"\tgeometry setup routed " << stats.microTriangleCount << L" micro triangles past binning, " << stats.quadTriangleCount << L" of them inside a pixel quad, and binned "
+		<< stats.regularTriangleCount << L" triangles, " << stats.overflowTriangleCount << L" of them past a full micro list.\n";
+
+	const BinList::Sizes& binSizes{ pipeline.GetBinSizes() };
+	std::wcout << L"\tbinning stored " << binSizes.triangleCount << L" bin triangle pairs in " << binSizes.GetEncodedByteCount() << L" bytes of delta coded lists, "
+		<< binSizes.GetRawByteCount() << L" bytes as triangle indices.\n";
+
+	std::wcout << L"\tedge tests dropped " << stats.missedBinCount << L" of " << binSizes.triangleCount + stats.missedBinCount
+		<< L" bins of the triangle aabbs in binning and " << stats.missedTileCount << L" triangle tiles in tiling.\n";
+	if (coverageMode == CompuRaster::ECoverageMode::Quad)
+		std::wcout << L"\tthe fine stage accepted / rejected " << stats.acceptedQuadCount << L" / " << stats.rejectedQuadCount << L" 2x2 quads of the partially covered triangle tiles.\n";
+	std::wcout << L"\tHi-Z rejected " << stats.hiZRejectedTileCount << L" triangle tiles in tiling, " << stats.hiZRejectedTriangleCount << L" triangles in the fine stage.\n";
+}
+
+void benchmarkObjLoading()
+{
+	const std::wstring modelPaths[]{ L"./Resources/Models/vehicle.obj", L"./Resources/Models/cent.obj", L"./Resources/Models/Holocron.obj", L"./Resources/Models/icosahedron.obj" };
+	const int runCount{ 10 };
+
+	for (const std::wstring& modelPath : modelPaths)
+	{
+		ObjReader::LoadStats bestStats{};
+		double bestMs{ (std::numeric_limits<double>::max)() };
+
+		for (int run{}; run < runCount; ++run)
+		{
+			MeshData meshData{};
+			ObjReader::LoadStats stats{};
+			if (!ObjReader::LoadModel(modelPath, meshData, &stats))
+				break;
+
+			if (stats.parseMs + stats.weldMs < bestMs)
+			{
+				bestMs = stats.parseMs + stats.weldMs;
+				bestStats = stats;
+			}
+		}
+
+		std::wcout << L"[OBJ benchmark] " << modelPath << L": " << bestStats.fileSize / 1024 << L" KB, parse " << bestStats.parseMs << L" ms, weld " << bestStats.weldMs
+			<< L" ms, best of " << runCount << L": " << bestStats.GetThroughputMBs() << L" MB/s\n";
+	}
+}
+
 LRESULT WndProc_Implementation(HWND, UINT msg, WPARAM wParam, LPARAM)
 {
 	switch (msg)
@@ -0,0 +1,77 @@
+#ifndef DEF_BIN_LIST_HLSLI
+#define DEF_BIN_LIST_HLSLI
+
+#include "RasterConfig.hlsli"
+
+// Triangle lists of the bins, delta and varint coded by BinRasterizer and decoded by TileRasterizer (BinList on the CPU)
+// A queue of a bin is cut in blocks of BIN_BLOCK_SIZE triangles, the header of a block is enough to decode it so a thread takes a block
+#define BIN_BLOCK_BITS 4
+#define BIN_BLOCK_SIZE (1u << BIN_BLOCK_BITS)
+// First triangle, byte offset of the deltas to the others in G_BIN_BUFFER, tile buffer index << BIN_BLOCK_BITS | triangle count - 1
+#define BIN_HEADER_SIZE 12
+
+// G_BIN_OFFSET holds 3 arrays, per bin then per queue with their total past them: the triangles, the blocks and the 32 bit words of deltas
+#define BIN_OFFSET_COUNT (BIN_COUNT * QUEUE_COUNT + 1)
+#define BIN_TRIANGLE_OFFSET 0
+#define BIN_BLOCK_OFFSET (BIN_OFFSET_COUNT * 4)
+#define BIN_WORD_OFFSET (2 * BIN_OFFSET_COUNT * 4)
+
+// Bytes of value, 7 bits per byte
+inline uint GetVarintSize(uint value)
+{
+	return value < (1u << 7) ? 1 : value < (1u << 14) ? 2 : value < (1u << 21) ? 3 : value < (1u << 28) ? 4 : 5;
+}
+
+inline uint GetBlockEntry(uint entry)
+{
+	return entry >> BIN_BLOCK_BITS;
+}
+
+inline uint GetBlockTriangleCount(uint entry)
+{
+	return (entry & (BIN_BLOCK_SIZE - 1)) + 1;
+}
+
+// Writes value from its low bits at byte cursor, the high bit of a byte flags another one
+// The bytes are gathered in pendingWord and stored once it is full, the words past byteCapacity are dropped
+void AppendVarint(RWByteAddressBuffer stream, uint byteCapacity, inout uint cursor, inout uint pendingWord, uint value)
+{
+	for (uint sizeLeft = GetVarintSize(value); sizeLeft != 0; --sizeLeft)
+	{
+		const uint streamByte = (value & 0x7f) | (sizeLeft > 1 ? 0x80 : 0);
+		value >>= 7;
+		pendingWord |= streamByte << ((cursor & 3) * 8);
+		++cursor;
+		if ((cursor & 3) == 0)
+		{
+			if (cursor <= byteCapacity)
+				stream.Store(cursor - 4, pendingWord);
+			pendingWord = 0;
+		}
+	}
+}
+
+// Stores the last partial word of a queue
+void FlushVarints(RWByteAddressBuffer stream, uint byteCapacity, uint cursor, uint pendingWord)
+{
+	if ((cursor & 3) != 0 && (cursor & ~3u) + 4 <= byteCapacity)
+		stream.Store(cursor & ~3u, pendingWord);
+}
+
+// Reads the varint at byteOffset and moves byteOffset past it
+uint ReadVarint(ByteAddressBuffer stream, inout uint byteOffset)
+{
+	uint value = 0;
+	for (uint shift = 0; shift < 35; shift += 7)
+	{
+		const uint streamByte = (stream.Load(byteOffset & ~3u) >> ((byteOffset & 3) * 8)) & 0xff;
+		++byteOffset;
+		value |= (streamByte & 0x7f) << shift;
+		if (streamByte < 0x80)
+			break;
+	}
+
+	return value;
+}
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef DEF_CLIPPING_HLSLI
+#define DEF_CLIPPING_HLSLI
+
+// Outcodes of the vertex stage and guard band clipping of geometry setup, in clip space (Clipping on the CPU)
+// Triangles with the 3 vertices outside one viewport plane are rejected, the ones crossing the near or far plane or leaving the guard band
+// are clipped and fanned into the MAX_CLIP_TRIANGLES raster slots past the mesh triangles, the others are rasterized as they are
+#define OUT_LEFT (1u << 0)
+#define OUT_RIGHT (1u << 1)
+#define OUT_BOTTOM (1u << 2)
+#define OUT_TOP (1u << 3)
+#define OUT_NEAR (1u << 4)
+#define OUT_FAR (1u << 5)
+#define OUT_GUARD_LEFT (1u << 6)
+#define OUT_GUARD_RIGHT (1u << 7)
+#define OUT_GUARD_BOTTOM (1u << 8)
+#define OUT_GUARD_TOP (1u << 9)
+#define PLANE_COUNT 10
+
+#define REJECT_OUTCODE (OUT_LEFT | OUT_RIGHT | OUT_BOTTOM | OUT_TOP | OUT_NEAR | OUT_FAR)
+#define CLIP_OUTCODE (OUT_NEAR | OUT_FAR | OUT_GUARD_LEFT | OUT_GUARD_RIGHT | OUT_GUARD_BOTTOM | OUT_GUARD_TOP)
+#define MAX_POLYGON_VERTICES (3 + 6)
+
+// Small enough for the FixedPointEdges functions of a triangle inside the band to stay below EDGE_CLAMP at 720p,
+// CompuRaster::Pipeline defines the one of its RasterConfig, shrunk for larger viewports in FIXED_POINT_RASTER
+#ifndef GUARD_BAND_PIXELS
+#define GUARD_BAND_PIXELS 512.f
+#endif
+#define NEAR_DEPTH (1.f / 65536.f)
+#define MAX_CLIP_TRIANGLES 4096
+
+struct ClipVertex
+{
+	float4 position;
+	float3 normal;
+};
+
+inline float GetPlaneDistance(uint planeIdx, float4 position, float viewportWidth, float viewportHeight)
+{
+	const float2 guard = 1.f + 2.f * GUARD_BAND_PIXELS / float2(viewportWidth, viewportHeight);
+
+	switch (planeIdx)
+	{
+	case 0: return position.w + position.x;
+	case 1: return position.w - position.x;
+	case 2: return position.w + position.y;
+	case 3: return position.w - position.y;
+	case 4: return position.z - NEAR_DEPTH * position.w;
+	case 5: return position.w - position.z;
+	case 6: return guard.x * position.w + position.x;
+	case 7: return guard.x * position.w - position.x;
+	case 8: return guard.y * position.w + position.y;
+	default: return guard.y * position.w - position.y;
+	}
+}
+
+inline uint GetOutcode(float4 position, float viewportWidth, float viewportHeight)
+{
+	uint outcode = 0;
+	[unroll]
+	for (uint planeIdx = 0; planeIdx < PLANE_COUNT; ++planeIdx)
+	{
+		// A NaN position is outside every plane
+		if (!(GetPlaneDistance(planeIdx, position, viewportWidth, viewportHeight) >= 0.f))
+			outcode |= 1u << planeIdx;
+	}
+	return outcode;
+}
+
+// Screen position of the raster stages, ProjectionToNDC then NDCToScreen of the vertex stage
+inline float4 ClipToScreen(float4 position, float viewportWidth, float viewportHeight)
+{
+	const float invW = 1.f / position.w;
+	return float4((position.x * invW + 1.f) * viewportWidth * 0.5f, (position.y * invW - 1.f) * -viewportHeight * 0.5f, position.z * invW, invW);
+}
+
+inline float4 ScreenToClip(float4 position, float viewportWidth, float viewportHeight)
+{
+	const float w = 1.f / position.w;
+	return float4((position.x * 2.f / viewportWidth - 1.f) * w, (1.f - position.y * 2.f / viewportHeight) * w, position.z * w, w);
+}
+
+// Sutherland-Hodgman clipping of the convex polygon in place, returns its vertex count, below 3 when nothing is left
+uint ClipPolygon(inout ClipVertex vertices[MAX_POLYGON_VERTICES], uint vCount, uint outcodeMask, float viewportWidth, float viewportHeight)
+{
+	ClipVertex clipped[MAX_POLYGON_VERTICES];
+	for (uint planeIdx = 0; planeIdx < PLANE_COUNT && vCount >= 3; ++planeIdx)
+	{
+		if ((outcodeMask & CLIP_OUTCODE & (1u << planeIdx)) == 0)
+			continue;
+
+		uint clippedCount = 0;
+		for (uint vIdx = 0; vIdx < vCount; ++vIdx)
+		{
+			const ClipVertex current = vertices[vIdx];
+			const ClipVertex next = vertices[(vIdx + 1) % vCount];
+			const float currentDistance = GetPlaneDistance(planeIdx, current.position, viewportWidth, viewportHeight);
+			const float nextDistance = GetPlaneDistance(planeIdx, next.position, viewportWidth, viewportHeight);
+
+			if (currentDistance >= 0.f)
+				clipped[clippedCount++] = current;
+
+			// Interpolated from the inside vertex of the edge, the triangle on its other side gets the same crossing point
+			if ((currentDistance >= 0.f) != (nextDistance >= 0.f))
+			{
+				const bool isCurrentInside = currentDistance >= 0.f;
+				const ClipVertex inside = isCurrentInside ? current : next;
+				const ClipVertex outside = isCurrentInside ? next : current;
+				const float insideDistance = isCurrentInside ? currentDistance : nextDistance;
+				const float t = insideDistance / (insideDistance - (isCurrentInside ? nextDistance : currentDistance));
+
+				clipped[clippedCount].position = lerp(inside.position, outside.position, t);
+				clipped[clippedCount].normal = lerp(inside.normal, outside.normal, t);
+				++clippedCount;
+			}
+		}
+
+		for (uint copyIdx = 0; copyIdx < clippedCount; ++copyIdx)
+			vertices[copyIdx] = clipped[copyIdx];
+		vCount = clippedCount;
+	}
+
+	return vCount;
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef DEF_FIXED_POINT_EDGES_HLSLI
+#define DEF_FIXED_POINT_EDGES_HLSLI
+
+// Integer edge functions of positions snapped to 1/256 pixel with the top-left fill rule, FIXED_POINT_RASTER (FixedPointEdges on the CPU)
+#define SUBPIXEL_BITS 8
+#define SUBPIXEL_SCALE (1 << SUBPIXEL_BITS)
+#define MAX_COORDINATE 4096.f
+#define EDGE_CLAMP (1 << 30)
+
+inline int2 SnapToSubpixel(float2 position)
+{
+	return int2(round(clamp(position, -MAX_COORDINATE, MAX_COORDINATE) * SUBPIXEL_SCALE));
+}
+
+inline bool IsTopLeft(int a, int b)
+{
+	return a > 0 || (a == 0 && b > 0);
+}
+
+// Folds the sub pixel part of start and the fill rule, a pixel is covered by the edge when EvaluateEdge > 0
+inline int GetEdgeThreshold(int a, int b, int2 start)
+{
+	const int subpixel = a * (start.x & (SUBPIXEL_SCALE - 1)) + b * (start.y & (SUBPIXEL_SCALE - 1));
+	return IsTopLeft(a, b) ? -(-subpixel >> SUBPIXEL_BITS) - 1 : subpixel >> SUBPIXEL_BITS;
+}
+
+// Unclamped float value of EvaluateEdge, the weights of the pixels whose edge value was clamped are computed from it
+inline float EstimateEdge(int a, int b, int2 start, int threshold, int2 pixel)
+{
+	const int2 d = pixel - (start >> SUBPIXEL_BITS);
+	return float(a) * float(d.x) + float(b) * float(d.y) - float(threshold);
+}
+
+// Exact below EDGE_CLAMP, clamped above it so stepping over a tile keeps the sign without overflowing
+// A clamped value is only good for the coverage test, not for the weights
+inline int EvaluateEdge(int a, int b, int2 start, int threshold, int2 pixel)
+{
+	const int2 d = pixel - (start >> SUBPIXEL_BITS);
+	const float estimate = EstimateEdge(a, b, start, threshold, pixel);
+	if (abs(estimate) >= float(EDGE_CLAMP))
+		return estimate > 0.f ? EDGE_CLAMP : -EDGE_CLAMP;
+
+	return asint(asuint(a) * asuint(d.x) + asuint(b) * asuint(d.y) - asuint(threshold));
+}
+
+#endif
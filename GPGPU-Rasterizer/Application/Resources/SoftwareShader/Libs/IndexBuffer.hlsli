@@ -0,0 +1,17 @@
+#ifndef DEF_INDEX_BUFFER_HLSLI
+#define DEF_INDEX_BUFFER_HLSLI
+
+// Index buffers hold uint32 indices, or with INDEX_16BIT two uint16 indices per uint32 (IndexPacker::Pack16)
+inline uint3 LoadTriangle(ByteAddressBuffer buffer, uint triIdx)
+{
+#if defined(INDEX_16BIT)
+	// 6 bytes per triangle, it starts either on a word or in the middle of one (IndexPacker::UnpackTriangle)
+	const uint byteOffset = triIdx * 6;
+	const uint2 words = buffer.Load2(byteOffset & ~3u);
+	return (byteOffset & 2) == 0 ? uint3(words.x & 0xFFFF, words.x >> 16, words.y & 0xFFFF) : uint3(words.x >> 16, words.y & 0xFFFF, words.y >> 16);
+#else
+	return buffer.Load3(triIdx * 12);
+#endif
+}
+
+#endif
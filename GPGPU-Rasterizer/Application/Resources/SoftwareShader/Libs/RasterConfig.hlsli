@@ -0,0 +1,47 @@
+#ifndef DEF_RASTER_CONFIG_HLSLI
+#define DEF_RASTER_CONFIG_HLSLI
+
+// Resolution and tiling of the pipeline (RasterConfig on the CPU), CompuRaster::Pipeline compiles every stage with the RASTER_ defines of its config
+// The fallbacks are the values of the default RasterConfig
+#ifndef RASTER_VIEWPORT_WIDTH
+#define RASTER_VIEWPORT_WIDTH 1280
+#endif
+#ifndef RASTER_VIEWPORT_HEIGHT
+#define RASTER_VIEWPORT_HEIGHT 720
+#endif
+// Pixels per tile side
+#ifndef RASTER_TILE_SIZE
+#define RASTER_TILE_SIZE 8
+#endif
+// Tiles per bin side
+#ifndef RASTER_BIN_SIZE
+#define RASTER_BIN_SIZE 8
+#endif
+#ifndef RASTER_QUEUE_COUNT
+#define RASTER_QUEUE_COUNT 16
+#endif
+// Micro triangles a tile lists for the point sampled path of the fine stage, one per fine thread
+#ifndef MICRO_TILE_CAPACITY
+#define MICRO_TILE_CAPACITY 64
+#endif
+
+#define VIEWPORT_WIDTH ((float)RASTER_VIEWPORT_WIDTH)
+#define VIEWPORT_HEIGHT ((float)RASTER_VIEWPORT_HEIGHT)
+#define TILE_SIZE uint2(RASTER_TILE_SIZE, RASTER_TILE_SIZE)
+#define BIN_SIZE uint2(RASTER_BIN_SIZE, RASTER_BIN_SIZE)
+#define BIN_TILE_COUNT (RASTER_BIN_SIZE * RASTER_BIN_SIZE)
+#define BIN_PIXEL_SIZE (BIN_SIZE * TILE_SIZE)
+#define QUEUE_COUNT RASTER_QUEUE_COUNT
+
+// Scalar forms, usable as array sizes
+#define BINNING_DIMS_X ((RASTER_VIEWPORT_WIDTH + RASTER_BIN_SIZE * RASTER_TILE_SIZE - 1) / (RASTER_BIN_SIZE * RASTER_TILE_SIZE))
+#define BINNING_DIMS_Y ((RASTER_VIEWPORT_HEIGHT + RASTER_BIN_SIZE * RASTER_TILE_SIZE - 1) / (RASTER_BIN_SIZE * RASTER_TILE_SIZE))
+#define BINNING_DIMS uint2(BINNING_DIMS_X, BINNING_DIMS_Y)
+#define BIN_COUNT (BINNING_DIMS_X * BINNING_DIMS_Y)
+// Bin tiles past the viewport included, bin by bin
+#define TILING_DIMS (BINNING_DIMS * BIN_SIZE)
+#define TILE_COUNT (BIN_COUNT * BIN_TILE_COUNT)
+// Screen tiles of the Hi-Z, the viewport is a multiple of the tile size
+#define HIZ_DIMS uint2(RASTER_VIEWPORT_WIDTH / RASTER_TILE_SIZE, RASTER_VIEWPORT_HEIGHT / RASTER_TILE_SIZE)
+
+#endif
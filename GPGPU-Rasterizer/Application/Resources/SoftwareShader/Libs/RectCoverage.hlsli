@@ -0,0 +1,63 @@
+#ifndef DEF_RECT_COVERAGE_HLSLI
+#define DEF_RECT_COVERAGE_HLSLI
+
+#include "FixedPointEdges.hlsli"
+
+// Corner tests of the three edges of a RasterData over an inclusive pixel rect, evaluated like FineRasterizer3 (EdgeKernel on the CPU)
+// The stepped values never decrease away from the corner where an edge is lowest, nor increase away from the one where it is highest,
+// so one corner per edge bounds the edge over the whole rect. edgeEq is the one of RasterData, with FIXED_POINT_RASTER the snapped vertices then the thresholds
+
+// Whether the edge passes at the corner of the rect where it is lowest, or where it is highest
+bool IsEdgePassedAtCorner(float edgeEq[9], uint aabbMin, uint edgeIdx, uint2 minPixel, uint2 maxPixel, bool isLowest)
+{
+#if defined(FIXED_POINT_RASTER)
+	// A clamped value keeps its sign, and a tile stepped from it stays on that side
+	const int2 start = asint(float2(edgeEq[(edgeIdx + 1) % 3 * 2], edgeEq[(edgeIdx + 1) % 3 * 2 + 1]));
+	const int2 end = asint(float2(edgeEq[(edgeIdx + 2) % 3 * 2], edgeEq[(edgeIdx + 2) % 3 * 2 + 1]));
+	const int a = start.y - end.y;
+	const int b = end.x - start.x;
+	const int2 corner = int2((a < 0) == isLowest ? maxPixel.x : minPixel.x, (b < 0) == isLowest ? maxPixel.y : minPixel.y);
+	return EvaluateEdge(a, b, start, asint(edgeEq[6 + edgeIdx]), corner) > 0;
+#else
+	// Stepped from the aabb min corner like FineRasterizer3
+	const float a = edgeEq[edgeIdx * 2];
+	const float b = edgeEq[1 + edgeIdx * 2];
+	const int2 corner = int2((a < 0.f) == isLowest ? maxPixel.x : minPixel.x, (b < 0.f) == isLowest ? maxPixel.y : minPixel.y);
+	const float cy = edgeEq[6 + edgeIdx] + b * (corner.y - (int)(aabbMin & 0xffff));
+	return cy + a * (corner.x - (int)(aabbMin >> 16)) > 0.f;
+#endif
+}
+
+// Trivial accept, every pixel of the rect passes the three edges
+bool IsRectCovered(float edgeEq[9], uint aabbMin, uint2 minPixel, uint2 maxPixel)
+{
+	[unroll]
+	for (uint edgeIdx = 0; edgeIdx < 3; ++edgeIdx)
+	{
+		if (!IsEdgePassedAtCorner(edgeEq, aabbMin, edgeIdx, minPixel, maxPixel, true))
+			return false;
+	}
+
+	return true;
+}
+
+// Conservative overlap, false when no pixel of the rect inside the packed pixel bounds of the triangle can pass the three edges
+bool IsRectOverlapped(float edgeEq[9], uint2 packedAabb, uint2 minPixel, uint2 maxPixel)
+{
+	const uint4 triAabb = uint4(packedAabb.x >> 16, packedAabb.x & 0xffff, packedAabb.y >> 16, packedAabb.y & 0xffff);
+	minPixel = max(minPixel, triAabb.xy);
+	maxPixel = min(maxPixel, triAabb.zw);
+	if (any(minPixel > maxPixel))
+		return false;
+
+	[unroll]
+	for (uint edgeIdx = 0; edgeIdx < 3; ++edgeIdx)
+	{
+		if (!IsEdgePassedAtCorner(edgeEq, packedAabb.x, edgeIdx, minPixel, maxPixel, false))
+			return false;
+	}
+
+	return true;
+}
+
+#endif
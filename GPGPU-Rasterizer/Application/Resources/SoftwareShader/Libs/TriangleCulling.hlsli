@@ -0,0 +1,34 @@
+#ifndef DEF_TRIANGLE_CULLING_HLSLI
+#define DEF_TRIANGLE_CULLING_HLSLI
+
+// Face and degenerate tests of geometry setup on twice the signed screen area, back faces are culled unless CULL_NONE or CULL_FRONT is defined (TriangleCulling on the CPU)
+// A back face that is drawn is set up with vertices 1 and 2 swapped and a negative invArea, GetWeights swaps their weights back
+
+inline bool IsDegenerate(float doubleArea)
+{
+	return !(abs(doubleArea) > 0.f);
+}
+
+inline bool IsCulled(float doubleArea)
+{
+#if defined(CULL_NONE)
+	return false;
+#elif defined(CULL_FRONT)
+	return doubleArea > 0.f;
+#else
+	return doubleArea < 0.f;
+#endif
+}
+
+// Screen space weights of the 3 vertices from the edge functions of the first two
+inline float3 GetWeights(float2 cx, float invArea)
+{
+	float3 weights;
+	weights.xy = cx * abs(invArea);
+	weights.z = 1 - weights.x - weights.y;
+	if (invArea < 0.f)
+		weights.yz = weights.zy;
+	return weights;
+}
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef DEF_VISIBILITY_BUFFER_HLSLI
+#define DEF_VISIBILITY_BUFFER_HLSLI
+
+// Visibility buffer ids of VISIBILITY_BUFFER, the triangle in the low bits and the instance above them (VisibilityBuffer on the CPU)
+#define VISIBILITY_TRIANGLE_BITS 25
+#define VISIBILITY_EMPTY 0xFFFFFFFF
+
+inline uint PackVisibility(uint triIdx, uint instanceIdx)
+{
+	return instanceIdx << VISIBILITY_TRIANGLE_BITS | triIdx;
+}
+
+inline uint GetVisibilityTriangle(uint id)
+{
+	return id & ((1u << VISIBILITY_TRIANGLE_BITS) - 1);
+}
+
+inline uint GetVisibilityInstance(uint id)
+{
+	return id >> VISIBILITY_TRIANGLE_BITS;
+}
+
+#endif
@@ -1,18 +1,16 @@
+#include "../Libs/BinList.hlsli"
+#include "../Libs/Clipping.hlsli"
 #include "../Libs/Common.hlsli"
-
-#define VIEWPORT_WIDTH 1280.f
-#define VIEWPORT_HEIGHT 720.f
-#define TILE_SIZE uint2(8, 8)
-#define BIN_SIZE uint2(8, 8)
-#define BIN_PIXEL_SIZE (BIN_SIZE * TILE_SIZE)
-#define BINNING_DIMS uint2(ceil(VIEWPORT_WIDTH / BIN_PIXEL_SIZE.x), ceil(VIEWPORT_HEIGHT / BIN_PIXEL_SIZE.y))
-#define BIN_COUNT (BINNING_DIMS.x * BINNING_DIMS.y)
+#include "../Libs/RasterConfig.hlsli"
+#include "../Libs/RectCoverage.hlsli"
 
 #define GROUP_X 32
 #define GROUP_Y 32
 #define THREAD_COUNT (GROUP_X * GROUP_Y)
 #define GROUP_DIMs GROUP_X, GROUP_Y, 1
 #define UINT3_GROUP_DIMs uint3(GROUP_DIMs)
+// A thread bins the triangles of the bins groupIndex + n * THREAD_COUNT, several past 1024 bins (4K with 64 pixel bins)
+#define BINS_PER_THREAD ((BIN_COUNT + THREAD_COUNT - 1) / THREAD_COUNT)
 
 cbuffer ObjectInfo : register(b0)
 {
@@ -32,34 +30,79 @@ struct RasterData
 	uint isClipped;
 };
 
-StructuredBuffer<RasterData> G_RASTER_DATA;
+StructuredBuffer<RasterData> G_RASTER_DATA : register(t0);
+// Counters of geometry setup, the clip triangles it emitted at offset 16
+ByteAddressBuffer G_SETUP_COUNTER : register(t1);
+// Per bin then per queue, the triangles, blocks and delta words the count pass found, BinScan turns them into offsets (BIN_OFFSET_COUNT of BinList)
+#if defined(BIN_COUNT_PASS)
+RWByteAddressBuffer G_BIN_OFFSET : register(u2);
+// Bins the aabb of a triangle overlaps and its edges miss, counted once by the count pass
+RWByteAddressBuffer G_OVERLAP_COUNTER : register(u3);
+#else
+ByteAddressBuffer G_BIN_OFFSET : register(t2);
+// Varint deltas of the triangles of every bin, its queues back to back, and the headers of their blocks, both sized from the counts of a previous frame
 RWByteAddressBuffer G_BIN_BUFFER : register(u2);
+RWByteAddressBuffer G_BIN_HEADER : register(u3);
+#endif
 
 groupshared uint GroupBatchTri[THREAD_COUNT];
 groupshared uint4 GroupBatchAabb[THREAD_COUNT];
 
+// Dispatched twice, with BIN_COUNT_PASS the bins are only counted and their coded size computed, then the same triangles are coded at the offsets of BinScan
+// A bin of the aabb of a triangle only gets it when the corner tests of its edges pass on the pixels of the bin, both passes agree on it
+// The triangles of a queue increase, each one past the first of a block is stored as the varint of its delta to the previous one minus 1
 [numthreads(GROUP_DIMs)]
 void main(uint groupIndex : SV_GroupIndex, uint3 dispatchID : SV_GroupId)
 {
-	const uint queueCount = 16;
-	const uint batchSize = ceil(triangleCount / (float)queueCount);
+	const uint queueCount = QUEUE_COUNT;
+	// The batches cover the mesh triangles then the clip triangle slots, the slots past the last emitted one hold stale data
+	const uint batchSize = ceil((triangleCount + MAX_CLIP_TRIANGLES) / (float)queueCount);
+	const uint rasterTriangleCount = triangleCount + min(G_SETUP_COUNTER.Load(16), MAX_CLIP_TRIANGLES);
 	const uint loopCount = ceil(batchSize / (float)THREAD_COUNT);
 	const uint batchStart = batchSize * dispatchID.x;
-	const uint2 binDim = uint2(groupIndex % BINNING_DIMS.x, groupIndex / BINNING_DIMS.x);
-	const uint binDataIdx = (batchSize + 1) * dispatchID.x + groupIndex * (batchSize + 1) * queueCount;
 
-	uint binTriCount = 0;
+#if !defined(BIN_COUNT_PASS)
+	// What does not fit was counted by BinScan, Pipeline grows the buffers once it reads the totals back
+	uint streamCapacity, headerCapacity;
+	G_BIN_BUFFER.GetDimensions(streamCapacity);
+	G_BIN_HEADER.GetDimensions(headerCapacity);
+#endif
+
+	uint missedCount = 0;
+	uint binTriCount[BINS_PER_THREAD];
+	uint binLastTri[BINS_PER_THREAD];
+#if defined(BIN_COUNT_PASS)
+	uint binByteCount[BINS_PER_THREAD];
+#else
+	uint binCursor[BINS_PER_THREAD];
+	uint binPendingWord[BINS_PER_THREAD];
+#endif
+	[unroll]
+	for (uint clearSlot = 0; clearSlot < BINS_PER_THREAD; ++clearSlot)
+	{
+		binTriCount[clearSlot] = 0;
+		binLastTri[clearSlot] = 0;
+#if defined(BIN_COUNT_PASS)
+		binByteCount[clearSlot] = 0;
+#else
+		// The deltas of a queue start on a word, no other queue writes to it
+		const uint clearBinIdx = groupIndex + clearSlot * THREAD_COUNT;
+		binCursor[clearSlot] = clearBinIdx < BIN_COUNT ? G_BIN_OFFSET.Load(BIN_WORD_OFFSET + (clearBinIdx * queueCount + dispatchID.x) * 4) * 4 : 0;
+		binPendingWord[clearSlot] = 0;
+#endif
+	}
+
 	uint triIdx = batchStart + groupIndex;
 	for (uint loop = 0; loop < loopCount; ++loop)
 	{
-		if (triIdx < triangleCount && (triIdx - batchStart) < batchSize)
+		if (triIdx < rasterTriangleCount && (triIdx - batchStart) < batchSize)
 		{
 			const RasterData triData = G_RASTER_DATA[triIdx];
 			if (!triData.isClipped)
 			{
 				uint4 binAabb = uint4(triData.aabb.x >> 16, triData.aabb.x & 0xffff, triData.aabb.y >> 16, triData.aabb.y & 0xffff);
-				binAabb.xy /= BIN_PIXEL_SIZE;
-				binAabb.zw = ceil(binAabb.zw / (float2)BIN_PIXEL_SIZE);
+				// Inclusive pixel bounds to inclusive bins, the max corner is rounded down like the min one
+				binAabb /= BIN_PIXEL_SIZE;
 				GroupBatchTri[groupIndex] = triIdx;
 				GroupBatchAabb[groupIndex] = binAabb;
 			}
@@ -72,23 +115,77 @@ void main(uint groupIndex : SV_GroupIndex, uint3 dispatchID : SV_GroupId)
 		GroupMemoryBarrierWithGroupSync();
 		triIdx += THREAD_COUNT;
 
-		if (groupIndex < BIN_COUNT)
+		// The triangles of this loop, the last one of the batch is partial
+		const uint loopTriCount = min(batchSize - loop * THREAD_COUNT, THREAD_COUNT);
+		[unroll]
+		for (uint binSlot = 0; binSlot < BINS_PER_THREAD; ++binSlot)
 		{
-			for (uint idx = 0; idx < batchSize; ++idx)
+			const uint binIdx = groupIndex + binSlot * THREAD_COUNT;
+			if (binIdx < BIN_COUNT)
 			{
-				uint triId = GroupBatchTri[idx];
-				uint4 aabb = GroupBatchAabb[idx];
-				if (triId != -1 
-					&& aabb.x <= binDim.x && aabb.z >= binDim.x
-					&& aabb.y <= binDim.y && aabb.w >= binDim.y)
+				const uint2 binDim = uint2(binIdx % BINNING_DIMS.x, binIdx / BINNING_DIMS.x);
+				const uint2 binPixel = binDim * BIN_PIXEL_SIZE;
+				const uint queueEntry = binIdx * queueCount + dispatchID.x;
+				for (uint idx = 0; idx < loopTriCount; ++idx)
 				{
-					G_BIN_BUFFER.Store((binDataIdx + 1 + binTriCount) * 4, triId);
-					++binTriCount;
+					uint triId = GroupBatchTri[idx];
+					uint4 aabb = GroupBatchAabb[idx];
+					if (triId != -1 
+						&& aabb.x <= binDim.x && aabb.z >= binDim.x
+						&& aabb.y <= binDim.y && aabb.w >= binDim.y)
+					{
+						const RasterData binTriData = G_RASTER_DATA[triId];
+						if (!IsRectOverlapped(binTriData.edgeEq, binTriData.aabb, binPixel, binPixel + BIN_PIXEL_SIZE - 1))
+						{
+							++missedCount;
+							continue;
+						}
+
+						const bool isBlockStart = (binTriCount[binSlot] & (BIN_BLOCK_SIZE - 1)) == 0;
+#if defined(BIN_COUNT_PASS)
+						if (!isBlockStart)
+							binByteCount[binSlot] += GetVarintSize(triId - binLastTri[binSlot] - 1);
+#else
+						if (isBlockStart)
+						{
+							const uint queueStart = G_BIN_OFFSET.Load(BIN_TRIANGLE_OFFSET + queueEntry * 4);
+							const uint queueTriCount = G_BIN_OFFSET.Load(BIN_TRIANGLE_OFFSET + (queueEntry + 1) * 4) - queueStart;
+							const uint blockIdx = G_BIN_OFFSET.Load(BIN_BLOCK_OFFSET + queueEntry * 4) + (binTriCount[binSlot] >> BIN_BLOCK_BITS);
+							const uint blockTriCount = min(queueTriCount - binTriCount[binSlot], BIN_BLOCK_SIZE);
+							if ((blockIdx + 1) * BIN_HEADER_SIZE <= headerCapacity)
+								G_BIN_HEADER.Store3(blockIdx * BIN_HEADER_SIZE, uint3(triId, binCursor[binSlot], (queueStart + binTriCount[binSlot]) << BIN_BLOCK_BITS | (blockTriCount - 1)));
+						}
+						else
+							AppendVarint(G_BIN_BUFFER, streamCapacity, binCursor[binSlot], binPendingWord[binSlot], triId - binLastTri[binSlot] - 1);
+#endif
+						binLastTri[binSlot] = triId;
+						++binTriCount[binSlot];
+					}
 				}
 			}
 		}
 		GroupMemoryBarrierWithGroupSync();
 	}
 
-	G_BIN_BUFFER.Store(binDataIdx * 4, binTriCount);
+	[unroll]
+	for (uint storeSlot = 0; storeSlot < BINS_PER_THREAD; ++storeSlot)
+	{
+		const uint binIdx = groupIndex + storeSlot * THREAD_COUNT;
+		if (binIdx < BIN_COUNT)
+		{
+			const uint queueEntry = binIdx * queueCount + dispatchID.x;
+#if defined(BIN_COUNT_PASS)
+			G_BIN_OFFSET.Store(BIN_TRIANGLE_OFFSET + queueEntry * 4, binTriCount[storeSlot]);
+			G_BIN_OFFSET.Store(BIN_BLOCK_OFFSET + queueEntry * 4, (binTriCount[storeSlot] + BIN_BLOCK_SIZE - 1) >> BIN_BLOCK_BITS);
+			G_BIN_OFFSET.Store(BIN_WORD_OFFSET + queueEntry * 4, (binByteCount[storeSlot] + 3) / 4);
+#else
+			FlushVarints(G_BIN_BUFFER, streamCapacity, binCursor[storeSlot], binPendingWord[storeSlot]);
+#endif
+		}
+	}
+
+#if defined(BIN_COUNT_PASS)
+	if (missedCount != 0)
+		G_OVERLAP_COUNTER.InterlockedAdd(0, missedCount);
+#endif
 }
\ No newline at end of file
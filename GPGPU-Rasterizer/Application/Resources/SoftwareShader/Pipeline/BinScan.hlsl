@@ -0,0 +1,51 @@
+#include "../Libs/BinList.hlsli"
+#include "../Libs/RasterConfig.hlsli"
+
+#define THREAD_COUNT 1024
+#define GROUP_DIMs THREAD_COUNT, 1, 1
+// One entry per bin and queue, the queues of a bin are back to back
+#define ENTRY_COUNT (BIN_COUNT * QUEUE_COUNT)
+
+// Per bin then per queue, the triangles, blocks and delta words the count pass of BinRasterizer found, each array replaced by its exclusive prefix sum
+// The total of an array is stored past it, Pipeline reads them back to size G_BIN_BUFFER, G_BIN_HEADER and G_TILE_BUFFER
+RWByteAddressBuffer G_BIN_OFFSET : register(u2);
+
+groupshared uint GroupSum[THREAD_COUNT];
+
+// A single group scans the entries THREAD_COUNT at a time, carrying the total of the previous chunks
+[numthreads(GROUP_DIMs)]
+void main(uint threadId : SV_GroupIndex)
+{
+	const uint arrayOffsets[3] = { BIN_TRIANGLE_OFFSET, BIN_BLOCK_OFFSET, BIN_WORD_OFFSET };
+	for (uint arrayIdx = 0; arrayIdx < 3; ++arrayIdx)
+	{
+		const uint arrayOffset = arrayOffsets[arrayIdx];
+		uint chunkOffset = 0;
+		for (uint chunkStart = 0; chunkStart < ENTRY_COUNT; chunkStart += THREAD_COUNT)
+		{
+			const uint entryIdx = chunkStart + threadId;
+			const uint count = entryIdx < ENTRY_COUNT ? G_BIN_OFFSET.Load(arrayOffset + entryIdx * 4) : 0;
+			GroupSum[threadId] = count;
+			GroupMemoryBarrierWithGroupSync();
+
+			// Inclusive Hillis-Steele scan of the chunk
+			[unroll]
+			for (uint stride = 1; stride < THREAD_COUNT; stride <<= 1)
+			{
+				const uint previous = threadId >= stride ? GroupSum[threadId - stride] : 0;
+				GroupMemoryBarrierWithGroupSync();
+				GroupSum[threadId] += previous;
+				GroupMemoryBarrierWithGroupSync();
+			}
+
+			if (entryIdx < ENTRY_COUNT)
+				G_BIN_OFFSET.Store(arrayOffset + entryIdx * 4, chunkOffset + GroupSum[threadId] - count);
+
+			chunkOffset += GroupSum[THREAD_COUNT - 1];
+			GroupMemoryBarrierWithGroupSync();
+		}
+
+		if (threadId == 0)
+			G_BIN_OFFSET.Store(arrayOffset + ENTRY_COUNT * 4, chunkOffset);
+	}
+}
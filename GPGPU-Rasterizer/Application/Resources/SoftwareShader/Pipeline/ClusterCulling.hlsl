@@ -0,0 +1,103 @@
+#include "../Libs/Common.hlsli"
+#include "../Libs/IndexBuffer.hlsli"
+
+// One group per meshlet, one thread per triangle (MeshletBuilder::MAX_MESHLET_TRIANGLES = 124)
+#define GROUP_X 128
+#define GROUP_DIMs GROUP_X, 1, 1
+#define MAX_DISPATCH_X 65535
+
+struct Meshlet
+{
+	float3 center;
+	float radius;
+	float3 coneApex;
+	float coneCutoff;
+	float3 coneAxis;
+	uint triangleOffset;
+	uint triangleCount;
+	uint vertexCount;
+	uint2 pad;
+};
+
+cbuffer ClusterCullInfo : register(b1)
+{
+	float4 frustumPlanes[6];
+	float3 cameraPosition;
+	uint meshletCount;
+	uint meshletOffset;
+}
+
+StructuredBuffer<Meshlet> G_MESHLET_BUFFER : register(t0);
+ByteAddressBuffer G_INDEX_BUFFER : register(t1);
+
+RWByteAddressBuffer G_VISIBLE_INDEX_BUFFER : register(u2);
+RWByteAddressBuffer G_VISIBLE_TRIANGLE_COUNT : register(u3);
+
+groupshared uint GroupVisibleOffset;
+groupshared uint GroupIsVisible;
+
+bool IsInFrustum(float3 center, float radius);
+bool IsBackfacing(Meshlet meshlet);
+
+[numthreads(GROUP_DIMs)]
+void main(uint groupIndex : SV_GroupIndex, uint3 groupId : SV_GroupID)
+{
+	// No early out, the barrier below has to be reached by every thread
+	// Only the meshlets of the selected level of detail are dispatched
+	const uint meshletIdx = groupId.y * MAX_DISPATCH_X + groupId.x;
+	const bool isValid = meshletIdx < meshletCount;
+	Meshlet meshlet = (Meshlet)0;
+	if (isValid)
+		meshlet = G_MESHLET_BUFFER[meshletOffset + meshletIdx];
+
+	if (groupIndex == 0)
+	{
+		GroupIsVisible = isValid && IsInFrustum(meshlet.center, meshlet.radius);
+#if !defined(CULL_NONE) && !defined(CULL_FRONT)
+		// The normal cones bound back faces only, with another cull mode GeometrySetup tests every triangle
+		GroupIsVisible = GroupIsVisible && !IsBackfacing(meshlet);
+#endif
+		if (GroupIsVisible)
+		{
+#if defined(INDEX_16BIT)
+			// Whole triangle pairs, so every pair starts on a word and no two groups write the same word
+			G_VISIBLE_TRIANGLE_COUNT.InterlockedAdd(0, (meshlet.triangleCount + 1) & ~1u, GroupVisibleOffset);
+#else
+			G_VISIBLE_TRIANGLE_COUNT.InterlockedAdd(0, meshlet.triangleCount, GroupVisibleOffset);
+#endif
+		}
+	}
+
+	GroupMemoryBarrierWithGroupSync();
+
+#if defined(INDEX_16BIT)
+	// One thread per triangle pair (12 bytes), an odd meshlet is padded with a degenerate triangle that GeometrySetup rejects
+	if (GroupIsVisible && (groupIndex & 1) == 0 && groupIndex < meshlet.triangleCount)
+	{
+		const uint3 tri0 = LoadTriangle(G_INDEX_BUFFER, meshlet.triangleOffset + groupIndex);
+		const uint3 tri1 = groupIndex + 1 < meshlet.triangleCount ? LoadTriangle(G_INDEX_BUFFER, meshlet.triangleOffset + groupIndex + 1) : uint3(0, 0, 0);
+		G_VISIBLE_INDEX_BUFFER.Store3((GroupVisibleOffset + groupIndex) * 6, uint3(tri0.x | (tri0.y << 16), tri0.z | (tri1.x << 16), tri1.y | (tri1.z << 16)));
+	}
+#else
+	if (GroupIsVisible && groupIndex < meshlet.triangleCount)
+		G_VISIBLE_INDEX_BUFFER.Store3((GroupVisibleOffset + groupIndex) * 3 * 4, LoadTriangle(G_INDEX_BUFFER, meshlet.triangleOffset + groupIndex));
+#endif
+}
+
+bool IsInFrustum(float3 center, float radius)
+{
+	[unroll]
+	for (uint planeIdx = 0; planeIdx < 6; ++planeIdx)
+	{
+		if (dot(frustumPlanes[planeIdx].xyz, center) + frustumPlanes[planeIdx].w < -radius)
+			return false;
+	}
+
+	return true;
+}
+
+bool IsBackfacing(Meshlet meshlet)
+{
+	// A disabled cone has a zero axis and a cutoff of 1, so it never passes
+	return dot(normalize(meshlet.coneApex - cameraPosition), meshlet.coneAxis) >= meshlet.coneCutoff;
+}
@@ -1,11 +1,7 @@
 #include "../Libs/Common.hlsli"
+#include "../Libs/RasterConfig.hlsli"
 
-#define VIEWPORT_WIDTH 1920.f
-#define VIEWPORT_HEIGHT 1080.f
-#define BIN_SIZE uint2(64, 64)
-#define BIN_PixelCount BIN_SIZE.x * BIN_SIZE.y
-#define BINNING_DIMS uint2(ceil(VIEWPORT_WIDTH / BIN_SIZE.x), ceil(VIEWPORT_HEIGHT / BIN_SIZE.y))
-#define BIN_COUNT BINNING_DIMS.x * BINNING_DIMS.y
+#define BIN_PixelCount BIN_PIXEL_SIZE.x * BIN_PIXEL_SIZE.y
 #define BIN_UINT_COUNT ceil(BIN_COUNT / 32.f)
 
 #define GROUP_X 32
@@ -72,7 +68,7 @@ float Remap(float val, float min, float max)
 void main(uint groupIndex : SV_GroupIndex, uint3 dispatchID : SV_GroupId)
 {
 	const uint binIdx = dispatchID.y * BINNING_DIMS.x + dispatchID.x;
-	const uint2 binCoord = dispatchID.xy * BIN_SIZE;
+	const uint2 binCoord = dispatchID.xy * BIN_PIXEL_SIZE;
 	const uint threadCount = GROUP_X * GROUP_Y;
 	const uint pixelPerThread = (uint)ceil(BIN_PixelCount / (float)threadCount);
 
@@ -129,7 +125,7 @@ void main(uint groupIndex : SV_GroupIndex, uint3 dispatchID : SV_GroupId)
 
 			for (uint pixel = startPixel; pixel < endPixel; ++pixel)
 			{
-				float2 screenPixelCoord = binCoord + float2(pixel % BIN_SIZE.x, pixel / BIN_SIZE.x);
+				float2 screenPixelCoord = binCoord + float2(pixel % BIN_PIXEL_SIZE.x, pixel / BIN_PIXEL_SIZE.x);
 
 				float2 pixelOffset = float2(screenPixelCoord - aabb4.xy);
 				float3 cy = baseCy + float3(triData.edgeEq[1], triData.edgeEq[3], triData.edgeEq[5]) * pixelOffset.y;
@@ -150,7 +146,7 @@ void main(uint groupIndex : SV_GroupIndex, uint3 dispatchID : SV_GroupId)
 		//uint pixelId = 0, pixelCounter = 0;
 		//while ((pixelId = threadCount * pixelCounter + groupIndex) < BIN_PixelCount)
 		//{
-		//	float2 screenPixelCoord = binCoord + float2(pixelId % BIN_SIZE.x, pixelId / BIN_SIZE.x) + (0.5f).xx;
+		//	float2 screenPixelCoord = binCoord + float2(pixelId % BIN_PIXEL_SIZE.x, pixelId / BIN_PIXEL_SIZE.x) + (0.5f).xx;
 
 		//	unorm float4 color = G_RENDER_TARGET.Load(screenPixelCoord);
 		//	float depthValue = G_DEPTH_BUFFER.Load(screenPixelCoord);
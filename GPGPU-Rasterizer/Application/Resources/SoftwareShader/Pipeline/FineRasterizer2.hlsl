@@ -1,11 +1,7 @@
 #include "../Libs/Common.hlsli"
+#include "../Libs/RasterConfig.hlsli"
 
-#define VIEWPORT_WIDTH 1920.f
-#define VIEWPORT_HEIGHT 1080.f
-#define BIN_SIZE uint2(64, 64)
-#define BIN_PixelCount BIN_SIZE.x * BIN_SIZE.y
-#define BINNING_DIMS uint2(ceil(VIEWPORT_WIDTH / BIN_SIZE.x), ceil(VIEWPORT_HEIGHT / BIN_SIZE.y))
-#define BIN_COUNT BINNING_DIMS.x * BINNING_DIMS.y
+#define BIN_PixelCount BIN_PIXEL_SIZE.x * BIN_PIXEL_SIZE.y
 #define BIN_UINT_COUNT ceil(BIN_COUNT / 32.f)
 
 #define GROUP_X 32
@@ -93,7 +89,7 @@ float Remap(float val, float min, float max)
 //
 //		uint binId = tileId / 64;
 //		uint tileid = tileId % 64;
-//		uint2 tileCoord = uint2(binId % BINNING_DIMS.x, binId / BINNING_DIMS.x) * BIN_SIZE + uint2(tileid % 8, tileid / 8) * uint2(8, 8);
+//		uint2 tileCoord = uint2(binId % BINNING_DIMS.x, binId / BINNING_DIMS.x) * BIN_PIXEL_SIZE + uint2(tileid % 8, tileid / 8) * uint2(8, 8);
 //
 //		uint2 pixelIds = (groupThread.x * 2).xx + uint2(0, 1);
 //		uint2 pixel0 = tileCoord + uint2(pixelIds.x % 8, pixelIds.x / 8);
@@ -211,7 +207,7 @@ void main(uint3 groupThread : SV_GroupThreadID, uint3 dispatchID : SV_GroupId)
 
 		uint binId = tileId / 64;
 		uint tileid = tileId % 64;
-		uint2 tileCoord = uint2(binId % BINNING_DIMS.x, binId / BINNING_DIMS.x) * BIN_SIZE + uint2(tileid % 8, tileid / 8) * uint2(8, 8);
+		uint2 tileCoord = uint2(binId % BINNING_DIMS.x, binId / BINNING_DIMS.x) * BIN_PIXEL_SIZE + uint2(tileid % 8, tileid / 8) * uint2(8, 8);
 
 		uint2 pixelIds = (groupThread.x * 2).xx + uint2(0, 1);
 		uint2 pixel0 = tileCoord + uint2(pixelIds.x % 8, pixelIds.x / 8);
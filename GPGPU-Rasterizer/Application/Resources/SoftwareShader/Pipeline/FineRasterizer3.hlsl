@@ -1,22 +1,26 @@
+#include "../Libs/Clipping.hlsli"
 #include "../Libs/Common.hlsli"
-
-#define VIEWPORT_WIDTH 1280.f
-#define VIEWPORT_HEIGHT 720.f
-#define TILE_SIZE uint2(8, 8)
-#define BIN_SIZE uint2(8, 8)
-#define BIN_TILE_COUNT (BIN_SIZE.x * BIN_SIZE.y)
-#define BIN_PIXEL_SIZE (BIN_SIZE * TILE_SIZE)
-#define BINNING_DIMS uint2(ceil(VIEWPORT_WIDTH / BIN_PIXEL_SIZE.x), ceil(VIEWPORT_HEIGHT / BIN_PIXEL_SIZE.y))
-#define TILING_DIMS (BINNING_DIMS * BIN_SIZE)
-#define BIN_COUNT (BINNING_DIMS.x * BINNING_DIMS.y)
-#define TILE_COUNT (TILING_DIMS.x * TILING_DIMS.y)
-
+#include "../Libs/FixedPointEdges.hlsli"
+#include "../Libs/IndexBuffer.hlsli"
+#include "../Libs/RasterConfig.hlsli"
+#include "../Libs/RectCoverage.hlsli"
+#include "../Libs/TriangleCulling.hlsli"
+#include "../Libs/VisibilityBuffer.hlsli"
+
+// One thread per pixel of the tile, GroupMask keeps a 32 bit row of the threads per GROUP_Y
 #define GROUP_X 32
-#define GROUP_Y 2
+#define GROUP_Y (RASTER_TILE_SIZE * RASTER_TILE_SIZE / GROUP_X)
 #define THREAD_COUNT (GROUP_X * GROUP_Y)
 #define GROUP_DIMs GROUP_X, GROUP_Y, 1
 #define UINT3_GROUP_DIMs uint3(GROUP_DIMs)
 
+// 2x2 pixel quads of the tile, row by row, bit quadIdx of the quad masks of CacheData
+#define QUAD_TILE_SIZE (RASTER_TILE_SIZE / 2)
+#define QUAD_COUNT (QUAD_TILE_SIZE * QUAD_TILE_SIZE)
+
+// QUAD_COVERAGE, set by CompuRaster::Pipeline::Init for ECoverageMode::Quad, classifies the quads of the partially covered triangle tiles before shading them.
+// Without it every quad is kept and only the fully covered tiles skip the edge tests
+
 #define LIGHT_DIR float3(0.577f, -0.577f, 0.577f)
 #define LIGHT_INTENSITY 4.f
 #define PI 3.14159265358979323846f
@@ -34,7 +38,7 @@ struct Vertex_Out
 {
 	float4 position;
 	float3 normal;
-	float pad;
+	uint outcode;
 };
 
 struct RasterData
@@ -49,9 +53,14 @@ struct RasterData
 struct BinData
 {
 	uint2 coverage;
+	uint2 fullCoverage;
 	uint triIdx;
 };
 
+// With FIXED_POINT_RASTER, edgeEq holds asfloat of the integer edge functions at the tile min corner, stepped from startPixel = tile min
+// aabb is the packed one of RasterData, the micro triangles only sample the pixels inside it
+// The quads of quadMask can be covered, the pixels of the other ones skip the triangle, and the ones of fullQuadMask are, they skip the edge tests
+// Every quad is in both when TileRasterizer found the tile entirely covered, every quad is in quadMask without QUAD_COVERAGE
 struct CacheData
 {
 	float edgeEq[9];
@@ -59,43 +68,230 @@ struct CacheData
 	uint2 startPixel;
 	float invArea;
 	uint triIdx;
+	uint2 aabb;
+	uint2 quadMask;
+	uint2 fullQuadMask;
+	// With FIXED_POINT_RASTER, the unclamped EstimateEdge of the first two edges at the tile min corner, the weights step them where edgeEq was clamped
+	float2 weightOrigin;
 };
 
+#if defined(VISIBILITY_BUFFER)
+#define PIXEL_TARGET uint
+#else
+#define PIXEL_TARGET float4
+#endif
+
 StructuredBuffer<RasterData> G_RASTER_DATA : register(t0);
 StructuredBuffer<BinData> G_TILE_BUFFER : register(t1);
-ByteAddressBuffer G_BIN_TRI_COUNTER : register(t2);
+// Per bin then per queue, the offsets of BinScan into G_TILE_BUFFER first (BIN_TRIANGLE_OFFSET of BinList), the total of the pairs past them
+ByteAddressBuffer G_BIN_OFFSET : register(t2);
 StructuredBuffer<Vertex_Out> G_TRANS_VERTEX_BUFFER : register(t3);
 ByteAddressBuffer G_INDEX_BUFFER : register(t4);
+StructuredBuffer<Vertex_Out> G_CLIP_VERTEX_BUFFER : register(t5);
+// Per tile, the micro triangles GeometrySetup appended, then MICRO_TILE_CAPACITY triangle indices per tile
+ByteAddressBuffer G_MICRO_TILE_COUNTER : register(t6);
+ByteAddressBuffer G_MICRO_TILE_BUFFER : register(t7);
 
 RWTexture2D<unorm float4> G_RENDER_TARGET: register(u0);
 RWTexture2D<float> G_DEPTH_BUFFER : register(u1);
 RWByteAddressBuffer G_TILE_COUNTER: register(u2);
+#if defined(VISIBILITY_BUFFER)
+// Shaded afterwards by VisibilityShading, G_RENDER_TARGET is left untouched
+RWTexture2D<uint> G_VISIBILITY_BUFFER : register(u3);
+#endif
+// Bins and tiles the edge tests of the earlier stages dropped, then the quads of the binned triangles rejected and accepted here
+RWByteAddressBuffer G_OVERLAP_COUNTER : register(u4);
+// Min and max depth of the screen tiles, row by row, kept equal to the ones of G_DEPTH_BUFFER
+RWStructuredBuffer<float2> G_HIZ_BUFFER : register(u5);
+RWByteAddressBuffer G_HIZ_COUNTER : register(u6);
 
 groupshared CacheData GroupBatchData[THREAD_COUNT];
 groupshared uint GroupTile;
+groupshared uint GroupBinStart;
 groupshared uint GroupTriCount;
-groupshared uint GroupMask[2];
+groupshared uint GroupMicroCount;
+groupshared uint GroupMask[GROUP_Y];
+// Depths are positive floats, their bits compare in the same order, hence the uint atomics
+// Max depth of the tile, the batch being shaded reads one slot while the other one gets its result
+groupshared uint GroupMaxDepth[2];
+groupshared uint GroupMinDepth;
+groupshared uint GroupRejectedCount;
+#if defined(QUAD_COVERAGE)
+groupshared uint GroupRejectedQuadCount;
+groupshared uint GroupAcceptedQuadCount;
+#endif
+
+void ClearGroupMask()
+{
+	[unroll]
+	for (uint rowIdx = 0; rowIdx < GROUP_Y; ++rowIdx)
+		GroupMask[rowIdx] = 0;
+}
 
 float Remap(float val, float min, float max)
 {
 	return (val - min) / (max - min);
 }
 
+// Vertices of a raster triangle, the clip triangles past triangleCount have their own
+void LoadTriangleVertices(uint triIdx, out Vertex_Out v0, out Vertex_Out v1, out Vertex_Out v2)
+{
+	if (triIdx >= triangleCount)
+	{
+		const uint clipVertexIdx = (triIdx - triangleCount) * 3;
+		v0 = G_CLIP_VERTEX_BUFFER[clipVertexIdx];
+		v1 = G_CLIP_VERTEX_BUFFER[clipVertexIdx + 1];
+		v2 = G_CLIP_VERTEX_BUFFER[clipVertexIdx + 2];
+		return;
+	}
+
+	const uint3 tri = LoadTriangle(G_INDEX_BUFFER, triIdx);
+	v0 = G_TRANS_VERTEX_BUFFER[tri.x];
+	v1 = G_TRANS_VERTEX_BUFFER[tri.y];
+	v2 = G_TRANS_VERTEX_BUFFER[tri.z];
+}
+
+#if defined(QUAD_COVERAGE)
+// Last level of the edge tests under the bins and tiles of TileRasterizer, the quads of the tile at tileMin the triangle can cover and the ones it fully covers
+void ClassifyQuads(RasterData rData, uint2 tileMin, out uint2 quadMask, out uint2 fullQuadMask)
+{
+	quadMask = 0;
+	fullQuadMask = 0;
+	for (uint quadIdx = 0; quadIdx < QUAD_COUNT; ++quadIdx)
+	{
+		const uint2 minPixel = tileMin + uint2(quadIdx % QUAD_TILE_SIZE, quadIdx / QUAD_TILE_SIZE) * 2;
+		if (!IsRectOverlapped(rData.edgeEq, rData.aabb, minPixel, minPixel + 1))
+			continue;
+
+		// Written component by component, a dynamically indexed vector is no l-value
+		const uint2 quadBits = quadIdx < 32 ? uint2(1u << quadIdx, 0) : uint2(0, 1u << (quadIdx - 32));
+		quadMask |= quadBits;
+		if (IsRectCovered(rData.edgeEq, rData.aabb.x, minPixel, minPixel + 1))
+			fullQuadMask |= quadBits;
+	}
+}
+#endif
+
+// Edge equations of the triangle stepped to the pixels of the tile at tileMin, and its quads unless the tile is fully covered
+CacheData LoadCacheData(uint triIdx, uint2 tileMin, bool isFull)
+{
+	const RasterData rData = G_RASTER_DATA[triIdx];
+
+	CacheData data = (CacheData)0;
+#if defined(QUAD_COVERAGE)
+	if (isFull)
+		data.quadMask = data.fullQuadMask = 0xffffffff;
+	else
+		ClassifyQuads(rData, tileMin, data.quadMask, data.fullQuadMask);
+#else
+	data.quadMask = 0xffffffff;
+	data.fullQuadMask = isFull ? 0xffffffff : 0;
+#endif
+
+#if defined(FIXED_POINT_RASTER)
+	const int2 s0 = asint(float2(rData.edgeEq[0], rData.edgeEq[1]));
+	const int2 s1 = asint(float2(rData.edgeEq[2], rData.edgeEq[3]));
+	const int2 s2 = asint(float2(rData.edgeEq[4], rData.edgeEq[5]));
+	const int3 a = int3(s1.y - s2.y, s2.y - s0.y, s0.y - s1.y);
+	const int3 b = int3(s2.x - s1.x, s0.x - s2.x, s1.x - s0.x);
+
+	data.startPixel = tileMin;
+	data.edgeEq[0] = asfloat(a.x);
+	data.edgeEq[1] = asfloat(b.x);
+	data.edgeEq[2] = asfloat(a.y);
+	data.edgeEq[3] = asfloat(b.y);
+	data.edgeEq[4] = asfloat(a.z);
+	data.edgeEq[5] = asfloat(b.z);
+	data.edgeEq[6] = asfloat(EvaluateEdge(a.x, b.x, s1, asint(rData.edgeEq[6]), tileMin));
+	data.edgeEq[7] = asfloat(EvaluateEdge(a.y, b.y, s2, asint(rData.edgeEq[7]), tileMin));
+	data.edgeEq[8] = asfloat(EvaluateEdge(a.z, b.z, s0, asint(rData.edgeEq[8]), tileMin));
+	data.weightOrigin = float2(EstimateEdge(a.x, b.x, s1, asint(rData.edgeEq[6]), tileMin), EstimateEdge(a.y, b.y, s2, asint(rData.edgeEq[7]), tileMin));
+#else
+	data.startPixel = uint2(rData.aabb.x >> 16, rData.aabb.x & 0xffff);
+	data.edgeEq = rData.edgeEq;
+#endif
+	data.invArea = rData.invArea;
+	data.triIdx = triIdx;
+	data.invZ = rData.invZ;
+	data.aabb = rData.aabb;
+	return data;
+}
+
+// Depth tests the pixel of quad quadIdx against the cached triangle, shades it or writes its id to target when covered and nearer
+void RasterizePixel(CacheData process, uint2 pixel, uint quadIdx, inout float depth, inout PIXEL_TARGET target)
+{
+	const uint quadBit = 1u << (quadIdx % 32);
+	if ((process.quadMask[quadIdx / 32] & quadBit) == 0)
+		return;
+
+#if defined(FIXED_POINT_RASTER)
+	// Integer stepping inside the tile, exact from the clamped tile values
+	const int3 cy = asint(float3(process.edgeEq[6], process.edgeEq[7], process.edgeEq[8])) + asint(float3(process.edgeEq[1], process.edgeEq[3], process.edgeEq[5])) * ((int)pixel.y - (int)process.startPixel.y);
+	const int3 cx = cy + asint(float3(process.edgeEq[0], process.edgeEq[2], process.edgeEq[4])) * ((int)pixel.x - (int)process.startPixel.x);
+#else
+	float3 cy = float3(process.edgeEq[6], process.edgeEq[7], process.edgeEq[8]) + float3(process.edgeEq[1], process.edgeEq[3], process.edgeEq[5]) * ((int)pixel.y - (int)process.startPixel.y);
+	float3 cx = cy + float3(process.edgeEq[0], process.edgeEq[2], process.edgeEq[4]) * ((int)pixel.x - (int)process.startPixel.x);
+#endif
+	if ((process.fullQuadMask[quadIdx / 32] & quadBit) == 0 && !all(cx > 0))
+		return;
+
+#if defined(FIXED_POINT_RASTER)
+	// A clamped tile value only keeps the sign of its edge, the weights of its pixels step the float estimate instead
+	const float2 pixelSteps = float2((int)pixel.x - (int)process.startPixel.x, (int)pixel.y - (int)process.startPixel.y);
+	const float2 estimate = process.weightOrigin + asint(float2(process.edgeEq[0], process.edgeEq[2])) * pixelSteps.x + asint(float2(process.edgeEq[1], process.edgeEq[3])) * pixelSteps.y;
+	const float2 weightCx = abs(asint(float2(process.edgeEq[6], process.edgeEq[7]))) >= EDGE_CLAMP ? estimate : float2(cx.xy);
+#else
+	const float2 weightCx = cx.xy;
+#endif
+	const float3 weights = GetWeights(weightCx, process.invArea);
+	const float z = 1.f / dot(process.invZ, weights);
+	if (z >= depth)
+		return;
+
+	depth = z;
+#if defined(VISIBILITY_BUFFER)
+	// CompuMesh is drawn as instance 0
+	target = PackVisibility(process.triIdx, 0);
+#else
+	Vertex_Out v0, v1, v2;
+	LoadTriangleVertices(process.triIdx, v0, v1, v2);
+
+	const float w = 1 / dot(float3(v0.position.w, v1.position.w, v2.position.w), weights);
+	float3 n = (v0.normal * weights.x + v1.normal * weights.y + v2.normal * weights.z) * w;
+	n = normalize(n);
+	float diffuseStrength = saturate(dot(n, -LIGHT_DIR)) * LIGHT_INTENSITY;
+	diffuseStrength /= PI;
+
+	target = float4(float3(0.5f, 0.5f, 0.5f) * diffuseStrength, 1.f);
+#endif
+}
+
 [numthreads(GROUP_DIMs)]
 void main(int threadId : SV_GroupIndex, int3 groupThreadId : SV_GroupThreadID)
 {
-	const uint queueCount = 16;
-	const uint batchSize = ceil(triangleCount / (float)queueCount);
+	const uint queueCount = QUEUE_COUNT;
+	// The pairs binning could not store past the capacity are left out, TileRasterizer cleared the coverage of the other ones of a bin it could not decode
+	uint binCapacity, binDataStride;
+	G_TILE_BUFFER.GetDimensions(binCapacity, binDataStride);
 
 	for (;;)
 	{
 		if (threadId == 0)
 		{
 			G_TILE_COUNTER.InterlockedAdd(0, 1, GroupTile);
-			GroupMask[0] = GroupMask[1] = 0;
+			ClearGroupMask();
+			GroupMaxDepth[0] = GroupMaxDepth[1] = 0;
+			GroupMinDepth = 0x7F7FFFFF; // FLT_MAX
+			GroupRejectedCount = 0;
+#if defined(QUAD_COVERAGE)
+			GroupRejectedQuadCount = 0;
+			GroupAcceptedQuadCount = 0;
+#endif
 
 			const uint binIdx = GroupTile / BIN_TILE_COUNT;
-			GroupTriCount = G_BIN_TRI_COUNTER.Load(binIdx * 4);
+			GroupBinStart = GroupTile < TILE_COUNT ? min(G_BIN_OFFSET.Load(binIdx * queueCount * 4), binCapacity) : 0;
+			GroupTriCount = GroupTile < TILE_COUNT ? min(G_BIN_OFFSET.Load((binIdx + 1) * queueCount * 4), binCapacity) - GroupBinStart : 0;
+			GroupMicroCount = GroupTile < TILE_COUNT ? min(G_MICRO_TILE_COUNTER.Load(GroupTile * 4), MICRO_TILE_CAPACITY) : 0;
 		}
 
 		GroupMemoryBarrierWithGroupSync();
@@ -105,10 +301,11 @@ void main(int threadId : SV_GroupIndex, int3 groupThreadId : SV_GroupThreadID)
 			break;
 
 		const uint binIdx = tileIdx / BIN_TILE_COUNT;
-		const uint binDataStart = binIdx * batchSize * queueCount;
+		const uint binDataStart = GroupBinStart;
 		const uint triCount = GroupTriCount;
+		const uint microCount = GroupMicroCount;
 		GroupMemoryBarrierWithGroupSync();
-		if (triCount == 0)
+		if (triCount == 0 && microCount == 0)
 			continue;
 
 		const uint loopCount = ceil(triCount / (float)THREAD_COUNT);
@@ -121,8 +318,14 @@ void main(int threadId : SV_GroupIndex, int3 groupThreadId : SV_GroupThreadID)
 		tileAabb.zw = tileAabb.xy + TILE_SIZE;
 
 		uint2 pixel = tileAabb.xy + uint2(threadId % TILE_SIZE.x, threadId / TILE_SIZE.x);
-		unorm float4 color = G_RENDER_TARGET[pixel];
+		const uint quadIdx = (pixel.y - tileAabb.y) / 2 * QUAD_TILE_SIZE + (pixel.x - tileAabb.x) / 2;
+#if defined(VISIBILITY_BUFFER)
+		PIXEL_TARGET target = G_VISIBILITY_BUFFER[pixel];
+#else
+		PIXEL_TARGET target = G_RENDER_TARGET[pixel];
+#endif
 		float depth = G_DEPTH_BUFFER[pixel];
+		InterlockedMax(GroupMaxDepth[0], asuint(depth));
 
 		uint triIndex = threadId;
 		uint loop = 0;
@@ -135,7 +338,8 @@ void main(int threadId : SV_GroupIndex, int3 groupThreadId : SV_GroupThreadID)
 				count = 0;
 				if (threadId == 0)
 				{
-					GroupMask[0] = GroupMask[1] = 0;
+					ClearGroupMask();
+					GroupMaxDepth[loop & 1] = 0;
 				}
 				GroupMemoryBarrierWithGroupSync();
 
@@ -145,6 +349,17 @@ void main(int threadId : SV_GroupIndex, int3 groupThreadId : SV_GroupThreadID)
 				{
 					triBinData = G_TILE_BUFFER[binDataStart + triIndex];
 					triMask = (triBinData.coverage[binTileId / 32] & (1 << (binTileId % 32))) != 0;
+
+					// The interpolated depth stays between the ones of the vertices, a triangle behind the whole tile is not cached
+					if (triMask)
+					{
+						const float3 invZ = G_RASTER_DATA[triBinData.triIdx].invZ;
+						if (1.f / max(invZ.x, max(invZ.y, invZ.z)) >= asfloat(GroupMaxDepth[(loop - 1) & 1]))
+						{
+							triMask = 0;
+							InterlockedAdd(GroupRejectedCount, 1);
+						}
+					}
 				}
 				InterlockedOr(GroupMask[groupThreadId.y], triMask << groupThreadId.x);
 				GroupMemoryBarrierWithGroupSync();
@@ -159,20 +374,22 @@ void main(int threadId : SV_GroupIndex, int3 groupThreadId : SV_GroupThreadID)
 
 					if (cacheId < THREAD_COUNT)
 					{
-						RasterData rData = G_RASTER_DATA[triBinData.triIdx];
-						uint4 triAabb = uint4(rData.aabb.x >> 16, rData.aabb.x & 0xffff, rData.aabb.y >> 16, rData.aabb.y & 0xffff);
-
-						CacheData data = (CacheData)0;
-						data.startPixel = triAabb.xy;
-						data.edgeEq = rData.edgeEq;
-						data.invArea = rData.invArea;
-						data.triIdx = triBinData.triIdx;
-						data.invZ = rData.invZ;
+						const bool isFull = (triBinData.fullCoverage[binTileId / 32] & (1 << (binTileId % 32))) != 0;
+						const CacheData data = LoadCacheData(triBinData.triIdx, tileAabb.xy, isFull);
 						GroupBatchData[cacheId] = data;
+#if defined(QUAD_COVERAGE)
+						if (!isFull)
+						{
+							InterlockedAdd(GroupRejectedQuadCount, QUAD_COUNT - countbits(data.quadMask.x) - countbits(data.quadMask.y));
+							InterlockedAdd(GroupAcceptedQuadCount, countbits(data.fullQuadMask.x) + countbits(data.fullQuadMask.y));
+						}
+#endif
 					}
 				}
 
-				count = countbits(GroupMask[0]) + countbits(GroupMask[1]);
+				[unroll]
+				for (uint rowIdx = 0; rowIdx < GROUP_Y; ++rowIdx)
+					count += countbits(GroupMask[rowIdx]);
 				batchCount += count;
 				triIndex += THREAD_COUNT;
 				GroupMemoryBarrierWithGroupSync();
@@ -182,40 +399,73 @@ void main(int threadId : SV_GroupIndex, int3 groupThreadId : SV_GroupThreadID)
 			batchCount = min(batchCount, THREAD_COUNT);
 
 			for (int cacheIdx = 0; cacheIdx < batchCount; ++cacheIdx)
+				RasterizePixel(GroupBatchData[cacheIdx], pixel, quadIdx, depth, target);
+
+			InterlockedMax(GroupMaxDepth[loop & 1], asuint(depth));
+		}
+
+		// Micro triangles of the tile, never binned, cached one per thread in the order GeometrySetup appended them
+		// and only sampled at the pixels inside their aabb, shaded after the binned ones as one more batch
+		if (microCount != 0)
+		{
+			++loop;
+			if (threadId == 0)
 			{
-				CacheData process = GroupBatchData[cacheIdx];
-				float3 cy = float3(process.edgeEq[6], process.edgeEq[7], process.edgeEq[8]) + float3(process.edgeEq[1], process.edgeEq[3], process.edgeEq[5]) * ((int)pixel.y - (int)process.startPixel.y);
-				float3 cx = cy + float3(process.edgeEq[0], process.edgeEq[2], process.edgeEq[4]) * ((int)pixel.x - (int)process.startPixel.x);
-				if (all(cx > 0))
-				{
-					uint3 tri = G_INDEX_BUFFER.Load3(process.triIdx * 3 * 4);
-					const Vertex_Out v0 = G_TRANS_VERTEX_BUFFER[tri.x];
-					const Vertex_Out v1 = G_TRANS_VERTEX_BUFFER[tri.y];
-					const Vertex_Out v2 = G_TRANS_VERTEX_BUFFER[tri.z];
+				ClearGroupMask();
+				GroupMaxDepth[loop & 1] = 0;
+			}
+			GroupMemoryBarrierWithGroupSync();
 
-					float3 weights = cx * process.invArea;
-					weights.z = 1 - weights.x - weights.y;
-					const float z = 1.f / dot(process.invZ, weights);
+			if (threadId < microCount)
+			{
+				const CacheData data = LoadCacheData(G_MICRO_TILE_BUFFER.Load((tileIdx * MICRO_TILE_CAPACITY + threadId) * 4), tileAabb.xy, false);
+				GroupBatchData[threadId] = data;
 
-					if (z < depth)
-					{
-						depth = z;
+				if (1.f / max(data.invZ.x, max(data.invZ.y, data.invZ.z)) >= asfloat(GroupMaxDepth[(loop - 1) & 1]))
+					InterlockedAdd(GroupRejectedCount, 1);
+				else
+					InterlockedOr(GroupMask[groupThreadId.y], 1u << groupThreadId.x);
+			}
+			GroupMemoryBarrierWithGroupSync();
 
-						const float w = 1 / dot(float3(v0.position.w, v1.position.w, v2.position.w), weights);
-						float3 n = (v0.normal * weights.x + v1.normal * weights.y + v2.normal * weights.z) * w;
-						n = normalize(n);
-						float diffuseStrength = saturate(dot(n, -LIGHT_DIR)) * LIGHT_INTENSITY;
-						diffuseStrength /= PI;
+			uint microMask[GROUP_Y];
+			[unroll]
+			for (uint rowIdx = 0; rowIdx < GROUP_Y; ++rowIdx)
+				microMask[rowIdx] = GroupMask[rowIdx];
+			for (uint cacheIdx = 0; cacheIdx < microCount; ++cacheIdx)
+			{
+				if ((microMask[cacheIdx / GROUP_X] & (1u << (cacheIdx % GROUP_X))) == 0)
+					continue;
 
-						color = float4(float3(0.5f, 0.5f, 0.5f) * diffuseStrength, 1.f);
-					}
-				}
+				const CacheData process = GroupBatchData[cacheIdx];
+				const uint4 triAabb = uint4(process.aabb.x >> 16, process.aabb.x & 0xffff, process.aabb.y >> 16, process.aabb.y & 0xffff);
+				if (all(pixel >= triAabb.xy && pixel <= triAabb.zw))
+					RasterizePixel(process, pixel, quadIdx, depth, target);
 			}
+
+			InterlockedMax(GroupMaxDepth[loop & 1], asuint(depth));
 		}
 
-		G_RENDER_TARGET[pixel] = color;
+#if defined(VISIBILITY_BUFFER)
+		G_VISIBILITY_BUFFER[pixel] = target;
+#else
+		G_RENDER_TARGET[pixel] = target;
+#endif
 		G_DEPTH_BUFFER[pixel] = depth;
+		InterlockedMin(GroupMinDepth, asuint(depth));
 
 		GroupMemoryBarrierWithGroupSync();
+
+		// Tiles past the viewport are shaded but never written
+		const uint2 hiZTile = tileAabb.xy / TILE_SIZE;
+		if (threadId == 0 && all(hiZTile < HIZ_DIMS))
+		{
+			G_HIZ_BUFFER[hiZTile.y * HIZ_DIMS.x + hiZTile.x] = float2(asfloat(GroupMinDepth), asfloat(GroupMaxDepth[loop & 1]));
+			G_HIZ_COUNTER.InterlockedAdd(4, GroupRejectedCount);
+#if defined(QUAD_COVERAGE)
+			G_OVERLAP_COUNTER.InterlockedAdd(8, GroupRejectedQuadCount);
+			G_OVERLAP_COUNTER.InterlockedAdd(12, GroupAcceptedQuadCount);
+#endif
+		}
 	}
 }
\ No newline at end of file
@@ -1,4 +1,9 @@
+#include "../Libs/Clipping.hlsli"
 #include "../Libs/Common.hlsli"
+#include "../Libs/FixedPointEdges.hlsli"
+#include "../Libs/IndexBuffer.hlsli"
+#include "../Libs/RasterConfig.hlsli"
+#include "../Libs/TriangleCulling.hlsli"
 
 #define GROUP_X 32
 #define GROUP_Y 16
@@ -6,9 +11,6 @@
 #define UINT3_GROUP_DIMs uint3(GROUP_DIMs)
 #define THREAD_COUNT (GROUP_X * GROUP_Y)
 
-#define VIEWPORT_WIDTH 1280.f
-#define VIEWPORT_HEIGHT 720.f
-
 cbuffer ObjectInfo : register(b0)
 {
 	float4x4 worldViewProj;
@@ -18,16 +20,22 @@ cbuffer ObjectInfo : register(b0)
 	uint indexCount;
 }
 
+// Still in clip space when the outcode has a CLIP_OUTCODE plane
 struct Vertex_Out
 {
 	float4 position;
 	float3 normal;
-	float pad;
+	uint outcode;
 };
 
-StructuredBuffer<Vertex_Out> G_TRANS_VERTEX_BUFFER;
-ByteAddressBuffer G_INDEX_BUFFER;
+StructuredBuffer<Vertex_Out> G_TRANS_VERTEX_BUFFER : register(t0);
+// Triangles of the clusters that passed ClusterCulling, compacted at the start of the buffer
+ByteAddressBuffer G_INDEX_BUFFER : register(t1);
+ByteAddressBuffer G_VISIBLE_TRIANGLE_COUNT : register(t2);
 
+// With FIXED_POINT_RASTER, edgeEq holds asfloat of the snapped x, y of the 3 vertices then the threshold of each edge
+// isClipped is also set for rejected, culled and degenerate triangles and the clipped ones, whose clip triangles take the slots past triangleCount,
+// and for the micro triangles, whose raster data stays valid for the fine stage
 struct RasterData
 {
 	float edgeEq[9];
@@ -37,58 +45,338 @@ struct RasterData
 	uint isClipped;
 };
 RWStructuredBuffer<RasterData> G_RASTER_DATA : register(u2);
+// Triangles dropped by the cull mode, degenerate triangles, rejected triangles, clipped triangles, the clip triangles emitted,
+// then micro triangles, the ones of them inside a pixel quad, binned triangles and the ones of them past a full micro list
+RWByteAddressBuffer G_SETUP_COUNTER : register(u3);
+// The 3 screen space vertices of every clip triangle slot
+RWStructuredBuffer<Vertex_Out> G_CLIP_VERTEX_BUFFER : register(u4);
+// Per tile, the micro triangles appended, then MICRO_TILE_CAPACITY triangle indices per tile, tiles stored bin by bin
+RWByteAddressBuffer G_MICRO_TILE_COUNTER : register(u6);
+RWByteAddressBuffer G_MICRO_TILE_BUFFER : register(u7);
+
+struct SetupStats
+{
+	uint culledCount;
+	uint degenerateCount;
+	uint rejectedCount;
+	uint clippedCount;
+	uint microCount;
+	uint quadCount;
+	uint regularCount;
+	uint overflowCount;
+};
+
+groupshared uint GroupCulledCount;
+groupshared uint GroupDegenerateCount;
+groupshared uint GroupRejectedCount;
+groupshared uint GroupClippedCount;
+groupshared uint GroupMicroCount;
+groupshared uint GroupQuadCount;
+groupshared uint GroupRegularCount;
+groupshared uint GroupOverflowCount;
 
-bool IsClipped(float4 vertex, float viewportWidth, float viewportHeight);
+RasterData SetupTriangle(uint triIdx, inout SetupStats stats);
+RasterData SetupRasterData(float4 v0, float4 v1, float4 v2, inout SetupStats stats);
+void ClipTriangle(Vertex_Out vertices[3], inout SetupStats stats);
+void RouteTriangle(uint triIdx, inout RasterData data, inout SetupStats stats);
 uint4 GetAabb(float2 v0, float2 v1, float2 v2);
 
 [numthreads(GROUP_DIMs)]
-void main(const uint3 DispatchThreadID : SV_DispatchThreadID)
+void main(const uint3 DispatchThreadID : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex)
 {
 	const uint numGroup = ceil(triangleCount / float(THREAD_COUNT));
 	const uint globalThreadId = FlattenID(DispatchThreadID, uint3(numGroup, 1, 1) * UINT3_GROUP_DIMs);
-	
+
+	if (groupIndex == 0)
+	{
+		GroupCulledCount = 0;
+		GroupDegenerateCount = 0;
+		GroupRejectedCount = 0;
+		GroupClippedCount = 0;
+		GroupMicroCount = 0;
+		GroupQuadCount = 0;
+		GroupRegularCount = 0;
+		GroupOverflowCount = 0;
+	}
+	GroupMemoryBarrierWithGroupSync();
+
+	// The slots past triangleCount belong to the clip triangles
+	SetupStats stats = (SetupStats)0;
+	if (globalThreadId < triangleCount)
+	{
+		RasterData data = SetupTriangle(globalThreadId, stats);
+		if (data.isClipped == 0)
+			RouteTriangle(globalThreadId, data, stats);
+		G_RASTER_DATA[globalThreadId] = data;
+	}
+
+	// Summed per group, one atomic on the counter per group
+	if (stats.culledCount != 0)
+		InterlockedAdd(GroupCulledCount, stats.culledCount);
+	if (stats.degenerateCount != 0)
+		InterlockedAdd(GroupDegenerateCount, stats.degenerateCount);
+	if (stats.rejectedCount != 0)
+		InterlockedAdd(GroupRejectedCount, stats.rejectedCount);
+	if (stats.clippedCount != 0)
+		InterlockedAdd(GroupClippedCount, stats.clippedCount);
+	if (stats.microCount != 0)
+		InterlockedAdd(GroupMicroCount, stats.microCount);
+	if (stats.quadCount != 0)
+		InterlockedAdd(GroupQuadCount, stats.quadCount);
+	if (stats.regularCount != 0)
+		InterlockedAdd(GroupRegularCount, stats.regularCount);
+	if (stats.overflowCount != 0)
+		InterlockedAdd(GroupOverflowCount, stats.overflowCount);
+	GroupMemoryBarrierWithGroupSync();
+
+	if (groupIndex == 0)
+	{
+		G_SETUP_COUNTER.InterlockedAdd(0, GroupCulledCount);
+		G_SETUP_COUNTER.InterlockedAdd(4, GroupDegenerateCount);
+		G_SETUP_COUNTER.InterlockedAdd(8, GroupRejectedCount);
+		G_SETUP_COUNTER.InterlockedAdd(12, GroupClippedCount);
+		G_SETUP_COUNTER.InterlockedAdd(20, GroupMicroCount);
+		G_SETUP_COUNTER.InterlockedAdd(24, GroupQuadCount);
+		G_SETUP_COUNTER.InterlockedAdd(28, GroupRegularCount);
+		G_SETUP_COUNTER.InterlockedAdd(32, GroupOverflowCount);
+	}
+}
+
+// Appends a triangle whose pixel bounds fit in one tile to the micro list of that tile, FineRasterizer3 point samples it there without binning
+void RouteTriangle(uint triIdx, inout RasterData data, inout SetupStats stats)
+{
+	// Inclusive pixel bounds, the tile past the viewport side has no micro list
+	const uint4 aabb = uint4(data.aabb.x >> 16, data.aabb.x & 0xffff, data.aabb.y >> 16, data.aabb.y & 0xffff);
+	const uint2 tile = aabb.xy / TILE_SIZE;
+	if (any(tile != aabb.zw / TILE_SIZE) || aabb.z >= (uint)VIEWPORT_WIDTH || aabb.w >= (uint)VIEWPORT_HEIGHT)
+	{
+		++stats.regularCount;
+		return;
+	}
+
+	const uint2 bin = tile / BIN_SIZE;
+	const uint2 binTile = tile % BIN_SIZE;
+	const uint tileIdx = (bin.y * BINNING_DIMS.x + bin.x) * BIN_TILE_COUNT + binTile.y * BIN_SIZE.x + binTile.x;
+
+	uint slot;
+	G_MICRO_TILE_COUNTER.InterlockedAdd(tileIdx * 4, 1, slot);
+	if (slot >= MICRO_TILE_CAPACITY)
+	{
+		++stats.regularCount;
+		++stats.overflowCount;
+		return;
+	}
+
+	G_MICRO_TILE_BUFFER.Store((tileIdx * MICRO_TILE_CAPACITY + slot) * 4, triIdx);
+	// Skipped by binning like the clipped triangles
+	data.isClipped = 1;
+	++stats.microCount;
+	if (all(aabb.zw - aabb.xy <= 1))
+		++stats.quadCount;
+}
+
+RasterData SetupTriangle(uint triIdx, inout SetupStats stats)
+{
 	RasterData data = (RasterData)0;
-	uint3 tri = G_INDEX_BUFFER.Load3(globalThreadId * 3 * 4);
+	data.isClipped = 1;
 
-	const float4 v0 = G_TRANS_VERTEX_BUFFER[tri.x].position;
-	const float4 v1 = G_TRANS_VERTEX_BUFFER[tri.y].position;
-	const float4 v2 = G_TRANS_VERTEX_BUFFER[tri.z].position;
+	// Past the visible triangles, flagged so binning skips the slot
+	if (triIdx >= G_VISIBLE_TRIANGLE_COUNT.Load(0))
+		return data;
 
-	data.isClipped = IsClipped(v0, VIEWPORT_WIDTH, VIEWPORT_HEIGHT) || IsClipped(v1, VIEWPORT_WIDTH, VIEWPORT_HEIGHT) || IsClipped(v2, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
-	if (!data.isClipped)
+	uint3 tri = LoadTriangle(G_INDEX_BUFFER, triIdx);
+#if defined(INDEX_16BIT)
+	// The (0, 0, 0) triangle ClusterCulling pads odd meshlets with, not counted so the degenerate count does not depend on the index format
+	if (all(tri == 0))
+		return data;
+#endif
+	if (tri.x == tri.y || tri.y == tri.z || tri.x == tri.z)
 	{
-		uint4 aabb = GetAabb(v0.xy, v1.xy, v2.xy);
+		++stats.degenerateCount;
+		return data;
+	}
+
+	Vertex_Out vertices[3] = { G_TRANS_VERTEX_BUFFER[tri.x], G_TRANS_VERTEX_BUFFER[tri.y], G_TRANS_VERTEX_BUFFER[tri.z] };
 
-		data.edgeEq[0] = v1.y - v2.y;
-		data.edgeEq[1] = v2.x - v1.x;
+	// All the vertices outside the same plane of the view volume
+	if ((vertices[0].outcode & vertices[1].outcode & vertices[2].outcode & REJECT_OUTCODE) != 0)
+	{
+		++stats.rejectedCount;
+		return data;
+	}
 
-		data.edgeEq[2] = v2.y - v0.y;
-		data.edgeEq[3] = v0.x - v2.x;
+	// Crossing the near or far plane or leaving the guard band, the slot stays skipped and the clip triangles are set up in their own
+	if (((vertices[0].outcode | vertices[1].outcode | vertices[2].outcode) & CLIP_OUTCODE) != 0)
+	{
+		ClipTriangle(vertices, stats);
+		return data;
+	}
 
-		data.edgeEq[4] = v0.y - v1.y;
-		data.edgeEq[5] = v1.x - v0.x;
+	return SetupRasterData(vertices[0].position, vertices[1].position, vertices[2].position, stats);
+}
 
-		data.edgeEq[6] = data.edgeEq[0] * aabb.x + data.edgeEq[1] * aabb.y + cross2d(v1.xy, v2.xy);
-		data.edgeEq[7] = data.edgeEq[2] * aabb.x + data.edgeEq[3] * aabb.y + cross2d(v2.xy, v0.xy);
-		data.edgeEq[8] = data.edgeEq[4] * aabb.x + data.edgeEq[5] * aabb.y + cross2d(v0.xy, v1.xy);
+void ClipTriangle(Vertex_Out vertices[3], inout SetupStats stats)
+{
+	// The vertices inside every clip plane are in screen space, back to clip space for the clipper
+	ClipVertex polygon[MAX_POLYGON_VERTICES];
+	float4 sourcePositions[3];
+	[unroll]
+	for (uint sourceIdx = 0; sourceIdx < 3; ++sourceIdx)
+	{
+		sourcePositions[sourceIdx] = (vertices[sourceIdx].outcode & CLIP_OUTCODE) != 0 ? vertices[sourceIdx].position : ScreenToClip(vertices[sourceIdx].position, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+		polygon[sourceIdx].position = sourcePositions[sourceIdx];
+		polygon[sourceIdx].normal = vertices[sourceIdx].normal;
+	}
 
-		data.aabb = uint2((aabb.x << 16) | aabb.y, (aabb.z << 16) | aabb.w);
-		data.invArea = 1.f / cross2d(v0.xy - v2.xy, v1.xy - v2.xy);
-		data.invZ = 1 / float3(v0.z, v1.z, v2.z);
+	const uint vCount = ClipPolygon(polygon, 3, CLIP_OUTCODE, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+	if (vCount < 3)
+	{
+		++stats.rejectedCount;
+		return;
 	}
 
-	G_RASTER_DATA[globalThreadId] = data;
+	// The vertices the clipper kept reuse their screen position, the round trip through clip space would not give it back bit for bit
+	Vertex_Out screenPolygon[MAX_POLYGON_VERTICES];
+	for (uint vIdx = 0; vIdx < vCount; ++vIdx)
+	{
+		screenPolygon[vIdx].position = ClipToScreen(polygon[vIdx].position, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+		screenPolygon[vIdx].normal = polygon[vIdx].normal;
+		screenPolygon[vIdx].outcode = 0;
+
+		[unroll]
+		for (uint sourceIdx = 0; sourceIdx < 3; ++sourceIdx)
+		{
+			if ((vertices[sourceIdx].outcode & CLIP_OUTCODE) == 0 && all(polygon[vIdx].position == sourcePositions[sourceIdx]))
+				screenPolygon[vIdx].position = vertices[sourceIdx].position;
+		}
+	}
+
+	// Face and degenerate tests on the whole polygon so a culled one claims no slot, with the winding of the fan
+	float doubleArea = 0.f;
+	for (uint fanIdx = 1; fanIdx + 1 < vCount; ++fanIdx)
+		doubleArea += cross2d(screenPolygon[0].position.xy - screenPolygon[fanIdx + 1].position.xy, screenPolygon[fanIdx].position.xy - screenPolygon[fanIdx + 1].position.xy);
+
+	if (IsDegenerate(doubleArea))
+	{
+		++stats.degenerateCount;
+		return;
+	}
+
+	if (IsCulled(doubleArea))
+	{
+		++stats.culledCount;
+		return;
+	}
+
+	++stats.clippedCount;
+
+	// Fanned from the first vertex, the slots past MAX_CLIP_TRIANGLES are counted and dropped
+	const uint fanCount = vCount - 2;
+	uint firstSlot;
+	G_SETUP_COUNTER.InterlockedAdd(16, fanCount, firstSlot);
+	for (uint fanIdx = 0; fanIdx < fanCount && firstSlot + fanIdx < MAX_CLIP_TRIANGLES; ++fanIdx)
+	{
+		const uint slot = firstSlot + fanIdx;
+		G_CLIP_VERTEX_BUFFER[slot * 3] = screenPolygon[0];
+		G_CLIP_VERTEX_BUFFER[slot * 3 + 1] = screenPolygon[fanIdx + 1];
+		G_CLIP_VERTEX_BUFFER[slot * 3 + 2] = screenPolygon[fanIdx + 2];
+
+		G_RASTER_DATA[triangleCount + slot] = SetupRasterData(screenPolygon[0].position, screenPolygon[fanIdx + 1].position, screenPolygon[fanIdx + 2].position, stats);
+	}
 }
 
-bool IsClipped(float4 vertex, float viewportWidth, float viewportHeight)
+// Snapping, face and degenerate tests and edge equations of a triangle in front of the near plane and inside the guard band
+RasterData SetupRasterData(float4 v0, float4 v1, float4 v2, inout SetupStats stats)
 {
-	return any(vertex.xyz < 0.f || vertex.xyz > float3(viewportWidth, viewportHeight, 1.f));
+	RasterData data = (RasterData)0;
+	data.isClipped = 1;
+
+	uint4 aabb = GetAabb(v0.xy, v1.xy, v2.xy);
+
+#if defined(FIXED_POINT_RASTER)
+	const int2 s0 = SnapToSubpixel(v0.xy);
+	int2 s1 = SnapToSubpixel(v1.xy);
+	int2 s2 = SnapToSubpixel(v2.xy);
+
+	// Of the snapped vertices, the ones the edge functions are built from
+	const float doubleArea = cross2d(float2(s0 - s2), float2(s1 - s2));
+#else
+	float2 p1 = v1.xy;
+	float2 p2 = v2.xy;
+	const float doubleArea = cross2d(v0.xy - v2.xy, v1.xy - v2.xy);
+#endif
+
+	if (IsDegenerate(doubleArea))
+	{
+		++stats.degenerateCount;
+		return data;
+	}
+
+	if (IsCulled(doubleArea))
+	{
+		++stats.culledCount;
+		return data;
+	}
+
+	data.isClipped = 0;
+
+#if defined(FIXED_POINT_RASTER)
+	// A drawn back face, its edge functions are built in front face order
+	if (doubleArea < 0.f)
+	{
+		const int2 swap = s1;
+		s1 = s2;
+		s2 = swap;
+	}
+
+	data.edgeEq[0] = asfloat(s0.x);
+	data.edgeEq[1] = asfloat(s0.y);
+	data.edgeEq[2] = asfloat(s1.x);
+	data.edgeEq[3] = asfloat(s1.y);
+	data.edgeEq[4] = asfloat(s2.x);
+	data.edgeEq[5] = asfloat(s2.y);
+
+	// Edge i is opposite to vertex i and starts at the next one, like the float equations
+	data.edgeEq[6] = asfloat(GetEdgeThreshold(s1.y - s2.y, s2.x - s1.x, s1));
+	data.edgeEq[7] = asfloat(GetEdgeThreshold(s2.y - s0.y, s0.x - s2.x, s2));
+	data.edgeEq[8] = asfloat(GetEdgeThreshold(s0.y - s1.y, s1.x - s0.x, s0));
+
+	// The edge functions are 1/256 of the sub pixel area, the weights stay area ratios
+	data.invArea = SUBPIXEL_SCALE / doubleArea;
+#else
+	if (doubleArea < 0.f)
+	{
+		const float2 swap = p1;
+		p1 = p2;
+		p2 = swap;
+	}
+
+	data.edgeEq[0] = p1.y - p2.y;
+	data.edgeEq[1] = p2.x - p1.x;
+
+	data.edgeEq[2] = p2.y - v0.y;
+	data.edgeEq[3] = v0.x - p2.x;
+
+	data.edgeEq[4] = v0.y - p1.y;
+	data.edgeEq[5] = p1.x - v0.x;
+
+	data.edgeEq[6] = data.edgeEq[0] * aabb.x + data.edgeEq[1] * aabb.y + cross2d(p1, p2);
+	data.edgeEq[7] = data.edgeEq[2] * aabb.x + data.edgeEq[3] * aabb.y + cross2d(p2, v0.xy);
+	data.edgeEq[8] = data.edgeEq[4] * aabb.x + data.edgeEq[5] * aabb.y + cross2d(v0.xy, p1);
+
+	data.invArea = 1.f / doubleArea;
+#endif
+
+	data.aabb = uint2((aabb.x << 16) | aabb.y, (aabb.z << 16) | aabb.w);
+	data.invZ = 1 / float3(v0.z, v1.z, v2.z);
+	return data;
 }
 
+// Clamped to the viewport, the guard band reaches past it
 uint4 GetAabb(float2 v0, float2 v1, float2 v2)
 {
 	float4 aabb;
-	aabb.xy = min(v0.xy, min(v1.xy, v2.xy));
-	aabb.zw = ceil(max(v0.xy, max(v1.xy, v2.xy)));
+	aabb.xy = max(min(v0.xy, min(v1.xy, v2.xy)), 0.f);
+	aabb.zw = min(ceil(max(v0.xy, max(v1.xy, v2.xy))), float2(VIEWPORT_WIDTH, VIEWPORT_HEIGHT));
 	return aabb;
 }
\ No newline at end of file
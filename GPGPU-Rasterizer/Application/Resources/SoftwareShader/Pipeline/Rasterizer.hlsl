@@ -1,11 +1,7 @@
 #include "../Libs/Common.hlsli"
+#include "../Libs/RasterConfig.hlsli"
 
-#define VIEWPORT_WIDTH 1920.f
-#define VIEWPORT_HEIGHT 1080.f
-#define BIN_SIZE uint2(64, 64)
-#define BIN_PixelCount BIN_SIZE.x * BIN_SIZE.y
-#define BINNING_DIMS uint2(ceil(VIEWPORT_WIDTH / BIN_SIZE.x), ceil(VIEWPORT_HEIGHT / BIN_SIZE.y))
-#define BIN_COUNT BINNING_DIMS.x * BINNING_DIMS.y
+#define BIN_PixelCount BIN_PIXEL_SIZE.x * BIN_PIXEL_SIZE.y
 #define BIN_UINT_COUNT (uint)ceil(BIN_COUNT / 32.f)
 
 #define GROUP_X 32
@@ -53,7 +49,7 @@ void main(uint groupIndex : SV_GroupIndex, uint3 dispatchID : SV_GroupId)
 		if (triData.isClipped)
 			continue;
 
-		uint4 binAabb = uint4(triData.aabb.x >> 16, triData.aabb.x & 0xffff, triData.aabb.y >> 16, triData.aabb.y & 0xffff) / BIN_SIZE.xyxy;
+		uint4 binAabb = uint4(triData.aabb.x >> 16, triData.aabb.x & 0xffff, triData.aabb.y >> 16, triData.aabb.y & 0xffff) / BIN_PIXEL_SIZE.xyxy;
 		for (uint x = binAabb.x; x <= binAabb.z; ++x)
 		{
 			for (uint y = binAabb.y; y <= binAabb.w; ++y)
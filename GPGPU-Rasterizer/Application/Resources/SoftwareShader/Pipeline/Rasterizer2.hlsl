@@ -1,10 +1,7 @@
 #include "../Libs/Common.hlsli"
+#include "../Libs/RasterConfig.hlsli"
 
-#define VIEWPORT_WIDTH 1920.f
-#define VIEWPORT_HEIGHT 1080.f
-#define BIN_SIZE uint2(64, 64)
-#define BIN_PixelCount BIN_SIZE.x * BIN_SIZE.y
-#define BINNING_DIMS uint2(ceil(VIEWPORT_WIDTH / BIN_SIZE.x), ceil(VIEWPORT_HEIGHT / BIN_SIZE.y))
+#define BIN_PixelCount BIN_PIXEL_SIZE.x * BIN_PIXEL_SIZE.y
 
 #define GROUP_X 32
 #define GROUP_Y 32
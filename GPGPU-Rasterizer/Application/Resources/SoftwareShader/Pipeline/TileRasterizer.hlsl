@@ -1,12 +1,9 @@
+#include "../Libs/BinList.hlsli"
+#include "../Libs/Clipping.hlsli"
 #include "../Libs/Common.hlsli"
-
-#define VIEWPORT_WIDTH 1280.f
-#define VIEWPORT_HEIGHT 720.f
-#define TILE_SIZE uint2(8, 8)
-#define BIN_SIZE uint2(8, 8)
-#define BIN_PIXEL_SIZE (BIN_SIZE * TILE_SIZE)
-#define BINNING_DIMS uint2(ceil(VIEWPORT_WIDTH / BIN_PIXEL_SIZE.x), ceil(VIEWPORT_HEIGHT / BIN_PIXEL_SIZE.y))
-#define BIN_COUNT (BINNING_DIMS.x * BINNING_DIMS.y)
+#include "../Libs/FixedPointEdges.hlsli"
+#include "../Libs/RasterConfig.hlsli"
+#include "../Libs/RectCoverage.hlsli"
 
 #define GROUP_X 32
 #define GROUP_Y 4
@@ -14,6 +11,10 @@
 #define GROUP_DIMs GROUP_X, GROUP_Y, 1
 #define UINT3_GROUP_DIMs uint3(GROUP_DIMs)
 
+// A triangle covering a whole tile bounds the depth of its pixels by its farthest vertex, past it by this margin for the rounding of the interpolated depths.
+// Only the triangles behind that bound are rejected, a tied one still wins the depth test when it comes first
+#define OCCLUDER_DEPTH_MARGIN (1.f + 1.f / 4096.f)
+
 cbuffer ObjectInfo : register(b0)
 {
 	float4x4 worldViewProj;
@@ -32,28 +33,43 @@ struct RasterData
 	uint isClipped;
 };
 
+// fullCoverage holds the tiles the triangle covers entirely, FineRasterizer3 skips their edge tests
 struct BinData
 {
 	uint2 coverage;
+	uint2 fullCoverage;
 	uint triIdx;
 };
 
+// Varint deltas of the triangles of the bins, decoded from the block headers of G_BIN_HEADER
 ByteAddressBuffer G_BIN_BUFFER : register(t0);
 StructuredBuffer<RasterData> G_RASTER_DATA : register(t1);
+// Per bin then per queue, the offsets of BinScan into G_TILE_BUFFER, G_BIN_HEADER and G_BIN_BUFFER, their totals past them
+ByteAddressBuffer G_BIN_OFFSET : register(t2);
+ByteAddressBuffer G_BIN_HEADER : register(t3);
 
 RWByteAddressBuffer G_BIN_COUNTER : register(u2);
-RWByteAddressBuffer G_BIN_TRI_COUNTER : register(u3);
+// Bins then tiles the aabb of a triangle overlaps and its edges miss, the tiles at offset 4
+RWByteAddressBuffer G_OVERLAP_COUNTER : register(u3);
+// The BinData of every triangle of a bin, its queues back to back
 RWStructuredBuffer<BinData> G_TILE_BUFFER : register(u4);
+// Min and max depth of the screen tiles, row by row, written by the fine stage, the max seeds the occluder depths of the bin tiles
+RWStructuredBuffer<float2> G_HIZ_BUFFER : register(u5);
+RWByteAddressBuffer G_HIZ_COUNTER : register(u6);
 
-uint2 GetCoverage(uint4 clampedAabb, uint2 binSize);
+BinData GetBinData(uint tri, uint4 binAabb, inout uint rejectedCount, inout uint missedCount);
+uint2 GetCoverage(uint4 clampedAabb, uint2 binSize, uint2 binTile, float triMinDepth, RasterData rData, bool isBinCovered, out uint2 fullCoverage, inout uint rejectedCount, inout uint missedCount);
+bool IsInsideAabb(RasterData rData, uint2 minPixel, uint2 maxPixel);
 
 groupshared uint GroupBin;
+// Max depth of the bin tiles from the Hi-Z of the earlier draws, FLT_MAX past the viewport, lowered by the triangles of the bin covering them
+// Depths are positive floats, their bits compare in the same order, hence the uint atomics
+groupshared uint GroupTileMaxDepth[BIN_TILE_COUNT];
 
 [numthreads(GROUP_DIMs)]
 void main(int threadId : SV_GroupIndex)
 {
-	const uint queueCount = 16;
-	const uint batchSize = ceil(triangleCount / (float)queueCount);
+	const uint queueCount = QUEUE_COUNT;
 
 	if (threadId == 0)
 	{
@@ -63,65 +79,123 @@ void main(int threadId : SV_GroupIndex)
 	GroupMemoryBarrierWithGroupSync();
 
 	uint binIdx = GroupBin;
-	if (binIdx >= BIN_COUNT) // BIN_COUNT = 15 * 9
+	if (binIdx >= BIN_COUNT)
 		return;
 
-	uint tileDataStart = binIdx * batchSize * queueCount;
-	uint queueDataStart = binIdx * (batchSize + 1) * queueCount;
-	uint triCount = G_BIN_BUFFER.Load(queueDataStart * 4);
-	uint totalCount = 0;
-	uint queueId = 0;
+	uint tileCapacity, tileStride, headerCapacity, streamCapacity;
+	G_TILE_BUFFER.GetDimensions(tileCapacity, tileStride);
+	G_BIN_HEADER.GetDimensions(headerCapacity);
+	G_BIN_BUFFER.GetDimensions(streamCapacity);
+	const uint binStart = G_BIN_OFFSET.Load(BIN_TRIANGLE_OFFSET + binIdx * queueCount * 4);
+	const uint binEnd = G_BIN_OFFSET.Load(BIN_TRIANGLE_OFFSET + (binIdx + 1) * queueCount * 4);
+	const uint blockStart = G_BIN_OFFSET.Load(BIN_BLOCK_OFFSET + binIdx * queueCount * 4);
+	const uint blockEnd = G_BIN_OFFSET.Load(BIN_BLOCK_OFFSET + (binIdx + 1) * queueCount * 4);
+	const uint wordEnd = G_BIN_OFFSET.Load(BIN_WORD_OFFSET + (binIdx + 1) * queueCount * 4);
+
+	// A bin whose triangles, headers or deltas went past a buffer was not fully stored, it is drawn empty until Pipeline grows them
+	// The fine stage reads its triangles from G_TILE_BUFFER, they are cleared so it skips them
+	if (binEnd > tileCapacity || blockEnd * BIN_HEADER_SIZE > headerCapacity || wordEnd * 4 > streamCapacity)
+	{
+		for (uint clearIndex = binStart + (uint)threadId; clearIndex < min(binEnd, tileCapacity); clearIndex += THREAD_COUNT)
+			G_TILE_BUFFER[clearIndex] = (BinData)0;
+		return;
+	}
 
 	uint4 binAabb;
-	binAabb.xy = uint2(binIdx % BINNING_DIMS.x, binIdx / BINNING_DIMS.x) * BIN_PIXEL_SIZE; // BIN_PIXEL_SIZE uint2(128, 128)
+	binAabb.xy = uint2(binIdx % BINNING_DIMS.x, binIdx / BINNING_DIMS.x) * BIN_PIXEL_SIZE;
 	binAabb.zw = binAabb.xy + BIN_PIXEL_SIZE;
-	uint dataIndex = threadId;
+	for (uint binTileId = (uint)threadId; binTileId < BIN_TILE_COUNT; binTileId += THREAD_COUNT)
+	{
+		const uint2 tile = binAabb.xy / TILE_SIZE + uint2(binTileId % BIN_SIZE.x, binTileId / BIN_SIZE.x);
+		GroupTileMaxDepth[binTileId] = all(tile < HIZ_DIMS) ? asuint(G_HIZ_BUFFER[tile.y * HIZ_DIMS.x + tile.x].y) : 0x7F7FFFFF; // FLT_MAX
+	}
+	GroupMemoryBarrierWithGroupSync();
+
+	uint rejectedCount = 0;
+	uint missedCount = 0;
 
-	for (;;)
+	// A thread per block, its triangles are the running sum of the deltas from the first one of the header
+	for (uint blockIdx = blockStart + (uint)threadId; blockIdx < blockEnd; blockIdx += THREAD_COUNT)
 	{
-		if (dataIndex < triCount)
-		{
-			const uint tri = G_BIN_BUFFER.Load((queueDataStart + 1 + dataIndex) * 4);
-			const uint2 aabb_16 = G_RASTER_DATA[tri].aabb;
-			uint4 triAabb = uint4(aabb_16.x >> 16, aabb_16.x & 0xffff, aabb_16.y >> 16, aabb_16.y & 0xffff);
-			triAabb = clamp(triAabb, binAabb.xyxy, binAabb.zwzw) - binAabb.xyxy;
-			triAabb.xy = triAabb.xy / TILE_SIZE;
-			triAabb.zw = ceil(triAabb.zw / (float2)TILE_SIZE);
-			BinData data = (BinData)0;
-			data.coverage = GetCoverage(triAabb, BIN_SIZE);
-			data.triIdx = tri;
-			G_TILE_BUFFER[tileDataStart + totalCount + dataIndex] = data;
-
-			dataIndex += THREAD_COUNT;
-		}
-		else
+		const uint3 header = G_BIN_HEADER.Load3(blockIdx * BIN_HEADER_SIZE);
+		const uint dataStart = GetBlockEntry(header.z);
+		const uint blockTriCount = GetBlockTriangleCount(header.z);
+		uint tri = header.x;
+		uint byteOffset = header.y;
+		for (uint blockTri = 0; blockTri < blockTriCount; ++blockTri)
 		{
-			++queueId;
-			totalCount += triCount;
-			if (queueId >= queueCount)
-				break;
-
-			queueDataStart += batchSize + 1;
-			dataIndex -= triCount;
-			triCount = G_BIN_BUFFER.Load(queueDataStart * 4);
+			if (blockTri != 0)
+				tri += ReadVarint(G_BIN_BUFFER, byteOffset) + 1;
+			G_TILE_BUFFER[dataStart + blockTri] = GetBinData(tri, binAabb, rejectedCount, missedCount);
 		}
 	}
 
-	if (threadId == 0)
-		G_BIN_TRI_COUNTER.Store(binIdx * 4, totalCount);
+	if (rejectedCount != 0)
+		G_HIZ_COUNTER.InterlockedAdd(0, rejectedCount);
+	if (missedCount != 0)
+		G_OVERLAP_COUNTER.InterlockedAdd(4, missedCount);
 }
 
-uint2 GetCoverage(uint4 clampedAabb, uint2 binSize)
+BinData GetBinData(uint tri, uint4 binAabb, inout uint rejectedCount, inout uint missedCount)
+{
+	const RasterData rData = G_RASTER_DATA[tri];
+	const uint2 aabb_16 = rData.aabb;
+	uint4 triAabb = uint4(aabb_16.x >> 16, aabb_16.x & 0xffff, aabb_16.y >> 16, aabb_16.y & 0xffff);
+	triAabb = clamp(triAabb, binAabb.xyxy, binAabb.zwzw) - binAabb.xyxy;
+	triAabb.xy = triAabb.xy / TILE_SIZE;
+	triAabb.zw = ceil(triAabb.zw / (float2)TILE_SIZE);
+	BinData data = (BinData)0;
+	const float triMinDepth = 1.f / max(rData.invZ.x, max(rData.invZ.y, rData.invZ.z));
+	// Trivial accept of the whole bin, its tiles are not tested one by one
+	const bool isBinCovered = IsInsideAabb(rData, binAabb.xy, binAabb.zw - 1) && IsRectCovered(rData.edgeEq, rData.aabb.x, binAabb.xy, binAabb.zw - 1);
+	data.coverage = GetCoverage(triAabb, BIN_SIZE, binAabb.xy / TILE_SIZE, triMinDepth, rData, isBinCovered, data.fullCoverage, rejectedCount, missedCount);
+	data.triIdx = tri;
+	return data;
+}
+
+// Tiles the edges miss and tiles already nearer than the nearest vertex of the triangle are left out, the ones it covers bound the depth of the later triangles, the ones inside its pixel bounds are tested for full coverage
+uint2 GetCoverage(uint4 clampedAabb, uint2 binSize, uint2 binTile, float triMinDepth, RasterData rData, bool isBinCovered, out uint2 fullCoverage, inout uint rejectedCount, inout uint missedCount)
 {
 	uint coverageMask[2] = { 0, 0 };
+	uint fullMask[2] = { 0, 0 };
+	// Once shaded, no pixel of a tile the triangle covers is farther than its farthest vertex, the triangles tested after it see that bound
+	const float occluderDepth = OCCLUDER_DEPTH_MARGIN / min(rData.invZ.x, min(rData.invZ.y, rData.invZ.z));
 	for (uint y = clampedAabb.y; y < clampedAabb.w; ++y)
 	{
 		for (uint x = clampedAabb.x; x < clampedAabb.z; ++x)
 		{
+			const uint2 tile = binTile + uint2(x, y);
+			const uint2 tilePixel = tile * TILE_SIZE;
+			if (!isBinCovered && !IsRectOverlapped(rData.edgeEq, rData.aabb, tilePixel, tilePixel + TILE_SIZE - 1))
+			{
+				++missedCount;
+				continue;
+			}
+
 			const uint bitOffset = y * binSize.x + x;
+			if (triMinDepth >= asfloat(GroupTileMaxDepth[bitOffset]))
+			{
+				++rejectedCount;
+				continue;
+			}
+
 			coverageMask[bitOffset / 32] |= 1 << (bitOffset % 32);
+
+			if (isBinCovered || (IsInsideAabb(rData, tilePixel, tilePixel + TILE_SIZE - 1) && IsRectCovered(rData.edgeEq, rData.aabb.x, tilePixel, tilePixel + TILE_SIZE - 1)))
+			{
+				fullMask[bitOffset / 32] |= 1 << (bitOffset % 32);
+				InterlockedMin(GroupTileMaxDepth[bitOffset], asuint(occluderDepth));
+			}
 		}
 	}
 
+	fullCoverage = uint2(fullMask[0], fullMask[1]);
 	return uint2( coverageMask[0], coverageMask[1] );
+}
+
+// Whether the inclusive pixel rect lies in the inclusive pixel bounds of the triangle, only those can be covered entirely
+bool IsInsideAabb(RasterData rData, uint2 minPixel, uint2 maxPixel)
+{
+	const uint4 triAabb = uint4(rData.aabb.x >> 16, rData.aabb.x & 0xffff, rData.aabb.y >> 16, rData.aabb.y & 0xffff);
+	return all(minPixel >= triAabb.xy && maxPixel <= triAabb.zw);
 }
\ No newline at end of file
@@ -1,7 +1,6 @@
+#include "../Libs/Clipping.hlsli"
 #include "../Libs/Common.hlsli"
-
-#define VIEWPORT_WIDTH 1280.f
-#define VIEWPORT_HEIGHT 720.f
+#include "../Libs/RasterConfig.hlsli"
 
 #define GROUP_X 32
 #define GROUP_Y 16
@@ -17,11 +16,12 @@ struct Vertex_In
 	float pad2;
 };
 
+// Screen position with w = 1 / clip w, or still in clip space when the outcode has a CLIP_OUTCODE plane
 struct Vertex_Out
 {
 	float4 position;
 	float3 normal;
-	float pad;
+	uint outcode;
 };
 
 cbuffer ObjectInfo : register(b0)
@@ -31,11 +31,19 @@ cbuffer ObjectInfo : register(b0)
 	uint vertexCount;
 	uint triangleCount;
 	uint indexCount;
+	float3 positionOffset;
+	float3 positionScale;
 }
 
+#if defined(QUANTIZED_VERTICES)
+// VertexQuantizer::QuantizedVertex: x = position.x | position.y << 16, y = position.z | normal.x << 16 | normal.y << 24
+StructuredBuffer<uint2> G_VERTEX_BUFFER;
+#else
 StructuredBuffer<Vertex_In> G_VERTEX_BUFFER;
+#endif
 RWStructuredBuffer<Vertex_Out> G_TRANS_VERTEX_BUFFER : register(u2);
 
+Vertex_In LoadVertex(uint vIdx);
 Vertex_Out Transform(Vertex_In v);
 void ProjectionToNDC(inout float4 vPos);
 void NDCToScreen(inout float4 vPos, float viewportWidth, float viewportHeight);
@@ -46,16 +54,49 @@ void main(const uint3 DispatchThreadID : SV_DispatchThreadID)
 	const uint numGroup = ceil(vertexCount / float(THREAD_COUNT));
 	const uint globalThreadId = FlattenID(DispatchThreadID, uint3(numGroup, 1, 1) * UINT3_GROUP_DIMs);
 
-	Vertex_In v = G_VERTEX_BUFFER[globalThreadId];
+	Vertex_In v = LoadVertex(globalThreadId);
 
 	Vertex_Out vOut = Transform(v);
 
-	ProjectionToNDC(vOut.position);
-	NDCToScreen(vOut.position, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+	// A vertex the clipper may cut keeps its clip space position, behind the eye the screen one is meaningless
+	vOut.outcode = GetOutcode(vOut.position, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+	if ((vOut.outcode & CLIP_OUTCODE) == 0)
+	{
+		ProjectionToNDC(vOut.position);
+		NDCToScreen(vOut.position, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+	}
 
 	G_TRANS_VERTEX_BUFFER[globalThreadId] = vOut;
 }
 
+#if defined(QUANTIZED_VERTICES)
+float3 OctDecode(float2 e)
+{
+	float3 n = float3(e, 1.f - abs(e.x) - abs(e.y));
+	const float t = saturate(-n.z);
+	n.xy += n.xy >= 0.f ? -t : t;
+	return normalize(n);
+}
+
+Vertex_In LoadVertex(uint vIdx)
+{
+	const uint2 packed = G_VERTEX_BUFFER[vIdx];
+
+	Vertex_In v = (Vertex_In) 0;
+	v.position = positionOffset + float3(packed.x & 0xFFFF, packed.x >> 16, packed.y & 0xFFFF) * positionScale;
+
+	// Sign extend the two snorm8 components
+	const int2 octNormal = asint(uint2(packed.y << 8, packed.y)) >> 24;
+	v.normal = OctDecode(max(octNormal / 127.f, -1.f));
+	return v;
+}
+#else
+Vertex_In LoadVertex(uint vIdx)
+{
+	return G_VERTEX_BUFFER[vIdx];
+}
+#endif
+
 Vertex_Out Transform(Vertex_In v)
 {
 	Vertex_Out vOut = (Vertex_Out) 0;
@@ -0,0 +1,120 @@
+#include "../Libs/Clipping.hlsli"
+#include "../Libs/Common.hlsli"
+#include "../Libs/FixedPointEdges.hlsli"
+#include "../Libs/IndexBuffer.hlsli"
+#include "../Libs/RasterConfig.hlsli"
+#include "../Libs/TriangleCulling.hlsli"
+#include "../Libs/VisibilityBuffer.hlsli"
+
+// Full screen pass of VISIBILITY_BUFFER, shades every pixel FineRasterizer3 gave a triangle id once, one group per tile
+#define GROUP_X RASTER_TILE_SIZE
+#define GROUP_Y RASTER_TILE_SIZE
+#define GROUP_DIMs GROUP_X, GROUP_Y, 1
+
+#define LIGHT_DIR float3(0.577f, -0.577f, 0.577f)
+#define LIGHT_INTENSITY 4.f
+#define PI 3.14159265358979323846f
+
+cbuffer ObjectInfo : register(b0)
+{
+	float4x4 worldViewProj;
+	float4x4 world;
+	uint vertexCount;
+	uint triangleCount;
+	uint indexCount;
+}
+
+struct Vertex_Out
+{
+	float4 position;
+	float3 normal;
+	uint outcode;
+};
+
+struct RasterData
+{
+	float edgeEq[9];
+	float3 invZ;
+	uint2 aabb;
+	float invArea;
+	uint isClipped;
+};
+
+StructuredBuffer<RasterData> G_RASTER_DATA : register(t0);
+StructuredBuffer<Vertex_Out> G_TRANS_VERTEX_BUFFER : register(t1);
+ByteAddressBuffer G_INDEX_BUFFER : register(t2);
+StructuredBuffer<Vertex_Out> G_CLIP_VERTEX_BUFFER : register(t3);
+
+RWTexture2D<unorm float4> G_RENDER_TARGET : register(u0);
+RWTexture2D<uint> G_VISIBILITY_BUFFER : register(u3);
+
+// Vertices of a raster triangle, the clip triangles past triangleCount have their own
+void LoadTriangleVertices(uint triIdx, out Vertex_Out v0, out Vertex_Out v1, out Vertex_Out v2)
+{
+	if (triIdx >= triangleCount)
+	{
+		const uint clipVertexIdx = (triIdx - triangleCount) * 3;
+		v0 = G_CLIP_VERTEX_BUFFER[clipVertexIdx];
+		v1 = G_CLIP_VERTEX_BUFFER[clipVertexIdx + 1];
+		v2 = G_CLIP_VERTEX_BUFFER[clipVertexIdx + 2];
+		return;
+	}
+
+	const uint3 tri = LoadTriangle(G_INDEX_BUFFER, triIdx);
+	v0 = G_TRANS_VERTEX_BUFFER[tri.x];
+	v1 = G_TRANS_VERTEX_BUFFER[tri.y];
+	v2 = G_TRANS_VERTEX_BUFFER[tri.z];
+}
+
+// One group per tile of FineRasterizer3, the weights are rebuilt with the exact steps it took, or its float estimates of the clamped edges
+[numthreads(GROUP_DIMs)]
+void main(uint3 groupId : SV_GroupID, uint3 groupThreadId : SV_GroupThreadID)
+{
+	const uint2 tileMin = groupId.xy * TILE_SIZE;
+	const uint2 pixel = tileMin + groupThreadId.xy;
+
+	const uint id = G_VISIBILITY_BUFFER[pixel];
+	if (id == VISIBILITY_EMPTY)
+		return;
+
+	const uint triIdx = GetVisibilityTriangle(id);
+	const RasterData rData = G_RASTER_DATA[triIdx];
+
+#if defined(FIXED_POINT_RASTER)
+	const int2 s0 = asint(float2(rData.edgeEq[0], rData.edgeEq[1]));
+	const int2 s1 = asint(float2(rData.edgeEq[2], rData.edgeEq[3]));
+	const int2 s2 = asint(float2(rData.edgeEq[4], rData.edgeEq[5]));
+	const int3 a = int3(s1.y - s2.y, s2.y - s0.y, s0.y - s1.y);
+	const int3 b = int3(s2.x - s1.x, s0.x - s2.x, s1.x - s0.x);
+
+	// Evaluated at the tile min corner then stepped, the clamped values of the fine stage
+	const int3 tileEdges = int3(EvaluateEdge(a.x, b.x, s1, asint(rData.edgeEq[6]), tileMin)
+		, EvaluateEdge(a.y, b.y, s2, asint(rData.edgeEq[7]), tileMin)
+		, EvaluateEdge(a.z, b.z, s0, asint(rData.edgeEq[8]), tileMin));
+	const int3 cy = tileEdges + b * (int)groupThreadId.y;
+	const int3 cx = cy + a * (int)groupThreadId.x;
+
+	// A clamped tile value only keeps the sign of its edge, the weights of its pixels step the float estimate instead, like the fine stage
+	const float2 weightOrigin = float2(EstimateEdge(a.x, b.x, s1, asint(rData.edgeEq[6]), tileMin), EstimateEdge(a.y, b.y, s2, asint(rData.edgeEq[7]), tileMin));
+	const float2 estimate = weightOrigin + float2(a.xy) * (float)groupThreadId.x + float2(b.xy) * (float)groupThreadId.y;
+	const float2 weightCx = abs(tileEdges.xy) >= EDGE_CLAMP ? estimate : float2(cx.xy);
+#else
+	const uint2 startPixel = uint2(rData.aabb.x >> 16, rData.aabb.x & 0xffff);
+	const float3 cy = float3(rData.edgeEq[6], rData.edgeEq[7], rData.edgeEq[8]) + float3(rData.edgeEq[1], rData.edgeEq[3], rData.edgeEq[5]) * ((int)pixel.y - (int)startPixel.y);
+	const float3 cx = cy + float3(rData.edgeEq[0], rData.edgeEq[2], rData.edgeEq[4]) * ((int)pixel.x - (int)startPixel.x);
+	const float2 weightCx = cx.xy;
+#endif
+
+	const float3 weights = GetWeights(weightCx, rData.invArea);
+
+	Vertex_Out v0, v1, v2;
+	LoadTriangleVertices(triIdx, v0, v1, v2);
+
+	const float w = 1 / dot(float3(v0.position.w, v1.position.w, v2.position.w), weights);
+	float3 n = (v0.normal * weights.x + v1.normal * weights.y + v2.normal * weights.z) * w;
+	n = normalize(n);
+	float diffuseStrength = saturate(dot(n, -LIGHT_DIR)) * LIGHT_INTENSITY;
+	diffuseStrength /= PI;
+
+	G_RENDER_TARGET[pixel] = float4(float3(0.5f, 0.5f, 0.5f) * diffuseStrength, 1.f);
+}
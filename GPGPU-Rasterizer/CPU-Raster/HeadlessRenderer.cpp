@@ -0,0 +1,290 @@
+#include "pch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include "Common/MeshCache.h"
+#include "Common/MeshSimplifier.h"
+#include "Renderer/FrameBuffer.h"
+#include "Renderer/Pipeline.h"
+
+// Renders a model with the CPU implementation of the binned compute pipeline, without D3D11 or a window, and reports the time of every stage.
+// Builds outside Visual Studio from the CMakeLists.txt next to GPGPU-Rasterizer.sln, which only needs DirectXMath.
+// Usage: CPU-Raster <model.obj> [-o <image.tga>] [-f <frame count>] [-t <worker threads>] [-l <level of detail>] [-s <scalar|sse2|avx2>] [-r <float|fixed>] [-v] [-c <none|back|front>] [-d <distance>] [-q]
+//	[-w <width>] [-h <height>] [-tile <tile size>] [-bin <bin size>] [-queues <queue count>]
+
+namespace
+{
+	constexpr float CAMERA_FOV_DEG{ 45.f };
+	constexpr float CAMERA_NEAR_PLANE{ 0.1f };
+	constexpr float CAMERA_FAR_PLANE{ 1000000.f };
+
+	// Looks down +z at the whole bounding sphere, with the projection Camera builds, from distanceScale times the framing distance
+	DirectX::XMFLOAT4X4 GetFramingViewProjection(const MeshData& meshData, float distanceScale, float aspectRatio)
+	{
+		using namespace DirectX;
+
+		XMFLOAT3 center{};
+		float radius{};
+		MeshSimplifier::ComputeBoundingSphere(meshData.vertices, center, radius);
+
+		const float fov{ XMConvertToRadians(CAMERA_FOV_DEG) };
+		const float distance{ radius / std::sin(fov * 0.5f) * distanceScale };
+		const XMVECTOR position{ XMLoadFloat3(&center) - XMVectorSet(0.f, 0.f, distance, 0.f) };
+
+		const XMMATRIX view{ XMMatrixLookToLH(position, XMVectorSet(0.f, 0.f, 1.f, 0.f), XMVectorSet(0.f, 1.f, 0.f, 0.f)) };
+		const XMMATRIX projection{ XMMatrixPerspectiveFovLH(fov, aspectRatio, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE) };
+
+		XMFLOAT4X4 viewProjection{};
+		XMStoreFloat4x4(&viewProjection, view * projection);
+		return viewProjection;
+	}
+
+	bool ParseCount(const char* pvalue, uint32_t& count)
+	{
+		char* pend{ nullptr };
+		const unsigned long value{ std::strtoul(pvalue, &pend, 10) };
+		if (pend == pvalue || *pend != '\0')
+			return false;
+
+		count = static_cast<uint32_t>(value);
+		return true;
+	}
+
+	bool ParseScale(const char* pvalue, float& scale)
+	{
+		char* pend{ nullptr };
+		const float value{ std::strtof(pvalue, &pend) };
+		if (pend == pvalue || *pend != '\0' || !(value >= 0.f))
+			return false;
+
+		scale = value;
+		return true;
+	}
+
+	bool ParseInstructionSet(const std::string& value, CpuRaster::EInstructionSet& instructionSet)
+	{
+		if (value == "scalar")
+			instructionSet = CpuRaster::EInstructionSet::Scalar;
+		else if (value == "sse2")
+			instructionSet = CpuRaster::EInstructionSet::SSE2;
+		else if (value == "avx2")
+			instructionSet = CpuRaster::EInstructionSet::AVX2;
+		else
+			return false;
+
+		return true;
+	}
+
+	bool ParseRasterMode(const std::string& value, ERasterMode& rasterMode)
+	{
+		if (value == "float")
+			rasterMode = ERasterMode::Float;
+		else if (value == "fixed")
+			rasterMode = ERasterMode::FixedPoint;
+		else
+			return false;
+
+		return true;
+	}
+
+	bool ParseCullMode(const std::string& value, ECullMode& cullMode)
+	{
+		if (value == "none")
+			cullMode = ECullMode::None;
+		else if (value == "back")
+			cullMode = ECullMode::Back;
+		else if (value == "front")
+			cullMode = ECullMode::Front;
+		else
+			return false;
+
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::wcout << L"Usage: CPU-Raster <model.obj> [-o <image.tga>] [-f <frame count>] [-t <worker threads>] [-l <level of detail>] [-s <scalar|sse2|avx2>] [-r <float|fixed>] [-v] [-c <none|back|front>] [-d <distance>] [-q]\n"
+			<< L"\t[-w <width>] [-h <height>] [-tile <tile size>] [-bin <bin size>] [-queues <queue count>]\n"
+			<< L"\t-o : writes the last frame to a TGA image\n"
+			<< L"\t-f : frames rendered, the stage times are averaged over them (default 1)\n"
+			<< L"\t-t : threads running the groups of a stage (default one per hardware thread)\n"
+			<< L"\t-l : level of detail drawn, generates them when above 0 (default 0)\n"
+			<< L"\t-s : widest instruction set of the tile coverage kernel (default avx2, lowered to what the CPU supports)\n"
+			<< L"\t-r : float edge equations, or fixed point ones snapped to 1/256 pixel with the top-left rule (default float)\n"
+			<< L"\t-v : the fine stage fills a visibility buffer, a full screen pass shades it\n"
+			<< L"\t-c : faces dropped by geometry setup (default back)\n"
+			<< L"\t-d : camera distance as a multiple of the one framing the model, below 1 to move through it (default 1)\n"
+			<< L"\t-q : the fine stage trivially rejects and accepts 2x2 pixel quads instead of running the kernel, and reports what every level of the edge tests accepted and rejected\n"
+			<< L"\t-w, -h, -tile, -bin, -queues : viewport size, tile and bin sides and binning queues of the pipeline, like the ones of the compute pipeline (default 1280, 720, 8, 8, 16), the CPU pipeline only runs 8 pixel tiles\n";
+		return 1;
+	}
+
+	std::wstring imagePath{};
+	uint32_t frameCount{ 1 };
+	uint32_t workerCount{ 0 };
+	uint32_t lodIdx{ 0 };
+	CpuRaster::EInstructionSet instructionSet{ CpuRaster::EInstructionSet::AVX2 };
+	ERasterMode rasterMode{ ERasterMode::Float };
+	EShadingMode shadingMode{ EShadingMode::Forward };
+	ECullMode cullMode{ ECullMode::Back };
+	float distanceScale{ 1.f };
+	CpuRaster::ECoverageMode coverageMode{ CpuRaster::ECoverageMode::Kernel };
+	RasterConfig rasterConfig{};
+	for (int argIdx{ 2 }; argIdx < argc; ++argIdx)
+	{
+		const std::string arg{ argv[argIdx] };
+		const bool hasValue{ argIdx + 1 < argc };
+		if (arg == "-o" && hasValue)
+			imagePath = std::filesystem::path{ argv[++argIdx] }.wstring();
+		else if (arg == "-f" && hasValue && ParseCount(argv[++argIdx], frameCount) && frameCount > 0)
+			continue;
+		else if (arg == "-t" && hasValue && ParseCount(argv[++argIdx], workerCount))
+			continue;
+		else if (arg == "-l" && hasValue && ParseCount(argv[++argIdx], lodIdx))
+			continue;
+		else if (arg == "-s" && hasValue && ParseInstructionSet(argv[++argIdx], instructionSet))
+			continue;
+		else if (arg == "-r" && hasValue && ParseRasterMode(argv[++argIdx], rasterMode))
+			continue;
+		else if (arg == "-v")
+			shadingMode = EShadingMode::VisibilityBuffer;
+		else if (arg == "-c" && hasValue && ParseCullMode(argv[++argIdx], cullMode))
+			continue;
+		else if (arg == "-d" && hasValue && ParseScale(argv[++argIdx], distanceScale))
+			continue;
+		else if (arg == "-q")
+			coverageMode = CpuRaster::ECoverageMode::Quad;
+		else if (arg == "-w" && hasValue && ParseCount(argv[++argIdx], rasterConfig.viewportWidth))
+			continue;
+		else if (arg == "-h" && hasValue && ParseCount(argv[++argIdx], rasterConfig.viewportHeight))
+			continue;
+		else if (arg == "-tile" && hasValue && ParseCount(argv[++argIdx], rasterConfig.tileSize))
+			continue;
+		else if (arg == "-bin" && hasValue && ParseCount(argv[++argIdx], rasterConfig.binSize))
+			continue;
+		else if (arg == "-queues" && hasValue && ParseCount(argv[++argIdx], rasterConfig.queueCount))
+			continue;
+		else
+		{
+			std::wcout << L"Error: Invalid option \"" << std::filesystem::path{ arg }.wstring() << L"\".\n";
+			return 1;
+		}
+	}
+
+	if (const wchar_t* error{ CpuRaster::Pipeline::GetConfigError(rasterConfig) })
+	{
+		std::wcout << L"Error: Invalid raster config: " << error << L".\n";
+		return 1;
+	}
+
+	if (rasterMode == ERasterMode::FixedPoint && !rasterConfig.IsFixedPointExact())
+		std::wcout << L"Warning: Viewport too large for exact fixed point edge functions, the weights of the largest triangles fall back to float estimates.\n";
+
+	const std::wstring modelPath{ std::filesystem::path{ argv[1] }.wstring() };
+	MeshData meshData{};
+	if (!MeshCache::LoadModel(modelPath, meshData, MeshCache::FLAG_OPTIMIZED | (lodIdx > 0 ? MeshCache::FLAG_LODS : 0u)))
+	{
+		std::wcout << L"Error: Failed to load \"" << modelPath << L"\".\n";
+		return 1;
+	}
+
+	if (lodIdx >= meshData.GetLodCount())
+	{
+		std::wcout << L"Error: \"" << modelPath << L"\" has " << meshData.GetLodCount() << L" levels of detail.\n";
+		return 1;
+	}
+
+	const MeshLod lod{ meshData.GetLod(lodIdx) };
+	DirectX::XMFLOAT4X4 world{};
+	DirectX::XMStoreFloat4x4(&world, DirectX::XMMatrixIdentity());
+	const DirectX::XMFLOAT4X4 worldViewProj{ GetFramingViewProjection(meshData, distanceScale, static_cast<float>(rasterConfig.viewportWidth) / static_cast<float>(rasterConfig.viewportHeight)) };
+
+	CpuRaster::FrameBuffer frameBuffer{ rasterConfig.viewportWidth, rasterConfig.viewportHeight };
+	CpuRaster::Pipeline pipeline{ rasterConfig, workerCount, instructionSet, rasterMode, shadingMode, cullMode, coverageMode };
+	pipeline.Init(meshData.GetVertexCount(), lod.indexCount / 3);
+
+	CpuRaster::Pipeline::StageTimings totalTimings{};
+	for (uint32_t frameIdx{}; frameIdx < frameCount; ++frameIdx)
+	{
+		frameBuffer.Clear();
+		pipeline.Dispatch(meshData, lod, worldViewProj, world, frameBuffer);
+
+		const CpuRaster::Pipeline::StageTimings& timings{ pipeline.GetStageTimings() };
+		totalTimings.vertex += timings.vertex;
+		totalTimings.geometrySetup += timings.geometrySetup;
+		totalTimings.binning += timings.binning;
+		totalTimings.tiling += timings.tiling;
+		totalTimings.fine += timings.fine;
+		totalTimings.shading += timings.shading;
+	}
+
+	const double frames{ static_cast<double>(frameCount) };
+	const double totalMs{ (totalTimings.vertex + totalTimings.geometrySetup + totalTimings.binning + totalTimings.tiling + totalTimings.fine + totalTimings.shading) / frames };
+	std::wcout << L"Rendered " << lod.indexCount / 3 << L" triangles, " << meshData.GetVertexCount() << L" vertices at " << rasterConfig.viewportWidth << L"x" << rasterConfig.viewportHeight
+		<< L" on " << pipeline.GetWorkerCount()
+		<< L" threads with the " << CpuRaster::EdgeKernel::GetInstructionSetName(pipeline.GetInstructionSet()) << L" coverage kernel"
+		<< (pipeline.GetCoverageMode() == CpuRaster::ECoverageMode::Quad ? L" replaced by quad tests" : L"")
+		<< (pipeline.GetRasterMode() == ERasterMode::FixedPoint ? L" on fixed point edges" : L"")
+		<< (pipeline.GetShadingMode() == EShadingMode::VisibilityBuffer ? L" through a visibility buffer, " : L", ") << frameCount << L" frames averaging " << totalMs << L" ms.\n"
+		<< L"\tvertex " << totalTimings.vertex / frames << L" ms, geometry setup " << totalTimings.geometrySetup / frames
+		<< L" ms, binning " << totalTimings.binning / frames << L" ms, tiling " << totalTimings.tiling / frames
+		<< L" ms, fine " << totalTimings.fine / frames << L" ms, shading " << totalTimings.shading / frames << L" ms.\n";
+
+	const CpuRaster::Pipeline::CullStats& cullStats{ pipeline.GetCullStats() };
+	const wchar_t* pculledFaces{ pipeline.GetCullMode() == ECullMode::Front ? L" front faces, " : L" back faces, " };
+	std::wcout << L"\tgeometry setup culled " << cullStats.culledTriangleCount << (pipeline.GetCullMode() == ECullMode::None ? L" triangles, " : pculledFaces)
+		<< cullStats.degenerateTriangleCount << L" degenerate triangles.\n";
+
+	const CpuRaster::Pipeline::ClipStats& clipStats{ pipeline.GetClipStats() };
+	std::wcout << L"\tgeometry setup rejected " << clipStats.rejectedTriangleCount << L" triangles outside the view volume, clipped "
+		<< clipStats.clippedTriangleCount << L" into " << clipStats.clipTriangleCount << L" triangles, " << clipStats.droppedClipTriangleCount << L" dropped past the clip capacity.\n";
+
+	const CpuRaster::Pipeline::MicroStats& microStats{ pipeline.GetMicroStats() };
+	std::wcout << L"\tgeometry setup routed " << microStats.microTriangleCount << L" micro triangles past binning, " << microStats.quadTriangleCount << L" of them inside a pixel quad, and binned "
+		<< microStats.regularTriangleCount << L" triangles, " << microStats.overflowTriangleCount << L" of them past a full micro list.\n";
+
+	const CpuRaster::Pipeline::BinStats& binStats{ pipeline.GetBinStats() };
+	std::wcout << L"\tbinning stored " << binStats.binTrianglePairCount << L" bin triangle pairs in " << binStats.encodedByteCount << L" bytes of delta coded lists, "
+		<< binStats.rawByteCount << L" bytes as triangle indices.\n";
+
+	const CpuRaster::Pipeline::OverlapStats& overlapStats{ pipeline.GetOverlapStats() };
+	std::wcout << L"\tedge tests dropped " << overlapStats.missedBinCount << L" of " << binStats.binTrianglePairCount + overlapStats.missedBinCount
+		<< L" bins of the triangle aabbs in binning and " << overlapStats.missedTileCount << L" triangle tiles in tiling.\n";
+
+	const CpuRaster::Pipeline::CoverageStats& coverageStats{ pipeline.GetCoverageStats() };
+	std::wcout << L"\ttiling accepted " << coverageStats.fullBinCount << L" fully covered bins and " << coverageStats.fullTileCount << L" fully covered triangle tiles, shaded without edge tests.\n";
+
+	if (pipeline.GetCoverageMode() == CpuRaster::ECoverageMode::Quad)
+	{
+		const CpuRaster::Pipeline::QuadStats& quadStats{ pipeline.GetQuadStats() };
+		std::wcout << L"\tedge test levels accepted / rejected: " << rasterConfig.GetBinPixelSize() << L"x" << rasterConfig.GetBinPixelSize() << L" bins "
+			<< coverageStats.fullBinCount << L" / " << overlapStats.missedBinCount << L", " << CpuRaster::TILE_SIZE << L"x" << CpuRaster::TILE_SIZE << L" tiles "
+			<< coverageStats.fullTileCount << L" / " << overlapStats.missedTileCount << L", 2x2 quads " << quadStats.acceptedQuadCount << L" / " << quadStats.rejectedQuadCount
+			<< L", " << quadStats.partialQuadCount << L" quads tested pixel by pixel.\n";
+	}
+
+	const CpuRaster::Pipeline::HiZStats& hiZStats{ pipeline.GetHiZStats() };
+	std::wcout << L"\tHi-Z rejected " << hiZStats.rejectedTileCount << L" triangle tiles in tiling, " << hiZStats.rejectedTriangleCount << L" triangles in the fine stage.\n";
+
+	// Load balance of the last frame, a worker running out of tiles long before the others shows as a low busy share
+	const std::vector<CpuRaster::TileScheduler::WorkerStats>& workerStats{ pipeline.GetFineWorkerStats() };
+	const double fineMs{ (std::max)(pipeline.GetStageTimings().fine, 1e-6) };
+	for (size_t workerIdx{}; workerIdx < std::size(workerStats); ++workerIdx)
+	{
+		const CpuRaster::TileScheduler::WorkerStats& stats{ workerStats[workerIdx] };
+		std::wcout << L"\tfine worker " << workerIdx << L": " << stats.itemCount << L" tiles, " << stats.stolenItemCount << L" stolen in "
+			<< stats.stealCount << L" steals, busy " << 100.0 * stats.busyMs / fineMs << L"% of the stage.\n";
+	}
+
+	if (!std::empty(imagePath) && !frameBuffer.WriteTga(imagePath))
+	{
+		std::wcout << L"Error: Failed to write \"" << imagePath << L"\".\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,398 @@
+#include "pch.h"
+#include "EdgeKernel.h"
+
+#include <algorithm>
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define EDGE_KERNEL_X86
+	#include <immintrin.h>
+#endif
+
+// MSVC emits any intrinsic without /arch, GCC and Clang only inside functions targeting the instruction set
+#if defined(EDGE_KERNEL_X86) && !defined(_MSC_VER)
+	#define EDGE_KERNEL_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+	#define EDGE_KERNEL_TARGET_AVX2
+#endif
+
+namespace CpuRaster
+{
+	namespace
+	{
+		static_assert(TILE_SIZE == 8, "The vector kernels process rows of 8 pixels");
+
+		// Per edge, the value at the start of every tile row and the x step of every tile column, the terms FineRasterizer3 adds
+		struct TileEdges
+		{
+			float rowStart[3][TILE_SIZE];
+			float columnStep[3][TILE_SIZE];
+		};
+
+		void SetupTileEdges(const RasterData& rData, uint32_t tileX, uint32_t tileY, TileEdges& edges)
+		{
+			const int startX{ static_cast<int>(rData.aabb[0] >> 16) };
+			const int startY{ static_cast<int>(rData.aabb[0] & 0xFFFF) };
+
+			for (uint32_t idx{}; idx < TILE_SIZE; ++idx)
+			{
+				const float dy{ static_cast<float>(static_cast<int>(tileY + idx) - startY) };
+				const float dx{ static_cast<float>(static_cast<int>(tileX + idx) - startX) };
+				for (uint32_t edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+				{
+					edges.rowStart[edgeIdx][idx] = rData.edgeEq[6 + edgeIdx] + rData.edgeEq[1 + edgeIdx * 2] * dy;
+					edges.columnStep[edgeIdx][idx] = rData.edgeEq[edgeIdx * 2] * dx;
+				}
+			}
+		}
+
+		uint64_t ComputeTileCoverageScalar(const RasterData& rData, uint32_t tileX, uint32_t tileY)
+		{
+			TileEdges edges;
+			SetupTileEdges(rData, tileX, tileY, edges);
+
+			uint64_t coverage{ 0 };
+			for (uint32_t pixelY{}; pixelY < TILE_SIZE; ++pixelY)
+			{
+				for (uint32_t pixelX{}; pixelX < TILE_SIZE; ++pixelX)
+				{
+					// Written as a positive test so a NaN edge fails like all(cx > 0) does
+					const bool isCovered{ edges.rowStart[0][pixelY] + edges.columnStep[0][pixelX] > 0.f
+						&& edges.rowStart[1][pixelY] + edges.columnStep[1][pixelX] > 0.f
+						&& edges.rowStart[2][pixelY] + edges.columnStep[2][pixelX] > 0.f };
+					coverage |= static_cast<uint64_t>(isCovered) << (pixelY * TILE_SIZE + pixelX);
+				}
+			}
+
+			return coverage;
+		}
+
+		uint64_t ComputeFixedTileCoverageScalar(const RasterData& rData, uint32_t tileX, uint32_t tileY)
+		{
+			EdgeKernel::FixedTileEdges edges;
+			EdgeKernel::SetupFixedTileEdges(rData, tileX, tileY, edges);
+
+			uint64_t coverage{ 0 };
+			for (int32_t pixelY{}; pixelY < static_cast<int32_t>(TILE_SIZE); ++pixelY)
+			{
+				for (int32_t pixelX{}; pixelX < static_cast<int32_t>(TILE_SIZE); ++pixelX)
+				{
+					const bool isCovered{ edges.origin[0] + edges.stepX[0] * pixelX + edges.stepY[0] * pixelY > 0
+						&& edges.origin[1] + edges.stepX[1] * pixelX + edges.stepY[1] * pixelY > 0
+						&& edges.origin[2] + edges.stepX[2] * pixelX + edges.stepY[2] * pixelY > 0 };
+					coverage |= static_cast<uint64_t>(isCovered) << (pixelY * TILE_SIZE + pixelX);
+				}
+			}
+
+			return coverage;
+		}
+
+#if defined(EDGE_KERNEL_X86)
+		// Two 4 pixel halves per row
+		uint64_t ComputeTileCoverageSSE2(const RasterData& rData, uint32_t tileX, uint32_t tileY)
+		{
+			TileEdges edges;
+			SetupTileEdges(rData, tileX, tileY, edges);
+
+			const __m128 zero{ _mm_setzero_ps() };
+			const __m128 step0Lo{ _mm_loadu_ps(edges.columnStep[0]) }, step0Hi{ _mm_loadu_ps(edges.columnStep[0] + 4) };
+			const __m128 step1Lo{ _mm_loadu_ps(edges.columnStep[1]) }, step1Hi{ _mm_loadu_ps(edges.columnStep[1] + 4) };
+			const __m128 step2Lo{ _mm_loadu_ps(edges.columnStep[2]) }, step2Hi{ _mm_loadu_ps(edges.columnStep[2] + 4) };
+
+			uint64_t coverage{ 0 };
+			for (uint32_t pixelY{}; pixelY < TILE_SIZE; ++pixelY)
+			{
+				const __m128 row0{ _mm_set1_ps(edges.rowStart[0][pixelY]) };
+				const __m128 row1{ _mm_set1_ps(edges.rowStart[1][pixelY]) };
+				const __m128 row2{ _mm_set1_ps(edges.rowStart[2][pixelY]) };
+
+				const __m128 insideLo{ _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(_mm_add_ps(row0, step0Lo), zero), _mm_cmpgt_ps(_mm_add_ps(row1, step1Lo), zero)), _mm_cmpgt_ps(_mm_add_ps(row2, step2Lo), zero)) };
+				const __m128 insideHi{ _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(_mm_add_ps(row0, step0Hi), zero), _mm_cmpgt_ps(_mm_add_ps(row1, step1Hi), zero)), _mm_cmpgt_ps(_mm_add_ps(row2, step2Hi), zero)) };
+
+				const uint32_t rowMask{ static_cast<uint32_t>(_mm_movemask_ps(insideLo)) | static_cast<uint32_t>(_mm_movemask_ps(insideHi)) << 4 };
+				coverage |= static_cast<uint64_t>(rowMask) << (pixelY * TILE_SIZE);
+			}
+
+			return coverage;
+		}
+
+		// One 8 pixel row per vector
+		EDGE_KERNEL_TARGET_AVX2 uint64_t ComputeTileCoverageAVX2(const RasterData& rData, uint32_t tileX, uint32_t tileY)
+		{
+			TileEdges edges;
+			SetupTileEdges(rData, tileX, tileY, edges);
+
+			const __m256 zero{ _mm256_setzero_ps() };
+			const __m256 step0{ _mm256_loadu_ps(edges.columnStep[0]) };
+			const __m256 step1{ _mm256_loadu_ps(edges.columnStep[1]) };
+			const __m256 step2{ _mm256_loadu_ps(edges.columnStep[2]) };
+
+			uint64_t coverage{ 0 };
+			for (uint32_t pixelY{}; pixelY < TILE_SIZE; ++pixelY)
+			{
+				const __m256 inside0{ _mm256_cmp_ps(_mm256_add_ps(_mm256_set1_ps(edges.rowStart[0][pixelY]), step0), zero, _CMP_GT_OQ) };
+				const __m256 inside1{ _mm256_cmp_ps(_mm256_add_ps(_mm256_set1_ps(edges.rowStart[1][pixelY]), step1), zero, _CMP_GT_OQ) };
+				const __m256 inside2{ _mm256_cmp_ps(_mm256_add_ps(_mm256_set1_ps(edges.rowStart[2][pixelY]), step2), zero, _CMP_GT_OQ) };
+
+				const uint32_t rowMask{ static_cast<uint32_t>(_mm256_movemask_ps(_mm256_and_ps(_mm256_and_ps(inside0, inside1), inside2))) };
+				coverage |= static_cast<uint64_t>(rowMask) << (pixelY * TILE_SIZE);
+			}
+
+			return coverage;
+		}
+
+		uint64_t ComputeFixedTileCoverageSSE2(const RasterData& rData, uint32_t tileX, uint32_t tileY)
+		{
+			EdgeKernel::FixedTileEdges edges;
+			EdgeKernel::SetupFixedTileEdges(rData, tileX, tileY, edges);
+
+			const __m128i zero{ _mm_setzero_si128() };
+			__m128i stepLo[3], stepHi[3];
+			for (uint32_t edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+			{
+				// SSE2 has no 32 bit multiply, the column offsets are built once per tile
+				int32_t columnSteps[TILE_SIZE];
+				for (int32_t pixelX{}; pixelX < static_cast<int32_t>(TILE_SIZE); ++pixelX)
+					columnSteps[pixelX] = edges.stepX[edgeIdx] * pixelX;
+
+				stepLo[edgeIdx] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columnSteps));
+				stepHi[edgeIdx] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columnSteps + 4));
+			}
+
+			uint64_t coverage{ 0 };
+			for (int32_t pixelY{}; pixelY < static_cast<int32_t>(TILE_SIZE); ++pixelY)
+			{
+				const __m128i row0{ _mm_set1_epi32(edges.origin[0] + edges.stepY[0] * pixelY) };
+				const __m128i row1{ _mm_set1_epi32(edges.origin[1] + edges.stepY[1] * pixelY) };
+				const __m128i row2{ _mm_set1_epi32(edges.origin[2] + edges.stepY[2] * pixelY) };
+
+				const __m128i insideLo{ _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(_mm_add_epi32(row0, stepLo[0]), zero), _mm_cmpgt_epi32(_mm_add_epi32(row1, stepLo[1]), zero)), _mm_cmpgt_epi32(_mm_add_epi32(row2, stepLo[2]), zero)) };
+				const __m128i insideHi{ _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(_mm_add_epi32(row0, stepHi[0]), zero), _mm_cmpgt_epi32(_mm_add_epi32(row1, stepHi[1]), zero)), _mm_cmpgt_epi32(_mm_add_epi32(row2, stepHi[2]), zero)) };
+
+				const uint32_t rowMask{ static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(insideLo))) | static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(insideHi))) << 4 };
+				coverage |= static_cast<uint64_t>(rowMask) << (pixelY * TILE_SIZE);
+			}
+
+			return coverage;
+		}
+
+		EDGE_KERNEL_TARGET_AVX2 uint64_t ComputeFixedTileCoverageAVX2(const RasterData& rData, uint32_t tileX, uint32_t tileY)
+		{
+			EdgeKernel::FixedTileEdges edges;
+			EdgeKernel::SetupFixedTileEdges(rData, tileX, tileY, edges);
+
+			const __m256i zero{ _mm256_setzero_si256() };
+			const __m256i column{ _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7) };
+			const __m256i step0{ _mm256_mullo_epi32(_mm256_set1_epi32(edges.stepX[0]), column) };
+			const __m256i step1{ _mm256_mullo_epi32(_mm256_set1_epi32(edges.stepX[1]), column) };
+			const __m256i step2{ _mm256_mullo_epi32(_mm256_set1_epi32(edges.stepX[2]), column) };
+
+			// Rows are stepped incrementally, one add per edge
+			__m256i row0{ _mm256_add_epi32(_mm256_set1_epi32(edges.origin[0]), step0) };
+			__m256i row1{ _mm256_add_epi32(_mm256_set1_epi32(edges.origin[1]), step1) };
+			__m256i row2{ _mm256_add_epi32(_mm256_set1_epi32(edges.origin[2]), step2) };
+			const __m256i rowStep0{ _mm256_set1_epi32(edges.stepY[0]) };
+			const __m256i rowStep1{ _mm256_set1_epi32(edges.stepY[1]) };
+			const __m256i rowStep2{ _mm256_set1_epi32(edges.stepY[2]) };
+
+			uint64_t coverage{ 0 };
+			for (uint32_t pixelY{}; pixelY < TILE_SIZE; ++pixelY)
+			{
+				const __m256i inside{ _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(row0, zero), _mm256_cmpgt_epi32(row1, zero)), _mm256_cmpgt_epi32(row2, zero)) };
+				const uint32_t rowMask{ static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(inside))) };
+				coverage |= static_cast<uint64_t>(rowMask) << (pixelY * TILE_SIZE);
+
+				row0 = _mm256_add_epi32(row0, rowStep0);
+				row1 = _mm256_add_epi32(row1, rowStep1);
+				row2 = _mm256_add_epi32(row2, rowStep2);
+			}
+
+			return coverage;
+		}
+
+		bool IsAVX2Supported()
+		{
+#if defined(_MSC_VER)
+			// AVX2 needs the CPU flag and the OS saving the YMM registers (OSXSAVE, XCR0 bits 1 and 2)
+			int cpuInfo[4]{};
+			__cpuid(cpuInfo, 0);
+			if (cpuInfo[0] < 7)
+				return false;
+
+			__cpuid(cpuInfo, 1);
+			const bool isAVXEnabled{ (cpuInfo[2] & (1 << 27)) != 0 && (cpuInfo[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6 };
+
+			__cpuidex(cpuInfo, 7, 0);
+			return isAVXEnabled && (cpuInfo[1] & (1 << 5)) != 0;
+#else
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+#endif
+		}
+#endif
+
+		// Whether the edge passes at the corner of the inclusive rect where it is lowest, or where it is highest
+		bool IsEdgePassedAtCorner(ERasterMode rasterMode, const RasterData& rData, uint32_t edgeIdx, uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY, bool isLowest)
+		{
+			if (rasterMode == ERasterMode::FixedPoint)
+			{
+				// A clamped value keeps its sign, and a tile stepped from it stays on that side
+				const int32_t* pstart{ rData.fixedEdge + (edgeIdx + 1) % 3 * 2 };
+				const int32_t* pend{ rData.fixedEdge + (edgeIdx + 2) % 3 * 2 };
+				const int32_t a{ pstart[1] - pend[1] };
+				const int32_t b{ pend[0] - pstart[0] };
+				const int32_t cornerX{ static_cast<int32_t>((a < 0) == isLowest ? maxX : minX) };
+				const int32_t cornerY{ static_cast<int32_t>((b < 0) == isLowest ? maxY : minY) };
+				return FixedPointEdges::EvaluateEdge(a, b, pstart[0], pstart[1], rData.fixedEdge[6 + edgeIdx], cornerX, cornerY) > 0;
+			}
+
+			// The row start then the column step, summed like TileEdges
+			const float a{ rData.edgeEq[edgeIdx * 2] };
+			const float b{ rData.edgeEq[1 + edgeIdx * 2] };
+			const float dx{ static_cast<float>(static_cast<int>((a < 0.f) == isLowest ? maxX : minX) - static_cast<int>(rData.aabb[0] >> 16)) };
+			const float dy{ static_cast<float>(static_cast<int>((b < 0.f) == isLowest ? maxY : minY) - static_cast<int>(rData.aabb[0] & 0xFFFF)) };
+			return rData.edgeEq[6 + edgeIdx] + b * dy + a * dx > 0.f;
+		}
+	}
+
+	EInstructionSet EdgeKernel::GetSupportedInstructionSet()
+	{
+#if defined(EDGE_KERNEL_X86)
+		// SSE2 is part of every x64 CPU and of the Win32 /arch default
+		static const EInstructionSet instructionSet{ IsAVX2Supported() ? EInstructionSet::AVX2 : EInstructionSet::SSE2 };
+		return instructionSet;
+#else
+		return EInstructionSet::Scalar;
+#endif
+	}
+
+	bool EdgeKernel::IsRectCovered(ERasterMode rasterMode, const RasterData& rData, uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY)
+	{
+		for (uint32_t edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+		{
+			if (!IsEdgePassedAtCorner(rasterMode, rData, edgeIdx, minX, minY, maxX, maxY, true))
+				return false;
+		}
+
+		return true;
+	}
+
+	bool EdgeKernel::IsRectOverlapped(ERasterMode rasterMode, const RasterData& rData, uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY)
+	{
+		minX = (std::max)(minX, rData.aabb[0] >> 16);
+		minY = (std::max)(minY, rData.aabb[0] & 0xFFFF);
+		maxX = (std::min)(maxX, rData.aabb[1] >> 16);
+		maxY = (std::min)(maxY, rData.aabb[1] & 0xFFFF);
+		if (minX > maxX || minY > maxY)
+			return false;
+
+		for (uint32_t edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+		{
+			if (!IsEdgePassedAtCorner(rasterMode, rData, edgeIdx, minX, minY, maxX, maxY, false))
+				return false;
+		}
+
+		return true;
+	}
+
+	uint64_t EdgeKernel::ComputeQuadCoverage(ERasterMode rasterMode, const RasterData& rData, uint32_t tileX, uint32_t tileY, QuadCounts& counts)
+	{
+		// Pixels (0, 0), (1, 0), (0, 1) and (1, 1) of the quad
+		constexpr uint64_t quadMask{ 3ull | 3ull << TILE_SIZE };
+
+		uint64_t coverage{ 0 };
+		for (uint32_t quadY{}; quadY < TILE_SIZE; quadY += 2)
+		{
+			for (uint32_t quadX{}; quadX < TILE_SIZE; quadX += 2)
+			{
+				const uint32_t minX{ tileX + quadX }, minY{ tileY + quadY };
+				if (!IsRectOverlapped(rasterMode, rData, minX, minY, minX + 1, minY + 1))
+				{
+					++counts.rejectedQuadCount;
+					continue;
+				}
+
+				const uint32_t quadBit{ quadY * TILE_SIZE + quadX };
+				if (IsRectCovered(rasterMode, rData, minX, minY, minX + 1, minY + 1))
+				{
+					++counts.acceptedQuadCount;
+					coverage |= quadMask << quadBit;
+					continue;
+				}
+
+				// A one pixel rect is covered when the pixel passes the three edges
+				++counts.partialQuadCount;
+				for (uint32_t pixelIdx{}; pixelIdx < 4; ++pixelIdx)
+				{
+					const uint32_t pixelX{ minX + pixelIdx % 2 }, pixelY{ minY + pixelIdx / 2 };
+					if (IsRectCovered(rasterMode, rData, pixelX, pixelY, pixelX, pixelY))
+						coverage |= 1ull << (quadBit + pixelIdx / 2 * TILE_SIZE + pixelIdx % 2);
+				}
+			}
+		}
+
+		return coverage;
+	}
+
+	void EdgeKernel::SetupFixedTileEdges(const RasterData& rData, uint32_t tileX, uint32_t tileY, FixedTileEdges& edges)
+	{
+		const int32_t pixelX{ static_cast<int32_t>(tileX) };
+		const int32_t pixelY{ static_cast<int32_t>(tileY) };
+		for (uint32_t edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+		{
+			// Edge i goes from vertex i + 1 to vertex i + 2
+			const int32_t* pstart{ rData.fixedEdge + (edgeIdx + 1) % 3 * 2 };
+			const int32_t* pend{ rData.fixedEdge + (edgeIdx + 2) % 3 * 2 };
+			const int32_t a{ pstart[1] - pend[1] };
+			const int32_t b{ pend[0] - pstart[0] };
+
+			edges.origin[edgeIdx] = FixedPointEdges::EvaluateEdge(a, b, pstart[0], pstart[1], rData.fixedEdge[6 + edgeIdx], pixelX, pixelY);
+			edges.weightOrigin[edgeIdx] = FixedPointEdges::EstimateEdge(a, b, pstart[0], pstart[1], rData.fixedEdge[6 + edgeIdx], pixelX, pixelY);
+			edges.stepX[edgeIdx] = a;
+			edges.stepY[edgeIdx] = b;
+		}
+	}
+
+	EdgeKernel::CoverageFnc EdgeKernel::GetKernel(EInstructionSet instructionSet, ERasterMode rasterMode)
+	{
+		const bool isFixedPoint{ rasterMode == ERasterMode::FixedPoint };
+		switch ((std::min)(instructionSet, GetSupportedInstructionSet()))
+		{
+#if defined(EDGE_KERNEL_X86)
+		case EInstructionSet::AVX2: return isFixedPoint ? &ComputeFixedTileCoverageAVX2 : &ComputeTileCoverageAVX2;
+		case EInstructionSet::SSE2: return isFixedPoint ? &ComputeFixedTileCoverageSSE2 : &ComputeTileCoverageSSE2;
+#endif
+		default: return isFixedPoint ? &ComputeFixedTileCoverageScalar : &ComputeTileCoverageScalar;
+		}
+	}
+
+	const wchar_t* EdgeKernel::GetInstructionSetName(EInstructionSet instructionSet)
+	{
+		switch (instructionSet)
+		{
+		case EInstructionSet::AVX2: return L"AVX2";
+		case EInstructionSet::SSE2: return L"SSE2";
+		default: return L"scalar";
+		}
+	}
+
+	uint32_t EdgeKernel::FindFirstSetBit(uint64_t mask)
+	{
+#if defined(_MSC_VER) && defined(_WIN64)
+		unsigned long bitIdx{};
+		_BitScanForward64(&bitIdx, mask);
+		return static_cast<uint32_t>(bitIdx);
+#elif defined(_MSC_VER)
+		unsigned long bitIdx{};
+		if (_BitScanForward(&bitIdx, static_cast<unsigned long>(mask)))
+			return static_cast<uint32_t>(bitIdx);
+
+		_BitScanForward(&bitIdx, static_cast<unsigned long>(mask >> 32));
+		return static_cast<uint32_t>(bitIdx) + 32;
+#else
+		return static_cast<uint32_t>(__builtin_ctzll(mask));
+#endif
+	}
+}
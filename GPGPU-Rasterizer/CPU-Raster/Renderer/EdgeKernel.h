@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+
+#include "Common/FixedPointEdges.h"
+#include "PipelineData.h"
+
+namespace CpuRaster
+{
+	// Vector width the edge kernel runs at, in increasing order of preference
+	enum class EInstructionSet
+	{
+		Scalar, SSE2, AVX2
+	};
+
+	// How the fine stage gets the coverage of a triangle tile the tile stage did not accept
+	enum class ECoverageMode
+	{
+		Kernel, // every pixel of the tile at once, with the edge kernel of the instruction set
+		Quad // 2x2 pixel quads trivially rejected and accepted from their corners, the pixels tested one by one only in the other ones
+	};
+
+	/**
+	 * \brief : Coverage of a TILE_SIZE x TILE_SIZE tile by the three edge equations of a RasterData, evaluated like FineRasterizer3:
+	 * stepped from the aabb min corner and sampled at integer pixel coordinates, a pixel is covered when every edge is strictly positive.
+	 * In ERasterMode::FixedPoint, the integer edge functions of FixedPointEdges are stepped from the tile min corner instead.\n
+	 * Bit y * TILE_SIZE + x of the mask is pixel (x, y) of the tile, the layout of BinData::coverage.
+	 * The kernels of every instruction set return the same masks.
+	 */
+	namespace EdgeKernel
+	{
+		using CoverageFnc = uint64_t(*)(const RasterData& rData, uint32_t tileX, uint32_t tileY);
+
+		// FixedPoint edge functions at the tile min corner and their step per pixel, edge(x, y) = origin + stepX * x + stepY * y
+		struct FixedTileEdges
+		{
+			int32_t origin[3];
+			int32_t stepX[3];
+			int32_t stepY[3];
+			// Unclamped FixedPointEdges::EstimateEdge at the tile min corner, stepped in float for the weights where origin is clamped
+			float weightOrigin[3];
+		};
+
+		void SetupFixedTileEdges(const RasterData& rData, uint32_t tileX, uint32_t tileY, FixedTileEdges& edges);
+
+		/**
+		 * \brief : Trivial accept, whether every pixel of the inclusive rect passes the three edges as the kernels and the fine stage evaluate them.\n
+		 * Each edge is only evaluated at the corner where it is lowest, exact since the rounded float terms and the integer ones never decrease away from it
+		 */
+		bool IsRectCovered(ERasterMode rasterMode, const RasterData& rData, uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY);
+
+		/**
+		 * \brief : Conservative overlap, false when no pixel of the inclusive rect inside the pixel bounds of the triangle can pass the three edges.\n
+		 * Each edge is only evaluated at the corner where it is highest, a rect can still pass every edge at a different corner and miss the triangle
+		 */
+		bool IsRectOverlapped(ERasterMode rasterMode, const RasterData& rData, uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY);
+
+		// Quads of a tile ComputeQuadCoverage classified
+		struct QuadCounts
+		{
+			// No pixel can pass the three edges, skipped
+			uint32_t rejectedQuadCount;
+			// Every pixel passes the three edges, set without per pixel tests
+			uint32_t acceptedQuadCount;
+			// Crossed by an edge, tested pixel by pixel
+			uint32_t partialQuadCount;
+		};
+
+		/**
+		 * \brief : Coverage of the tile like the kernels, the last level under the bins and tiles of the tile stage:
+		 * each 2x2 pixel quad is rejected by IsRectOverlapped or accepted by IsRectCovered, only the pixels of the other ones are tested.
+		 * The kernels of every instruction set return the same masks
+		 */
+		uint64_t ComputeQuadCoverage(ERasterMode rasterMode, const RasterData& rData, uint32_t tileX, uint32_t tileY, QuadCounts& counts);
+
+		/**
+		 * \brief : Widest instruction set both the build and the running CPU support, checked once
+		 */
+		EInstructionSet GetSupportedInstructionSet();
+
+		/**
+		 * \brief : Kernel of instructionSet, or of the widest supported one below it
+		 */
+		CoverageFnc GetKernel(EInstructionSet instructionSet, ERasterMode rasterMode);
+
+		const wchar_t* GetInstructionSetName(EInstructionSet instructionSet);
+
+		/**
+		 * \brief : Index of the lowest set bit, mask must not be 0
+		 */
+		uint32_t FindFirstSetBit(uint64_t mask);
+	};
+}
@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "FrameBuffer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <filesystem>
+
+namespace CpuRaster
+{
+	FrameBuffer::FrameBuffer(uint32_t width, uint32_t height)
+		: m_Width{ width }
+		, m_Height{ height }
+		, m_Color(static_cast<size_t>(width) * height)
+		, m_Depth(static_cast<size_t>(width) * height)
+		, m_TileCountX{ (width + TILE_SIZE - 1) / TILE_SIZE }
+		, m_TileDepth(static_cast<size_t>(m_TileCountX) * ((height + TILE_SIZE - 1) / TILE_SIZE))
+	{
+		Clear();
+	}
+
+	void FrameBuffer::Clear()
+	{
+		std::fill(std::begin(m_Color), std::end(m_Color), PackColor(0.f, 0.f, 0.f, 1.f));
+		std::fill(std::begin(m_Depth), std::end(m_Depth), FLT_MAX);
+		std::fill(std::begin(m_TileDepth), std::end(m_TileDepth), TileDepth{ FLT_MAX, FLT_MAX });
+	}
+
+	bool FrameBuffer::WriteTga(const std::wstring& filePath) const
+	{
+		std::ofstream file{ std::filesystem::path{ filePath }, std::ios::binary };
+		if (!file)
+			return false;
+
+		// Uncompressed true color, 32 bits per pixel, 8 alpha bits, rows stored top to bottom
+		const uint8_t header[18]{ 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0
+			, static_cast<uint8_t>(m_Width & 0xFF), static_cast<uint8_t>(m_Width >> 8)
+			, static_cast<uint8_t>(m_Height & 0xFF), static_cast<uint8_t>(m_Height >> 8)
+			, 32, 0x28 };
+		file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+		// TGA pixels are BGRA
+		std::vector<uint32_t> row(m_Width);
+		for (uint32_t y{}; y < m_Height; ++y)
+		{
+			const uint32_t* psrc{ std::data(m_Color) + static_cast<size_t>(y) * m_Width };
+			std::transform(psrc, psrc + m_Width, std::begin(row), [](uint32_t rgba)
+				{
+					return (rgba & 0xFF00FF00u) | ((rgba & 0xFFu) << 16) | ((rgba >> 16) & 0xFFu);
+				});
+			file.write(reinterpret_cast<const char*>(std::data(row)), static_cast<std::streamsize>(m_Width * sizeof(uint32_t)));
+		}
+
+		return static_cast<bool>(file);
+	}
+
+	uint32_t FrameBuffer::PackColor(float r, float g, float b, float a)
+	{
+		// UNORM conversion: saturate, scale and round to nearest
+		const auto toUnorm{ [](float value) { return static_cast<uint32_t>((std::min)((std::max)(value, 0.f), 1.f) * 255.f + 0.5f); } };
+		return toUnorm(r) | toUnorm(g) << 8 | toUnorm(b) << 16 | toUnorm(a) << 24;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "PipelineData.h"
+
+namespace CpuRaster
+{
+	/**
+	 * \brief : In-memory render target and depth buffer of the CPU pipeline.\n
+	 * Colors are R8G8B8A8_UNORM packed with red in the low byte, like the swap chain the compute pipeline writes to.
+	 * The min and max depth of every TILE_SIZE tile (Hi-Z) are kept next to the depth buffer, the pipeline updates both.
+	 */
+	class FrameBuffer
+	{
+	public:
+		// Hi-Z entry of a tile, tiles are stored row by row from the top left one
+		struct TileDepth
+		{
+			float minDepth;
+			float maxDepth;
+		};
+
+		explicit FrameBuffer(uint32_t width, uint32_t height);
+		~FrameBuffer() = default;
+
+		FrameBuffer(const FrameBuffer&) = delete;
+		FrameBuffer(FrameBuffer&&) noexcept = delete;
+		FrameBuffer& operator=(const FrameBuffer&) = delete;
+		FrameBuffer& operator=(FrameBuffer&&) noexcept = delete;
+
+		/**
+		 * \brief : Opaque black and FLT_MAX depth, the values CompuRenderer::ClearBuffers uses, Hi-Z included
+		 */
+		void Clear();
+
+		/**
+		 * \brief : Writes the color buffer as an uncompressed 32 bit TGA
+		 */
+		bool WriteTga(const std::wstring& filePath) const;
+
+		uint32_t GetWidth() const { return m_Width; }
+		uint32_t GetHeight() const { return m_Height; }
+		uint32_t* GetColorData() { return std::data(m_Color); }
+		const uint32_t* GetColorData() const { return std::data(m_Color); }
+		float* GetDepthData() { return std::data(m_Depth); }
+		const float* GetDepthData() const { return std::data(m_Depth); }
+		uint32_t GetTileCountX() const { return m_TileCountX; }
+		TileDepth* GetTileDepthData() { return std::data(m_TileDepth); }
+		const TileDepth* GetTileDepthData() const { return std::data(m_TileDepth); }
+
+		static uint32_t PackColor(float r, float g, float b, float a);
+
+	private:
+		uint32_t m_Width;
+		uint32_t m_Height;
+		std::vector<uint32_t> m_Color;
+		std::vector<float> m_Depth;
+		uint32_t m_TileCountX;
+		std::vector<TileDepth> m_TileDepth;
+	};
+}
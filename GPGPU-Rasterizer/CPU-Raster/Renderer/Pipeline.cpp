@@ -0,0 +1,1124 @@
+#include "pch.h"
+#include "Pipeline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <thread>
+#include <utility>
+
+#include "FrameBuffer.h"
+
+namespace CpuRaster
+{
+	namespace
+	{
+		// Items handled by one group of the vertex and geometry setup stages, THREAD_COUNT of their shaders
+		constexpr uint32_t VERTEX_GROUP_SIZE{ 512 };
+		constexpr uint32_t SETUP_GROUP_SIZE{ 512 };
+		constexpr float PI{ 3.14159265358979323846f };
+
+		// m_BinOffset holds the triangle, block and delta word arrays of BinScan, each per bin then per queue with their total past them
+		size_t GetBinOffsetCount(const RasterConfig& rasterConfig)
+		{
+			return static_cast<size_t>(rasterConfig.GetBinCount()) * rasterConfig.queueCount + 1;
+		}
+
+		// The batches cover the mesh triangles then the clip triangle slots
+		uint32_t GetBatchSize(uint32_t triangleCount, uint32_t queueCount)
+		{
+			return (triangleCount + Clipping::MAX_CLIP_TRIANGLES + queueCount - 1) / queueCount;
+		}
+
+		/**
+		 * \brief : Calls fnc(binIdx) for every bin of the inclusive bin range of the triangle the corner tests of its edges pass,
+		 * both pixel bounds are inclusive so both are rounded down to bins
+		 * \return : Bins of the range the edges miss
+		 */
+		template<typename FNC>
+		uint32_t ForEachBin(const RasterConfig& rasterConfig, ERasterMode rasterMode, const RasterData& triData, FNC&& fnc)
+		{
+			const uint32_t binPixelSize{ rasterConfig.GetBinPixelSize() };
+			const uint32_t binningDimsX{ rasterConfig.GetBinningDimsX() };
+			const uint32_t binMinX{ (triData.aabb[0] >> 16) / binPixelSize };
+			const uint32_t binMinY{ (triData.aabb[0] & 0xFFFF) / binPixelSize };
+			const uint32_t binMaxX{ (std::min)((triData.aabb[1] >> 16) / binPixelSize, binningDimsX - 1) };
+			const uint32_t binMaxY{ (std::min)((triData.aabb[1] & 0xFFFF) / binPixelSize, rasterConfig.GetBinningDimsY() - 1) };
+
+			uint32_t missedCount{ 0 };
+			for (uint32_t binY{ binMinY }; binY <= binMaxY; ++binY)
+			{
+				for (uint32_t binX{ binMinX }; binX <= binMaxX; ++binX)
+				{
+					const uint32_t pixelX{ binX * binPixelSize };
+					const uint32_t pixelY{ binY * binPixelSize };
+					if (EdgeKernel::IsRectOverlapped(rasterMode, triData, pixelX, pixelY, pixelX + binPixelSize - 1, pixelY + binPixelSize - 1))
+						fnc(binY * binningDimsX + binX);
+					else
+						++missedCount;
+				}
+			}
+
+			return missedCount;
+		}
+
+		inline float Cross2d(float ax, float ay, float bx, float by)
+		{
+			return ax * by - ay * bx;
+		}
+
+		inline bool IsEqual(const DirectX::XMFLOAT4& a, const DirectX::XMFLOAT4& b)
+		{
+			return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+		}
+
+		// Interleaves the bits of x and y, x in the even ones
+		uint32_t GetMortonCode(uint32_t x, uint32_t y)
+		{
+			const auto spreadBits{ [](uint32_t value)
+				{
+					value &= 0xFFFF;
+					value = (value | (value << 8)) & 0x00FF00FF;
+					value = (value | (value << 4)) & 0x0F0F0F0F;
+					value = (value | (value << 2)) & 0x33333333;
+					return (value | (value << 1)) & 0x55555555;
+				} };
+
+			return spreadBits(x) | spreadBits(y) << 1;
+		}
+
+		// Indices [0, count) sorted by the Morton code of their position, dropping the ones getPosition rejects
+		template<typename FNC>
+		std::vector<uint32_t> GetMortonOrder(uint32_t count, FNC&& getPosition)
+		{
+			std::vector<std::pair<uint32_t, uint32_t>> codes{};
+			codes.reserve(count);
+			for (uint32_t idx{}; idx < count; ++idx)
+			{
+				uint32_t x{}, y{};
+				if (getPosition(idx, x, y))
+					codes.emplace_back(GetMortonCode(x, y), idx);
+			}
+
+			std::sort(std::begin(codes), std::end(codes));
+
+			std::vector<uint32_t> order{};
+			order.reserve(std::size(codes));
+			for (const std::pair<uint32_t, uint32_t>& code : codes)
+				order.push_back(code.second);
+
+			return order;
+		}
+
+		// Edge functions of the first two vertices at a pixel of the tile, the weight numerators FineRasterizer3 uses
+		inline void GetEdgeValues(ERasterMode rasterMode, const RasterData& rData, const EdgeKernel::FixedTileEdges& fixedEdges, uint32_t tileX, uint32_t tileY, uint32_t pixelX, uint32_t pixelY, float& cx0, float& cx1)
+		{
+			if (rasterMode == ERasterMode::FixedPoint)
+			{
+				// A clamped tile value only keeps the sign of its edge, the weights of its pixels step the float estimate instead
+				const int32_t x{ static_cast<int32_t>(pixelX) }, y{ static_cast<int32_t>(pixelY) };
+				const auto getValue{ [&](uint32_t edgeIdx)
+					{
+						if (std::abs(fixedEdges.origin[edgeIdx]) >= FixedPointEdges::EDGE_CLAMP)
+							return fixedEdges.weightOrigin[edgeIdx] + static_cast<float>(fixedEdges.stepX[edgeIdx]) * static_cast<float>(x) + static_cast<float>(fixedEdges.stepY[edgeIdx]) * static_cast<float>(y);
+
+						return static_cast<float>(fixedEdges.origin[edgeIdx] + fixedEdges.stepX[edgeIdx] * x + fixedEdges.stepY[edgeIdx] * y);
+					} };
+				cx0 = getValue(0);
+				cx1 = getValue(1);
+			}
+			else
+			{
+				const float dy{ static_cast<float>(static_cast<int>(tileY + pixelY) - static_cast<int>(rData.aabb[0] & 0xFFFF)) };
+				const float dx{ static_cast<float>(static_cast<int>(tileX + pixelX) - static_cast<int>(rData.aabb[0] >> 16)) };
+				cx0 = rData.edgeEq[6] + rData.edgeEq[1] * dy + rData.edgeEq[0] * dx;
+				cx1 = rData.edgeEq[7] + rData.edgeEq[3] * dy + rData.edgeEq[2] * dx;
+			}
+		}
+
+		// Where the fine stage gets the coverage of a triangle in a tile from
+		enum class ECoverage
+		{
+			Kernel, // binned, the coverage kernel or the quads of ECoverageMode::Quad
+			Full, // binned and accepted by the tile stage, every pixel
+			Point // micro triangle, GetPointCoverage
+		};
+
+		// Coverage mask of the micro triangle path, only the pixels of the aabb are sampled, each with the edge values the coverage kernels step to
+		uint64_t GetPointCoverage(ERasterMode rasterMode, const RasterData& rData, const EdgeKernel::FixedTileEdges& fixedEdges, uint32_t tileX, uint32_t tileY)
+		{
+			// Inclusive bounds, a pixel on the max corner can be covered, inside the tile for a micro triangle
+			const uint32_t minX{ (rData.aabb[0] >> 16) - tileX }, minY{ (rData.aabb[0] & 0xFFFF) - tileY };
+			const uint32_t maxX{ (rData.aabb[1] >> 16) - tileX }, maxY{ (rData.aabb[1] & 0xFFFF) - tileY };
+
+			uint64_t coverage{ 0 };
+			for (uint32_t pixelY{ minY }; pixelY <= maxY; ++pixelY)
+			{
+				for (uint32_t pixelX{ minX }; pixelX <= maxX; ++pixelX)
+				{
+					bool isCovered{ true };
+					for (uint32_t edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+					{
+						if (rasterMode == ERasterMode::FixedPoint)
+						{
+							const int32_t x{ static_cast<int32_t>(pixelX) }, y{ static_cast<int32_t>(pixelY) };
+							isCovered = isCovered && fixedEdges.origin[edgeIdx] + fixedEdges.stepX[edgeIdx] * x + fixedEdges.stepY[edgeIdx] * y > 0;
+						}
+						else
+						{
+							const float dy{ static_cast<float>(static_cast<int>(tileY + pixelY) - static_cast<int>(rData.aabb[0] & 0xFFFF)) };
+							const float dx{ static_cast<float>(static_cast<int>(tileX + pixelX) - static_cast<int>(rData.aabb[0] >> 16)) };
+							isCovered = isCovered && rData.edgeEq[6 + edgeIdx] + rData.edgeEq[1 + edgeIdx * 2] * dy + rData.edgeEq[edgeIdx * 2] * dx > 0.f;
+						}
+					}
+					coverage |= static_cast<uint64_t>(isCovered) << (pixelY * TILE_SIZE + pixelX);
+				}
+			}
+
+			return coverage;
+		}
+
+		// Screen space weights of the 3 vertices, a negative invArea marks a back face set up with vertices 1 and 2 swapped
+		inline void GetWeights(const RasterData& rData, float cx0, float cx1, float& weightX, float& weightY, float& weightZ)
+		{
+			const float invArea{ std::abs(rData.invArea) };
+			weightX = cx0 * invArea;
+			weightY = cx1 * invArea;
+			weightZ = 1.f - weightX - weightY;
+			if (rData.invArea < 0.f)
+				std::swap(weightY, weightZ);
+		}
+
+		// Lambert diffuse of the perspective correct normal, packed like the render target
+		uint32_t ShadePixel(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, float weightX, float weightY, float weightZ)
+		{
+			const float w{ 1.f / (v0.position.w * weightX + v1.position.w * weightY + v2.position.w * weightZ) };
+			float normalX{ (v0.normal.x * weightX + v1.normal.x * weightY + v2.normal.x * weightZ) * w };
+			float normalY{ (v0.normal.y * weightX + v1.normal.y * weightY + v2.normal.y * weightZ) * w };
+			float normalZ{ (v0.normal.z * weightX + v1.normal.z * weightY + v2.normal.z * weightZ) * w };
+			const float invLength{ 1.f / std::sqrt(normalX * normalX + normalY * normalY + normalZ * normalZ) };
+			normalX *= invLength;
+			normalY *= invLength;
+			normalZ *= invLength;
+
+			const float lambert{ -(normalX * LIGHT_DIR.x + normalY * LIGHT_DIR.y + normalZ * LIGHT_DIR.z) };
+			const float diffuseStrength{ (std::min)((std::max)(lambert, 0.f), 1.f) * LIGHT_INTENSITY / PI };
+			return FrameBuffer::PackColor(0.5f * diffuseStrength, 0.5f * diffuseStrength, 0.5f * diffuseStrength, 1.f);
+		}
+	}
+
+	Pipeline::Pipeline(const RasterConfig& rasterConfig, uint32_t workerCount, EInstructionSet instructionSet, ERasterMode rasterMode, EShadingMode shadingMode, ECullMode cullMode, ECoverageMode coverageMode)
+		: m_pConfigError{ GetConfigError(rasterConfig) }
+		, m_RasterConfig{ m_pConfigError == nullptr ? rasterConfig : RasterConfig{} }
+		, m_GuardBandPixels{ m_RasterConfig.GetGuardBandPixels(rasterMode) }
+		, m_WorkerCount{ workerCount != 0 ? workerCount : (std::max)(1u, std::thread::hardware_concurrency()) }
+		, m_InstructionSet{ (std::min)(instructionSet, EdgeKernel::GetSupportedInstructionSet()) }
+		, m_RasterMode{ rasterMode }
+		, m_ShadingMode{ shadingMode }
+		, m_CullMode{ cullMode }
+		, m_CoverageMode{ coverageMode }
+		, m_pCoverageKernel{ EdgeKernel::GetKernel(m_InstructionSet, m_RasterMode) }
+		, m_StageTimings{}
+		, m_CullStats{}
+		, m_ClipStats{}
+		, m_MicroStats{}
+		, m_BinStats{}
+		, m_OverlapStats{}
+		, m_CoverageStats{}
+		, m_QuadStats{}
+		, m_HiZStats{}
+		, m_Scheduler{ m_WorkerCount }
+		, m_FineWorkerStats{}
+		, m_BinOrder{ GetMortonOrder(m_RasterConfig.GetBinCount(), [this](uint32_t binIdx, uint32_t& x, uint32_t& y)
+			{
+				x = binIdx % m_RasterConfig.GetBinningDimsX();
+				y = binIdx / m_RasterConfig.GetBinningDimsX();
+				return true;
+			}) }
+		, m_TileOrder{ GetMortonOrder(m_RasterConfig.GetTileCount(), [this](uint32_t tileIdx, uint32_t& x, uint32_t& y)
+			{
+				const uint32_t binSize{ m_RasterConfig.binSize };
+				const uint32_t binIdx{ tileIdx / m_RasterConfig.GetBinTileCount() };
+				const uint32_t binTileId{ tileIdx % m_RasterConfig.GetBinTileCount() };
+				x = binIdx % m_RasterConfig.GetBinningDimsX() * binSize + binTileId % binSize;
+				y = binIdx / m_RasterConfig.GetBinningDimsX() * binSize + binTileId / binSize;
+				return x * TILE_SIZE < m_RasterConfig.viewportWidth && y * TILE_SIZE < m_RasterConfig.viewportHeight;
+			}) }
+		, m_VertexOut{}
+		, m_RasterData{}
+		, m_ClipVertexOut(static_cast<size_t>(Clipping::MAX_CLIP_TRIANGLES) * 3)
+		, m_BinOffset(3 * GetBinOffsetCount(m_RasterConfig), 0)
+		, m_BinHeaders{}
+		, m_BinStream{}
+		, m_TileBuffer{}
+		, m_pMicroTileCounter{ std::make_unique<std::atomic<uint32_t>[]>(m_RasterConfig.GetTileCount()) }
+		, m_MicroTileBuffer(static_cast<size_t>(m_RasterConfig.GetTileCount()) * MICRO_TILE_CAPACITY)
+		, m_VisibilityBuffer(shadingMode == EShadingMode::VisibilityBuffer ? static_cast<size_t>(m_RasterConfig.viewportWidth) * m_RasterConfig.viewportHeight : 0)
+	{}
+
+	const wchar_t* Pipeline::GetConfigError(const RasterConfig& rasterConfig)
+	{
+		if (const wchar_t* error{ rasterConfig.GetError() })
+			return error;
+		if (rasterConfig.tileSize != TILE_SIZE)
+			return L"The CPU pipeline only runs 8 pixel tiles, the coverage kernels keep a tile in a 64 bit mask";
+		return nullptr;
+	}
+
+	void Pipeline::Init(uint32_t vCount, uint32_t triangleCount)
+	{
+		m_VertexOut.resize((std::max)(std::size(m_VertexOut), static_cast<size_t>(vCount)));
+		m_RasterData.resize((std::max)(std::size(m_RasterData), static_cast<size_t>(triangleCount) + Clipping::MAX_CLIP_TRIANGLES));
+	}
+
+	template<typename FNC>
+	void Pipeline::ParallelFor(uint32_t groupCount, FNC&& fnc) const
+	{
+		std::atomic<uint32_t> nextGroup{ 0 };
+		const auto worker{ [&]()
+			{
+				for (uint32_t groupIdx{ nextGroup++ }; groupIdx < groupCount; groupIdx = nextGroup++)
+					fnc(groupIdx);
+			} };
+
+		// The calling thread is one of the workers
+		const uint32_t threadCount{ (std::min)(m_WorkerCount, groupCount) };
+		std::vector<std::thread> workers{};
+		workers.reserve(threadCount);
+		for (uint32_t threadIdx{ 1 }; threadIdx < threadCount; ++threadIdx)
+			workers.emplace_back(worker);
+
+		worker();
+
+		for (std::thread& workerThread : workers)
+			workerThread.join();
+	}
+
+	void Pipeline::Dispatch(const MeshData& meshData, const MeshLod& lod, const DirectX::XMFLOAT4X4& worldViewProj, const DirectX::XMFLOAT4X4& world, FrameBuffer& frameBuffer)
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Milliseconds = std::chrono::duration<double, std::milli>;
+
+		if (m_pConfigError != nullptr)
+		{
+			std::wcout << L"Error: Invalid raster config: " << m_pConfigError << L".\n";
+			return;
+		}
+
+		if (frameBuffer.GetWidth() != m_RasterConfig.viewportWidth || frameBuffer.GetHeight() != m_RasterConfig.viewportHeight)
+		{
+			std::wcout << L"Error: The CPU pipeline renders to " << m_RasterConfig.viewportWidth << L"x" << m_RasterConfig.viewportHeight << L" frame buffers.\n";
+			return;
+		}
+
+		const uint32_t triangleCount{ lod.indexCount / 3 };
+		const uint32_t* pindices{ std::data(meshData.indices) + lod.indexOffset };
+		Init(meshData.GetVertexCount(), triangleCount);
+
+		const Clock::time_point vertexStart{ Clock::now() };
+		RunVertexStage(meshData, worldViewProj, world);
+		const Clock::time_point setupStart{ Clock::now() };
+		const uint32_t clipTriangleCount{ RunGeometrySetup(pindices, triangleCount) };
+		const Clock::time_point binningStart{ Clock::now() };
+		RunBinning(triangleCount, clipTriangleCount);
+		const Clock::time_point tilingStart{ Clock::now() };
+		m_HiZStats = HiZStats{};
+		RunTiling(frameBuffer);
+		const Clock::time_point fineStart{ Clock::now() };
+		RunFine(pindices, triangleCount, frameBuffer);
+		const Clock::time_point shadingStart{ Clock::now() };
+		if (m_ShadingMode == EShadingMode::VisibilityBuffer)
+			RunShading(pindices, triangleCount, frameBuffer);
+		const Clock::time_point shadingEnd{ Clock::now() };
+
+		m_StageTimings.vertex = Milliseconds(setupStart - vertexStart).count();
+		m_StageTimings.geometrySetup = Milliseconds(binningStart - setupStart).count();
+		m_StageTimings.binning = Milliseconds(tilingStart - binningStart).count();
+		m_StageTimings.tiling = Milliseconds(fineStart - tilingStart).count();
+		m_StageTimings.fine = Milliseconds(shadingStart - fineStart).count();
+		m_StageTimings.shading = Milliseconds(shadingEnd - shadingStart).count();
+	}
+
+	void Pipeline::RunVertexStage(const MeshData& meshData, const DirectX::XMFLOAT4X4& worldViewProj, const DirectX::XMFLOAT4X4& world)
+	{
+		using namespace DirectX;
+
+		const uint32_t vCount{ meshData.GetVertexCount() };
+		const XMMATRIX xmWorldViewProj{ XMLoadFloat4x4(&worldViewProj) };
+		const XMMATRIX xmWorld{ XMLoadFloat4x4(&world) };
+		const float viewportWidth{ static_cast<float>(m_RasterConfig.viewportWidth) };
+		const float viewportHeight{ static_cast<float>(m_RasterConfig.viewportHeight) };
+
+		ParallelFor((vCount + VERTEX_GROUP_SIZE - 1) / VERTEX_GROUP_SIZE, [&](uint32_t groupIdx)
+			{
+				const uint32_t vEnd{ (std::min)(vCount, (groupIdx + 1) * VERTEX_GROUP_SIZE) };
+				for (uint32_t vIdx{ groupIdx * VERTEX_GROUP_SIZE }; vIdx < vEnd; ++vIdx)
+				{
+					const MeshVertex& vIn{ meshData.vertices[vIdx] };
+					Vertex_Out& vOut{ m_VertexOut[vIdx] };
+
+					// The shaders read the matrices untransposed, so mul(matrix, v) is a row vector transform
+					XMFLOAT4 clipPosition{};
+					XMStoreFloat4(&clipPosition, XMVector3Transform(XMLoadFloat3(&vIn.position), xmWorldViewProj));
+					XMStoreFloat3(&vOut.normal, XMVector3TransformNormal(XMLoadFloat3(&vIn.normal), xmWorld));
+
+					// A vertex the clipper may cut keeps its clip space position, behind the eye the screen one is meaningless
+					vOut.outcode = Clipping::GetOutcode(clipPosition, viewportWidth, viewportHeight, m_GuardBandPixels);
+					vOut.position = (vOut.outcode & Clipping::CLIP_OUTCODE) != 0 ? clipPosition : Clipping::ClipToScreen(clipPosition, viewportWidth, viewportHeight);
+				}
+			});
+	}
+
+	uint32_t Pipeline::RunGeometrySetup(const uint32_t* pindices, uint32_t triangleCount)
+	{
+		std::atomic<uint32_t> culledTriangleCount{ 0 };
+		std::atomic<uint32_t> degenerateTriangleCount{ 0 };
+		std::atomic<uint32_t> rejectedTriangleCount{ 0 };
+		std::atomic<uint32_t> clippedTriangleCount{ 0 };
+		// Next clip triangle slot, the clipped triangles of every group claim theirs from it
+		std::atomic<uint32_t> clipTriangleCounter{ 0 };
+		std::atomic<uint32_t> microTriangleCount{ 0 };
+		std::atomic<uint32_t> quadTriangleCount{ 0 };
+		std::atomic<uint32_t> regularTriangleCount{ 0 };
+		std::atomic<uint32_t> overflowTriangleCount{ 0 };
+
+		for (uint32_t tileIdx{}; tileIdx < m_RasterConfig.GetTileCount(); ++tileIdx)
+			m_pMicroTileCounter[tileIdx].store(0, std::memory_order_relaxed);
+
+		ParallelFor((triangleCount + SETUP_GROUP_SIZE - 1) / SETUP_GROUP_SIZE, [&](uint32_t groupIdx)
+			{
+				CullStats groupCullStats{};
+				ClipStats groupClipStats{};
+				MicroStats groupMicroStats{};
+				const uint32_t triEnd{ (std::min)(triangleCount, (groupIdx + 1) * SETUP_GROUP_SIZE) };
+				for (uint32_t triIdx{ groupIdx * SETUP_GROUP_SIZE }; triIdx < triEnd; ++triIdx)
+				{
+					RasterData& data{ m_RasterData[triIdx] };
+					data = SetupTriangle(pindices + static_cast<size_t>(triIdx) * 3, triangleCount, clipTriangleCounter, groupCullStats, groupClipStats);
+					if (data.isClipped == 0)
+						RouteTriangle(triIdx, data, groupMicroStats);
+				}
+
+				if (groupCullStats.culledTriangleCount != 0)
+					culledTriangleCount += groupCullStats.culledTriangleCount;
+				if (groupCullStats.degenerateTriangleCount != 0)
+					degenerateTriangleCount += groupCullStats.degenerateTriangleCount;
+				if (groupClipStats.rejectedTriangleCount != 0)
+					rejectedTriangleCount += groupClipStats.rejectedTriangleCount;
+				if (groupClipStats.clippedTriangleCount != 0)
+					clippedTriangleCount += groupClipStats.clippedTriangleCount;
+				if (groupMicroStats.microTriangleCount != 0)
+					microTriangleCount += groupMicroStats.microTriangleCount;
+				if (groupMicroStats.quadTriangleCount != 0)
+					quadTriangleCount += groupMicroStats.quadTriangleCount;
+				if (groupMicroStats.regularTriangleCount != 0)
+					regularTriangleCount += groupMicroStats.regularTriangleCount;
+				if (groupMicroStats.overflowTriangleCount != 0)
+					overflowTriangleCount += groupMicroStats.overflowTriangleCount;
+			});
+
+		const uint32_t clipTriangleCount{ clipTriangleCounter };
+		m_CullStats.culledTriangleCount = culledTriangleCount;
+		m_CullStats.degenerateTriangleCount = degenerateTriangleCount;
+		m_ClipStats.rejectedTriangleCount = rejectedTriangleCount;
+		m_ClipStats.clippedTriangleCount = clippedTriangleCount;
+		m_ClipStats.clipTriangleCount = (std::min)(clipTriangleCount, Clipping::MAX_CLIP_TRIANGLES);
+		m_ClipStats.droppedClipTriangleCount = clipTriangleCount - m_ClipStats.clipTriangleCount;
+		m_MicroStats.microTriangleCount = microTriangleCount;
+		m_MicroStats.quadTriangleCount = quadTriangleCount;
+		m_MicroStats.regularTriangleCount = regularTriangleCount;
+		m_MicroStats.overflowTriangleCount = overflowTriangleCount;
+		return clipTriangleCount;
+	}
+
+	RasterData Pipeline::SetupTriangle(const uint32_t* ptri, uint32_t triangleCount, std::atomic<uint32_t>& clipTriangleCounter, CullStats& cullStats, ClipStats& clipStats)
+	{
+		// Rejected, clipped, culled and degenerate triangles are all skipped by binning
+		RasterData data{};
+		data.isClipped = 1;
+
+		if (ptri[0] == ptri[1] || ptri[1] == ptri[2] || ptri[0] == ptri[2])
+		{
+			++cullStats.degenerateTriangleCount;
+			return data;
+		}
+
+		const Vertex_Out* pvertices[3]{ &m_VertexOut[ptri[0]], &m_VertexOut[ptri[1]], &m_VertexOut[ptri[2]] };
+		const uint32_t outcodes[3]{ pvertices[0]->outcode, pvertices[1]->outcode, pvertices[2]->outcode };
+
+		// All the vertices outside the same plane of the view volume
+		if ((outcodes[0] & outcodes[1] & outcodes[2] & Clipping::REJECT_OUTCODE) != 0)
+		{
+			++clipStats.rejectedTriangleCount;
+			return data;
+		}
+
+		// Crossing the near or far plane or leaving the guard band, its slot stays skipped and the clip triangles are set up in their own
+		if (((outcodes[0] | outcodes[1] | outcodes[2]) & Clipping::CLIP_OUTCODE) != 0)
+		{
+			ClipTriangle(pvertices, triangleCount, clipTriangleCounter, cullStats, clipStats);
+			return data;
+		}
+
+		return SetupRasterData(pvertices[0]->position, pvertices[1]->position, pvertices[2]->position, cullStats);
+	}
+
+	void Pipeline::ClipTriangle(const Vertex_Out* pvertices[3], uint32_t triangleCount, std::atomic<uint32_t>& clipTriangleCounter, CullStats& cullStats, ClipStats& clipStats)
+	{
+		const float viewportWidth{ static_cast<float>(m_RasterConfig.viewportWidth) };
+		const float viewportHeight{ static_cast<float>(m_RasterConfig.viewportHeight) };
+
+		// The vertices inside every clip plane are in screen space, back to clip space for the clipper
+		Clipping::ClipVertex polygon[Clipping::MAX_POLYGON_VERTICES]{};
+		DirectX::XMFLOAT4 sourcePositions[3]{};
+		for (uint32_t vIdx{}; vIdx < 3; ++vIdx)
+		{
+			const Vertex_Out& vertex{ *pvertices[vIdx] };
+			sourcePositions[vIdx] = (vertex.outcode & Clipping::CLIP_OUTCODE) != 0 ? vertex.position : Clipping::ScreenToClip(vertex.position, viewportWidth, viewportHeight);
+			polygon[vIdx].position = sourcePositions[vIdx];
+			polygon[vIdx].normal = vertex.normal;
+		}
+
+		const uint32_t vCount{ Clipping::ClipPolygon(polygon, 3, Clipping::CLIP_OUTCODE, viewportWidth, viewportHeight, m_GuardBandPixels) };
+		if (vCount < 3)
+		{
+			++clipStats.rejectedTriangleCount;
+			return;
+		}
+
+		// The vertices the clipper kept reuse their screen position, the round trip through clip space would not give it back bit for bit
+		Vertex_Out screenPolygon[Clipping::MAX_POLYGON_VERTICES]{};
+		for (uint32_t vIdx{}; vIdx < vCount; ++vIdx)
+		{
+			screenPolygon[vIdx].position = Clipping::ClipToScreen(polygon[vIdx].position, viewportWidth, viewportHeight);
+			screenPolygon[vIdx].normal = polygon[vIdx].normal;
+
+			for (uint32_t sourceIdx{}; sourceIdx < 3; ++sourceIdx)
+			{
+				const Vertex_Out& source{ *pvertices[sourceIdx] };
+				if ((source.outcode & Clipping::CLIP_OUTCODE) == 0 && IsEqual(polygon[vIdx].position, sourcePositions[sourceIdx]))
+					screenPolygon[vIdx].position = source.position;
+			}
+		}
+
+		// Face and degenerate tests on the whole polygon, so a culled one claims no slot, with the winding of the fan
+		float doubleArea{ 0.f };
+		const DirectX::XMFLOAT4& p0{ screenPolygon[0].position };
+		for (uint32_t vIdx{ 1 }; vIdx + 1 < vCount; ++vIdx)
+		{
+			const DirectX::XMFLOAT4& p1{ screenPolygon[vIdx].position };
+			const DirectX::XMFLOAT4& p2{ screenPolygon[vIdx + 1].position };
+			doubleArea += Cross2d(p0.x - p2.x, p0.y - p2.y, p1.x - p2.x, p1.y - p2.y);
+		}
+
+		if (TriangleCulling::IsDegenerate(doubleArea))
+		{
+			++cullStats.degenerateTriangleCount;
+			return;
+		}
+
+		if (TriangleCulling::IsCulled(doubleArea, m_CullMode))
+		{
+			++cullStats.culledTriangleCount;
+			return;
+		}
+
+		++clipStats.clippedTriangleCount;
+
+		// Fanned from the first vertex, the slots past MAX_CLIP_TRIANGLES are counted and dropped
+		const uint32_t fanCount{ vCount - 2 };
+		const uint32_t firstSlot{ clipTriangleCounter.fetch_add(fanCount) };
+		for (uint32_t fanIdx{}; fanIdx < fanCount && firstSlot + fanIdx < Clipping::MAX_CLIP_TRIANGLES; ++fanIdx)
+		{
+			const uint32_t slot{ firstSlot + fanIdx };
+			Vertex_Out* pclipVertices{ std::data(m_ClipVertexOut) + static_cast<size_t>(slot) * 3 };
+			pclipVertices[0] = screenPolygon[0];
+			pclipVertices[1] = screenPolygon[fanIdx + 1];
+			pclipVertices[2] = screenPolygon[fanIdx + 2];
+
+			m_RasterData[static_cast<size_t>(triangleCount) + slot] = SetupRasterData(pclipVertices[0].position, pclipVertices[1].position, pclipVertices[2].position, cullStats);
+		}
+	}
+
+	RasterData Pipeline::SetupRasterData(const DirectX::XMFLOAT4& v0, const DirectX::XMFLOAT4& v1, const DirectX::XMFLOAT4& v2, CullStats& cullStats) const
+	{
+		RasterData data{};
+		data.isClipped = 1;
+
+		int32_t snapped[6]{};
+		float doubleArea{};
+		if (m_RasterMode == ERasterMode::FixedPoint)
+		{
+			snapped[0] = FixedPointEdges::SnapCoordinate(v0.x);
+			snapped[1] = FixedPointEdges::SnapCoordinate(v0.y);
+			snapped[2] = FixedPointEdges::SnapCoordinate(v1.x);
+			snapped[3] = FixedPointEdges::SnapCoordinate(v1.y);
+			snapped[4] = FixedPointEdges::SnapCoordinate(v2.x);
+			snapped[5] = FixedPointEdges::SnapCoordinate(v2.y);
+
+			// Of the snapped vertices, the ones the edge functions are built from
+			doubleArea = Cross2d(static_cast<float>(snapped[0] - snapped[4]), static_cast<float>(snapped[1] - snapped[5]), static_cast<float>(snapped[2] - snapped[4]), static_cast<float>(snapped[3] - snapped[5]));
+		}
+		else
+			doubleArea = Cross2d(v0.x - v2.x, v0.y - v2.y, v1.x - v2.x, v1.y - v2.y);
+
+		if (TriangleCulling::IsDegenerate(doubleArea))
+		{
+			++cullStats.degenerateTriangleCount;
+			return data;
+		}
+
+		if (TriangleCulling::IsCulled(doubleArea, m_CullMode))
+		{
+			++cullStats.culledTriangleCount;
+			return data;
+		}
+
+		data.isClipped = 0;
+
+		// A drawn back face, its edge functions are built in front face order
+		const bool isFlipped{ doubleArea < 0.f };
+
+		// Clamped to the viewport, the guard band reaches past it, then the min corner is truncated and the max corner rounded up as GetAabb does
+		const uint32_t minX{ static_cast<uint32_t>((std::max)((std::min)({ v0.x, v1.x, v2.x }), 0.f)) };
+		const uint32_t minY{ static_cast<uint32_t>((std::max)((std::min)({ v0.y, v1.y, v2.y }), 0.f)) };
+		const uint32_t maxX{ static_cast<uint32_t>((std::min)(std::ceil((std::max)({ v0.x, v1.x, v2.x })), static_cast<float>(m_RasterConfig.viewportWidth))) };
+		const uint32_t maxY{ static_cast<uint32_t>((std::min)(std::ceil((std::max)({ v0.y, v1.y, v2.y })), static_cast<float>(m_RasterConfig.viewportHeight))) };
+
+		if (m_RasterMode == ERasterMode::FixedPoint)
+		{
+			if (isFlipped)
+			{
+				std::swap(snapped[2], snapped[4]);
+				std::swap(snapped[3], snapped[5]);
+			}
+
+			const int32_t s0x{ snapped[0] }, s0y{ snapped[1] };
+			const int32_t s1x{ snapped[2] }, s1y{ snapped[3] };
+			const int32_t s2x{ snapped[4] }, s2y{ snapped[5] };
+			std::copy_n(snapped, 6, data.fixedEdge);
+
+			// Edge i is opposite to vertex i and starts at the next one, like the float equations
+			data.fixedEdge[6] = FixedPointEdges::GetThreshold(s1y - s2y, s2x - s1x, s1x, s1y);
+			data.fixedEdge[7] = FixedPointEdges::GetThreshold(s2y - s0y, s0x - s2x, s2x, s2y);
+			data.fixedEdge[8] = FixedPointEdges::GetThreshold(s0y - s1y, s1x - s0x, s0x, s0y);
+
+			// The edge functions are 1/256 of the sub pixel area, the weights stay area ratios
+			data.invArea = static_cast<float>(FixedPointEdges::SUBPIXEL_SCALE) / doubleArea;
+		}
+		else
+		{
+			const DirectX::XMFLOAT4& p1{ isFlipped ? v2 : v1 };
+			const DirectX::XMFLOAT4& p2{ isFlipped ? v1 : v2 };
+
+			data.edgeEq[0] = p1.y - p2.y;
+			data.edgeEq[1] = p2.x - p1.x;
+
+			data.edgeEq[2] = p2.y - v0.y;
+			data.edgeEq[3] = v0.x - p2.x;
+
+			data.edgeEq[4] = v0.y - p1.y;
+			data.edgeEq[5] = p1.x - v0.x;
+
+			const float aabbX{ static_cast<float>(minX) }, aabbY{ static_cast<float>(minY) };
+			data.edgeEq[6] = data.edgeEq[0] * aabbX + data.edgeEq[1] * aabbY + Cross2d(p1.x, p1.y, p2.x, p2.y);
+			data.edgeEq[7] = data.edgeEq[2] * aabbX + data.edgeEq[3] * aabbY + Cross2d(p2.x, p2.y, v0.x, v0.y);
+			data.edgeEq[8] = data.edgeEq[4] * aabbX + data.edgeEq[5] * aabbY + Cross2d(v0.x, v0.y, p1.x, p1.y);
+
+			data.invArea = 1.f / doubleArea;
+		}
+
+		data.aabb[0] = (minX << 16) | minY;
+		data.aabb[1] = (maxX << 16) | maxY;
+		data.invZ = DirectX::XMFLOAT3{ 1.f / v0.z, 1.f / v1.z, 1.f / v2.z };
+		return data;
+	}
+
+	void Pipeline::RouteTriangle(uint32_t triIdx, RasterData& data, MicroStats& microStats)
+	{
+		// Inclusive pixel bounds, the tile past the viewport side has no micro list
+		const uint32_t minX{ data.aabb[0] >> 16 }, minY{ data.aabb[0] & 0xFFFF };
+		const uint32_t maxX{ data.aabb[1] >> 16 }, maxY{ data.aabb[1] & 0xFFFF };
+		const uint32_t tileX{ minX / TILE_SIZE }, tileY{ minY / TILE_SIZE };
+		if (tileX != maxX / TILE_SIZE || tileY != maxY / TILE_SIZE || maxX >= m_RasterConfig.viewportWidth || maxY >= m_RasterConfig.viewportHeight)
+		{
+			++microStats.regularTriangleCount;
+			return;
+		}
+
+		// Tiles are stored bin by bin, like the ones of the fine stage
+		const uint32_t binSize{ m_RasterConfig.binSize };
+		const uint32_t binIdx{ tileY / binSize * m_RasterConfig.GetBinningDimsX() + tileX / binSize };
+		const uint32_t tileIdx{ binIdx * m_RasterConfig.GetBinTileCount() + tileY % binSize * binSize + tileX % binSize };
+		const uint32_t slot{ m_pMicroTileCounter[tileIdx].fetch_add(1, std::memory_order_relaxed) };
+		if (slot >= MICRO_TILE_CAPACITY)
+		{
+			++microStats.regularTriangleCount;
+			++microStats.overflowTriangleCount;
+			return;
+		}
+
+		m_MicroTileBuffer[static_cast<size_t>(tileIdx) * MICRO_TILE_CAPACITY + slot] = triIdx;
+		// Skipped by binning like the clipped triangles, its raster data stays valid for the fine and shading stages
+		data.isClipped = 1;
+		++microStats.microTriangleCount;
+		if (maxX - minX <= 1 && maxY - minY <= 1)
+			++microStats.quadTriangleCount;
+	}
+
+	void Pipeline::RunBinning(uint32_t triangleCount, uint32_t clipTriangleCount)
+	{
+		const uint32_t queueCount{ m_RasterConfig.queueCount };
+		const uint32_t binCount{ m_RasterConfig.GetBinCount() };
+		const size_t binOffsetCount{ GetBinOffsetCount(m_RasterConfig) };
+		const size_t triangleOffset{ 0 }, blockOffset{ binOffsetCount }, wordOffset{ 2 * binOffsetCount };
+		const uint32_t batchSize{ GetBatchSize(triangleCount, queueCount) };
+		// The clip triangle slots past the last emitted one hold stale data
+		const uint32_t rasterTriangleCount{ triangleCount + (std::min)(clipTriangleCount, Clipping::MAX_CLIP_TRIANGLES) };
+
+		// One group per queue, each counts then appends its batch in triangle order to its own range of every bin it overlaps, returns the bins its edges missed
+		const auto binBatch{ [&](uint32_t queueIdx, auto&& fnc)
+			{
+				const uint32_t batchStart{ batchSize * queueIdx };
+				const uint32_t batchEnd{ (std::min)(rasterTriangleCount, batchStart + batchSize) };
+				uint32_t missedCount{ 0 };
+				for (uint32_t triIdx{ batchStart }; triIdx < batchEnd; ++triIdx)
+				{
+					const RasterData& triData{ m_RasterData[triIdx] };
+					if (!triData.isClipped)
+						missedCount += ForEachBin(m_RasterConfig, m_RasterMode, triData, [&](uint32_t binIdx) { fnc(binIdx, triIdx); });
+				}
+
+				return missedCount;
+			} };
+
+		// Count pass of BinRasterizer, the triangles of every bin and the blocks and delta words they are coded in
+		std::atomic<uint32_t> missedBinCount{ 0 };
+		ParallelFor(queueCount, [&](uint32_t queueIdx)
+			{
+				std::vector<uint32_t> binTriCounts(binCount, 0);
+				std::vector<uint32_t> binLastTris(binCount, 0);
+				std::vector<uint32_t> binByteCounts(binCount, 0);
+				missedBinCount += binBatch(queueIdx, [&](uint32_t binIdx, uint32_t triIdx)
+					{
+						if (binTriCounts[binIdx]++ % BinList::BLOCK_SIZE != 0)
+							binByteCounts[binIdx] += BinList::GetVarintSize(triIdx - binLastTris[binIdx] - 1);
+						binLastTris[binIdx] = triIdx;
+					});
+
+				for (uint32_t binIdx{}; binIdx < binCount; ++binIdx)
+				{
+					const size_t queueEntry{ static_cast<size_t>(binIdx) * queueCount + queueIdx };
+					m_BinOffset[triangleOffset + queueEntry] = binTriCounts[binIdx];
+					m_BinOffset[blockOffset + queueEntry] = (binTriCounts[binIdx] + BinList::BLOCK_SIZE - 1) / BinList::BLOCK_SIZE;
+					m_BinOffset[wordOffset + queueEntry] = (binByteCounts[binIdx] + 3) / 4;
+				}
+			});
+
+		// BinScan, the queues of a bin end up back to back in queue order in each array
+		for (const size_t arrayOffset : { triangleOffset, blockOffset, wordOffset })
+		{
+			const auto arrayBegin{ std::begin(m_BinOffset) + static_cast<ptrdiff_t>(arrayOffset) };
+			arrayBegin[static_cast<ptrdiff_t>(binOffsetCount) - 1] = 0;
+			std::exclusive_scan(arrayBegin, arrayBegin + static_cast<ptrdiff_t>(binOffsetCount), arrayBegin, 0u);
+		}
+
+		const BinList::Sizes sizes{ m_BinOffset[triangleOffset + binOffsetCount - 1], m_BinOffset[blockOffset + binOffsetCount - 1], m_BinOffset[wordOffset + binOffsetCount - 1] };
+		m_BinHeaders.resize((std::max)(std::size(m_BinHeaders), static_cast<size_t>(sizes.blockCount)));
+		m_BinStream.resize((std::max)(std::size(m_BinStream), static_cast<size_t>(sizes.wordCount) * 4));
+		m_TileBuffer.resize((std::max)(std::size(m_TileBuffer), static_cast<size_t>(sizes.triangleCount)));
+		m_BinStats.binTrianglePairCount = sizes.triangleCount;
+		m_BinStats.encodedByteCount = sizes.GetEncodedByteCount();
+		m_BinStats.rawByteCount = sizes.GetRawByteCount();
+		m_OverlapStats.missedBinCount = missedBinCount;
+
+		// Scatter pass of BinRasterizer, a header starts every block and the other triangles append their delta to the words of the queue
+		ParallelFor(queueCount, [&](uint32_t queueIdx)
+			{
+				std::vector<uint32_t> binTriCounts(binCount, 0);
+				std::vector<uint32_t> binLastTris(binCount, 0);
+				std::vector<uint32_t> binCursors(binCount);
+				for (uint32_t binIdx{}; binIdx < binCount; ++binIdx)
+					binCursors[binIdx] = m_BinOffset[wordOffset + static_cast<size_t>(binIdx) * queueCount + queueIdx] * 4;
+
+				binBatch(queueIdx, [&](uint32_t binIdx, uint32_t triIdx)
+					{
+						const size_t queueEntry{ static_cast<size_t>(binIdx) * queueCount + queueIdx };
+						uint32_t& binTriCount{ binTriCounts[binIdx] };
+						if (binTriCount % BinList::BLOCK_SIZE == 0)
+						{
+							const uint32_t queueStart{ m_BinOffset[triangleOffset + queueEntry] };
+							const uint32_t queueTriCount{ m_BinOffset[triangleOffset + queueEntry + 1] - queueStart };
+							const uint32_t blockIdx{ m_BinOffset[blockOffset + queueEntry] + binTriCount / BinList::BLOCK_SIZE };
+							m_BinHeaders[blockIdx] = BinList::PackHeader(triIdx, binCursors[binIdx], queueStart + binTriCount, (std::min)(queueTriCount - binTriCount, BinList::BLOCK_SIZE));
+						}
+						else
+							binCursors[binIdx] += BinList::WriteVarint(std::data(m_BinStream) + binCursors[binIdx], triIdx - binLastTris[binIdx] - 1);
+
+						binLastTris[binIdx] = triIdx;
+						++binTriCount;
+					});
+			});
+	}
+
+	void Pipeline::RunTiling(const FrameBuffer& frameBuffer)
+	{
+		const FrameBuffer::TileDepth* ptileDepth{ frameBuffer.GetTileDepthData() };
+		const uint32_t tileCountX{ frameBuffer.GetTileCountX() };
+		const uint32_t binSize{ m_RasterConfig.binSize };
+		const uint32_t binTileCount{ m_RasterConfig.GetBinTileCount() };
+		const uint32_t binPixelSize{ m_RasterConfig.GetBinPixelSize() };
+		const uint32_t binningDimsX{ m_RasterConfig.GetBinningDimsX() };
+		const uint32_t queueCount{ m_RasterConfig.queueCount };
+		const size_t blockOffset{ GetBinOffsetCount(m_RasterConfig) };
+		std::atomic<uint32_t> rejectedTileCount{ 0 };
+		std::atomic<uint32_t> missedTileCount{ 0 };
+		std::atomic<uint32_t> fullBinCount{ 0 };
+		std::atomic<uint32_t> fullTileCount{ 0 };
+
+		// One group per bin, decodes the triangles of its queues and computes their tile coverage
+		m_Scheduler.Run(m_BinOrder, [&](uint32_t binIdx)
+			{
+				const uint32_t binX{ binIdx % binningDimsX * binPixelSize };
+				const uint32_t binY{ binIdx / binningDimsX * binPixelSize };
+				const uint32_t blockStart{ m_BinOffset[blockOffset + static_cast<size_t>(binIdx) * queueCount] };
+				const uint32_t blockEnd{ m_BinOffset[blockOffset + static_cast<size_t>(binIdx + 1) * queueCount] };
+
+				// Max depth of the bin tiles from the Hi-Z of the earlier draws, FLT_MAX past the viewport, lowered by the triangles of the bin covering them
+				float tileMaxDepth[RasterConfig::MAX_BIN_TILE_COUNT];
+				for (uint32_t binTileId{}; binTileId < binTileCount; ++binTileId)
+				{
+					const uint32_t tileX{ binX / TILE_SIZE + binTileId % binSize };
+					const uint32_t tileY{ binY / TILE_SIZE + binTileId / binSize };
+					const bool isInside{ tileX * TILE_SIZE < m_RasterConfig.viewportWidth && tileY * TILE_SIZE < m_RasterConfig.viewportHeight };
+					tileMaxDepth[binTileId] = isInside ? ptileDepth[tileY * tileCountX + tileX].maxDepth : FLT_MAX;
+				}
+
+				uint32_t binRejectedCount{ 0 };
+				uint32_t binMissedCount{ 0 };
+				uint32_t binFullCount{ 0 };
+				uint32_t binFullTileCount{ 0 };
+				// A TileRasterizer thread per block, its triangles are the running sum of the deltas from the first one of the header
+				for (uint32_t blockIdx{ blockStart }; blockIdx < blockEnd; ++blockIdx)
+				{
+					const BinList::BlockHeader& header{ m_BinHeaders[blockIdx] };
+					const uint32_t dataStart{ BinList::GetEntry(header) };
+					const uint32_t blockTriCount{ BinList::GetTriangleCount(header) };
+					uint32_t triIdx{ header.firstTriangle };
+					uint32_t byteOffset{ header.byteOffset };
+					for (uint32_t blockTri{}; blockTri < blockTriCount; ++blockTri)
+					{
+						if (blockTri != 0)
+							triIdx += BinList::ReadVarint(std::data(m_BinStream), byteOffset) + 1;
+
+						const RasterData& triData{ m_RasterData[triIdx] };
+
+						// Clamped to the bin, min corner rounded down and max corner rounded up to tiles
+						const uint32_t tileMinX{ (std::clamp(triData.aabb[0] >> 16, binX, binX + binPixelSize) - binX) / TILE_SIZE };
+						const uint32_t tileMinY{ (std::clamp(triData.aabb[0] & 0xFFFF, binY, binY + binPixelSize) - binY) / TILE_SIZE };
+						const uint32_t tileMaxX{ (std::clamp(triData.aabb[1] >> 16, binX, binX + binPixelSize) - binX + TILE_SIZE - 1) / TILE_SIZE };
+						const uint32_t tileMaxY{ (std::clamp(triData.aabb[1] & 0xFFFF, binY, binY + binPixelSize) - binY + TILE_SIZE - 1) / TILE_SIZE };
+
+						uint64_t coverage{ 0 };
+						if (tileMinX < tileMaxX)
+						{
+							const uint64_t rowMask{ ((1ull << (tileMaxX - tileMinX)) - 1) << tileMinX };
+							for (uint32_t tileY{ tileMinY }; tileY < tileMaxY; ++tileY)
+								coverage |= rowMask << (tileY * binSize);
+						}
+
+						// Trivial accept of the whole bin, then tiles the edges miss are dropped and the ones inside the inclusive pixel bounds of the triangle accepted
+						const uint32_t minX{ triData.aabb[0] >> 16 }, minY{ triData.aabb[0] & 0xFFFF };
+						const uint32_t maxX{ triData.aabb[1] >> 16 }, maxY{ triData.aabb[1] & 0xFFFF };
+						const auto isInside{ [&](uint32_t rectX, uint32_t rectY, uint32_t size)
+							{
+								return rectX >= minX && rectY >= minY && rectX + size - 1 <= maxX && rectY + size - 1 <= maxY;
+							} };
+
+						uint64_t fullCoverage{ 0 };
+						if (isInside(binX, binY, binPixelSize) && EdgeKernel::IsRectCovered(m_RasterMode, triData, binX, binY, binX + binPixelSize - 1, binY + binPixelSize - 1))
+						{
+							fullCoverage = coverage;
+							++binFullCount;
+						}
+						else
+						{
+							for (uint64_t tileMask{ coverage }; tileMask != 0; tileMask &= tileMask - 1)
+							{
+								const uint32_t binTileId{ EdgeKernel::FindFirstSetBit(tileMask) };
+								const uint32_t tileX{ binX + binTileId % binSize * TILE_SIZE };
+								const uint32_t tileY{ binY + binTileId / binSize * TILE_SIZE };
+								if (!EdgeKernel::IsRectOverlapped(m_RasterMode, triData, tileX, tileY, tileX + TILE_SIZE - 1, tileY + TILE_SIZE - 1))
+								{
+									coverage &= ~(1ull << binTileId);
+									++binMissedCount;
+								}
+								else if (isInside(tileX, tileY, TILE_SIZE) && EdgeKernel::IsRectCovered(m_RasterMode, triData, tileX, tileY, tileX + TILE_SIZE - 1, tileY + TILE_SIZE - 1))
+									fullCoverage |= 1ull << binTileId;
+							}
+						}
+
+						// Tiles already nearer than the nearest vertex of the triangle can not pass a depth test
+						const float triMinDepth{ 1.f / (std::max)({ triData.invZ.x, triData.invZ.y, triData.invZ.z }) };
+						for (uint64_t tileMask{ coverage }; tileMask != 0; tileMask &= tileMask - 1)
+						{
+							const uint32_t binTileId{ EdgeKernel::FindFirstSetBit(tileMask) };
+							if (triMinDepth >= tileMaxDepth[binTileId])
+							{
+								coverage &= ~(1ull << binTileId);
+								++binRejectedCount;
+							}
+						}
+
+						// Once shaded, no pixel of a tile the triangle covers is farther than its farthest vertex, the triangles after it are tested against that
+						fullCoverage &= coverage;
+						const float occluderDepth{ OCCLUDER_DEPTH_MARGIN / (std::min)({ triData.invZ.x, triData.invZ.y, triData.invZ.z }) };
+						for (uint64_t tileMask{ fullCoverage }; tileMask != 0; tileMask &= tileMask - 1)
+						{
+							const uint32_t binTileId{ EdgeKernel::FindFirstSetBit(tileMask) };
+							tileMaxDepth[binTileId] = (std::min)(tileMaxDepth[binTileId], occluderDepth);
+							++binFullTileCount;
+						}
+
+						BinData& data{ m_TileBuffer[dataStart + blockTri] };
+						data.coverage[0] = static_cast<uint32_t>(coverage);
+						data.coverage[1] = static_cast<uint32_t>(coverage >> 32);
+						data.fullCoverage[0] = static_cast<uint32_t>(fullCoverage);
+						data.fullCoverage[1] = static_cast<uint32_t>(fullCoverage >> 32);
+						data.triIdx = triIdx;
+					}
+				}
+
+				rejectedTileCount += binRejectedCount;
+				missedTileCount += binMissedCount;
+				fullBinCount += binFullCount;
+				fullTileCount += binFullTileCount;
+			});
+
+		m_HiZStats.rejectedTileCount = rejectedTileCount;
+		m_OverlapStats.missedTileCount = missedTileCount;
+		m_CoverageStats.fullBinCount = fullBinCount;
+		m_CoverageStats.fullTileCount = fullTileCount;
+	}
+
+	void Pipeline::RunFine(const uint32_t* pindices, uint32_t triangleCount, FrameBuffer& frameBuffer)
+	{
+		std::atomic<uint32_t> rejectedTriangleCount{ 0 };
+		std::atomic<uint32_t> rejectedQuadCount{ 0 };
+		std::atomic<uint32_t> acceptedQuadCount{ 0 };
+		std::atomic<uint32_t> partialQuadCount{ 0 };
+
+		std::fill(std::begin(m_VisibilityBuffer), std::end(m_VisibilityBuffer), VisibilityBuffer::EMPTY);
+
+		// One group per tile, where FineRasterizer3 pulls them from G_TILE_COUNTER the workers own Morton ordered ranges and steal from each other
+		m_Scheduler.Run(m_TileOrder, [&](uint32_t tileIdx)
+			{
+				EdgeKernel::QuadCounts quadCounts{};
+				const uint32_t tileRejectedCount{ ShadeTile(tileIdx, pindices, triangleCount, frameBuffer, quadCounts) };
+				if (tileRejectedCount != 0)
+					rejectedTriangleCount += tileRejectedCount;
+				if (quadCounts.rejectedQuadCount != 0)
+					rejectedQuadCount += quadCounts.rejectedQuadCount;
+				if (quadCounts.acceptedQuadCount != 0)
+					acceptedQuadCount += quadCounts.acceptedQuadCount;
+				if (quadCounts.partialQuadCount != 0)
+					partialQuadCount += quadCounts.partialQuadCount;
+			});
+
+		m_FineWorkerStats = m_Scheduler.GetWorkerStats();
+		m_HiZStats.rejectedTriangleCount = rejectedTriangleCount;
+		m_QuadStats.rejectedQuadCount = rejectedQuadCount;
+		m_QuadStats.acceptedQuadCount = acceptedQuadCount;
+		m_QuadStats.partialQuadCount = partialQuadCount;
+	}
+
+	void Pipeline::RunShading(const uint32_t* pindices, uint32_t triangleCount, FrameBuffer& frameBuffer)
+	{
+		// VisibilityShading, the weights come from the same edge functions the fine stage tested
+		const uint32_t viewportWidth{ m_RasterConfig.viewportWidth };
+		m_Scheduler.Run(m_TileOrder, [&](uint32_t tileIdx)
+			{
+				uint32_t tileX{}, tileY{};
+				GetTilePosition(tileIdx, tileX, tileY);
+
+				uint32_t shadedTriIdx{ VisibilityBuffer::EMPTY };
+				EdgeKernel::FixedTileEdges fixedEdges{};
+				for (uint32_t pixelY{}; pixelY < TILE_SIZE; ++pixelY)
+				{
+					const size_t rowStart{ static_cast<size_t>(tileY + pixelY) * viewportWidth + tileX };
+					for (uint32_t pixelX{}; pixelX < TILE_SIZE; ++pixelX)
+					{
+						const uint32_t id{ m_VisibilityBuffer[rowStart + pixelX] };
+						if (id == VisibilityBuffer::EMPTY)
+							continue;
+
+						const uint32_t triIdx{ VisibilityBuffer::GetTriangle(id) };
+						const RasterData& rData{ m_RasterData[triIdx] };
+						if (m_RasterMode == ERasterMode::FixedPoint && triIdx != shadedTriIdx)
+							EdgeKernel::SetupFixedTileEdges(rData, tileX, tileY, fixedEdges);
+						shadedTriIdx = triIdx;
+
+						float cx0{}, cx1{};
+						GetEdgeValues(m_RasterMode, rData, fixedEdges, tileX, tileY, pixelX, pixelY, cx0, cx1);
+						float weightX{}, weightY{}, weightZ{};
+						GetWeights(rData, cx0, cx1, weightX, weightY, weightZ);
+
+						const std::array<const Vertex_Out*, 3> vertices{ GetTriangleVertices(pindices, triangleCount, triIdx) };
+						frameBuffer.GetColorData()[rowStart + pixelX] = ShadePixel(*vertices[0], *vertices[1], *vertices[2], weightX, weightY, weightZ);
+					}
+				}
+			});
+	}
+
+	uint32_t Pipeline::ShadeTile(uint32_t tileIdx, const uint32_t* pindices, uint32_t triangleCount, FrameBuffer& frameBuffer, EdgeKernel::QuadCounts& quadCounts)
+	{
+		const uint32_t binIdx{ tileIdx / m_RasterConfig.GetBinTileCount() };
+		const uint32_t binStart{ m_BinOffset[static_cast<size_t>(binIdx) * m_RasterConfig.queueCount] };
+		const uint32_t triCount{ m_BinOffset[static_cast<size_t>(binIdx + 1) * m_RasterConfig.queueCount] - binStart };
+		const uint32_t microCount{ (std::min)(m_pMicroTileCounter[tileIdx].load(std::memory_order_relaxed), MICRO_TILE_CAPACITY) };
+		if (triCount == 0 && microCount == 0)
+			return 0;
+
+		const uint32_t binTileId{ tileIdx % m_RasterConfig.GetBinTileCount() };
+		uint32_t tileX{}, tileY{};
+		GetTilePosition(tileIdx, tileX, tileY);
+		if (tileX >= m_RasterConfig.viewportWidth || tileY >= m_RasterConfig.viewportHeight)
+			return 0;
+
+		// Colors, or the ids of the visibility buffer
+		const bool isVisibilityBuffer{ m_ShadingMode == EShadingMode::VisibilityBuffer };
+		const size_t viewportWidth{ m_RasterConfig.viewportWidth };
+		uint32_t* ptarget{ (isVisibilityBuffer ? std::data(m_VisibilityBuffer) : frameBuffer.GetColorData()) + tileY * viewportWidth + tileX };
+		float* pdepth{ frameBuffer.GetDepthData() + tileY * viewportWidth + tileX };
+
+		// The tile stays in local arrays while every triangle of the bin is tested against it, in bin order
+		uint32_t tileTarget[TILE_SIZE * TILE_SIZE];
+		float tileDepth[TILE_SIZE * TILE_SIZE];
+		for (uint32_t rowIdx{}; rowIdx < TILE_SIZE; ++rowIdx)
+		{
+			std::copy_n(ptarget + rowIdx * viewportWidth, TILE_SIZE, tileTarget + rowIdx * TILE_SIZE);
+			std::copy_n(pdepth + rowIdx * viewportWidth, TILE_SIZE, tileDepth + rowIdx * TILE_SIZE);
+		}
+
+		// The Hi-Z of the tile, min and max of tileDepth as triangles get shaded
+		FrameBuffer::TileDepth& hiZ{ frameBuffer.GetTileDepthData()[tileY / TILE_SIZE * frameBuffer.GetTileCountX() + tileX / TILE_SIZE] };
+		FrameBuffer::TileDepth tileDepthRange{ hiZ };
+		uint32_t rejectedCount{ 0 };
+
+		// Binned triangles get their coverage from the kernel, or all the tile when the tile stage accepted it, micro triangles only sample the pixels of their aabb
+		const auto shadeTriangle{ [&](uint32_t triIdx, ECoverage coverageSource)
+			{
+				const RasterData& rData{ m_RasterData[triIdx] };
+
+				// The interpolated depth stays between the ones of the vertices
+				const float triMinDepth{ 1.f / (std::max)({ rData.invZ.x, rData.invZ.y, rData.invZ.z }) };
+				if (triMinDepth >= tileDepthRange.maxDepth)
+				{
+					++rejectedCount;
+					return;
+				}
+
+				const float triMaxDepth{ 1.f / (std::min)({ rData.invZ.x, rData.invZ.y, rData.invZ.z }) };
+				const bool isDepthTested{ triMaxDepth >= tileDepthRange.minDepth };
+				bool isDepthWritten{ false };
+
+				const std::array<const Vertex_Out*, 3> vertices{ GetTriangleVertices(pindices, triangleCount, triIdx) };
+
+				EdgeKernel::FixedTileEdges fixedEdges{};
+				if (coverageSource == ECoverage::Point && m_RasterMode == ERasterMode::FixedPoint)
+					EdgeKernel::SetupFixedTileEdges(rData, tileX, tileY, fixedEdges);
+
+				// Only the covered pixels are shaded, the edges are evaluated again there with the same math the kernel uses for the weights
+				uint64_t coverage{ ~0ull };
+				if (coverageSource == ECoverage::Point)
+					coverage = GetPointCoverage(m_RasterMode, rData, fixedEdges, tileX, tileY);
+				else if (coverageSource == ECoverage::Kernel)
+					coverage = m_CoverageMode == ECoverageMode::Quad ? EdgeKernel::ComputeQuadCoverage(m_RasterMode, rData, tileX, tileY, quadCounts) : m_pCoverageKernel(rData, tileX, tileY);
+				if (coverage == 0)
+					return;
+
+				if (coverageSource != ECoverage::Point && m_RasterMode == ERasterMode::FixedPoint)
+					EdgeKernel::SetupFixedTileEdges(rData, tileX, tileY, fixedEdges);
+
+				for (; coverage != 0; coverage &= coverage - 1)
+				{
+					const uint32_t pixelIdx{ EdgeKernel::FindFirstSetBit(coverage) };
+					const uint32_t pixelX{ pixelIdx % TILE_SIZE };
+					const uint32_t pixelY{ pixelIdx / TILE_SIZE };
+
+					float cx0{}, cx1{};
+					GetEdgeValues(m_RasterMode, rData, fixedEdges, tileX, tileY, pixelX, pixelY, cx0, cx1);
+
+					float weightX{}, weightY{}, weightZ{};
+					GetWeights(rData, cx0, cx1, weightX, weightY, weightZ);
+					const float z{ 1.f / (rData.invZ.x * weightX + rData.invZ.y * weightY + rData.invZ.z * weightZ) };
+
+					if (isDepthTested && z >= tileDepth[pixelIdx])
+						continue;
+
+					tileDepth[pixelIdx] = z;
+					isDepthWritten = true;
+
+					// The drawn mesh is instance 0, the only one a Dispatch draws
+					tileTarget[pixelIdx] = isVisibilityBuffer ? VisibilityBuffer::Pack(triIdx, 0)
+						: ShadePixel(*vertices[0], *vertices[1], *vertices[2], weightX, weightY, weightZ);
+				}
+
+				if (isDepthWritten)
+				{
+					const auto minMax{ std::minmax_element(std::begin(tileDepth), std::end(tileDepth)) };
+					tileDepthRange = FrameBuffer::TileDepth{ *minMax.first, *minMax.second };
+				}
+			} };
+
+		const uint32_t coverageWord{ binTileId / 32 };
+		const uint32_t coverageBit{ 1u << (binTileId % 32) };
+		const BinData* pbinData{ std::data(m_TileBuffer) + binStart };
+		for (uint32_t dataIdx{}; dataIdx < triCount; ++dataIdx)
+		{
+			const BinData& binData{ pbinData[dataIdx] };
+			if ((binData.coverage[coverageWord] & coverageBit) != 0)
+				shadeTriangle(binData.triIdx, (binData.fullCoverage[coverageWord] & coverageBit) != 0 ? ECoverage::Full : ECoverage::Kernel);
+		}
+
+		// Appended by the setup groups in any order, sorted so equal depths resolve the same way every run
+		uint32_t microTriangles[MICRO_TILE_CAPACITY];
+		std::copy_n(std::data(m_MicroTileBuffer) + static_cast<size_t>(tileIdx) * MICRO_TILE_CAPACITY, microCount, microTriangles);
+		std::sort(microTriangles, microTriangles + microCount);
+		for (uint32_t microIdx{}; microIdx < microCount; ++microIdx)
+			shadeTriangle(microTriangles[microIdx], ECoverage::Point);
+
+		hiZ = tileDepthRange;
+
+		for (uint32_t rowIdx{}; rowIdx < TILE_SIZE; ++rowIdx)
+		{
+			std::copy_n(tileTarget + rowIdx * TILE_SIZE, TILE_SIZE, ptarget + rowIdx * viewportWidth);
+			std::copy_n(tileDepth + rowIdx * TILE_SIZE, TILE_SIZE, pdepth + rowIdx * viewportWidth);
+		}
+
+		return rejectedCount;
+	}
+
+	void Pipeline::GetTilePosition(uint32_t tileIdx, uint32_t& tileX, uint32_t& tileY) const
+	{
+		const uint32_t binIdx{ tileIdx / m_RasterConfig.GetBinTileCount() };
+		const uint32_t binTileId{ tileIdx % m_RasterConfig.GetBinTileCount() };
+		tileX = binIdx % m_RasterConfig.GetBinningDimsX() * m_RasterConfig.GetBinPixelSize() + binTileId % m_RasterConfig.binSize * TILE_SIZE;
+		tileY = binIdx / m_RasterConfig.GetBinningDimsX() * m_RasterConfig.GetBinPixelSize() + binTileId / m_RasterConfig.binSize * TILE_SIZE;
+	}
+
+	std::array<const Vertex_Out*, 3> Pipeline::GetTriangleVertices(const uint32_t* pindices, uint32_t triangleCount, uint32_t triIdx) const
+	{
+		if (triIdx >= triangleCount)
+		{
+			const Vertex_Out* pclipVertices{ std::data(m_ClipVertexOut) + static_cast<size_t>(triIdx - triangleCount) * 3 };
+			return { pclipVertices, pclipVertices + 1, pclipVertices + 2 };
+		}
+
+		const uint32_t* ptri{ pindices + static_cast<size_t>(triIdx) * 3 };
+		return { &m_VertexOut[ptri[0]], &m_VertexOut[ptri[1]], &m_VertexOut[ptri[2]] };
+	}
+}
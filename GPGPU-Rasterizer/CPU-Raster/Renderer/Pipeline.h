@@ -0,0 +1,275 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <DirectXMath.h>
+#include <memory>
+#include <vector>
+
+#include "Common/BinList.h"
+#include "Common/Clipping.h"
+#include "Common/MeshData.h"
+#include "Common/TriangleCulling.h"
+#include "Common/VisibilityBuffer.h"
+#include "EdgeKernel.h"
+#include "PipelineData.h"
+#include "TileScheduler.h"
+
+namespace CpuRaster
+{
+	class FrameBuffer;
+
+	/**
+	 * \brief : Host implementation of the binned compute pipeline CompuRaster::Pipeline dispatches:
+	 * VertexShader, GeometrySetup, BinRasterizer with BinScan, TileRasterizer, FineRasterizer3 and with a visibility buffer VisibilityShading.\n
+	 * Every stage fills the same buffers, with the same layouts, as its shader. The groups of a stage are spread over worker threads,
+	 * the bins of tiling and the tiles of the fine stage by a work-stealing TileScheduler in Morton order.
+	 * Cluster culling is not run, every triangle of the drawn level goes through geometry setup.
+	 */
+	class Pipeline
+	{
+	public:
+		// Wall time of each stage during the last Dispatch, in milliseconds
+		struct StageTimings
+		{
+			double vertex;
+			double geometrySetup;
+			double binning;
+			double tiling;
+			double fine;
+			// Full screen pass of EShadingMode::VisibilityBuffer, 0 in forward
+			double shading;
+		};
+
+		// Triangles geometry setup dropped during the last Dispatch, on top of the rejected ones
+		struct CullStats
+		{
+			// Facing the way the cull mode drops
+			uint32_t culledTriangleCount;
+			// Repeated indices or a zero screen area, in every cull mode
+			uint32_t degenerateTriangleCount;
+		};
+
+		// Triangles geometry setup rejected or clipped during the last Dispatch
+		struct ClipStats
+		{
+			// Outside the viewport, from their outcodes or with nothing left after clipping
+			uint32_t rejectedTriangleCount;
+			// Crossing the near or far plane or leaving the guard band, cut by the clipper
+			uint32_t clippedTriangleCount;
+			// Emitted by the clipper into the raster slots past the mesh triangles
+			uint32_t clipTriangleCount;
+			// Emitted past Clipping::MAX_CLIP_TRIANGLES and dropped
+			uint32_t droppedClipTriangleCount;
+		};
+
+		// Split of the mesh triangles geometry setup kept during the last Dispatch between the binned path and the micro triangle one
+		struct MicroStats
+		{
+			// Pixel bounds inside one tile, listed by that tile and point sampled by the fine stage without binning
+			uint32_t microTriangleCount;
+			// Of the micro triangles, the ones inside a 2x2 pixel quad
+			uint32_t quadTriangleCount;
+			// Binned and tiled, the clip triangles are not counted
+			uint32_t regularTriangleCount;
+			// Of the regular triangles, the micro ones binned because their tile list was full
+			uint32_t overflowTriangleCount;
+		};
+
+		// Storage of the bins during the last Dispatch, sized by the count pass instead of a worst case queue per bin
+		struct BinStats
+		{
+			// Triangle index of a bin, one per bin a triangle overlaps
+			uint32_t binTrianglePairCount;
+			// Block headers and varint deltas of the BinList the tile stage decodes
+			uint64_t encodedByteCount;
+			// The same lists as 32 bit triangle indices
+			uint64_t rawByteCount;
+		};
+
+		// False positives of an aabb only assignment during the last Dispatch, dropped by the corner tests of the edges of their triangle
+		struct OverlapStats
+		{
+			// Bins of the aabb of a triangle binning left out
+			uint32_t missedBinCount;
+			// Tiles of the aabb of a triangle in a bin it was stored in, left out of its coverage by the tile stage
+			uint32_t missedTileCount;
+		};
+
+		// Trivial accepts of the tile stage during the last Dispatch, after the Hi-Z
+		struct CoverageStats
+		{
+			// Bins entirely covered by a triangle, their tiles skip the per tile test
+			uint32_t fullBinCount;
+			// Triangle tiles entirely covered, shaded without edge tests by the fine stage
+			uint32_t fullTileCount;
+		};
+
+		// Last level of the edge test hierarchy during the last Dispatch, the quads of the triangle tiles the fine stage got from ECoverageMode::Quad, all 0 with the kernel
+		struct QuadStats
+		{
+			uint32_t rejectedQuadCount;
+			uint32_t acceptedQuadCount;
+			// Tested pixel by pixel
+			uint32_t partialQuadCount;
+		};
+
+		// Work saved by the Hi-Z of the frame buffer during the last Dispatch
+		struct HiZStats
+		{
+			// Tiles dropped from the coverage of a triangle by the tile stage, the Hi-Z of the earlier draws or a triangle of the bin covering the whole tile is nearer than it
+			uint32_t rejectedTileCount;
+			// Triangles the fine stage skipped for a tile before computing their coverage, the tile got nearer while shading the bin
+			uint32_t rejectedTriangleCount;
+		};
+
+		/**
+		 * \param rasterConfig : Viewport, tiling and binning queues of the stages, like the one CompuRaster::Pipeline::Init takes.
+		 * With a config GetConfigError rejects, the stages are sized for the default one and Dispatch draws nothing
+		 * \param workerCount : Threads running the groups of a stage, 0 for one per hardware thread
+		 * \param instructionSet : Widest instruction set the fine stage computes tile coverage with, capped to what the CPU supports
+		 * \param rasterMode : Edge functions of geometry setup and the fine stage, the FIXED_POINT_RASTER define of the shaders
+		 * \param shadingMode : Whether the fine stage shades or fills the visibility buffer, the VISIBILITY_BUFFER define of the shaders
+		 * \param cullMode : Faces geometry setup drops, the CULL_NONE and CULL_FRONT defines of the shaders
+		 * \param coverageMode : How the fine stage gets the coverage of the tiles the tile stage did not accept, FineRasterizer3 classifies the quads
+		 */
+		explicit Pipeline(const RasterConfig& rasterConfig, uint32_t workerCount = 0, EInstructionSet instructionSet = EInstructionSet::AVX2, ERasterMode rasterMode = ERasterMode::Float, EShadingMode shadingMode = EShadingMode::Forward, ECullMode cullMode = ECullMode::Back,
+			ECoverageMode coverageMode = ECoverageMode::Kernel);
+		~Pipeline() = default;
+
+		Pipeline(const Pipeline&) = delete;
+		Pipeline(Pipeline&&) noexcept = delete;
+		Pipeline& operator=(const Pipeline&) = delete;
+		Pipeline& operator=(Pipeline&&) noexcept = delete;
+
+		/**
+		 * \brief : Why the CPU pipeline cannot run with rasterConfig, RasterConfig::GetError or a tile size other than the TILE_SIZE of the coverage kernels,
+		 * nullptr when it can
+		 */
+		static const wchar_t* GetConfigError(const RasterConfig& rasterConfig);
+
+		/**
+		 * \brief : Sizes the stage buffers for up to vCount vertices and triangleCount triangles, Dispatch grows them past that,
+		 * the bins are sized by every Dispatch from the triangles they actually get
+		 */
+		void Init(uint32_t vCount, uint32_t triangleCount);
+
+		/**
+		 * \brief : Renders the lod range of meshData into frameBuffer, depth tested against its current content
+		 * \param frameBuffer : Must be the viewport size of the config, the size the stages are built for
+		 */
+		void Dispatch(const MeshData& meshData, const MeshLod& lod, const DirectX::XMFLOAT4X4& worldViewProj, const DirectX::XMFLOAT4X4& world, FrameBuffer& frameBuffer);
+
+		const StageTimings& GetStageTimings() const { return m_StageTimings; }
+		const CullStats& GetCullStats() const { return m_CullStats; }
+		const ClipStats& GetClipStats() const { return m_ClipStats; }
+		const MicroStats& GetMicroStats() const { return m_MicroStats; }
+		const BinStats& GetBinStats() const { return m_BinStats; }
+		const OverlapStats& GetOverlapStats() const { return m_OverlapStats; }
+		const CoverageStats& GetCoverageStats() const { return m_CoverageStats; }
+		const QuadStats& GetQuadStats() const { return m_QuadStats; }
+		const HiZStats& GetHiZStats() const { return m_HiZStats; }
+		const RasterConfig& GetRasterConfig() const { return m_RasterConfig; }
+		uint32_t GetWorkerCount() const { return m_WorkerCount; }
+		EInstructionSet GetInstructionSet() const { return m_InstructionSet; }
+		ERasterMode GetRasterMode() const { return m_RasterMode; }
+		EShadingMode GetShadingMode() const { return m_ShadingMode; }
+		ECullMode GetCullMode() const { return m_CullMode; }
+		ECoverageMode GetCoverageMode() const { return m_CoverageMode; }
+		// Per worker, the tiles it shaded during the fine stage of the last Dispatch
+		const std::vector<TileScheduler::WorkerStats>& GetFineWorkerStats() const { return m_FineWorkerStats; }
+
+	private:
+		// Set when the config passed to the constructor was rejected, m_RasterConfig is then the default one
+		const wchar_t* m_pConfigError;
+		RasterConfig m_RasterConfig;
+		// RasterConfig::GetGuardBandPixels of the raster mode, the band geometry setup clips to
+		float m_GuardBandPixels;
+		uint32_t m_WorkerCount;
+		EInstructionSet m_InstructionSet;
+		ERasterMode m_RasterMode;
+		EShadingMode m_ShadingMode;
+		ECullMode m_CullMode;
+		ECoverageMode m_CoverageMode;
+		EdgeKernel::CoverageFnc m_pCoverageKernel;
+		StageTimings m_StageTimings;
+		CullStats m_CullStats;
+		ClipStats m_ClipStats;
+		MicroStats m_MicroStats;
+		BinStats m_BinStats;
+		OverlapStats m_OverlapStats;
+		CoverageStats m_CoverageStats;
+		QuadStats m_QuadStats;
+		HiZStats m_HiZStats;
+		TileScheduler m_Scheduler;
+		std::vector<TileScheduler::WorkerStats> m_FineWorkerStats;
+		// Bins and tiles inside the viewport, in Morton order so the range of a worker covers a compact area
+		std::vector<uint32_t> m_BinOrder;
+		std::vector<uint32_t> m_TileOrder;
+
+		std::vector<Vertex_Out> m_VertexOut;
+		// The mesh triangles, then Clipping::MAX_CLIP_TRIANGLES slots for the ones the clipper emits
+		std::vector<RasterData> m_RasterData;
+		// The 3 screen space vertices of every clip triangle slot
+		std::vector<Vertex_Out> m_ClipVertexOut;
+		// Per bin then per queue, the exclusive prefix sums of the triangles, BinList blocks and delta words binning counted, each total past its array
+		std::vector<uint32_t> m_BinOffset;
+		// BinList::BlockHeader of every block, the blocks of a bin back to back
+		std::vector<BinList::BlockHeader> m_BinHeaders;
+		// The varint deltas of the blocks, the ones of a queue from a 4 byte boundary like the words of G_BIN_BUFFER
+		std::vector<uint8_t> m_BinStream;
+		// Per bin, the triangles of its queues back to back with their tile coverage
+		std::vector<BinData> m_TileBuffer;
+		// Per tile, the micro triangles geometry setup appended, past MICRO_TILE_CAPACITY for the binned ones
+		std::unique_ptr<std::atomic<uint32_t>[]> m_pMicroTileCounter;
+		// Per tile, MICRO_TILE_CAPACITY micro triangle indices
+		std::vector<uint32_t> m_MicroTileBuffer;
+		// VisibilityBuffer id of every viewport pixel, cleared at every Dispatch so the shading pass only touches the pixels it drew
+		std::vector<uint32_t> m_VisibilityBuffer;
+
+		void RunVertexStage(const MeshData& meshData, const DirectX::XMFLOAT4X4& worldViewProj, const DirectX::XMFLOAT4X4& world);
+		/**
+		 * \return : Triangles the clipper emitted, past Clipping::MAX_CLIP_TRIANGLES for the dropped ones
+		 */
+		uint32_t RunGeometrySetup(const uint32_t* pindices, uint32_t triangleCount);
+		RasterData SetupTriangle(const uint32_t* ptri, uint32_t triangleCount, std::atomic<uint32_t>& clipTriangleCounter, CullStats& cullStats, ClipStats& clipStats);
+		// Snapping, face and degenerate tests and edge equations of a triangle in front of the near plane and inside the guard band
+		RasterData SetupRasterData(const DirectX::XMFLOAT4& v0, const DirectX::XMFLOAT4& v1, const DirectX::XMFLOAT4& v2, CullStats& cullStats) const;
+		/**
+		 * \brief : Clips the triangle and fans what is left into clip triangle slots, from clipTriangleCounter
+		 */
+		void ClipTriangle(const Vertex_Out* pvertices[3], uint32_t triangleCount, std::atomic<uint32_t>& clipTriangleCounter, CullStats& cullStats, ClipStats& clipStats);
+		/**
+		 * \brief : Appends a set up triangle whose pixel bounds fit in one tile to the micro list of that tile and flags it so binning skips it
+		 */
+		void RouteTriangle(uint32_t triIdx, RasterData& data, MicroStats& microStats);
+		void RunBinning(uint32_t triangleCount, uint32_t clipTriangleCount);
+		void RunTiling(const FrameBuffer& frameBuffer);
+		void RunFine(const uint32_t* pindices, uint32_t triangleCount, FrameBuffer& frameBuffer);
+		void RunShading(const uint32_t* pindices, uint32_t triangleCount, FrameBuffer& frameBuffer);
+
+		/**
+		 * \brief : Shades every triangle of the bin covering the tile, in bin order, then the micro triangles of the tile, in triangle order,
+		 * or writes their id to the visibility buffer, and updates the Hi-Z of the tile
+		 * \param quadCounts : Incremented by the quads of the binned triangles with ECoverageMode::Quad
+		 * \return : Triangles rejected by the Hi-Z
+		 */
+		uint32_t ShadeTile(uint32_t tileIdx, const uint32_t* pindices, uint32_t triangleCount, FrameBuffer& frameBuffer, EdgeKernel::QuadCounts& quadCounts);
+
+		/**
+		 * \brief : Pixel position of the min corner of a tile, the tiles are stored bin by bin
+		 */
+		void GetTilePosition(uint32_t tileIdx, uint32_t& tileX, uint32_t& tileY) const;
+
+		/**
+		 * \brief : Vertices of a raster triangle, from the index buffer for the mesh triangles and from m_ClipVertexOut for the clip triangles past them
+		 */
+		std::array<const Vertex_Out*, 3> GetTriangleVertices(const uint32_t* pindices, uint32_t triangleCount, uint32_t triIdx) const;
+
+		/**
+		 * \brief : Calls fnc(groupIdx) for every group in [0, groupCount), the workers pull the next group from a shared counter
+		 */
+		template<typename FNC>
+		void ParallelFor(uint32_t groupCount, FNC&& fnc) const;
+	};
+}
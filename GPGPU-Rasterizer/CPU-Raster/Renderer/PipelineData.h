@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <DirectXMath.h>
+
+#include "Common/RasterConfig.h"
+
+namespace CpuRaster
+{
+	// Pixels per tile side the coverage kernels are built for, a pixel per bit of a 64 bit mask, the tileSize of every RasterConfig the CPU pipeline runs.
+	// The viewport, bin size and queue count come from the RasterConfig of the pipeline like they do for the compute shaders
+	constexpr uint32_t TILE_SIZE{ 8 };
+	static_assert(RasterConfig{}.tileSize == TILE_SIZE, "The CPU pipeline must run the default config");
+	// Micro triangles a tile lists for the point sampled path of the fine stage, one per FineRasterizer3 thread, the ones past it are binned
+	constexpr uint32_t MICRO_TILE_CAPACITY{ RasterConfig::MICRO_TILE_CAPACITY };
+
+	// A triangle covering a whole tile bounds the depth of its pixels by its farthest vertex, past it by this margin for the rounding of the interpolated depths.
+	// The tile stage only rejects the triangles behind that bound, a tied one still wins the depth test when it comes first
+	constexpr float OCCLUDER_DEPTH_MARGIN{ 1.f + 1.f / 4096.f };
+
+	constexpr DirectX::XMFLOAT3 LIGHT_DIR{ 0.577f, -0.577f, 0.577f };
+	constexpr float LIGHT_INTENSITY{ 4.f };
+
+	// Vertex_Out of VertexShader.hlsl, position in screen space with w = 1 / clip w,
+	// or still in clip space when the outcode has a Clipping::CLIP_OUTCODE plane, only the clipper reads those vertices
+	struct Vertex_Out
+	{
+		DirectX::XMFLOAT4 position;
+		DirectX::XMFLOAT3 normal;
+		uint32_t outcode;
+	};
+	static_assert(sizeof(Vertex_Out) == 32, "Vertex_Out must match the G_TRANS_VERTEX_BUFFER stride");
+
+	// RasterData of GeometrySetup.hlsl, edge equations are evaluated relative to the aabb min corner
+	struct RasterData
+	{
+		union
+		{
+			float edgeEq[9];
+			// ERasterMode::FixedPoint, the snapped x, y of the 3 vertices then the FixedPointEdges threshold of each edge
+			int32_t fixedEdge[9];
+		};
+		DirectX::XMFLOAT3 invZ;
+		// Pixel bounds packed as (minX << 16 | minY, maxX << 16 | maxY)
+		uint32_t aabb[2];
+		float invArea;
+		uint32_t isClipped;
+	};
+	static_assert(sizeof(RasterData) == 64, "RasterData must match the G_RASTER_DATA stride");
+
+	// BinData of TileRasterizer.hlsl, one bit per tile of the bin
+	struct BinData
+	{
+		uint32_t coverage[2];
+		// Tiles the triangle covers entirely, the fine stage only depth tests and shades their pixels
+		uint32_t fullCoverage[2];
+		uint32_t triIdx;
+	};
+	static_assert(sizeof(BinData) == 20, "BinData must match the G_TILE_BUFFER stride");
+	static_assert(RasterConfig::MAX_BIN_TILE_COUNT <= 64, "BinData::coverage holds 64 tiles");
+}
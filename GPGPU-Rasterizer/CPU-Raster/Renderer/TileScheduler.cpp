@@ -0,0 +1,198 @@
+#include "pch.h"
+#include "TileScheduler.h"
+
+#include <chrono>
+
+namespace CpuRaster
+{
+	namespace
+	{
+		inline uint64_t PackRange(uint32_t begin, uint32_t end)
+		{
+			return static_cast<uint64_t>(begin) << 32 | end;
+		}
+
+		inline uint32_t GetRangeBegin(uint64_t range)
+		{
+			return static_cast<uint32_t>(range >> 32);
+		}
+
+		inline uint32_t GetRangeEnd(uint64_t range)
+		{
+			return static_cast<uint32_t>(range);
+		}
+	}
+
+	TileScheduler::TileScheduler(uint32_t workerCount)
+		: m_WorkerCount{ workerCount != 0 ? workerCount : 1 }
+		, m_pRanges{ std::make_unique<WorkerRange[]>(m_WorkerCount) }
+		, m_WorkerStats(m_WorkerCount, WorkerStats{})
+		, m_pItems{ nullptr }
+		, m_pTaskFnc{ nullptr }
+		, m_pTask{ nullptr }
+		, m_Threads{}
+		, m_Mutex{}
+		, m_WakeCondition{}
+		, m_DoneCondition{}
+		, m_RunIdx{ 0 }
+		, m_PendingCount{ 0 }
+		, m_IsStopping{ false }
+		, m_StartedCount{ 0 }
+	{
+		m_Threads.reserve(m_WorkerCount - 1);
+		for (uint32_t workerIdx{ 1 }; workerIdx < m_WorkerCount; ++workerIdx)
+			m_Threads.emplace_back(&TileScheduler::WaitForRuns, this, workerIdx);
+	}
+
+	TileScheduler::~TileScheduler()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_WakeCondition.notify_all();
+
+		for (std::thread& workerThread : m_Threads)
+			workerThread.join();
+	}
+
+	void TileScheduler::RunItems(const std::vector<uint32_t>& items, TaskFnc pfnc, void* ptask)
+	{
+		SplitItems(static_cast<uint32_t>(std::size(items)));
+		m_pItems = &items;
+		m_pTaskFnc = pfnc;
+		m_pTask = ptask;
+		m_StartedCount.store(0, std::memory_order_relaxed);
+
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			++m_RunIdx;
+			m_PendingCount = m_WorkerCount - 1;
+		}
+		m_WakeCondition.notify_all();
+
+		RunWorker(0);
+
+		std::unique_lock<std::mutex> lock{ m_Mutex };
+		m_DoneCondition.wait(lock, [this]() { return m_PendingCount == 0; });
+	}
+
+	void TileScheduler::WaitForRuns(uint32_t workerIdx)
+	{
+		uint64_t lastRunIdx{ 0 };
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock{ m_Mutex };
+				m_WakeCondition.wait(lock, [&]() { return m_IsStopping || m_RunIdx != lastRunIdx; });
+				if (m_IsStopping)
+					return;
+
+				lastRunIdx = m_RunIdx;
+			}
+
+			RunWorker(workerIdx);
+
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			if (--m_PendingCount == 0)
+				m_DoneCondition.notify_one();
+		}
+	}
+
+	void TileScheduler::RunWorker(uint32_t workerIdx)
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		using Milliseconds = std::chrono::duration<double, std::milli>;
+
+		// Start barrier, no worker takes an item before every one of them is awake
+		m_StartedCount.fetch_add(1, std::memory_order_acq_rel);
+		while (m_StartedCount.load(std::memory_order_acquire) < m_WorkerCount)
+			std::this_thread::yield();
+
+		WorkerStats stats{};
+		Clock::time_point start{};
+		uint32_t itemPos{};
+		uint32_t stolenCount{};
+		do
+		{
+			stats.stolenItemCount += stolenCount;
+			stats.stealCount += stolenCount != 0 ? 1 : 0;
+			for (; PopFront(workerIdx, itemPos); ++stats.itemCount)
+			{
+				if (stats.itemCount == 0)
+					start = Clock::now();
+
+				m_pTaskFnc(m_pTask, (*m_pItems)[itemPos]);
+			}
+		} while ((stolenCount = StealHalf(workerIdx)) != 0);
+
+		stats.busyMs = stats.itemCount != 0 ? Milliseconds{ Clock::now() - start }.count() : 0.0;
+		m_WorkerStats[workerIdx] = stats;
+	}
+
+	void TileScheduler::SplitItems(uint32_t itemCount)
+	{
+		for (uint32_t workerIdx{}; workerIdx < m_WorkerCount; ++workerIdx)
+		{
+			const uint32_t begin{ static_cast<uint32_t>(static_cast<uint64_t>(itemCount) * workerIdx / m_WorkerCount) };
+			const uint32_t end{ static_cast<uint32_t>(static_cast<uint64_t>(itemCount) * (workerIdx + 1) / m_WorkerCount) };
+			m_pRanges[workerIdx].range.store(PackRange(begin, end), std::memory_order_relaxed);
+		}
+	}
+
+	bool TileScheduler::PopFront(uint32_t workerIdx, uint32_t& itemPos)
+	{
+		std::atomic<uint64_t>& ownRange{ m_pRanges[workerIdx].range };
+		uint64_t range{ ownRange.load(std::memory_order_acquire) };
+		for (;;)
+		{
+			const uint32_t begin{ GetRangeBegin(range) };
+			const uint32_t end{ GetRangeEnd(range) };
+			if (begin >= end)
+				return false;
+
+			// A thief shrinking the range in between fails the exchange and reloads it
+			if (ownRange.compare_exchange_weak(range, PackRange(begin + 1, end), std::memory_order_acq_rel))
+			{
+				itemPos = begin;
+				return true;
+			}
+		}
+	}
+
+	uint32_t TileScheduler::StealHalf(uint32_t thiefIdx)
+	{
+		for (;;)
+		{
+			uint32_t victimIdx{ thiefIdx };
+			uint64_t victimRange{};
+			uint32_t victimCount{ 0 };
+			for (uint32_t offset{ 1 }; offset < m_WorkerCount; ++offset)
+			{
+				const uint32_t workerIdx{ (thiefIdx + offset) % m_WorkerCount };
+				const uint64_t range{ m_pRanges[workerIdx].range.load(std::memory_order_acquire) };
+				const uint32_t count{ GetRangeEnd(range) > GetRangeBegin(range) ? GetRangeEnd(range) - GetRangeBegin(range) : 0 };
+				if (count > victimCount)
+				{
+					victimIdx = workerIdx;
+					victimRange = range;
+					victimCount = count;
+				}
+			}
+
+			// Items only move from a range to an empty one, so finding every range empty once means the run is over for this worker
+			if (victimCount == 0)
+				return 0;
+
+			const uint32_t begin{ GetRangeBegin(victimRange) };
+			const uint32_t end{ GetRangeEnd(victimRange) };
+			const uint32_t stolenCount{ (victimCount + 1) / 2 };
+			if (m_pRanges[victimIdx].range.compare_exchange_strong(victimRange, PackRange(begin, end - stolenCount), std::memory_order_acq_rel))
+			{
+				// Positions are only handed out once, so a range can not come back and fool a compare exchange expecting an older one
+				m_pRanges[thiefIdx].range.store(PackRange(end - stolenCount, end), std::memory_order_release);
+				return stolenCount;
+			}
+		}
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace CpuRaster
+{
+	/**
+	 * \brief : Work-stealing scheduler for the tile and bin groups of the CPU pipeline.\n
+	 * Every worker owns a contiguous range of the item list and runs it front to back, so neighbouring items stay on one core.
+	 * Once its range is empty, a worker steals the back half of the fullest other range.\n
+	 * The worker threads live as long as the scheduler, every Run wakes them and they all pass a start barrier before taking items,
+	 * so a thread scheduled late does not find its range already stolen.
+	 */
+	class TileScheduler
+	{
+	public:
+		// What one worker did during the last Run
+		struct WorkerStats
+		{
+			uint32_t itemCount;
+			uint32_t stolenItemCount;
+			uint32_t stealCount;
+			// Time from the first item of the worker until it found every range empty, 0 without items
+			double busyMs;
+		};
+
+		/**
+		 * \param workerCount : Threads of every Run, the calling thread is worker 0, the other ones are started here
+		 */
+		explicit TileScheduler(uint32_t workerCount);
+		~TileScheduler();
+
+		TileScheduler(const TileScheduler&) = delete;
+		TileScheduler(TileScheduler&&) noexcept = delete;
+		TileScheduler& operator=(const TileScheduler&) = delete;
+		TileScheduler& operator=(TileScheduler&&) noexcept = delete;
+
+		/**
+		 * \brief : Calls fnc(item) once for every entry of items, returns once every worker is done
+		 * \param items : Split in equal ranges in this order, items touching the same memory should be next to each other
+		 */
+		template<typename FNC>
+		void Run(const std::vector<uint32_t>& items, FNC&& fnc);
+
+		uint32_t GetWorkerCount() const { return m_WorkerCount; }
+		const std::vector<WorkerStats>& GetWorkerStats() const { return m_WorkerStats; }
+
+	private:
+		// Own cache line per range, so the owner popping does not invalidate the others
+		struct alignas(64) WorkerRange
+		{
+			// Begin position in the high 32 bits and end position in the low ones
+			std::atomic<uint64_t> range;
+		};
+
+		using TaskFnc = void(*)(void* ptask, uint32_t item);
+
+		uint32_t m_WorkerCount;
+		std::unique_ptr<WorkerRange[]> m_pRanges;
+		std::vector<WorkerStats> m_WorkerStats;
+
+		// Items and task of the current Run
+		const std::vector<uint32_t>* m_pItems;
+		TaskFnc m_pTaskFnc;
+		void* m_pTask;
+
+		// Workers 1 and up wait on m_WakeCondition for the next Run, the caller of Run on m_DoneCondition for the last of them
+		std::vector<std::thread> m_Threads;
+		std::mutex m_Mutex;
+		std::condition_variable m_WakeCondition;
+		std::condition_variable m_DoneCondition;
+		uint64_t m_RunIdx;
+		uint32_t m_PendingCount;
+		bool m_IsStopping;
+		// Workers that reached the start barrier of the current Run
+		std::atomic<uint32_t> m_StartedCount;
+
+		void RunItems(const std::vector<uint32_t>& items, TaskFnc pfnc, void* ptask);
+		void WaitForRuns(uint32_t workerIdx);
+		// Pops and steals items until every range is empty, then stores the stats of workerIdx
+		void RunWorker(uint32_t workerIdx);
+		void SplitItems(uint32_t itemCount);
+		bool PopFront(uint32_t workerIdx, uint32_t& itemPos);
+
+		/**
+		 * \brief : Moves the back half of the fullest other range to the range of thiefIdx
+		 * \return : Items stolen, 0 once every range is empty
+		 */
+		uint32_t StealHalf(uint32_t thiefIdx);
+	};
+
+	template<typename FNC>
+	void TileScheduler::Run(const std::vector<uint32_t>& items, FNC&& fnc)
+	{
+		using Task = std::remove_reference_t<FNC>;
+		RunItems(items, [](void* ptask, uint32_t item) { (*static_cast<Task*>(ptask))(item); }, const_cast<void*>(static_cast<const void*>(&fnc)));
+	}
+}
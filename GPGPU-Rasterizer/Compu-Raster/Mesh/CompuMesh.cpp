@@ -5,16 +5,29 @@
 #include "../Renderer/Pipeline/Material.h"
 #include "Camera/Camera.h"
 #include "Common/Helpers.h"
+#include "Common/MeshSimplifier.h"
+#include "Managers/Logger.h"
 
 namespace CompuRaster
 {
-	CompuMesh::CompuMesh(std::vector<DirectX::XMFLOAT3>&& positions, std::vector<DirectX::XMFLOAT3>&& normals, std::vector<DirectX::XMFLOAT2>&& uvs, std::vector<uint32_t>&& indices, bool calculateTangents)
+	CompuMesh::CompuMesh(MeshData&& meshData, bool releaseCpuData, EVertexFormat vertexFormat)
 		: m_WorldMatrix{  }
-		, m_VertexPositions{ positions }
-		, m_VertexNorms{ normals }
-		, m_VertexTangents{  }
-		, m_VertexUvs{ uvs }
-		, m_Indices{ indices }
+		, m_MeshData{ std::move(meshData) }
+		, m_VertexCount{ m_MeshData.GetVertexCount() }
+		, m_IndexCount{ m_MeshData.GetIndexCount() }
+		, m_VertexFormat{ vertexFormat }
+		, m_IndexFormat{ IndexPacker::SelectFormat(m_VertexCount) }
+		, m_Dequantization{ VertexQuantizer::ComputeDequantization(m_MeshData.vertices) }
+		, m_Lods{ std::empty(m_MeshData.lods) ? std::vector<MeshLod>{ m_MeshData.GetLod(0) } : m_MeshData.lods }
+		, m_LodIdx{ 0 }
+		, m_BoundingCenter{}
+		, m_BoundingRadius{}
+		, m_Meshlets{}
+		, m_LodMeshletOffsets{ 0 }
+		, m_LodVisibleTriangleCounts{}
+		, m_MaxVisibleTriangleCount{ 0 }
+		, m_MeshletCount{ 0 }
+		, m_ReleaseCpuData{ releaseCpuData }
 		, m_VertexBufferView{ nullptr }
 		, m_VertexOutBufferView{ nullptr }
 		, m_IndexBufferView{ nullptr }
@@ -22,12 +35,35 @@ namespace CompuRaster
 		, m_VertexBuffer{ nullptr }
 		, m_VertexOutBuffer{ nullptr }
 		, m_IndexBuffer{ nullptr }
+		, m_MeshletBufferView{ nullptr }
+		, m_VisibleIndexBufferView{ nullptr }
+		, m_VisibleIndexBufferUAV{ nullptr }
+		, m_VisibleTriangleCountView{ nullptr }
+		, m_VisibleTriangleCountUAV{ nullptr }
+		, m_MeshletBuffer{ nullptr }
+		, m_VisibleIndexBuffer{ nullptr }
+		, m_VisibleTriangleCount{ nullptr }
 		, m_pMaterial{ nullptr }
 	{
 		XMStoreFloat4x4(&m_WorldMatrix, DirectX::XMMatrixIdentity());
+		MeshSimplifier::ComputeBoundingSphere(m_MeshData.vertices, m_BoundingCenter, m_BoundingRadius);
 
-		calculateTangents;
-		m_VertexTangents.resize(m_VertexPositions.size());
+		for (const MeshLod& lod : m_Lods)
+		{
+			const std::vector<MeshletBuilder::Meshlet> lodMeshlets{ MeshletBuilder::Build(m_MeshData, lod) };
+			m_Meshlets.insert(std::end(m_Meshlets), std::begin(lodMeshlets), std::end(lodMeshlets));
+			m_LodMeshletOffsets.push_back(static_cast<UINT>(std::size(m_Meshlets)));
+
+			UINT visibleTriangleCount{ lod.indexCount / 3 };
+			if (m_IndexFormat == EIndexFormat::Uint16)
+				for (const MeshletBuilder::Meshlet& meshlet : lodMeshlets)
+					visibleTriangleCount += meshlet.triangleCount & 1;
+
+			m_LodVisibleTriangleCounts.push_back(visibleTriangleCount);
+			m_MaxVisibleTriangleCount = (std::max)(m_MaxVisibleTriangleCount, visibleTriangleCount);
+		}
+
+		m_MeshletCount = static_cast<UINT>(std::size(m_Meshlets));
 	}
 
 	CompuMesh::~CompuMesh()
@@ -39,6 +75,20 @@ namespace CompuRaster
 		Helpers::SafeRelease(m_VertexBuffer);
 		Helpers::SafeRelease(m_VertexOutBuffer);
 		Helpers::SafeRelease(m_IndexBuffer);
+		Helpers::SafeRelease(m_MeshletBufferView);
+		Helpers::SafeRelease(m_VisibleIndexBufferView);
+		Helpers::SafeRelease(m_VisibleIndexBufferUAV);
+		Helpers::SafeRelease(m_VisibleTriangleCountView);
+		Helpers::SafeRelease(m_VisibleTriangleCountUAV);
+		Helpers::SafeRelease(m_MeshletBuffer);
+		Helpers::SafeRelease(m_VisibleIndexBuffer);
+		Helpers::SafeRelease(m_VisibleTriangleCount);
+	}
+
+	const D3D_SHADER_MACRO* CompuMesh::GetVertexShaderDefines(EVertexFormat vertexFormat)
+	{
+		static const D3D_SHADER_MACRO quantizedDefines[]{ { "QUANTIZED_VERTICES", "1" }, { nullptr, nullptr } };
+		return vertexFormat == EVertexFormat::Quantized ? quantizedDefines : nullptr;
 	}
 
 	void CompuMesh::SetMaterial(ID3D11Device* pdevice, Material* pmaterial)
@@ -46,15 +96,41 @@ namespace CompuRaster
 		m_pMaterial = pmaterial;
 		BuildVertexBuffer(pdevice);
 		BuildIndexBuffer(pdevice);
+		BuildClusterBuffers(pdevice);
+
+		if (m_ReleaseCpuData && m_VertexBuffer && m_IndexBuffer && m_MeshletBuffer)
+		{
+			m_MeshData.Release();
+			std::vector<MeshletBuilder::Meshlet>{}.swap(m_Meshlets);
+		}
 	}
 
 	void CompuMesh::BuildVertexBuffer(ID3D11Device* pdevice)
 	{
-		if (!m_pMaterial)
+		if (!m_pMaterial || m_VertexBuffer || m_VertexCount == 0)
 			return;
 
-		UINT vCount{ static_cast<UINT>(std::size(m_VertexPositions)) };
-		UINT vStride{ 32u };
+		UINT vCount{ m_VertexCount };
+		UINT vStride{ static_cast<UINT>(sizeof(MeshVertex)) };
+
+		// MeshVertex already has the Vertex_In packing, upload it as-is
+		D3D11_SUBRESOURCE_DATA vResData{};
+		vResData.pSysMem = std::data(m_MeshData.vertices);
+
+		std::vector<VertexQuantizer::QuantizedVertex> quantizedVertices{};
+		if (m_VertexFormat == EVertexFormat::Quantized)
+		{
+			quantizedVertices = VertexQuantizer::Encode(m_MeshData.vertices, m_Dequantization);
+			vStride = static_cast<UINT>(sizeof(VertexQuantizer::QuantizedVertex));
+			vResData.pSysMem = std::data(quantizedVertices);
+
+#if defined(DEBUG) | defined(_DEBUG) | defined(FORCE_LOGS)
+			// Only measured when it is logged, the bounds are checked by the VertexQuantizer test
+			const VertexQuantizer::RoundTripError error{ VertexQuantizer::MeasureRoundTripError(m_MeshData.vertices, quantizedVertices, m_Dequantization) };
+			APP_LOG_INFO(L"Quantized " + std::to_wstring(vCount) + L" vertices to " + std::to_wstring(vStride) + L" bytes: max position error " + std::to_wstring(error.maxPositionError)
+				+ L", max normal error " + std::to_wstring(error.maxNormalErrorDeg) + L" deg");
+#endif
+		}
 
 		D3D11_BUFFER_DESC vBufferDesc{};
 		vBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
@@ -64,29 +140,10 @@ namespace CompuRaster
 		vBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
 		vBufferDesc.StructureByteStride = vStride;
 
-		char* pdata{ new char[vBufferDesc.ByteWidth] };
-
-		for (UINT idx{}; idx < vCount; ++idx)
-		{
-			UINT memOffset{ vStride * idx };
-			memcpy(pdata + memOffset, &m_VertexPositions[idx], sizeof m_VertexPositions[idx]);
-
-			if (idx < std::size(m_VertexNorms))
-			{
-				memOffset += 16u;
-				memcpy(pdata + memOffset, &m_VertexNorms[idx], sizeof m_VertexNorms[idx]);
-			}
-		}
-
-		D3D11_SUBRESOURCE_DATA vResData{};
-		vResData.pSysMem = pdata;
-
 		HRESULT res{ pdevice->CreateBuffer(&vBufferDesc, &vResData, &m_VertexBuffer) };
 		if (FAILED(res))
 			return;
 
-		delete[] pdata;
-
 		D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc{};
 		viewDesc.Format = DXGI_FORMAT_UNKNOWN;
 		viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
@@ -129,9 +186,24 @@ namespace CompuRaster
 
 	void CompuMesh::BuildIndexBuffer(ID3D11Device* pdevice)
 	{
-		UINT iCount{ static_cast<UINT>(std::size(m_Indices)) };
+		if (m_IndexBuffer || m_IndexCount == 0)
+			return;
+
+		// Raw views count 32 bit words, 16 bit indices are packed in pairs
+		UINT iCount{ m_IndexCount };
 		UINT iStride{ static_cast<UINT>(sizeof uint32_t) };
 
+		D3D11_SUBRESOURCE_DATA vResData{};
+		vResData.pSysMem = std::data(m_MeshData.indices);
+
+		std::vector<uint32_t> packedIndices{};
+		if (m_IndexFormat == EIndexFormat::Uint16)
+		{
+			packedIndices = IndexPacker::Pack16(std::data(m_MeshData.indices), m_IndexCount);
+			iCount = static_cast<UINT>(std::size(packedIndices));
+			vResData.pSysMem = std::data(packedIndices);
+		}
+
 		D3D11_BUFFER_DESC iBufferDesc{};
 		iBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
 		iBufferDesc.ByteWidth = iCount * iStride;
@@ -140,9 +212,6 @@ namespace CompuRaster
 		iBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
 		iBufferDesc.StructureByteStride = 0;
 
-		D3D11_SUBRESOURCE_DATA vResData{};
-		vResData.pSysMem = std::data(m_Indices);
-
 		HRESULT res{ pdevice->CreateBuffer(&iBufferDesc, &vResData, &m_IndexBuffer) };
 		if (FAILED(res))
 			return;
@@ -158,6 +227,131 @@ namespace CompuRaster
 			return;
 	}
 
+	void CompuMesh::BuildClusterBuffers(ID3D11Device* pdevice)
+	{
+		if (m_MeshletBuffer || m_MeshletCount == 0)
+			return;
+
+		UINT mCount{ m_MeshletCount };
+		UINT mStride{ static_cast<UINT>(sizeof(MeshletBuilder::Meshlet)) };
+
+		D3D11_BUFFER_DESC mBufferDesc{};
+		mBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		mBufferDesc.ByteWidth = mStride * mCount;
+		mBufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		mBufferDesc.CPUAccessFlags = 0;
+		mBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		mBufferDesc.StructureByteStride = mStride;
+
+		D3D11_SUBRESOURCE_DATA mResData{};
+		mResData.pSysMem = std::data(m_Meshlets);
+
+		HRESULT res{ pdevice->CreateBuffer(&mBufferDesc, &mResData, &m_MeshletBuffer) };
+		if (FAILED(res))
+			return;
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC mViewDesc{};
+		mViewDesc.Format = DXGI_FORMAT_UNKNOWN;
+		mViewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		mViewDesc.Buffer.FirstElement = 0;
+		mViewDesc.Buffer.NumElements = mCount;
+		res = pdevice->CreateShaderResourceView(m_MeshletBuffer, &mViewDesc, &m_MeshletBufferView);
+		if (FAILED(res))
+			return;
+
+		// Compacted copy of the selected level, rewritten every frame by the cluster culling pass. Sized in 32 bit words
+		const UINT visibleIndexCount{ m_IndexFormat == EIndexFormat::Uint16 ? (m_MaxVisibleTriangleCount * 3 + 1) / 2 : m_MaxVisibleTriangleCount * 3 };
+
+		D3D11_BUFFER_DESC iBufferDesc{};
+		iBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+		iBufferDesc.ByteWidth = visibleIndexCount * static_cast<UINT>(sizeof(uint32_t));
+		iBufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+		iBufferDesc.CPUAccessFlags = 0;
+		iBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+		iBufferDesc.StructureByteStride = 0;
+
+		res = pdevice->CreateBuffer(&iBufferDesc, nullptr, &m_VisibleIndexBuffer);
+		if (FAILED(res))
+			return;
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC rawViewDesc{};
+		rawViewDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+		rawViewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
+		rawViewDesc.BufferEx.FirstElement = 0;
+		rawViewDesc.BufferEx.NumElements = visibleIndexCount;
+		rawViewDesc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
+		res = pdevice->CreateShaderResourceView(m_VisibleIndexBuffer, &rawViewDesc, &m_VisibleIndexBufferView);
+		if (FAILED(res))
+			return;
+
+		D3D11_UNORDERED_ACCESS_VIEW_DESC rawUavDesc{};
+		rawUavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+		rawUavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+		rawUavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+		rawUavDesc.Buffer.FirstElement = 0;
+		rawUavDesc.Buffer.NumElements = visibleIndexCount;
+		res = pdevice->CreateUnorderedAccessView(m_VisibleIndexBuffer, &rawUavDesc, &m_VisibleIndexBufferUAV);
+		if (FAILED(res))
+			return;
+
+		// Number of triangles in the compacted index buffer
+		iBufferDesc.ByteWidth = 4;
+		res = pdevice->CreateBuffer(&iBufferDesc, nullptr, &m_VisibleTriangleCount);
+		if (FAILED(res))
+			return;
+
+		rawViewDesc.BufferEx.NumElements = 1;
+		res = pdevice->CreateShaderResourceView(m_VisibleTriangleCount, &rawViewDesc, &m_VisibleTriangleCountView);
+		if (FAILED(res))
+			return;
+
+		rawUavDesc.Buffer.NumElements = 1;
+		res = pdevice->CreateUnorderedAccessView(m_VisibleTriangleCount, &rawUavDesc, &m_VisibleTriangleCountUAV);
+		if (FAILED(res))
+			return;
+	}
+
+	HelperStruct::ClusterCullInfo CompuMesh::GetClusterCullInfo(const Camera* pcamera) const
+	{
+		using namespace DirectX;
+
+		const XMMATRIX world{ XMLoadFloat4x4(&m_WorldMatrix) };
+		const XMFLOAT4X4 viewProj{ pcamera->GetViewProjection() };
+		XMFLOAT4X4 worldViewProj{};
+		XMStoreFloat4x4(&worldViewProj, world * XMLoadFloat4x4(&viewProj));
+
+		// Gribb-Hartmann plane extraction for row vectors (clip = v * M), D3D clip space so the near plane is z >= 0
+		const XMFLOAT4X4& m{ worldViewProj };
+		const XMVECTOR col0{ XMVectorSet(m._11, m._21, m._31, m._41) };
+		const XMVECTOR col1{ XMVectorSet(m._12, m._22, m._32, m._42) };
+		const XMVECTOR col2{ XMVectorSet(m._13, m._23, m._33, m._43) };
+		const XMVECTOR col3{ XMVectorSet(m._14, m._24, m._34, m._44) };
+		const XMVECTOR planes[6]{ col3 + col0, col3 - col0, col3 + col1, col3 - col1, col2, col3 - col2 };
+
+		HelperStruct::ClusterCullInfo cullInfo{};
+		for (UINT planeIdx{}; planeIdx < 6; ++planeIdx)
+			XMStoreFloat4(&cullInfo.frustumPlanes[planeIdx], XMPlaneNormalize(planes[planeIdx]));
+
+		const XMFLOAT3 cameraPosition{ pcamera->GetPosition() };
+		XMStoreFloat3(&cullInfo.cameraPosition, XMVector3TransformCoord(XMLoadFloat3(&cameraPosition), XMMatrixInverse(nullptr, world)));
+		cullInfo.meshletCount = GetMeshletCount();
+		cullInfo.meshletOffset = m_LodMeshletOffsets[m_LodIdx];
+
+		return cullInfo;
+	}
+
+	void CompuMesh::SelectLod(const Camera* pcamera, float viewportHeight)
+	{
+		using namespace DirectX;
+
+		// Distance to the closest point of the bounding sphere, the world matrix is assumed to carry no scale
+		const XMVECTOR center{ XMVector3TransformCoord(XMLoadFloat3(&m_BoundingCenter), XMLoadFloat4x4(&m_WorldMatrix)) };
+		const XMFLOAT3 cameraPosition{ pcamera->GetPosition() };
+		const float distance{ XMVectorGetX(XMVector3Length(center - XMLoadFloat3(&cameraPosition))) - m_BoundingRadius };
+
+		m_LodIdx = MeshSimplifier::SelectLod(m_Lods, distance, pcamera->GetFOV(), viewportHeight);
+	}
+
 	void CompuMesh::SetupDrawInfo(Camera* pcamera, ID3D11DeviceContext* pdeviceContext) const
 	{
 		if (!m_pMaterial)
@@ -169,7 +363,8 @@ namespace CompuRaster
 
 		XMStoreFloat4x4(&world, DirectX::XMMatrixIdentity());
 		XMStoreFloat4x4(&worldViewProj, XMLoadFloat4x4(&viewProj));
-		m_pMaterial->SetConstantBuffer<HelperStruct::CameraObjectMatricesAndInfo>(pdeviceContext, "ObjectInfo", worldViewProj, world, static_cast<UINT>(std::size(m_VertexPositions)), static_cast<UINT>(std::size(m_Indices) / 3), static_cast<UINT>(std::size(m_Indices)));
+		m_pMaterial->SetConstantBuffer<HelperStruct::CameraObjectMatricesAndInfo>(pdeviceContext, "ObjectInfo", worldViewProj, world, m_VertexCount, GetLodVisibleTriangleCount(), m_Lods[m_LodIdx].indexCount
+			, 0u, m_Dequantization.offset, 0.f, m_Dequantization.scale);
 		m_pMaterial->SetShaders(pdeviceContext, this);
 	}
 }
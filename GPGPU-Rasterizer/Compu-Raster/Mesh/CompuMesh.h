@@ -2,16 +2,36 @@
 #include <DirectXMath.h>
 #include <vector>
 
+#include "Common/IndexPacker.h"
+#include "Common/MeshData.h"
+#include "Common/MeshletBuilder.h"
+#include "Common/Structs.h"
+#include "Common/VertexQuantizer.h"
+
 class Camera;
 
 namespace CompuRaster
 {
 	class Material;
 
+	// Vertex buffer layout read by the compute vertex stage
+	enum class EVertexFormat
+	{
+		Float, // MeshVertex, 32 bytes
+		Quantized // VertexQuantizer::QuantizedVertex, 8 bytes
+	};
+
 	class CompuMesh
 	{
 	public:
-		explicit CompuMesh(std::vector<DirectX::XMFLOAT3>&& positions, std::vector<DirectX::XMFLOAT3>&& normals, std::vector<DirectX::XMFLOAT2>&& uvs, std::vector<uint32_t>&& indices, bool calculateTangents = false);
+		/**
+		 * \brief : Adopts meshData without copying it, its vertices are uploaded as the Vertex_In structured buffer.\n
+		 * The triangles of every level of detail are split into meshlets for the cluster culling pass.\n
+		 * Indices are uploaded as 16 bit pairs when the vertex count allows it (IndexPacker), see GetIndexFormat.
+		 * \param releaseCpuData : Frees the CPU-side vertices, indices and meshlets once SetMaterial uploaded them
+		 * \param vertexFormat : Layout of the uploaded vertices, the material vertex stage must be compiled with GetVertexShaderDefines(vertexFormat)
+		 */
+		explicit CompuMesh(MeshData&& meshData, bool releaseCpuData = false, EVertexFormat vertexFormat = EVertexFormat::Float);
 		~CompuMesh();
 
 		CompuMesh(const CompuMesh&) = delete;
@@ -19,25 +39,71 @@ namespace CompuRaster
 		CompuMesh& operator=(const CompuMesh&) = delete;
 		CompuMesh& operator=(CompuMesh&&) noexcept = delete;
 
+		/**
+		 * \brief : Macros selecting the vertex layout in VertexShader.hlsl, nullptr for the float layout
+		 */
+		static const D3D_SHADER_MACRO* GetVertexShaderDefines(EVertexFormat vertexFormat);
+
 		void SetMaterial(ID3D11Device* pdevice, Material* pmaterial);
 		void SetupDrawInfo(Camera* pcamera, ID3D11DeviceContext* pdeviceContext) const;
 		ID3D11ShaderResourceView* GetVertexBufferView() const { return m_VertexBufferView; }
 		ID3D11ShaderResourceView* GetIndexBufferView() const { return m_IndexBufferView; }
 		ID3D11ShaderResourceView* GetVertexOutBufferView() const { return m_VertexOutBufferView; }
 		ID3D11UnorderedAccessView* GetVertexOutBufferUAV() const { return m_VertexOutBufferUAV; }
+		ID3D11ShaderResourceView* GetMeshletBufferView() const { return m_MeshletBufferView; }
+		ID3D11ShaderResourceView* GetVisibleIndexBufferView() const { return m_VisibleIndexBufferView; }
+		ID3D11UnorderedAccessView* GetVisibleIndexBufferUAV() const { return m_VisibleIndexBufferUAV; }
+		ID3D11ShaderResourceView* GetVisibleTriangleCountView() const { return m_VisibleTriangleCountView; }
+		ID3D11UnorderedAccessView* GetVisibleTriangleCountUAV() const { return m_VisibleTriangleCountUAV; }
+
+		/**
+		 * \brief : Frustum planes and camera position in object space, for the cluster culling pass
+		 */
+		HelperStruct::ClusterCullInfo GetClusterCullInfo(const Camera* pcamera) const;
 
-		UINT GetIndexCount() const { return static_cast<UINT>(std::size(m_Indices)); }
-		UINT GetTriangleCount() const { return GetIndexCount() / 3; }
-		UINT GetVertexCount() const { return static_cast<UINT>(std::size(m_VertexPositions)); }
+		/**
+		 * \brief : Picks the coarsest level of detail whose error projects to less than a pixel from the camera (MeshSimplifier::SelectLod)
+		 * \param viewportHeight : Height of the render target in pixels
+		 */
+		void SelectLod(const Camera* pcamera, float viewportHeight);
+
+		// Indices of every level of detail
+		UINT GetIndexCount() const { return m_IndexCount; }
+		// Triangles of LOD 0, the most any level draws, used to size the pipeline buffers
+		UINT GetTriangleCount() const { return m_Lods[0].indexCount / 3; }
+		UINT GetVertexCount() const { return m_VertexCount; }
+		EVertexFormat GetVertexFormat() const { return m_VertexFormat; }
+		UINT GetLodCount() const { return static_cast<UINT>(std::size(m_Lods)); }
+		UINT GetLodIndex() const { return m_LodIdx; }
+		UINT GetLodTriangleCount() const { return m_Lods[m_LodIdx].indexCount / 3; }
+		EIndexFormat GetIndexFormat() const { return m_IndexFormat; }
+		// Slots the cluster culling pass may fill for the selected level, 16 bit indices pad every odd meshlet with a degenerate triangle
+		UINT GetLodVisibleTriangleCount() const { return m_LodVisibleTriangleCounts[m_LodIdx]; }
+		// Most slots any level fills, used to size the pipeline buffers
+		UINT GetMaxVisibleTriangleCount() const { return m_MaxVisibleTriangleCount; }
+		// Meshlets of the selected level of detail
+		UINT GetMeshletCount() const { return m_LodMeshletOffsets[m_LodIdx + 1] - m_LodMeshletOffsets[m_LodIdx]; }
 
 	private:
 		DirectX::XMFLOAT4X4 m_WorldMatrix;
 
-		std::vector<DirectX::XMFLOAT3> m_VertexPositions;
-		std::vector<DirectX::XMFLOAT3> m_VertexNorms;
-		std::vector<DirectX::XMFLOAT3> m_VertexTangents;
-		std::vector<DirectX::XMFLOAT2> m_VertexUvs;
-		std::vector<uint32_t> m_Indices;
+		MeshData m_MeshData;
+		UINT m_VertexCount;
+		UINT m_IndexCount;
+		EVertexFormat m_VertexFormat;
+		EIndexFormat m_IndexFormat;
+		VertexQuantizer::Dequantization m_Dequantization;
+		std::vector<MeshLod> m_Lods;
+		UINT m_LodIdx;
+		DirectX::XMFLOAT3 m_BoundingCenter;
+		float m_BoundingRadius;
+		// Meshlets of every level back to back, level i owns [m_LodMeshletOffsets[i], m_LodMeshletOffsets[i + 1])
+		std::vector<MeshletBuilder::Meshlet> m_Meshlets;
+		std::vector<UINT> m_LodMeshletOffsets;
+		std::vector<UINT> m_LodVisibleTriangleCounts;
+		UINT m_MaxVisibleTriangleCount;
+		UINT m_MeshletCount;
+		bool m_ReleaseCpuData;
 
 		ID3D11ShaderResourceView* m_VertexBufferView;
 		ID3D11ShaderResourceView* m_VertexOutBufferView;
@@ -46,10 +112,20 @@ namespace CompuRaster
 		ID3D11Buffer* m_VertexBuffer;
 		ID3D11Buffer* m_VertexOutBuffer;
 		ID3D11Buffer* m_IndexBuffer;
+
+		ID3D11ShaderResourceView* m_MeshletBufferView;
+		ID3D11ShaderResourceView* m_VisibleIndexBufferView;
+		ID3D11UnorderedAccessView* m_VisibleIndexBufferUAV;
+		ID3D11ShaderResourceView* m_VisibleTriangleCountView;
+		ID3D11UnorderedAccessView* m_VisibleTriangleCountUAV;
+		ID3D11Buffer* m_MeshletBuffer;
+		ID3D11Buffer* m_VisibleIndexBuffer;
+		ID3D11Buffer* m_VisibleTriangleCount;
 		Material* m_pMaterial;
 
 		void BuildVertexBuffer(ID3D11Device* pdevice);
 		void BuildIndexBuffer(ID3D11Device* pdevice);
+		void BuildClusterBuffers(ID3D11Device* pdevice);
 	};
 }
 
@@ -6,21 +6,20 @@
 
 namespace CompuRaster
 {
-	Mesh::Mesh(std::vector<DirectX::XMFLOAT3>&& positions, std::vector<DirectX::XMFLOAT3>&& normals, std::vector<DirectX::XMFLOAT2>&& uvs, std::vector<uint32_t>&& indices, bool calculateTangents)
+	Mesh::Mesh(MeshData&& meshData, bool releaseCpuData)
 		: m_WorldMatrix{  }
-		, m_VertexPositions{ positions }
-		, m_VertexNorms{ normals }
-		, m_VertexTangents{  }
-		, m_VertexUvs{ uvs }
-		, m_Indices{ indices }
+		, m_MeshData{ std::move(meshData) }
+		, m_VertexCount{ m_MeshData.GetVertexCount() }
+		// Only LOD 0 is drawn, it is the start of the index buffer
+		, m_IndexCount{ m_MeshData.GetLod(0).indexCount }
+		, m_ReleaseCpuData{ releaseCpuData }
+		, m_VertexBufferView{ nullptr }
+		, m_IndexBufferView{ nullptr }
 		, m_VertexBuffer{ nullptr }
 		, m_IndexBuffer{ nullptr }
 		, m_pMaterial{ nullptr }
 	{
 		XMStoreFloat4x4(&m_WorldMatrix, DirectX::XMMatrixIdentity());
-
-		calculateTangents;
-		m_VertexTangents.resize(m_VertexPositions.size());
 	}
 
 	Mesh::~Mesh()
@@ -36,15 +35,18 @@ namespace CompuRaster
 		m_pMaterial = pmaterial;
 		BuildVertexBuffer(pdevice);
 		BuildIndexBuffer(pdevice);
+
+		if (m_ReleaseCpuData && m_VertexBuffer && m_IndexBuffer)
+			m_MeshData.Release();
 	}
 
 	void Mesh::BuildVertexBuffer(ID3D11Device* pdevice)
 	{
-		if (!m_pMaterial)
+		if (!m_pMaterial || m_VertexBuffer || m_VertexCount == 0)
 			return;
 
-		UINT vCount{ static_cast<UINT>(std::size(m_VertexPositions)) };
-		UINT vStride{ 32u };
+		UINT vCount{ m_VertexCount };
+		UINT vStride{ static_cast<UINT>(sizeof(MeshVertex)) };
 
 		D3D11_BUFFER_DESC vBufferDesc{};
 		vBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
@@ -54,29 +56,14 @@ namespace CompuRaster
 		vBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
 		vBufferDesc.StructureByteStride = vStride;
 
-		char* pdata{ new char[vBufferDesc.ByteWidth] };
-
-		for (UINT idx{}; idx < vCount; ++idx)
-		{
-			UINT memOffset{ vStride * idx };
-			memcpy(pdata + memOffset, &m_VertexPositions[idx], sizeof m_VertexPositions[idx]);
-
-			if (idx < std::size(m_VertexNorms))
-			{
-				memOffset += 16u;
-				memcpy(pdata + memOffset, &m_VertexNorms[idx], sizeof m_VertexNorms[idx]);
-			}
-		}
-
+		// MeshVertex already has the Vertex_In packing, upload it as-is
 		D3D11_SUBRESOURCE_DATA vResData{};
-		vResData.pSysMem = pdata;
+		vResData.pSysMem = std::data(m_MeshData.vertices);
 
 		HRESULT res{ pdevice->CreateBuffer(&vBufferDesc, &vResData, &m_VertexBuffer) };
 		if (FAILED(res))
 			return;
 
-		delete[] pdata;
-
 		D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc{};
 		viewDesc.Format = DXGI_FORMAT_UNKNOWN;
 		viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
@@ -89,7 +76,10 @@ namespace CompuRaster
 
 	void Mesh::BuildIndexBuffer(ID3D11Device* pdevice)
 	{
-		UINT iCount{ static_cast<UINT>(std::size(m_Indices)) };
+		if (m_IndexBuffer || m_IndexCount == 0)
+			return;
+
+		UINT iCount{ m_IndexCount };
 		UINT iStride{ static_cast<UINT>(sizeof uint32_t) };
 
 		D3D11_BUFFER_DESC iBufferDesc{};
@@ -101,7 +91,7 @@ namespace CompuRaster
 		iBufferDesc.StructureByteStride = iStride;
 
 		D3D11_SUBRESOURCE_DATA vResData{};
-		vResData.pSysMem = std::data(m_Indices);
+		vResData.pSysMem = std::data(m_MeshData.indices);
 
 		HRESULT res{ pdevice->CreateBuffer(&iBufferDesc, &vResData, &m_IndexBuffer) };
 		if (FAILED(res))
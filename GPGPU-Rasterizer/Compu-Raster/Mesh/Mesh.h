@@ -2,6 +2,7 @@
 #include <DirectXMath.h>
 #include <vector>
 
+#include "Common/MeshData.h"
 #include "Common/Structs.h"
 
 class Camera;
@@ -13,7 +14,11 @@ namespace CompuRaster
 	class Mesh
 	{
 	public:
-		explicit Mesh(std::vector<DirectX::XMFLOAT3>&& positions, std::vector<DirectX::XMFLOAT3>&& normals, std::vector<DirectX::XMFLOAT2>&& uvs, std::vector<uint32_t>&& indices, bool calculateTangents = false);
+		/**
+		 * \brief : Adopts meshData without copying it, its vertices are uploaded as the Vertex_In structured buffer.
+		 * \param releaseCpuData : Frees the CPU-side vertices and indices once SetMaterial uploaded them
+		 */
+		explicit Mesh(MeshData&& meshData, bool releaseCpuData = false);
 		~Mesh();
 
 		Mesh(const Mesh&) = delete;
@@ -26,16 +31,15 @@ namespace CompuRaster
 		ID3D11ShaderResourceView* GetVertexBufferView() const { return m_VertexBufferView; }
 		ID3D11ShaderResourceView* GetIndexBufferView() const { return m_IndexBufferView; }
 
-		UINT GetIndexCount() const { return static_cast<UINT>(std::size(m_Indices)); }
+		UINT GetIndexCount() const { return m_IndexCount; }
 
 	private:
 		DirectX::XMFLOAT4X4 m_WorldMatrix;
 
-		std::vector<DirectX::XMFLOAT3> m_VertexPositions;
-		std::vector<DirectX::XMFLOAT3> m_VertexNorms;
-		std::vector<DirectX::XMFLOAT3> m_VertexTangents;
-		std::vector<DirectX::XMFLOAT2> m_VertexUvs;
-		std::vector<uint32_t> m_Indices;
+		MeshData m_MeshData;
+		UINT m_VertexCount;
+		UINT m_IndexCount;
+		bool m_ReleaseCpuData;
 
 		ID3D11ShaderResourceView* m_VertexBufferView;
 		ID3D11ShaderResourceView* m_IndexBufferView;
@@ -16,11 +16,13 @@ namespace CompuRaster
 		, m_pDxSwapChain{ nullptr }
 		, m_pRenderTargetUAV{ nullptr }
 		, m_pDepthUAV{ nullptr }
+		, m_pHiZUAV{ nullptr }
 		, m_bInitialized{ false }
 	{}
 
 	CompuRenderer::~CompuRenderer()
 	{
+		Helpers::SafeRelease(m_pHiZUAV);
 		Helpers::SafeRelease(m_pDepthUAV);
 		Helpers::SafeRelease(m_pRenderTargetUAV);
 		Helpers::SafeRelease(m_pDxSwapChain);
@@ -28,7 +30,7 @@ namespace CompuRaster
 		Helpers::SafeRelease(m_pDxDevice);
 	}
 
-	HRESULT CompuRenderer::Initialize(const Window& window)
+	HRESULT CompuRenderer::Initialize(const Window& window, const RasterConfig& rasterConfig)
 	{
 		HRESULT res{ S_OK };
 
@@ -110,6 +112,10 @@ namespace CompuRaster
 
 		D3D11_TEXTURE2D_DESC bbDesc{};
 		pbackBuffer->GetDesc(&bbDesc);
+		if (bbDesc.Width != rasterConfig.viewportWidth || bbDesc.Height != rasterConfig.viewportHeight)
+		{
+			APP_LOG_ERROR(L"Back buffer size differs from the raster config viewport, the pipeline only draws its viewport !");
+		}
 
 		D3D11_UNORDERED_ACCESS_VIEW_DESC rtUAVDesc{};
 		rtUAVDesc.Format = bbDesc.Format;
@@ -134,6 +140,32 @@ namespace CompuRaster
 		res = m_pDxDevice->CreateUnorderedAccessView(pdepthBuffer, &depthUAVDesc, &m_pDepthUAV);
 		APP_ASSERT_ERROR(SUCCEEDED(res), L"Failed to create depth buffer UAV !");
 
+		// HIZ_DIMS of the pipeline shaders, one float2 per tile
+		const UINT hiZTileCount{ rasterConfig.GetHiZTileCount() };
+		const UINT hiZStride{ 2 * 4 };
+
+		D3D11_BUFFER_DESC hiZDesc{};
+		hiZDesc.Usage = D3D11_USAGE_DEFAULT;
+		hiZDesc.ByteWidth = hiZTileCount * hiZStride;
+		hiZDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+		hiZDesc.CPUAccessFlags = 0;
+		hiZDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		hiZDesc.StructureByteStride = hiZStride;
+
+		ID3D11Buffer* phiZBuffer;
+		res = m_pDxDevice->CreateBuffer(&hiZDesc, nullptr, &phiZBuffer);
+		APP_ASSERT_ERROR(SUCCEEDED(res), L"Failed to create Hi-Z buffer !");
+
+		D3D11_UNORDERED_ACCESS_VIEW_DESC hiZUAVDesc{};
+		hiZUAVDesc.Format = DXGI_FORMAT_UNKNOWN;
+		hiZUAVDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+		hiZUAVDesc.Buffer.FirstElement = 0;
+		hiZUAVDesc.Buffer.NumElements = hiZTileCount;
+
+		res = m_pDxDevice->CreateUnorderedAccessView(phiZBuffer, &hiZUAVDesc, &m_pHiZUAV);
+		APP_ASSERT_ERROR(SUCCEEDED(res), L"Failed to create Hi-Z UAV !");
+
+		Helpers::SafeRelease(phiZBuffer);
 		Helpers::SafeRelease(pdepthBuffer);
 		Helpers::SafeRelease(pbackBuffer);
 		Helpers::SafeRelease(dxgiDevice);
@@ -3,6 +3,7 @@
 
 class Camera;
 class Window;
+struct RasterConfig;
 
 namespace CompuRaster
 {
@@ -21,7 +22,10 @@ namespace CompuRaster
 		CompuRenderer& operator=(const CompuRenderer&) = delete;
 		CompuRenderer& operator=(CompuRenderer&&) noexcept = delete;
 
-		HRESULT Initialize(const Window& window);
+		/**
+		 * \param rasterConfig : The viewport must be the window size, the Hi-Z keeps one entry per tile of it
+		 */
+		HRESULT Initialize(const Window& window, const RasterConfig& rasterConfig);
 
 		ID3D11Device* GetDevice() const { return m_pDxDevice; }
 		ID3D11DeviceContext* GetDeviceContext() const { return m_pDxDeviceContext; }
@@ -33,8 +37,13 @@ namespace CompuRaster
 			float max[4]{ FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
 			m_pDxDeviceContext->ClearUnorderedAccessViewFloat(m_pDepthUAV, max);
 
+			// FLT_MAX bits, the Hi-Z is a structured buffer
+			const UINT maxBits[4]{ 0x7F7FFFFF, 0x7F7FFFFF, 0x7F7FFFFF, 0x7F7FFFFF };
+			m_pDxDeviceContext->ClearUnorderedAccessViewUint(m_pHiZUAV, maxBits);
+
 			ID3D11UnorderedAccessView* uavs[]{ m_pRenderTargetUAV, m_pDepthUAV };
 			m_pDxDeviceContext->CSSetUnorderedAccessViews(0, 2, uavs, nullptr);
+			m_pDxDeviceContext->CSSetUnorderedAccessViews(5, 1, &m_pHiZUAV, nullptr);
 		}
 
 		void Draw(Camera* pcamera, Mesh* pmesh) const;
@@ -46,6 +55,8 @@ namespace CompuRaster
 		IDXGISwapChain* m_pDxSwapChain;
 		ID3D11UnorderedAccessView* m_pRenderTargetUAV;
 		ID3D11UnorderedAccessView* m_pDepthUAV;
+		// Min and max depth of every RasterConfig tile of the depth buffer, G_HIZ_BUFFER of the tile and fine stages
+		ID3D11UnorderedAccessView* m_pHiZUAV;
 
 		bool m_bInitialized;
 	};
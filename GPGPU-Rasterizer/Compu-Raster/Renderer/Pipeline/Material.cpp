@@ -22,9 +22,9 @@ namespace CompuRaster
 		Helpers::SafeDelete(m_pPixelShader);
 	}
 
-	void Material::Init(ID3D11Device* pdevice, const wchar_t* vsPath, const wchar_t*)
+	void Material::Init(ID3D11Device* pdevice, const wchar_t* vsPath, const wchar_t*, const D3D_SHADER_MACRO* pvsDefines)
 	{
-		m_pVertexShader = new ComputeShader(pdevice, vsPath);
+		m_pVertexShader = new ComputeShader(pdevice, vsPath, "main", pvsDefines);
 		APP_ASSERT_ERROR(L"Could not create Vertex Shader !", m_pVertexShader);
 
 		//m_pPixelShader = new ComputeShader(pdevice, psPath);
@@ -26,7 +26,11 @@ namespace CompuRaster
 		Material& operator=(const Material&) = delete;
 		Material& operator=(Material&&) noexcept = delete;
 
-		void Init(ID3D11Device* pdevice, const wchar_t* vsPath, const wchar_t* psPath);
+		/**
+		 * \brief : Compiles the compute vertex stage.
+		 * \param pvsDefines : Optional macros for the vertex stage, see CompuMesh::GetVertexShaderDefines
+		 */
+		void Init(ID3D11Device* pdevice, const wchar_t* vsPath, const wchar_t* psPath, const D3D_SHADER_MACRO* pvsDefines = nullptr);
 
 		ComputeShader* GetVertexShader() const { return m_pVertexShader; }
 		ComputeShader* GetPixelShader() const { return m_pPixelShader; }
@@ -1,30 +1,53 @@
 #include "pch.h"
 #include "Pipeline.h"
 
+#include <algorithm>
+#include <climits>
+#include <cstddef>
 #include <DirectXColors.h>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "../../Mesh/CompuMesh.h"
+#include "Managers/Logger.h"
 
 namespace CompuRaster
 {
 	Pipeline::Pipeline()
-		: m_pGeometrySetupShader{ nullptr }
+		: m_pClusterCullingShader{ nullptr }
+		, m_pGeometrySetupShader{ nullptr }
+		, m_pBinCountShader{ nullptr }
+		, m_pBinScanShader{ nullptr }
 		, m_pBinningShader{ nullptr }
 		, m_pCoarseShader{ nullptr }
 		, m_pFineShader{ nullptr }
+		, m_pShadingShader{ nullptr }
 	{}
 
 	Pipeline::~Pipeline()
 	{
+		Release();
+	}
+
+	void Pipeline::Release()
+	{
+		Helpers::SafeRelease(m_pClusterCullInfoBuffer);
 		Helpers::SafeRelease(m_pVOutoutBuffer);
 		Helpers::SafeRelease(m_pVOutoutSRV);
 		Helpers::SafeRelease(m_pVOutoutUAV);
 		Helpers::SafeRelease(m_pRasterDataBuffer);
 		Helpers::SafeRelease(m_pRasterDataSRV);
 		Helpers::SafeRelease(m_pRasterDataUAV);
+		Helpers::SafeRelease(m_pBinOffsetBuffer);
+		Helpers::SafeRelease(m_pBinOffsetSRV);
+		Helpers::SafeRelease(m_pBinOffsetUAV);
 		Helpers::SafeRelease(m_pBinBuffer);
 		Helpers::SafeRelease(m_pBinSRV);
 		Helpers::SafeRelease(m_pBinUAV);
+		Helpers::SafeRelease(m_pBinHeaderBuffer);
+		Helpers::SafeRelease(m_pBinHeaderSRV);
+		Helpers::SafeRelease(m_pBinHeaderUAV);
 		Helpers::SafeRelease(m_pTileBuffer);
 		Helpers::SafeRelease(m_pTileSRV);
 		Helpers::SafeRelease(m_pTileUAV);
@@ -32,38 +55,143 @@ namespace CompuRaster
 		Helpers::SafeRelease(m_pBinCounter);
 		Helpers::SafeRelease(m_pBinCounterUAV);
 
-		Helpers::SafeRelease(m_pBinTriCounter);
-		Helpers::SafeRelease(m_pBinTriCounterSRV);
-		Helpers::SafeRelease(m_pBinTriCounterUAV);
-
 		Helpers::SafeRelease(m_pTileCounter);
 		Helpers::SafeRelease(m_pTileCounterUAV);
 
+		Helpers::SafeRelease(m_pSetupCounter);
+		Helpers::SafeRelease(m_pSetupCounterSRV);
+		Helpers::SafeRelease(m_pSetupCounterUAV);
+
+		Helpers::SafeRelease(m_pClipVertexBuffer);
+		Helpers::SafeRelease(m_pClipVertexSRV);
+		Helpers::SafeRelease(m_pClipVertexUAV);
+
+		Helpers::SafeRelease(m_pMicroTileCounter);
+		Helpers::SafeRelease(m_pMicroTileCounterSRV);
+		Helpers::SafeRelease(m_pMicroTileCounterUAV);
+
+		Helpers::SafeRelease(m_pMicroTileBuffer);
+		Helpers::SafeRelease(m_pMicroTileSRV);
+		Helpers::SafeRelease(m_pMicroTileUAV);
+
+		Helpers::SafeRelease(m_pHiZCounter);
+		Helpers::SafeRelease(m_pHiZCounterUAV);
+		Helpers::SafeRelease(m_pOverlapCounter);
+		Helpers::SafeRelease(m_pOverlapCounterUAV);
+
+		Helpers::SafeRelease(m_pVisibilityBuffer);
+		Helpers::SafeRelease(m_pVisibilityUAV);
+
+		for (ID3D11Buffer*& preadback : m_pBinReadback)
+			Helpers::SafeRelease(preadback);
+		m_BinReadbackFrame = 0;
+		m_BinCapacity = {};
+		m_BinSizes = {};
+
+		for (ID3D11Buffer*& preadback : m_pStatsReadback)
+			Helpers::SafeRelease(preadback);
+		m_StatsReadbackFrame = 0;
+		m_Stats = {};
+
+		Helpers::SafeDelete(m_pClusterCullingShader);
 		Helpers::SafeDelete(m_pGeometrySetupShader);
+		Helpers::SafeDelete(m_pBinCountShader);
+		Helpers::SafeDelete(m_pBinScanShader);
 		Helpers::SafeDelete(m_pBinningShader);
 		Helpers::SafeDelete(m_pCoarseShader);
 		Helpers::SafeDelete(m_pFineShader);
+		Helpers::SafeDelete(m_pShadingShader);
 	}
 
-	void Pipeline::Init(ID3D11Device* pdevice, UINT vCount, UINT triangleCount, const wchar_t* geometrySetupPath, const wchar_t* binningPath, const wchar_t* tilePath, const wchar_t* finePath)
+	void Pipeline::Init(ID3D11Device* pdevice, UINT vCount, UINT triangleCount, EIndexFormat indexFormat, const RasterConfig& rasterConfig, ERasterMode rasterMode, EShadingMode shadingMode, ECullMode cullMode, ECoverageMode coverageMode, const wchar_t* clusterCullingPath, const wchar_t* geometrySetupPath, const wchar_t* binningPath, const wchar_t* binScanPath, const wchar_t* tilePath, const wchar_t* finePath, const wchar_t* shadingPath)
 	{
-		m_pGeometrySetupShader = new ComputeShader(pdevice, geometrySetupPath);
-		m_pBinningShader = new ComputeShader(pdevice, binningPath);
-		m_pCoarseShader = new ComputeShader(pdevice, tilePath);
-		m_pFineShader = new ComputeShader(pdevice, finePath);
+		Release();
+
+		if (const wchar_t* error{ rasterConfig.GetError() })
+		{
+			APP_LOG_ERROR(std::wstring{ L"Invalid raster config: " } + error);
+			return;
+		}
+
+		if (rasterMode == ERasterMode::FixedPoint && !rasterConfig.IsFixedPointExact())
+		{
+			APP_LOG_WARNING(L"Viewport too large for exact fixed point edge functions, the weights of the largest triangles fall back to float estimates");
+		}
+
+		m_RasterConfig = rasterConfig;
+		m_ShaderDefines = rasterConfig.GetShaderDefines(rasterMode);
+
+		// Every stage sizes its groups, bins and tiles from the config
+		const std::vector<D3D_SHADER_MACRO> configDefines{ GetShaderDefines() };
+
+		// Every stage reading an index buffer decodes 16 bit pairs when the mesh was uploaded with them
+		std::vector<D3D_SHADER_MACRO> indexDefines{ std::begin(configDefines), std::prev(std::end(configDefines)) };
+		if (indexFormat == EIndexFormat::Uint16)
+			indexDefines.push_back({ "INDEX_16BIT", "1" });
+
+		// Back faces are culled by default, cluster culling reads the mode too
+		if (cullMode == ECullMode::None)
+			indexDefines.push_back({ "CULL_NONE", "1" });
+		else if (cullMode == ECullMode::Front)
+			indexDefines.push_back({ "CULL_FRONT", "1" });
+
+		// Geometry setup, tiling and the fine stage also agree on the edge functions
+		std::vector<D3D_SHADER_MACRO> rasterDefines{ indexDefines };
+		if (rasterMode == ERasterMode::FixedPoint)
+			rasterDefines.push_back({ "FIXED_POINT_RASTER", "1" });
+
+		std::vector<D3D_SHADER_MACRO> fineDefines{ rasterDefines };
+		if (shadingMode == EShadingMode::VisibilityBuffer)
+			fineDefines.push_back({ "VISIBILITY_BUFFER", "1" });
+		if (coverageMode == ECoverageMode::Quad)
+			fineDefines.push_back({ "QUAD_COVERAGE", "1" });
+
+		indexDefines.push_back({ nullptr, nullptr });
+		rasterDefines.push_back({ nullptr, nullptr });
+		fineDefines.push_back({ nullptr, nullptr });
+
+		// Binning counts the bins of the triangles before storing them, it tests their edges on the bins like tiling
+		std::vector<D3D_SHADER_MACRO> binCountDefines{ std::begin(rasterDefines), std::prev(std::end(rasterDefines)) };
+		binCountDefines.push_back({ "BIN_COUNT_PASS", "1" });
+		binCountDefines.push_back({ nullptr, nullptr });
+
+		m_pClusterCullingShader = new ComputeShader(pdevice, clusterCullingPath, "main", std::data(indexDefines));
+		m_pGeometrySetupShader = new ComputeShader(pdevice, geometrySetupPath, "main", std::data(rasterDefines));
+		m_pBinCountShader = new ComputeShader(pdevice, binningPath, "main", std::data(binCountDefines));
+		m_pBinScanShader = new ComputeShader(pdevice, binScanPath, "main", std::data(configDefines));
+		m_pBinningShader = new ComputeShader(pdevice, binningPath, "main", std::data(rasterDefines));
+		m_pCoarseShader = new ComputeShader(pdevice, tilePath, "main", std::data(rasterDefines));
+		m_pFineShader = new ComputeShader(pdevice, finePath, "main", std::data(fineDefines));
+		// Rebuilds the weights of the fine stage, so it also agrees on the edge functions
+		if (shadingMode == EShadingMode::VisibilityBuffer)
+			m_pShadingShader = new ComputeShader(pdevice, shadingPath, "main", std::data(rasterDefines));
 
 		vCount;
+
+		D3D11_BUFFER_DESC cullInfoDesc{};
+		cullInfoDesc.Usage = D3D11_USAGE_DYNAMIC;
+		cullInfoDesc.ByteWidth = static_cast<UINT>(sizeof(HelperStruct::ClusterCullInfo));
+		cullInfoDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		cullInfoDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		cullInfoDesc.MiscFlags = 0;
+		cullInfoDesc.StructureByteStride = 0;
+
+		HRESULT res{ pdevice->CreateBuffer(&cullInfoDesc, nullptr, &m_pClusterCullInfoBuffer) };
+		if (FAILED(res))
+			return;
+
 		UINT rasterDataStride{ 4u * 16u };
+		const UINT rasterTriangleCount{ triangleCount + Clipping::MAX_CLIP_TRIANGLES };
 
 		D3D11_BUFFER_DESC rasterDataBufferDesc{};
 		rasterDataBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-		rasterDataBufferDesc.ByteWidth = rasterDataStride * triangleCount;
+		rasterDataBufferDesc.ByteWidth = rasterDataStride * rasterTriangleCount;
 		rasterDataBufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
 		rasterDataBufferDesc.CPUAccessFlags = 0;
 		rasterDataBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
 		rasterDataBufferDesc.StructureByteStride = rasterDataStride;
 
-		HRESULT res{ pdevice->CreateBuffer(&rasterDataBufferDesc, nullptr, &m_pRasterDataBuffer) };
+		res = pdevice->CreateBuffer(&rasterDataBufferDesc, nullptr, &m_pRasterDataBuffer);
 		if (FAILED(res))
 			return;
 
@@ -71,7 +199,7 @@ namespace CompuRaster
 		rdViewDesc.Format = DXGI_FORMAT_UNKNOWN;
 		rdViewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
 		rdViewDesc.Buffer.FirstElement = 0;
-		rdViewDesc.Buffer.NumElements = triangleCount;
+		rdViewDesc.Buffer.NumElements = rasterTriangleCount;
 		res = pdevice->CreateShaderResourceView(m_pRasterDataBuffer, &rdViewDesc, &m_pRasterDataSRV);
 		if (FAILED(res))
 			return;
@@ -81,85 +209,35 @@ namespace CompuRaster
 		rdUavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
 		rdUavDesc.Buffer.Flags = 0;
 		rdUavDesc.Buffer.FirstElement = 0;
-		rdUavDesc.Buffer.NumElements = triangleCount;
+		rdUavDesc.Buffer.NumElements = rasterTriangleCount;
 		res = pdevice->CreateUnorderedAccessView(m_pRasterDataBuffer, &rdUavDesc, &m_pRasterDataUAV);
 		if (FAILED(res))
 			return;
 
-		const UINT dispatchCount = 16;
-		const UINT batchSize = static_cast<UINT>(ceil(static_cast<float>(triangleCount) / static_cast<float>(dispatchCount)));
-		const UINT queueSize = dispatchCount * batchSize;
-		const UINT binCount{ 20 * 12 };
-		UINT elemCount = binCount * (queueSize + dispatchCount);
+		UINT vertexOutStride{ 4u * 8u };
 
-#pragma region INPUT_BUFFER
-		D3D11_BUFFER_DESC binBufferDesc{};
-		binBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-		binBufferDesc.ByteWidth = elemCount * 4;
-		binBufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
-		binBufferDesc.CPUAccessFlags = 0;
-		binBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
-		binBufferDesc.StructureByteStride = 0;
+		D3D11_BUFFER_DESC clipVertexBufferDesc{ rasterDataBufferDesc };
+		clipVertexBufferDesc.ByteWidth = vertexOutStride * 3 * Clipping::MAX_CLIP_TRIANGLES;
+		clipVertexBufferDesc.StructureByteStride = vertexOutStride;
 
-		res = pdevice->CreateBuffer(&binBufferDesc, nullptr, &m_pBinBuffer);
+		res = pdevice->CreateBuffer(&clipVertexBufferDesc, nullptr, &m_pClipVertexBuffer);
 		if (FAILED(res))
 			return;
 
-		D3D11_SHADER_RESOURCE_VIEW_DESC binViewDesc{};
-		binViewDesc.Format = DXGI_FORMAT_R32_TYPELESS;
-		binViewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
-		binViewDesc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
-		binViewDesc.BufferEx.FirstElement = 0;
-		binViewDesc.BufferEx.NumElements = elemCount;
-		res = pdevice->CreateShaderResourceView(m_pBinBuffer, &binViewDesc, &m_pBinSRV);
-		if (FAILED(res))
-			return;
-
-		D3D11_UNORDERED_ACCESS_VIEW_DESC binUavDesc{};
-		binUavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
-		binUavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
-		binUavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
-		binUavDesc.Buffer.FirstElement = 0;
-		binUavDesc.Buffer.NumElements = elemCount;
-		res = pdevice->CreateUnorderedAccessView(m_pBinBuffer, &binUavDesc, &m_pBinUAV);
-		if (FAILED(res))
-			return;
-#pragma endregion
-
-		// Ouput buffer structure is a uint2x4, so 8 * 4 bytes stride, used as a bit mask for the 16*16 tiles (256 bits, 256 tiles)
-		elemCount = binCount * queueSize;
-		const UINT tileStride = 4 * (2 + 1); 
-		D3D11_BUFFER_DESC tileBufferDesc{ };
-		tileBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-		tileBufferDesc.ByteWidth = elemCount * tileStride;
-		tileBufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
-		tileBufferDesc.CPUAccessFlags = 0;
-		tileBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
-		tileBufferDesc.StructureByteStride = tileStride;
-		res = pdevice->CreateBuffer(&tileBufferDesc, nullptr, &m_pTileBuffer);
+		rdViewDesc.Buffer.NumElements = 3 * Clipping::MAX_CLIP_TRIANGLES;
+		res = pdevice->CreateShaderResourceView(m_pClipVertexBuffer, &rdViewDesc, &m_pClipVertexSRV);
 		if (FAILED(res))
 			return;
 
-		D3D11_SHADER_RESOURCE_VIEW_DESC tileViewDesc{ };
-		tileViewDesc.Format = DXGI_FORMAT_UNKNOWN;
-		tileViewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
-		tileViewDesc.Buffer.FirstElement = 0;
-		tileViewDesc.Buffer.NumElements = elemCount;
-		res = pdevice->CreateShaderResourceView(m_pTileBuffer, &tileViewDesc, &m_pTileSRV);
+		rdUavDesc.Buffer.NumElements = 3 * Clipping::MAX_CLIP_TRIANGLES;
+		res = pdevice->CreateUnorderedAccessView(m_pClipVertexBuffer, &rdUavDesc, &m_pClipVertexUAV);
 		if (FAILED(res))
 			return;
 
-		D3D11_UNORDERED_ACCESS_VIEW_DESC tileUavDesc{ };
-		tileUavDesc.Format = DXGI_FORMAT_UNKNOWN;
-		tileUavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
-		tileUavDesc.Buffer.Flags = 0;
-		tileUavDesc.Buffer.FirstElement = 0;
-		tileUavDesc.Buffer.NumElements = elemCount;
-		res = pdevice->CreateUnorderedAccessView(m_pTileBuffer, &tileUavDesc, &m_pTileUAV);
-		if (FAILED(res))
+		const UINT initialPairCount{ rasterTriangleCount * INITIAL_BIN_PAIRS_PER_TRIANGLE };
+		if (!CreateBinBuffers(pdevice, { initialPairCount, initialPairCount / INITIAL_BIN_PAIRS_PER_BLOCK, initialPairCount / INITIAL_BIN_PAIRS_PER_WORD }))
 			return;
 
-
 		D3D11_BUFFER_DESC counterDesc{};
 		counterDesc.Usage = D3D11_USAGE_DEFAULT;
 		counterDesc.ByteWidth = 4;
@@ -194,9 +272,35 @@ namespace CompuRaster
 		if (FAILED(res))
 			return;
 
+		counterDesc.ByteWidth = 2 * 4;
+		res = pdevice->CreateBuffer(&counterDesc, nullptr, &m_pHiZCounter);
+		if (FAILED(res))
+			return;
+
+		counterUavDesc.Buffer.NumElements = 2;
+		res = pdevice->CreateUnorderedAccessView(m_pHiZCounter, &counterUavDesc, &m_pHiZCounterUAV);
+		if (FAILED(res))
+			return;
+
+		counterDesc.ByteWidth = 4 * 4;
+		res = pdevice->CreateBuffer(&counterDesc, nullptr, &m_pOverlapCounter);
+		if (FAILED(res))
+			return;
+
+		counterUavDesc.Buffer.NumElements = 4;
+		res = pdevice->CreateUnorderedAccessView(m_pOverlapCounter, &counterUavDesc, &m_pOverlapCounterUAV);
+		if (FAILED(res))
+			return;
+
+		// Read by the binning stage for the clip triangle count
 		counterDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
-		counterDesc.ByteWidth = binCount * 4;
-		res = pdevice->CreateBuffer(&counterDesc, nullptr, &m_pBinTriCounter);
+		counterDesc.ByteWidth = 9 * 4;
+		res = pdevice->CreateBuffer(&counterDesc, nullptr, &m_pSetupCounter);
+		if (FAILED(res))
+			return;
+
+		counterUavDesc.Buffer.NumElements = 9;
+		res = pdevice->CreateUnorderedAccessView(m_pSetupCounter, &counterUavDesc, &m_pSetupCounterUAV);
 		if (FAILED(res))
 			return;
 
@@ -205,21 +309,295 @@ namespace CompuRaster
 		binCounterViewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
 		binCounterViewDesc.BufferEx.FirstElement = 0;
 		binCounterViewDesc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
-		binCounterViewDesc.BufferEx.NumElements = binCount;
-		res = pdevice->CreateShaderResourceView(m_pBinTriCounter, &binCounterViewDesc, &m_pBinTriCounterSRV);
+		binCounterViewDesc.BufferEx.NumElements = 9;
+		res = pdevice->CreateShaderResourceView(m_pSetupCounter, &binCounterViewDesc, &m_pSetupCounterSRV);
+		if (FAILED(res))
+			return;
+
+		// TILE_COUNT of the shaders, the bin tiles past the viewport included
+		const UINT tileCount{ rasterConfig.GetTileCount() };
+		counterDesc.ByteWidth = tileCount * 4;
+		res = pdevice->CreateBuffer(&counterDesc, nullptr, &m_pMicroTileCounter);
+		if (FAILED(res))
+			return;
+
+		counterUavDesc.Buffer.NumElements = tileCount;
+		res = pdevice->CreateUnorderedAccessView(m_pMicroTileCounter, &counterUavDesc, &m_pMicroTileCounterUAV);
+		if (FAILED(res))
+			return;
+
+		binCounterViewDesc.BufferEx.NumElements = tileCount;
+		res = pdevice->CreateShaderResourceView(m_pMicroTileCounter, &binCounterViewDesc, &m_pMicroTileCounterSRV);
+		if (FAILED(res))
+			return;
+
+		const UINT microTileCapacity{ RasterConfig::MICRO_TILE_CAPACITY };
+		counterDesc.ByteWidth = tileCount * microTileCapacity * 4;
+		res = pdevice->CreateBuffer(&counterDesc, nullptr, &m_pMicroTileBuffer);
+		if (FAILED(res))
+			return;
+
+		counterUavDesc.Buffer.NumElements = tileCount * microTileCapacity;
+		res = pdevice->CreateUnorderedAccessView(m_pMicroTileBuffer, &counterUavDesc, &m_pMicroTileUAV);
 		if (FAILED(res))
 			return;
 
-		counterUavDesc.Buffer.NumElements = binCount;
-		res = pdevice->CreateUnorderedAccessView(m_pBinTriCounter, &counterUavDesc, &m_pBinTriCounterUAV);
+		binCounterViewDesc.BufferEx.NumElements = tileCount * microTileCapacity;
+		res = pdevice->CreateShaderResourceView(m_pMicroTileBuffer, &binCounterViewDesc, &m_pMicroTileSRV);
+		if (FAILED(res))
+			return;
+
+		// BIN_OFFSET_COUNT of BinList for the triangles, the blocks and the delta words
+		const UINT binOffsetCount{ 3 * (rasterConfig.GetBinCount() * rasterConfig.queueCount + 1) };
+		counterDesc.ByteWidth = binOffsetCount * 4;
+		res = pdevice->CreateBuffer(&counterDesc, nullptr, &m_pBinOffsetBuffer);
+		if (FAILED(res))
+			return;
+
+		binCounterViewDesc.BufferEx.NumElements = binOffsetCount;
+		res = pdevice->CreateShaderResourceView(m_pBinOffsetBuffer, &binCounterViewDesc, &m_pBinOffsetSRV);
+		if (FAILED(res))
+			return;
+
+		counterUavDesc.Buffer.NumElements = binOffsetCount;
+		res = pdevice->CreateUnorderedAccessView(m_pBinOffsetBuffer, &counterUavDesc, &m_pBinOffsetUAV);
+		if (FAILED(res))
+			return;
+
+		D3D11_BUFFER_DESC readbackDesc{};
+		readbackDesc.Usage = D3D11_USAGE_STAGING;
+		readbackDesc.ByteWidth = sizeof(BinList::Sizes);
+		readbackDesc.BindFlags = 0;
+		readbackDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+		readbackDesc.MiscFlags = 0;
+		readbackDesc.StructureByteStride = 0;
+		for (ID3D11Buffer*& preadback : m_pBinReadback)
+		{
+			res = pdevice->CreateBuffer(&readbackDesc, nullptr, &preadback);
+			if (FAILED(res))
+				return;
+		}
+
+		readbackDesc.ByteWidth = sizeof(Stats);
+		for (ID3D11Buffer*& preadback : m_pStatsReadback)
+		{
+			res = pdevice->CreateBuffer(&readbackDesc, nullptr, &preadback);
+			if (FAILED(res))
+				return;
+		}
+
+		if (shadingMode != EShadingMode::VisibilityBuffer)
+			return;
+
+		D3D11_TEXTURE2D_DESC visibilityDesc{};
+		visibilityDesc.Width = rasterConfig.viewportWidth;
+		visibilityDesc.Height = rasterConfig.viewportHeight;
+		visibilityDesc.MipLevels = 1;
+		visibilityDesc.ArraySize = 1;
+		visibilityDesc.Format = DXGI_FORMAT_R32_UINT;
+		visibilityDesc.SampleDesc.Count = 1;
+		visibilityDesc.SampleDesc.Quality = 0;
+		visibilityDesc.Usage = D3D11_USAGE_DEFAULT;
+		visibilityDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+		visibilityDesc.CPUAccessFlags = 0;
+		visibilityDesc.MiscFlags = 0;
+		res = pdevice->CreateTexture2D(&visibilityDesc, nullptr, &m_pVisibilityBuffer);
+		if (FAILED(res))
+			return;
+
+		D3D11_UNORDERED_ACCESS_VIEW_DESC visibilityUavDesc{};
+		visibilityUavDesc.Format = DXGI_FORMAT_R32_UINT;
+		visibilityUavDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
+		visibilityUavDesc.Texture2D.MipSlice = 0;
+		res = pdevice->CreateUnorderedAccessView(m_pVisibilityBuffer, &visibilityUavDesc, &m_pVisibilityUAV);
 		if (FAILED(res))
 			return;
 	}
 
+	bool Pipeline::CreateBinBuffers(ID3D11Device* pdevice, const BinList::Sizes& capacity)
+	{
+		ID3D11Buffer* pbinBuffer{ nullptr };
+		ID3D11ShaderResourceView* pbinSRV{ nullptr };
+		ID3D11UnorderedAccessView* pbinUAV{ nullptr };
+		ID3D11Buffer* pheaderBuffer{ nullptr };
+		ID3D11ShaderResourceView* pheaderSRV{ nullptr };
+		ID3D11UnorderedAccessView* pheaderUAV{ nullptr };
+		ID3D11Buffer* ptileBuffer{ nullptr };
+		ID3D11ShaderResourceView* ptileSRV{ nullptr };
+		ID3D11UnorderedAccessView* ptileUAV{ nullptr };
+		const auto release{ [&]()
+			{
+				Helpers::SafeRelease(pbinBuffer);
+				Helpers::SafeRelease(pbinSRV);
+				Helpers::SafeRelease(pbinUAV);
+				Helpers::SafeRelease(pheaderBuffer);
+				Helpers::SafeRelease(pheaderSRV);
+				Helpers::SafeRelease(pheaderUAV);
+				Helpers::SafeRelease(ptileBuffer);
+				Helpers::SafeRelease(ptileSRV);
+				Helpers::SafeRelease(ptileUAV);
+			} };
+
+		// Raw buffers of wordCount 32 bit words, the varint deltas and the block headers
+		const auto createRawBuffer{ [pdevice](UINT wordCount, ID3D11Buffer*& pbuffer, ID3D11ShaderResourceView*& psrv, ID3D11UnorderedAccessView*& puav)
+			{
+				D3D11_BUFFER_DESC rawBufferDesc{};
+				rawBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+				rawBufferDesc.ByteWidth = wordCount * 4;
+				rawBufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+				rawBufferDesc.CPUAccessFlags = 0;
+				rawBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+				rawBufferDesc.StructureByteStride = 0;
+
+				D3D11_SHADER_RESOURCE_VIEW_DESC rawViewDesc{};
+				rawViewDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+				rawViewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
+				rawViewDesc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
+				rawViewDesc.BufferEx.FirstElement = 0;
+				rawViewDesc.BufferEx.NumElements = wordCount;
+
+				D3D11_UNORDERED_ACCESS_VIEW_DESC rawUavDesc{};
+				rawUavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+				rawUavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+				rawUavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+				rawUavDesc.Buffer.FirstElement = 0;
+				rawUavDesc.Buffer.NumElements = wordCount;
+
+				return SUCCEEDED(pdevice->CreateBuffer(&rawBufferDesc, nullptr, &pbuffer))
+					&& SUCCEEDED(pdevice->CreateShaderResourceView(pbuffer, &rawViewDesc, &psrv))
+					&& SUCCEEDED(pdevice->CreateUnorderedAccessView(pbuffer, &rawUavDesc, &puav));
+			} };
+
+		// BinData of TileRasterizer, the coverage and full coverage masks of the tiles of the bin (64 bits each) and the triangle index
+		const UINT tileStride = 4 * (2 + 2 + 1);
+		D3D11_BUFFER_DESC tileBufferDesc{ };
+		tileBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+		tileBufferDesc.ByteWidth = capacity.triangleCount * tileStride;
+		tileBufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+		tileBufferDesc.CPUAccessFlags = 0;
+		tileBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		tileBufferDesc.StructureByteStride = tileStride;
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC tileViewDesc{ };
+		tileViewDesc.Format = DXGI_FORMAT_UNKNOWN;
+		tileViewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		tileViewDesc.Buffer.FirstElement = 0;
+		tileViewDesc.Buffer.NumElements = capacity.triangleCount;
+
+		D3D11_UNORDERED_ACCESS_VIEW_DESC tileUavDesc{ };
+		tileUavDesc.Format = DXGI_FORMAT_UNKNOWN;
+		tileUavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+		tileUavDesc.Buffer.Flags = 0;
+		tileUavDesc.Buffer.FirstElement = 0;
+		tileUavDesc.Buffer.NumElements = capacity.triangleCount;
+
+		const UINT headerWordCount{ sizeof(BinList::BlockHeader) / 4 };
+		if (capacity.triangleCount == 0 || capacity.triangleCount > (std::min)(UINT_MAX / tileStride, BinList::MAX_ENTRY_COUNT)
+			|| capacity.blockCount == 0 || capacity.blockCount > UINT_MAX / sizeof(BinList::BlockHeader)
+			|| capacity.wordCount == 0 || capacity.wordCount > UINT_MAX / 4
+			|| !createRawBuffer(capacity.wordCount, pbinBuffer, pbinSRV, pbinUAV)
+			|| !createRawBuffer(capacity.blockCount * headerWordCount, pheaderBuffer, pheaderSRV, pheaderUAV)
+			|| FAILED(pdevice->CreateBuffer(&tileBufferDesc, nullptr, &ptileBuffer))
+			|| FAILED(pdevice->CreateShaderResourceView(ptileBuffer, &tileViewDesc, &ptileSRV))
+			|| FAILED(pdevice->CreateUnorderedAccessView(ptileBuffer, &tileUavDesc, &ptileUAV)))
+		{
+			release();
+			APP_LOG_ERROR(L"Failed to create bin buffers of " + std::to_wstring(capacity.triangleCount) + L" bin triangle pairs, " + std::to_wstring(capacity.blockCount)
+				+ L" blocks and " + std::to_wstring(capacity.wordCount) + L" words of deltas !");
+			return false;
+		}
+
+		std::swap(pbinBuffer, m_pBinBuffer);
+		std::swap(pbinSRV, m_pBinSRV);
+		std::swap(pbinUAV, m_pBinUAV);
+		std::swap(pheaderBuffer, m_pBinHeaderBuffer);
+		std::swap(pheaderSRV, m_pBinHeaderSRV);
+		std::swap(pheaderUAV, m_pBinHeaderUAV);
+		std::swap(ptileBuffer, m_pTileBuffer);
+		std::swap(ptileSRV, m_pTileSRV);
+		std::swap(ptileUAV, m_pTileUAV);
+		m_BinCapacity = capacity;
+		release();
+		return true;
+	}
+
+	void Pipeline::UpdateBinCapacity(ID3D11Device* pdevice, ID3D11DeviceContext* pdeviceContext)
+	{
+		// The totals past the triangle, block and delta word arrays of BinScan, gathered as a BinList::Sizes
+		const UINT offsetCount{ m_RasterConfig.GetBinCount() * m_RasterConfig.queueCount + 1 };
+		ID3D11Buffer* pcopy{ m_pBinReadback[m_BinReadbackFrame % BIN_READBACK_LATENCY] };
+		for (UINT arrayIdx{}; arrayIdx < 3; ++arrayIdx)
+		{
+			const UINT totalOffset{ (arrayIdx * offsetCount + offsetCount - 1) * 4 };
+			const D3D11_BOX totalBox{ totalOffset, 0, 0, totalOffset + 4, 1, 1 };
+			pdeviceContext->CopySubresourceRegion(pcopy, 0, arrayIdx * 4, 0, 0, m_pBinOffsetBuffer, 0, &totalBox);
+		}
+		++m_BinReadbackFrame;
+		if (m_BinReadbackFrame < BIN_READBACK_LATENCY)
+			return;
+
+		// The oldest copy, BIN_READBACK_LATENCY - 1 frames ago, skipped when the GPU is further behind
+		ID3D11Buffer* preadback{ m_pBinReadback[m_BinReadbackFrame % BIN_READBACK_LATENCY] };
+		D3D11_MAPPED_SUBRESOURCE mappedSizes{};
+		if (FAILED(pdeviceContext->Map(preadback, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mappedSizes)))
+			return;
+
+		m_BinSizes = *static_cast<const BinList::Sizes*>(mappedSizes.pData);
+		pdeviceContext->Unmap(preadback, 0);
+		if (m_BinSizes.triangleCount <= m_BinCapacity.triangleCount && m_BinSizes.blockCount <= m_BinCapacity.blockCount && m_BinSizes.wordCount <= m_BinCapacity.wordCount)
+			return;
+
+		// Some headroom so a slowly growing size does not reallocate every few frames
+		const auto grow{ [](UINT size, UINT currentCapacity) { return size <= currentCapacity ? currentCapacity : size + size / 2; } };
+		const BinList::Sizes capacity{ grow(m_BinSizes.triangleCount, m_BinCapacity.triangleCount), grow(m_BinSizes.blockCount, m_BinCapacity.blockCount),
+			grow(m_BinSizes.wordCount, m_BinCapacity.wordCount) };
+		APP_LOG_WARNING(L"Bins overflowed with " + std::to_wstring(m_BinSizes.triangleCount) + L" bin triangle pairs in " + std::to_wstring(m_BinSizes.blockCount)
+			+ L" blocks and " + std::to_wstring(m_BinSizes.wordCount) + L" words of deltas, growing them");
+		CreateBinBuffers(pdevice, capacity);
+	}
+
+	void Pipeline::UpdateStats(ID3D11DeviceContext* pdeviceContext)
+	{
+		ID3D11Buffer* pcopy{ m_pStatsReadback[m_StatsReadbackFrame % BIN_READBACK_LATENCY] };
+		// count uints of pcounter from counterOffset to the Stats member at statsOffset
+		const auto copyCounters{ [pdeviceContext, pcopy](size_t statsOffset, ID3D11Buffer* pcounter, UINT counterOffset, UINT count)
+			{
+				const D3D11_BOX counterBox{ counterOffset * 4, 0, 0, (counterOffset + count) * 4, 1, 1 };
+				pdeviceContext->CopySubresourceRegion(pcopy, 0, static_cast<UINT>(statsOffset), 0, 0, pcounter, 0, &counterBox);
+			} };
+		copyCounters(offsetof(Stats, culledTriangleCount), m_pSetupCounter, 0, 9);
+		copyCounters(offsetof(Stats, missedBinCount), m_pOverlapCounter, 0, 4);
+		copyCounters(offsetof(Stats, hiZRejectedTileCount), m_pHiZCounter, 0, 2);
+		++m_StatsReadbackFrame;
+		if (m_StatsReadbackFrame < BIN_READBACK_LATENCY)
+			return;
+
+		ID3D11Buffer* preadback{ m_pStatsReadback[m_StatsReadbackFrame % BIN_READBACK_LATENCY] };
+		D3D11_MAPPED_SUBRESOURCE mappedStats{};
+		if (FAILED(pdeviceContext->Map(preadback, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mappedStats)))
+			return;
+
+		m_Stats = *static_cast<const Stats*>(mappedStats.pData);
+		pdeviceContext->Unmap(preadback, 0);
+	}
+
+	std::vector<D3D_SHADER_MACRO> Pipeline::GetShaderDefines(const D3D_SHADER_MACRO* pdefines) const
+	{
+		std::vector<D3D_SHADER_MACRO> defines{};
+		for (const std::pair<std::string, std::string>& define : m_ShaderDefines)
+			defines.push_back({ define.first.c_str(), define.second.c_str() });
+
+		for (; pdefines && pdefines->Name; ++pdefines)
+			defines.push_back(*pdefines);
+
+		defines.push_back({ nullptr, nullptr });
+		return defines;
+	}
+
 	void Pipeline::Dispatch(ID3D11DeviceContext* pdeviceContext, CompuMesh* pmesh, Camera* pcamera) const
 	{
 		const UINT vCount = pmesh->GetVertexCount();
-		const UINT triCount = pmesh->GetTriangleCount();
+		const UINT triCount = pmesh->GetLodVisibleTriangleCount();
 
 		pmesh->SetupDrawInfo(pcamera, pdeviceContext);
 		ID3D11UnorderedAccessView* outUAV{ pmesh->GetVertexOutBufferUAV() };
@@ -228,52 +606,129 @@ namespace CompuRaster
 		ID3D11UnorderedAccessView* nullUav[] = { nullptr };
 		pdeviceContext->CSSetUnorderedAccessViews(2, 1, nullUav, nullptr);
 
+		//CLUSTER CULLING SHADER
+		const UINT clearValue[4]{};
+		pdeviceContext->ClearUnorderedAccessViewUint(pmesh->GetVisibleTriangleCountUAV(), clearValue);
+		pdeviceContext->ClearUnorderedAccessViewUint(m_pHiZCounterUAV, clearValue);
+		pdeviceContext->ClearUnorderedAccessViewUint(m_pOverlapCounterUAV, clearValue);
+		pdeviceContext->ClearUnorderedAccessViewUint(m_pSetupCounterUAV, clearValue);
+		pdeviceContext->ClearUnorderedAccessViewUint(m_pMicroTileCounterUAV, clearValue);
+		if (m_pVisibilityUAV)
+		{
+			const UINT emptyValue[4]{ VisibilityBuffer::EMPTY, VisibilityBuffer::EMPTY, VisibilityBuffer::EMPTY, VisibilityBuffer::EMPTY };
+			pdeviceContext->ClearUnorderedAccessViewUint(m_pVisibilityUAV, emptyValue);
+		}
+
+		D3D11_MAPPED_SUBRESOURCE mappedCullInfo{};
+		if (SUCCEEDED(pdeviceContext->Map(m_pClusterCullInfoBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedCullInfo)))
+		{
+			*static_cast<HelperStruct::ClusterCullInfo*>(mappedCullInfo.pData) = pmesh->GetClusterCullInfo(pcamera);
+			pdeviceContext->Unmap(m_pClusterCullInfoBuffer, 0);
+		}
+
+		pdeviceContext->CSSetShader(m_pClusterCullingShader->GetShader(), nullptr, 0);
+		pdeviceContext->CSSetConstantBuffers(1, 1, &m_pClusterCullInfoBuffer);
+
+		ID3D11ShaderResourceView* cullSrvs[]{ pmesh->GetMeshletBufferView(), pmesh->GetIndexBufferView() };
+		pdeviceContext->CSSetShaderResources(0, 2, cullSrvs);
+		ID3D11UnorderedAccessView* cullUavs[]{ pmesh->GetVisibleIndexBufferUAV(), pmesh->GetVisibleTriangleCountUAV() };
+		pdeviceContext->CSSetUnorderedAccessViews(2, 2, cullUavs, nullptr);
+
+		// One group per meshlet, wrapped into y past the dispatch size limit (MAX_DISPATCH_X in the shader)
+		const UINT meshletCount{ pmesh->GetMeshletCount() };
+		const UINT maxDispatchX{ D3D11_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION };
+		pdeviceContext->Dispatch((std::min)(meshletCount, maxDispatchX), (meshletCount + maxDispatchX - 1) / maxDispatchX, 1);
+
+		ID3D11UnorderedAccessView* nullUavs2[]{ nullptr, nullptr };
+		pdeviceContext->CSSetUnorderedAccessViews(2, 2, nullUavs2, nullptr);
+		ID3D11ShaderResourceView* nullSrvs2[]{ nullptr, nullptr };
+		pdeviceContext->CSSetShaderResources(0, 2, nullSrvs2);
+
 		//GEOMETRY SETUP SHADER
 		pdeviceContext->CSSetShader(m_pGeometrySetupShader->GetShader(), nullptr, 0);
-		pdeviceContext->CSSetUnorderedAccessViews(2, 1, &m_pRasterDataUAV, nullptr);
-
-		ID3D11ShaderResourceView* geoSrvs[]{ pmesh->GetVertexOutBufferView(), pmesh->GetIndexBufferView() };
-		pdeviceContext->CSSetShaderResources(0, 2, geoSrvs);
+		ID3D11UnorderedAccessView* geoUavs[]{ m_pRasterDataUAV, m_pSetupCounterUAV, m_pClipVertexUAV };
+		pdeviceContext->CSSetUnorderedAccessViews(2, 3, geoUavs, nullptr);
+		// After the G_HIZ_BUFFER CompuRenderer keeps in u5
+		ID3D11UnorderedAccessView* microUavs[]{ m_pMicroTileCounterUAV, m_pMicroTileUAV };
+		pdeviceContext->CSSetUnorderedAccessViews(6, 2, microUavs, nullptr);
+
+		// Dispatched for every triangle, the ones past the visible count only flag their slot as clipped
+		ID3D11ShaderResourceView* geoSrvs[]{ pmesh->GetVertexOutBufferView(), pmesh->GetVisibleIndexBufferView(), pmesh->GetVisibleTriangleCountView() };
+		pdeviceContext->CSSetShaderResources(0, 3, geoSrvs);
 		pdeviceContext->Dispatch(static_cast<UINT>(ceil(triCount / 512.f)), 1, 1);
 
-		pdeviceContext->CSSetUnorderedAccessViews(2, 1, nullUav, nullptr);
-		ID3D11ShaderResourceView* nullSrvs2[]{ nullptr, nullptr };
-		pdeviceContext->CSSetShaderResources(0, 2, nullSrvs2);
+		ID3D11UnorderedAccessView* nullUavs3[]{ nullptr, nullptr, nullptr };
+		pdeviceContext->CSSetUnorderedAccessViews(2, 3, nullUavs3, nullptr);
+		pdeviceContext->CSSetUnorderedAccessViews(6, 2, nullUavs2, nullptr);
+		ID3D11ShaderResourceView* nullSrvs3[]{ nullptr, nullptr, nullptr };
+		pdeviceContext->CSSetShaderResources(0, 3, nullSrvs3);
 
 		//BIN SHADER
+		// Counts the triangles of every bin and queue, the scan turns them into offsets, then the same pass stores the triangles at them
+		pdeviceContext->CSSetShader(m_pBinCountShader->GetShader(), nullptr, 0);
+		ID3D11UnorderedAccessView* binCountUavs[]{ m_pBinOffsetUAV, m_pOverlapCounterUAV };
+		pdeviceContext->CSSetUnorderedAccessViews(2, 2, binCountUavs, nullptr);
+		ID3D11ShaderResourceView* binSrvs[]{ m_pRasterDataSRV, m_pSetupCounterSRV, m_pBinOffsetSRV };
+		pdeviceContext->CSSetShaderResources(0, 2, binSrvs);
+		pdeviceContext->Dispatch(m_RasterConfig.queueCount, 1, 1);
+
+		pdeviceContext->CSSetShader(m_pBinScanShader->GetShader(), nullptr, 0);
+		pdeviceContext->Dispatch(1, 1, 1);
+		pdeviceContext->CSSetUnorderedAccessViews(2, 2, nullUavs3, nullptr);
+
 		pdeviceContext->CSSetShader(m_pBinningShader->GetShader(), nullptr, 0);
-		pdeviceContext->CSSetUnorderedAccessViews(2, 1, &m_pBinUAV, nullptr);
-		pdeviceContext->CSSetShaderResources(0, 1, &m_pRasterDataSRV);
-		pdeviceContext->Dispatch(16, 1, 1);
+		ID3D11UnorderedAccessView* binUavs[]{ m_pBinUAV, m_pBinHeaderUAV };
+		pdeviceContext->CSSetUnorderedAccessViews(2, 2, binUavs, nullptr);
+		pdeviceContext->CSSetShaderResources(0, 3, binSrvs);
+		pdeviceContext->Dispatch(m_RasterConfig.queueCount, 1, 1);
 
-		pdeviceContext->CSSetUnorderedAccessViews(2, 1, nullUav, nullptr);
-		ID3D11ShaderResourceView* nullSrvs[]{ nullptr };
-		pdeviceContext->CSSetShaderResources(0, 1, nullSrvs);
+		pdeviceContext->CSSetUnorderedAccessViews(2, 2, nullUavs3, nullptr);
+		pdeviceContext->CSSetShaderResources(0, 3, nullSrvs3);
 
 		//TILE SHADER
 		pdeviceContext->CSSetShader(m_pCoarseShader->GetShader(), nullptr, 0);
 
-		ID3D11UnorderedAccessView* tileUavs[]{ m_pBinCounterUAV, m_pBinTriCounterUAV, m_pTileUAV };
+		ID3D11UnorderedAccessView* tileUavs[]{ m_pBinCounterUAV, m_pOverlapCounterUAV, m_pTileUAV };
 		pdeviceContext->CSSetUnorderedAccessViews(2, 3, tileUavs, nullptr);
+		// Bound for the tile and fine stages, after the G_HIZ_BUFFER CompuRenderer keeps in u5
+		pdeviceContext->CSSetUnorderedAccessViews(6, 1, &m_pHiZCounterUAV, nullptr);
 
-		ID3D11ShaderResourceView* tileSrvs[]{ m_pBinSRV, m_pRasterDataSRV };
-		pdeviceContext->CSSetShaderResources(0, 2, tileSrvs);
-		pdeviceContext->Dispatch(20, 12, 1);
+		ID3D11ShaderResourceView* tileSrvs[]{ m_pBinSRV, m_pRasterDataSRV, m_pBinOffsetSRV, m_pBinHeaderSRV };
+		pdeviceContext->CSSetShaderResources(0, 4, tileSrvs);
+		pdeviceContext->Dispatch(m_RasterConfig.GetBinningDimsX(), m_RasterConfig.GetBinningDimsY(), 1);
 
-		ID3D11UnorderedAccessView* nullUavs3[]{ nullptr, nullptr, nullptr };
 		pdeviceContext->CSSetUnorderedAccessViews(2, 3, nullUavs3, nullptr);
-		pdeviceContext->CSSetShaderResources(0, 2, nullSrvs2);
+		ID3D11ShaderResourceView* nullSrvs4[]{ nullptr, nullptr, nullptr, nullptr };
+		pdeviceContext->CSSetShaderResources(0, 4, nullSrvs4);
 
 		//FINE SHADER
 		pdeviceContext->CSSetShader(m_pFineShader->GetShader(), nullptr, 0);
 
-		ID3D11ShaderResourceView* fineSrvs[]{ m_pRasterDataSRV, m_pTileSRV, m_pBinTriCounterSRV, pmesh->GetVertexOutBufferView(), pmesh->GetIndexBufferView() };
-		pdeviceContext->CSSetShaderResources(0, 5, fineSrvs);
-		pdeviceContext->CSSetUnorderedAccessViews(2, 1, &m_pTileCounterUAV, nullptr);
+		ID3D11ShaderResourceView* fineSrvs[]{ m_pRasterDataSRV, m_pTileSRV, m_pBinOffsetSRV, pmesh->GetVertexOutBufferView(), pmesh->GetVisibleIndexBufferView(), m_pClipVertexSRV,
+			m_pMicroTileCounterSRV, m_pMicroTileSRV };
+		pdeviceContext->CSSetShaderResources(0, 8, fineSrvs);
+		ID3D11UnorderedAccessView* fineUavs[]{ m_pTileCounterUAV, m_pVisibilityUAV, m_pOverlapCounterUAV };
+		pdeviceContext->CSSetUnorderedAccessViews(2, 3, fineUavs, nullptr);
 		pdeviceContext->Dispatch(256, 1, 1);
 		pdeviceContext->CSSetUnorderedAccessViews(2, 1, nullUav, nullptr);
-		ID3D11ShaderResourceView* nullSrvs5[]{ nullptr, nullptr, nullptr, nullptr, nullptr };
-		pdeviceContext->CSSetShaderResources(0, 5, nullSrvs5);
+		pdeviceContext->CSSetUnorderedAccessViews(4, 1, nullUav, nullptr);
+		pdeviceContext->CSSetUnorderedAccessViews(6, 1, nullUav, nullptr);
+		ID3D11ShaderResourceView* nullSrvs8[]{ nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+		pdeviceContext->CSSetShaderResources(0, 8, nullSrvs8);
+
+		//VISIBILITY SHADING SHADER
+		if (m_pShadingShader)
+		{
+			pdeviceContext->CSSetShader(m_pShadingShader->GetShader(), nullptr, 0);
+
+			// The visibility buffer stays bound in u3
+			ID3D11ShaderResourceView* shadingSrvs[]{ m_pRasterDataSRV, pmesh->GetVertexOutBufferView(), pmesh->GetVisibleIndexBufferView(), m_pClipVertexSRV };
+			pdeviceContext->CSSetShaderResources(0, 4, shadingSrvs);
+			// One group per tile of the viewport
+			pdeviceContext->Dispatch(m_RasterConfig.GetHiZDimsX(), m_RasterConfig.GetHiZDimsY(), 1);
+			pdeviceContext->CSSetShaderResources(0, 4, nullSrvs8);
+		}
+		pdeviceContext->CSSetUnorderedAccessViews(3, 1, nullUav, nullptr);
 
 		pdeviceContext->ClearUnorderedAccessViewUint(m_pTileCounterUAV, reinterpret_cast<const UINT*>(&DirectX::Colors::Black));
 		pdeviceContext->ClearUnorderedAccessViewUint(m_pBinCounterUAV, reinterpret_cast<const UINT*>(&DirectX::Colors::Black));
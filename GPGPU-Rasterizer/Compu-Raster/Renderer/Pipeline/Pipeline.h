@@ -1,4 +1,11 @@
 #pragma once
+#include "Common/BinList.h"
+#include "Common/Clipping.h"
+#include "Common/FixedPointEdges.h"
+#include "Common/IndexPacker.h"
+#include "Common/RasterConfig.h"
+#include "Common/TriangleCulling.h"
+#include "Common/VisibilityBuffer.h"
 #include "Render/Shader/Shader.h"
 
 class Camera;
@@ -12,9 +19,42 @@ namespace CompuRaster
 
 	class CompuMesh;
 
+	// How the fine stage gets the coverage of a triangle tile the tile stage did not accept, the ECoverageMode of the CPU pipeline
+	enum class ECoverageMode
+	{
+		Pixel, // every pixel of the tile tests the edges
+		Quad // QUAD_COVERAGE, 2x2 pixel quads trivially rejected and accepted from their corners first, only the pixels of the other ones test the edges
+	};
+
 	class Pipeline
 	{
 	public:
+		// Counters of a Dispatch, zero until UpdateStats read back the first one
+		struct Stats
+		{
+			// Triangles geometry setup dropped by the cull mode, then degenerate ones
+			UINT culledTriangleCount;
+			UINT degenerateTriangleCount;
+			// Triangles rejected by their outcodes, clipped, then the clip triangles they were fanned into, the ones past Clipping::MAX_CLIP_TRIANGLES dropped
+			UINT rejectedTriangleCount;
+			UINT clippedTriangleCount;
+			UINT clipTriangleCount;
+			// Micro triangles routed past binning, the ones of them inside a pixel quad, binned triangles and the ones of them past a full micro list
+			UINT microTriangleCount;
+			UINT quadTriangleCount;
+			UINT regularTriangleCount;
+			UINT overflowTriangleCount;
+			// Bins then tiles the aabb of a triangle overlaps and the corner tests of its edges miss
+			UINT missedBinCount;
+			UINT missedTileCount;
+			// 2x2 quads of the partially covered triangle tiles the fine stage rejected and accepted, 0 unless it runs ECoverageMode::Quad
+			UINT rejectedQuadCount;
+			UINT acceptedQuadCount;
+			// Triangle tiles rejected by the Hi-Z in the tile stage, then triangles rejected in the fine stage
+			UINT hiZRejectedTileCount;
+			UINT hiZRejectedTriangleCount;
+		};
+
 		explicit Pipeline();
 		~Pipeline();
 
@@ -23,28 +63,99 @@ namespace CompuRaster
 		Pipeline& operator=(const Pipeline&) = delete;
 		Pipeline& operator=(Pipeline&&) noexcept = delete;
 
-		void Init(ID3D11Device* pdevice, UINT vCount, UINT triangleCount, const wchar_t* geometrySetupPath, const wchar_t* binningPath, const wchar_t* tilePath, const wchar_t* finePath);
+		/**
+		 * \brief : Compiles the stages for rasterConfig and sizes the buffers from it, calling it again releases and reallocates everything
+		 * \param rasterConfig : Must match the render target, depth buffer and Hi-Z of the CompuRenderer, nothing is created when it is invalid
+		 * \param cullMode : Faces geometry setup drops, cluster culling only drops back facing meshlets with ECullMode::Back
+		 * \param coverageMode : Whether the fine stage classifies the quads of the tiles it tests, compiled with QUAD_COVERAGE
+		 * \param binningPath : Dispatched twice, counting the triangles of every bin and their coded size then coding them at the offsets binScanPath computed
+		 * \param shadingPath : Full screen pass of EShadingMode::VisibilityBuffer, not loaded in forward
+		 */
+		void Init(ID3D11Device* pdevice, UINT vCount, UINT triangleCount, EIndexFormat indexFormat, const RasterConfig& rasterConfig, ERasterMode rasterMode, EShadingMode shadingMode, ECullMode cullMode, ECoverageMode coverageMode, const wchar_t* clusterCullingPath, const wchar_t* geometrySetupPath, const wchar_t* binningPath, const wchar_t* binScanPath, const wchar_t* tilePath, const wchar_t* finePath, const wchar_t* shadingPath);
+
+		/**
+		 * \brief : RasterConfig macros of the last Init followed by the ones of pdefines, null terminated.\n
+		 * The material vertex stage must be compiled with them, they point into the pipeline until its next Init
+		 */
+		std::vector<D3D_SHADER_MACRO> GetShaderDefines(const D3D_SHADER_MACRO* pdefines = nullptr) const;
+
+		const RasterConfig& GetRasterConfig() const { return m_RasterConfig; }
 
 		void Dispatch(ID3D11DeviceContext* pdeviceContext, CompuMesh* pmesh, Camera* pcamera) const;
 
+		/**
+		 * \brief : Call after every Dispatch, queues a copy of the bin list sizes it counted and reads back the one of BIN_READBACK_LATENCY frames ago.\n
+		 * The bin and tile buffers grow when those sizes did not fit, the frames in between drew the overflowing bins empty
+		 */
+		void UpdateBinCapacity(ID3D11Device* pdevice, ID3D11DeviceContext* pdeviceContext);
+
+		const BinList::Sizes& GetBinCapacity() const { return m_BinCapacity; }
+		// Sizes of the last bin lists read back, BIN_READBACK_LATENCY frames late, with their encoded and raw bytes
+		const BinList::Sizes& GetBinSizes() const { return m_BinSizes; }
+
+		/**
+		 * \brief : Call after every Dispatch, queues a copy of its counters and reads back the one of BIN_READBACK_LATENCY frames ago, skipped when the GPU is further behind
+		 */
+		void UpdateStats(ID3D11DeviceContext* pdeviceContext);
+
+		const Stats& GetStats() const { return m_Stats; }
+
 	private:
+		// Frames between the copy of the pair count and its map, so reading it back never stalls
+		static constexpr UINT BIN_READBACK_LATENCY{ 3 };
+		// Bin triangle pairs reserved per raster triangle before the first read back count, most triangles overlap one or two bins
+		static constexpr UINT INITIAL_BIN_PAIRS_PER_TRIANGLE{ 2 };
+		// Pairs per block and per word of deltas reserved with them, the end of a queue cuts blocks short and most deltas take one or two bytes
+		static constexpr UINT INITIAL_BIN_PAIRS_PER_BLOCK{ 4 };
+		static constexpr UINT INITIAL_BIN_PAIRS_PER_WORD{ 2 };
+
+		RasterConfig m_RasterConfig;
+		std::vector<std::pair<std::string, std::string>> m_ShaderDefines;
+
+		void Release();
+		/**
+		 * \brief : Replaces the bin, bin header and tile buffers by ones holding capacity, the current ones are kept when it fails
+		 */
+		bool CreateBinBuffers(ID3D11Device* pdevice, const BinList::Sizes& capacity);
+
+		ComputeShader* m_pClusterCullingShader;
 		ComputeShader* m_pGeometrySetupShader;
+		ComputeShader* m_pBinCountShader;
+		ComputeShader* m_pBinScanShader;
 		ComputeShader* m_pBinningShader;
 		ComputeShader* m_pCoarseShader;
 		ComputeShader* m_pFineShader;
+		ComputeShader* m_pShadingShader;
+
+		ID3D11Buffer* m_pClusterCullInfoBuffer = nullptr;
 
 		ID3D11Buffer* m_pVOutoutBuffer = nullptr;
 		ID3D11ShaderResourceView* m_pVOutoutSRV = nullptr;
 		ID3D11UnorderedAccessView* m_pVOutoutUAV = nullptr;
 
+		// Mesh triangles then Clipping::MAX_CLIP_TRIANGLES slots for the triangles of the clipper
 		ID3D11Buffer* m_pRasterDataBuffer = nullptr;
 		ID3D11ShaderResourceView* m_pRasterDataSRV = nullptr;
 		ID3D11UnorderedAccessView* m_pRasterDataUAV = nullptr;
 
+		// Per bin then per queue, the triangles, blocks and delta words of the count pass then the exclusive offsets of the scan, their totals past them
+		ID3D11Buffer* m_pBinOffsetBuffer = nullptr;
+		ID3D11ShaderResourceView* m_pBinOffsetSRV = nullptr;
+		ID3D11UnorderedAccessView* m_pBinOffsetUAV = nullptr;
+
+		// Per bin, the varint deltas of the triangles of its queues back to back, m_BinCapacity.wordCount words of them
+		BinList::Sizes m_BinCapacity{};
+		BinList::Sizes m_BinSizes{};
 		ID3D11Buffer* m_pBinBuffer = nullptr;
 		ID3D11ShaderResourceView* m_pBinSRV = nullptr;
 		ID3D11UnorderedAccessView* m_pBinUAV = nullptr;
 
+		// BinList::BlockHeader of every block of m_pBinBuffer
+		ID3D11Buffer* m_pBinHeaderBuffer = nullptr;
+		ID3D11ShaderResourceView* m_pBinHeaderSRV = nullptr;
+		ID3D11UnorderedAccessView* m_pBinHeaderUAV = nullptr;
+
+		// The BinData of every bin triangle pair, the queues of a bin back to back
 		ID3D11Buffer* m_pTileBuffer = nullptr;
 		ID3D11ShaderResourceView* m_pTileSRV = nullptr;
 		ID3D11UnorderedAccessView* m_pTileUAV = nullptr;
@@ -52,12 +163,50 @@ namespace CompuRaster
 		ID3D11Buffer* m_pBinCounter = nullptr;
 		ID3D11UnorderedAccessView* m_pBinCounterUAV = nullptr;
 
-		ID3D11Buffer* m_pBinTriCounter = nullptr;
-		ID3D11ShaderResourceView* m_pBinTriCounterSRV = nullptr;
-		ID3D11UnorderedAccessView* m_pBinTriCounterUAV = nullptr;
-
 		ID3D11Buffer* m_pTileCounter = nullptr;
 		ID3D11UnorderedAccessView* m_pTileCounterUAV = nullptr;
+
+		// Geometry setup counters: triangles dropped by the cull mode, degenerate, rejected by their outcodes, clipped, the clip triangles emitted,
+		// then micro triangles, the ones of them inside a pixel quad, binned triangles and the ones of them past a full micro list
+		ID3D11Buffer* m_pSetupCounter = nullptr;
+		ID3D11ShaderResourceView* m_pSetupCounterSRV = nullptr;
+		ID3D11UnorderedAccessView* m_pSetupCounterUAV = nullptr;
+
+		// The 3 vertices of every clip triangle, in screen space
+		ID3D11Buffer* m_pClipVertexBuffer = nullptr;
+		ID3D11ShaderResourceView* m_pClipVertexSRV = nullptr;
+		ID3D11UnorderedAccessView* m_pClipVertexUAV = nullptr;
+
+		// Per tile, the micro triangles geometry setup appended for the point sampled path of the fine stage, then MICRO_TILE_CAPACITY indices per tile
+		ID3D11Buffer* m_pMicroTileCounter = nullptr;
+		ID3D11ShaderResourceView* m_pMicroTileCounterSRV = nullptr;
+		ID3D11UnorderedAccessView* m_pMicroTileCounterUAV = nullptr;
+
+		ID3D11Buffer* m_pMicroTileBuffer = nullptr;
+		ID3D11ShaderResourceView* m_pMicroTileSRV = nullptr;
+		ID3D11UnorderedAccessView* m_pMicroTileUAV = nullptr;
+
+		// Triangle tiles rejected by the Hi-Z in the tile stage, then triangles rejected in the fine stage
+		ID3D11Buffer* m_pHiZCounter = nullptr;
+		ID3D11UnorderedAccessView* m_pHiZCounterUAV = nullptr;
+
+		// Bins then tiles the aabb of a triangle overlaps and the corner tests of its edges miss, the false positives of an aabb only assignment,
+		// then the 2x2 quads of the partially covered triangle tiles the fine stage rejected and accepted, 0 unless it runs ECoverageMode::Quad
+		ID3D11Buffer* m_pOverlapCounter = nullptr;
+		ID3D11UnorderedAccessView* m_pOverlapCounterUAV = nullptr;
+
+		// VisibilityBuffer id per pixel, cleared at every Dispatch so the shading pass only touches the pixels it drew
+		ID3D11Texture2D* m_pVisibilityBuffer = nullptr;
+		ID3D11UnorderedAccessView* m_pVisibilityUAV = nullptr;
+
+		// BinList::Sizes copied by UpdateBinCapacity, one per frame in flight
+		ID3D11Buffer* m_pBinReadback[BIN_READBACK_LATENCY]{};
+		UINT m_BinReadbackFrame = 0;
+
+		// Stats copied by UpdateStats, one per frame in flight
+		Stats m_Stats{};
+		ID3D11Buffer* m_pStatsReadback[BIN_READBACK_LATENCY]{};
+		UINT m_StatsReadbackFrame = 0;
 	};
 }
 
@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "Material.h"
 
+#include "Common/MeshData.h"
+
 Material::Material(ID3D11Device* pdevice, const wchar_t* vsPath, const wchar_t* hsPath, const wchar_t* dsPath, const wchar_t* gsPath, const wchar_t* psPath)
 	: m_ShaderCBBinding{}
 	, m_ShaderCBs{}
@@ -92,22 +94,33 @@ void Material::GenerateInputLayout(ID3D11Device* pdevice)
 	D3D11_SHADER_DESC shaderDesc;
 	pReflector->GetDesc(&shaderDesc);
 
-	UINT byteOffset = 0;
 	for (UINT idx{}; idx < shaderDesc.InputParameters; ++idx)
 	{
 		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
 		pReflector->GetInputParameterDesc(idx, &paramDesc);
 
+		// System values (SV_VertexID, ...) are generated by the input assembler, not fetched
+		if (paramDesc.SystemValueType != D3D_NAME_UNDEFINED)
+			continue;
+
 		// create input element desc
 		D3D11_INPUT_ELEMENT_DESC elementDesc;
 		elementDesc.SemanticName = paramDesc.SemanticName;
 		elementDesc.SemanticIndex = paramDesc.SemanticIndex;
 		elementDesc.InputSlot = 0;
-		elementDesc.AlignedByteOffset = byteOffset;
 		elementDesc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 		elementDesc.InstanceDataStepRate = 0;
-		
-		byteOffset += static_cast<UINT>(floor(log(paramDesc.Mask) / log(2)) + 1) * 4;
+
+		// Meshes upload their MeshData vertices untouched, so attributes are fetched at their MeshVertex offsets
+		if (strcmp(paramDesc.SemanticName, "POSITION") == 0)
+			elementDesc.AlignedByteOffset = offsetof(MeshVertex, position);
+		else if (strcmp(paramDesc.SemanticName, "NORMAL") == 0)
+			elementDesc.AlignedByteOffset = offsetof(MeshVertex, normal);
+		else
+		{
+			APP_LOG_WARNING(L"Vertex input semantic '" + std::wstring(paramDesc.SemanticName, paramDesc.SemanticName + strlen(paramDesc.SemanticName)) + L"' is not part of MeshVertex !");
+			return;
+		}
 
 		// determine DXGI format
 		switch (paramDesc.ComponentType)
@@ -138,7 +151,7 @@ void Material::GenerateInputLayout(ID3D11Device* pdevice)
 		m_InputLayoutDescs.push_back(elementDesc);
 	}
 
-	m_InputLayoutSize = byteOffset;
+	m_InputLayoutSize = static_cast<UINT>(sizeof(MeshVertex));
 
 	res = pdevice->CreateInputLayout(
 		std::data(m_InputLayoutDescs)
@@ -4,22 +4,25 @@
 #include "Common/Structs.h"
 #include "../Material/Material.h"
 #include "Camera/Camera.h"
+#include "Common/MeshSimplifier.h"
 
-TriangleMesh::TriangleMesh(std::vector<DirectX::XMFLOAT3>&& positions, std::vector<DirectX::XMFLOAT3>&& normals, std::vector<DirectX::XMFLOAT2>&& uvs, std::vector<uint32_t>&& indices, bool calculateTangents)
+TriangleMesh::TriangleMesh(MeshData&& meshData, bool releaseCpuData)
 	: m_WorldMatrix{  }
-	, m_VertexPositions{ positions }
-	, m_VertexNorms{ normals }
-	, m_VertexTangents{  }
-	, m_VertexUvs{ uvs }
-	, m_Indices{ indices }
+	, m_MeshData{ std::move(meshData) }
+	, m_VertexCount{ m_MeshData.GetVertexCount() }
+	, m_IndexCount{ m_MeshData.GetIndexCount() }
+	, m_IndexFormat{ IndexPacker::SelectFormat(m_VertexCount) }
+	, m_Lods{ std::empty(m_MeshData.lods) ? std::vector<MeshLod>{ m_MeshData.GetLod(0) } : m_MeshData.lods }
+	, m_LodIdx{ 0 }
+	, m_BoundingCenter{}
+	, m_BoundingRadius{}
+	, m_ReleaseCpuData{ releaseCpuData }
 	, m_VertexBuffer{ nullptr }
 	, m_IndexBuffer{ nullptr }
 	, m_pMaterial{ nullptr }
 {
 	XMStoreFloat4x4(&m_WorldMatrix, DirectX::XMMatrixIdentity());
-
-	calculateTangents;
-	m_VertexTangents.resize(m_VertexPositions.size());
+	MeshSimplifier::ComputeBoundingSphere(m_MeshData.vertices, m_BoundingCenter, m_BoundingRadius);
 }
 
 TriangleMesh::~TriangleMesh()
@@ -33,6 +36,9 @@ void TriangleMesh::SetMaterial(ID3D11Device* pdevice, Material* pmaterial)
 	m_pMaterial = pmaterial;
 	BuildVertexBuffer(pdevice);
 	BuildIndexBuffer(pdevice);
+
+	if (m_ReleaseCpuData && m_VertexBuffer && m_IndexBuffer)
+		m_MeshData.Release();
 }
 
 void TriangleMesh::BuildVertexBuffer(ID3D11Device* pdevice)
@@ -40,64 +46,72 @@ void TriangleMesh::BuildVertexBuffer(ID3D11Device* pdevice)
 	if (!m_pMaterial)
 		return;
 
-	UINT vCount{ static_cast<UINT>(m_VertexPositions.size()) };
+	if (m_VertexBuffer || m_VertexCount == 0)
+		return;
+
+	// The material input layout fetches straight from MeshVertex, no staging copy is needed
 	UINT vStride{ m_pMaterial->GetInputLayoutSize() };
+	if (vStride != sizeof(MeshVertex))
+		return;
 
 	D3D11_BUFFER_DESC vBufferDesc{};
 	vBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
-	vBufferDesc.ByteWidth = vStride * vCount;
+	vBufferDesc.ByteWidth = vStride * m_VertexCount;
 	vBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	vBufferDesc.CPUAccessFlags = 0;
 	vBufferDesc.MiscFlags = 0;
 	vBufferDesc.StructureByteStride = 0;
 
-	const std::vector<D3D11_INPUT_ELEMENT_DESC>& inputDescs{ m_pMaterial->GetInputLayoutDesc() };
-	char* pdata{ new char[vBufferDesc.ByteWidth] };
-
-	for (const D3D11_INPUT_ELEMENT_DESC& desc : inputDescs)
-	{
-		for (UINT idx{}; idx < vCount; ++idx)
-		{
-			const UINT memOffset{ vStride * idx + desc.AlignedByteOffset };
-			if (strcmp(desc.SemanticName, "POSITION") == 0)
-				memcpy(pdata + memOffset, &m_VertexPositions[idx], sizeof m_VertexPositions[idx]);
-			else if (strcmp(desc.SemanticName, "NORMAL") == 0)
-				memcpy(pdata + memOffset, &m_VertexNorms[idx], sizeof m_VertexNorms[idx]);
-			else if (strcmp(desc.SemanticName, "TANGENT") == 0)
-				memcpy(pdata + memOffset, &m_VertexTangents[idx], sizeof m_VertexTangents[idx]);
-			else if (strcmp(desc.SemanticName, "TEXTCOORD") == 0)
-				memcpy(pdata + memOffset, &m_VertexUvs[idx], sizeof m_VertexUvs[idx]);
-		}
-	}
-
 	D3D11_SUBRESOURCE_DATA vResData{};
-	vResData.pSysMem = pdata;
+	vResData.pSysMem = std::data(m_MeshData.vertices);
 
 	HRESULT res{ pdevice->CreateBuffer(&vBufferDesc, &vResData, &m_VertexBuffer) };
 	if (FAILED(res))
 		return;
-
-	delete[] pdata;
 }
 
 void TriangleMesh::BuildIndexBuffer(ID3D11Device* pdevice)
 {
+	if (m_IndexBuffer || m_IndexCount == 0)
+		return;
+
 	D3D11_BUFFER_DESC iBufferDesc{};
 	iBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
-	iBufferDesc.ByteWidth = static_cast<UINT>(std::size(m_Indices) * sizeof uint32_t);
+	iBufferDesc.ByteWidth = static_cast<UINT>(m_IndexCount * sizeof uint32_t);
 	iBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	iBufferDesc.CPUAccessFlags = 0;
 	iBufferDesc.MiscFlags = 0;
 	iBufferDesc.StructureByteStride = 0;
 
 	D3D11_SUBRESOURCE_DATA vResData{};
-	vResData.pSysMem = std::data(m_Indices);
+	vResData.pSysMem = std::data(m_MeshData.indices);
+
+	// The packed words are a plain uint16 array, LOD offsets stay in indices
+	std::vector<uint32_t> packedIndices{};
+	if (m_IndexFormat == EIndexFormat::Uint16)
+	{
+		packedIndices = IndexPacker::Pack16(std::data(m_MeshData.indices), m_IndexCount);
+		iBufferDesc.ByteWidth = static_cast<UINT>(std::size(packedIndices) * sizeof uint32_t);
+		vResData.pSysMem = std::data(packedIndices);
+	}
 
 	HRESULT res{ pdevice->CreateBuffer(&iBufferDesc, &vResData, &m_IndexBuffer) };
 	if (FAILED(res))
 		return;
 }
 
+void TriangleMesh::SelectLod(const Camera* pcamera, float viewportHeight)
+{
+	using namespace DirectX;
+
+	// Distance to the closest point of the bounding sphere, the world matrix is assumed to carry no scale
+	const XMVECTOR center{ XMVector3TransformCoord(XMLoadFloat3(&m_BoundingCenter), XMLoadFloat4x4(&m_WorldMatrix)) };
+	const XMFLOAT3 cameraPosition{ pcamera->GetPosition() };
+	const float distance{ XMVectorGetX(XMVector3Length(center - XMLoadFloat3(&cameraPosition))) - m_BoundingRadius };
+
+	m_LodIdx = MeshSimplifier::SelectLod(m_Lods, distance, pcamera->GetFOV(), viewportHeight);
+}
+
 void TriangleMesh::SetupDrawInfo(Camera* pcamera, ID3D11DeviceContext* pdeviceContext) const
 {
 	if (!m_pMaterial)
@@ -106,7 +120,7 @@ void TriangleMesh::SetupDrawInfo(Camera* pcamera, ID3D11DeviceContext* pdeviceCo
 	const UINT stride{ m_pMaterial->GetInputLayoutSize() };
 	const UINT offset{ 0 };
 	pdeviceContext->IASetVertexBuffers(0, 1, &m_VertexBuffer, &stride, &offset);
-	pdeviceContext->IASetIndexBuffer(m_IndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	pdeviceContext->IASetIndexBuffer(m_IndexBuffer, m_IndexFormat == EIndexFormat::Uint16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0);
 	pdeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	DirectX::XMFLOAT4X4 world{};
@@ -2,13 +2,21 @@
 #include <DirectXMath.h>
 #include <vector>
 
+#include "Common/IndexPacker.h"
+#include "Common/MeshData.h"
+
 class Camera;
 class Material;
 
 class TriangleMesh
 {
 public:
-	explicit TriangleMesh(std::vector<DirectX::XMFLOAT3>&& positions, std::vector<DirectX::XMFLOAT3>&& normals, std::vector<DirectX::XMFLOAT2>&& uvs, std::vector<uint32_t>&& indices, bool calculateTangents = false);
+	/**
+	 * \brief : Adopts meshData without copying it, every level of detail is uploaded in the same index buffer.\n
+	 * Indices are uploaded as R16_UINT when the vertex count allows it (IndexPacker).
+	 * \param releaseCpuData : Frees the CPU-side vertices and indices once SetMaterial uploaded them
+	 */
+	explicit TriangleMesh(MeshData&& meshData, bool releaseCpuData = false);
 	~TriangleMesh();
 
 	TriangleMesh(const TriangleMesh&) = delete;
@@ -19,16 +27,31 @@ public:
 	void SetMaterial(ID3D11Device* pdevice, Material* pmaterial);
 	void SetupDrawInfo(Camera* pcamera, ID3D11DeviceContext* pdeviceContext) const;
 
-	UINT GetIndexCount() const { return static_cast<UINT>(std::size(m_Indices)); }
+	/**
+	 * \brief : Picks the coarsest level of detail whose error projects to less than a pixel from the camera (MeshSimplifier::SelectLod)
+	 * \param viewportHeight : Height of the render target in pixels
+	 */
+	void SelectLod(const Camera* pcamera, float viewportHeight);
+
+	UINT GetIndexCount() const { return m_IndexCount; }
+	EIndexFormat GetIndexFormat() const { return m_IndexFormat; }
+	UINT GetLodCount() const { return static_cast<UINT>(std::size(m_Lods)); }
+	UINT GetLodIndex() const { return m_LodIdx; }
+	UINT GetLodIndexOffset() const { return m_Lods[m_LodIdx].indexOffset; }
+	UINT GetLodIndexCount() const { return m_Lods[m_LodIdx].indexCount; }
 
 private:
 	DirectX::XMFLOAT4X4 m_WorldMatrix;
 
-	std::vector<DirectX::XMFLOAT3> m_VertexPositions;
-	std::vector<DirectX::XMFLOAT3> m_VertexNorms;
-	std::vector<DirectX::XMFLOAT3> m_VertexTangents;
-	std::vector<DirectX::XMFLOAT2> m_VertexUvs;
-	std::vector<uint32_t> m_Indices;
+	MeshData m_MeshData;
+	UINT m_VertexCount;
+	UINT m_IndexCount;
+	EIndexFormat m_IndexFormat;
+	std::vector<MeshLod> m_Lods;
+	UINT m_LodIdx;
+	DirectX::XMFLOAT3 m_BoundingCenter;
+	float m_BoundingRadius;
+	bool m_ReleaseCpuData;
 
 	ID3D11Buffer* m_VertexBuffer;
 	ID3D11Buffer* m_IndexBuffer;
@@ -150,5 +150,5 @@ HRESULT HardwareRenderer::Initialize(const Window& window)
 void HardwareRenderer::DrawIndexed(Camera* pcamera, TriangleMesh* pmesh) const
 {
 	pmesh->SetupDrawInfo(pcamera, m_pDxDeviceContext);
-	m_pDxDeviceContext->DrawIndexed(pmesh->GetIndexCount(), 0, 0);
+	m_pDxDeviceContext->DrawIndexed(pmesh->GetLodIndexCount(), pmesh->GetLodIndexOffset(), 0);
 }
\ No newline at end of file
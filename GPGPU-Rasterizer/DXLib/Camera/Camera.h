@@ -13,6 +13,9 @@ public:
 
 	DirectX::XMFLOAT4X4 GetViewProjection() const;
 	DirectX::XMFLOAT4X4 GetViewProjectionInverse() const;
+	DirectX::XMFLOAT3 GetPosition() const { return DirectX::XMFLOAT3{ m_ViewInvMatrix._41, m_ViewInvMatrix._42, m_ViewInvMatrix._43 }; }
+	// Vertical field of view in radians
+	float GetFOV() const { return m_FOV; }
 
 	void Update(float delatTime);
 
@@ -0,0 +1,66 @@
+#include "pch.h"
+#include "BinList.h"
+
+uint64_t BinList::Sizes::GetEncodedByteCount() const
+{
+	return static_cast<uint64_t>(blockCount) * sizeof(BlockHeader) + static_cast<uint64_t>(wordCount) * sizeof(uint32_t);
+}
+
+uint64_t BinList::Sizes::GetRawByteCount() const
+{
+	return static_cast<uint64_t>(triangleCount) * sizeof(uint32_t);
+}
+
+BinList::BlockHeader BinList::PackHeader(uint32_t firstTriangle, uint32_t byteOffset, uint32_t entryIdx, uint32_t triangleCount)
+{
+	return { firstTriangle, byteOffset, entryIdx << BLOCK_BITS | (triangleCount - 1) };
+}
+
+uint32_t BinList::GetEntry(const BlockHeader& header)
+{
+	return header.entry >> BLOCK_BITS;
+}
+
+uint32_t BinList::GetTriangleCount(const BlockHeader& header)
+{
+	return (header.entry & (BLOCK_SIZE - 1)) + 1;
+}
+
+uint32_t BinList::GetVarintSize(uint32_t value)
+{
+	uint32_t size{ 1 };
+	while (value >= 0x80)
+	{
+		value >>= 7;
+		++size;
+	}
+
+	return size;
+}
+
+uint32_t BinList::WriteVarint(uint8_t* pstream, uint32_t value)
+{
+	uint32_t size{ 0 };
+	while (value >= 0x80)
+	{
+		pstream[size++] = static_cast<uint8_t>(value | 0x80);
+		value >>= 7;
+	}
+
+	pstream[size++] = static_cast<uint8_t>(value);
+	return size;
+}
+
+uint32_t BinList::ReadVarint(const uint8_t* pstream, uint32_t& byteOffset)
+{
+	uint32_t value{ 0 };
+	for (uint32_t shift{ 0 }; shift < 7 * MAX_VARINT_SIZE; shift += 7)
+	{
+		const uint8_t streamByte{ pstream[byteOffset++] };
+		value |= static_cast<uint32_t>(streamByte & 0x7F) << shift;
+		if (streamByte < 0x80)
+			break;
+	}
+
+	return value;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * \brief : Triangle lists of the bins, delta and varint coded between binning and tiling.\n
+ * The triangles of a queue of a bin strictly increase, the queue is cut in blocks of BLOCK_SIZE of them. A block header holds its first triangle,
+ * the byte offset of the varint coded deltas to the others and where its triangles go in the tile buffer, so every block decodes on its own.\n
+ * The deltas of a queue start on a 32 bit word, the binning shader stores them a word at a time.\n
+ * This is the CPU reference of BinList.hlsli.
+ */
+namespace BinList
+{
+	constexpr uint32_t BLOCK_BITS{ 4 };
+	constexpr uint32_t BLOCK_SIZE{ 1u << BLOCK_BITS };
+	// Tile buffer indices a header can hold
+	constexpr uint32_t MAX_ENTRY_COUNT{ 1u << (32 - BLOCK_BITS) };
+	// Bytes of a varint of any 32 bit value
+	constexpr uint32_t MAX_VARINT_SIZE{ 5 };
+
+	struct BlockHeader
+	{
+		uint32_t firstTriangle;
+		uint32_t byteOffset;
+		// Tile buffer index of the first triangle << BLOCK_BITS | triangle count - 1
+		uint32_t entry;
+	};
+	static_assert(sizeof(BlockHeader) == 12, "BlockHeader must match BIN_HEADER_SIZE");
+
+	// Totals of a frame, what the scan of the binning stage stores past its offsets
+	struct Sizes
+	{
+		// Bin triangle pairs, one per bin a triangle overlaps
+		uint32_t triangleCount;
+		uint32_t blockCount;
+		// 32 bit words of varint deltas
+		uint32_t wordCount;
+
+		// Headers and deltas
+		uint64_t GetEncodedByteCount() const;
+		// A 32 bit triangle index per pair
+		uint64_t GetRawByteCount() const;
+	};
+	static_assert(sizeof(Sizes) == 12, "Sizes must match the totals BinScan stores past its arrays");
+
+	BlockHeader PackHeader(uint32_t firstTriangle, uint32_t byteOffset, uint32_t entryIdx, uint32_t triangleCount);
+	uint32_t GetEntry(const BlockHeader& header);
+	uint32_t GetTriangleCount(const BlockHeader& header);
+
+	// Bytes of value, 7 bits per byte
+	uint32_t GetVarintSize(uint32_t value);
+	/**
+	 * \brief : Writes value from its low bits, the high bit of a byte flags another one
+	 * \return : Bytes written
+	 */
+	uint32_t WriteVarint(uint8_t* pstream, uint32_t value);
+	/**
+	 * \brief : Reads the varint at byteOffset and moves byteOffset past it
+	 */
+	uint32_t ReadVarint(const uint8_t* pstream, uint32_t& byteOffset);
+};
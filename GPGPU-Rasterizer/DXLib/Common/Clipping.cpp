@@ -0,0 +1,93 @@
+#include "pch.h"
+#include "Clipping.h"
+
+#include <algorithm>
+
+float Clipping::GetPlaneDistance(uint32_t planeIdx, const DirectX::XMFLOAT4& position, float viewportWidth, float viewportHeight, float guardBandPixels)
+{
+	// The guard band in clip space, NDC reaches 1 at the viewport side and 1 + 2 * guardBandPixels / size at the band side
+	const float guardX{ 1.f + 2.f * guardBandPixels / viewportWidth };
+	const float guardY{ 1.f + 2.f * guardBandPixels / viewportHeight };
+
+	switch (planeIdx)
+	{
+	case 0: return position.w + position.x;
+	case 1: return position.w - position.x;
+	case 2: return position.w + position.y;
+	case 3: return position.w - position.y;
+	case 4: return position.z - NEAR_DEPTH * position.w;
+	case 5: return position.w - position.z;
+	case 6: return guardX * position.w + position.x;
+	case 7: return guardX * position.w - position.x;
+	case 8: return guardY * position.w + position.y;
+	default: return guardY * position.w - position.y;
+	}
+}
+
+uint32_t Clipping::GetOutcode(const DirectX::XMFLOAT4& position, float viewportWidth, float viewportHeight, float guardBandPixels)
+{
+	uint32_t outcode{ 0 };
+	for (uint32_t planeIdx{}; planeIdx < PLANE_COUNT; ++planeIdx)
+	{
+		// Written as a positive test so a NaN position is outside every plane
+		if (!(GetPlaneDistance(planeIdx, position, viewportWidth, viewportHeight, guardBandPixels) >= 0.f))
+			outcode |= 1u << planeIdx;
+	}
+
+	return outcode;
+}
+
+DirectX::XMFLOAT4 Clipping::ClipToScreen(const DirectX::XMFLOAT4& position, float viewportWidth, float viewportHeight)
+{
+	// ProjectionToNDC keeps 1 / w in w, NDCToScreen flips y
+	const float invW{ 1.f / position.w };
+	return DirectX::XMFLOAT4{ (position.x * invW + 1.f) * viewportWidth * 0.5f, (position.y * invW - 1.f) * -viewportHeight * 0.5f, position.z * invW, invW };
+}
+
+DirectX::XMFLOAT4 Clipping::ScreenToClip(const DirectX::XMFLOAT4& position, float viewportWidth, float viewportHeight)
+{
+	const float w{ 1.f / position.w };
+	return DirectX::XMFLOAT4{ (position.x * 2.f / viewportWidth - 1.f) * w, (1.f - position.y * 2.f / viewportHeight) * w, position.z * w, w };
+}
+
+uint32_t Clipping::ClipPolygon(ClipVertex* pvertices, uint32_t vCount, uint32_t outcodeMask, float viewportWidth, float viewportHeight, float guardBandPixels)
+{
+	ClipVertex clipped[MAX_POLYGON_VERTICES]{};
+	for (uint32_t planeIdx{}; planeIdx < PLANE_COUNT && vCount >= 3; ++planeIdx)
+	{
+		if ((outcodeMask & CLIP_OUTCODE & (1u << planeIdx)) == 0)
+			continue;
+
+		uint32_t clippedCount{ 0 };
+		for (uint32_t vIdx{}; vIdx < vCount; ++vIdx)
+		{
+			const ClipVertex& current{ pvertices[vIdx] };
+			const ClipVertex& next{ pvertices[(vIdx + 1) % vCount] };
+			const float currentDistance{ GetPlaneDistance(planeIdx, current.position, viewportWidth, viewportHeight, guardBandPixels) };
+			const float nextDistance{ GetPlaneDistance(planeIdx, next.position, viewportWidth, viewportHeight, guardBandPixels) };
+
+			if (currentDistance >= 0.f)
+				clipped[clippedCount++] = current;
+
+			// The edge crosses the plane, interpolated from its inside vertex so the triangle on the other side of the edge gets the same crossing point
+			if ((currentDistance >= 0.f) != (nextDistance >= 0.f))
+			{
+				using namespace DirectX;
+				const bool isCurrentInside{ currentDistance >= 0.f };
+				const ClipVertex& inside{ isCurrentInside ? current : next };
+				const ClipVertex& outside{ isCurrentInside ? next : current };
+				const float insideDistance{ isCurrentInside ? currentDistance : nextDistance };
+				const float t{ insideDistance / (insideDistance - (isCurrentInside ? nextDistance : currentDistance)) };
+
+				ClipVertex& crossing{ clipped[clippedCount++] };
+				XMStoreFloat4(&crossing.position, XMVectorLerp(XMLoadFloat4(&inside.position), XMLoadFloat4(&outside.position), t));
+				XMStoreFloat3(&crossing.normal, XMVectorLerp(XMLoadFloat3(&inside.normal), XMLoadFloat3(&outside.normal), t));
+			}
+		}
+
+		std::copy_n(clipped, clippedCount, pvertices);
+		vCount = clippedCount;
+	}
+
+	return vCount;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <DirectXMath.h>
+
+/**
+ * \brief : Outcodes and homogeneous clipping of geometry setup, in the clip space of the vertex stage (-w <= x, y <= w and 0 <= z <= w).\n
+ * A triangle with its 3 vertices outside the same viewport plane is rejected. The others are rasterized as they are
+ * while they stay in front of the near plane, behind the far plane and inside the guard band, the raster stages clamp them to the viewport.
+ * Only the few left are clipped into a polygon, fanned into triangles stored past the mesh triangles, up to MAX_CLIP_TRIANGLES.\n
+ * The guard band reaches GUARD_BAND_PIXELS past every viewport side. A triangle inside it has twice its area below (width + 2 * band) * (height + 2 * band)
+ * pixels, so the FixedPointEdges functions of its covered pixels stay exact below EDGE_CLAMP for a 1280x720 viewport,
+ * RasterConfig::GetGuardBandPixels shrinks the band for larger ones, the functions below take the band they clip to.\n
+ * This is the CPU reference of Clipping.hlsli.
+ */
+namespace Clipping
+{
+	// Outcode bits, one per plane, set when the position is outside it
+	constexpr uint32_t OUT_LEFT{ 1u << 0 };
+	constexpr uint32_t OUT_RIGHT{ 1u << 1 };
+	constexpr uint32_t OUT_BOTTOM{ 1u << 2 };
+	constexpr uint32_t OUT_TOP{ 1u << 3 };
+	constexpr uint32_t OUT_NEAR{ 1u << 4 };
+	constexpr uint32_t OUT_FAR{ 1u << 5 };
+	constexpr uint32_t OUT_GUARD_LEFT{ 1u << 6 };
+	constexpr uint32_t OUT_GUARD_RIGHT{ 1u << 7 };
+	constexpr uint32_t OUT_GUARD_BOTTOM{ 1u << 8 };
+	constexpr uint32_t OUT_GUARD_TOP{ 1u << 9 };
+	constexpr uint32_t PLANE_COUNT{ 10 };
+
+	// A triangle with its 3 vertices outside one of these planes covers no pixel
+	constexpr uint32_t REJECT_OUTCODE{ OUT_LEFT | OUT_RIGHT | OUT_BOTTOM | OUT_TOP | OUT_NEAR | OUT_FAR };
+	// Planes the clipper cuts along, the viewport sides are left to the guard band
+	constexpr uint32_t CLIP_OUTCODE{ OUT_NEAR | OUT_FAR | OUT_GUARD_LEFT | OUT_GUARD_RIGHT | OUT_GUARD_BOTTOM | OUT_GUARD_TOP };
+	// Every plane of CLIP_OUTCODE adds at most one vertex to a convex polygon
+	constexpr uint32_t MAX_POLYGON_VERTICES{ 3 + 6 };
+
+	constexpr float GUARD_BAND_PIXELS{ 512.f };
+	// Depth of the near plane, above 0 so geometry setup never inverts a zero depth
+	constexpr float NEAR_DEPTH{ 1.f / 65536.f };
+	// Triangles the clipper can emit per Dispatch, the slots past the mesh triangles
+	constexpr uint32_t MAX_CLIP_TRIANGLES{ 4096 };
+
+	struct ClipVertex
+	{
+		DirectX::XMFLOAT4 position;
+		DirectX::XMFLOAT3 normal;
+	};
+
+	/**
+	 * \brief : Signed distance to the plane of outcode bit planeIdx, negative outside
+	 */
+	float GetPlaneDistance(uint32_t planeIdx, const DirectX::XMFLOAT4& position, float viewportWidth, float viewportHeight, float guardBandPixels = GUARD_BAND_PIXELS);
+
+	uint32_t GetOutcode(const DirectX::XMFLOAT4& position, float viewportWidth, float viewportHeight, float guardBandPixels = GUARD_BAND_PIXELS);
+
+	/**
+	 * \brief : Screen position the raster stages use, x and y in pixels with y down, z / w then 1 / w
+	 */
+	DirectX::XMFLOAT4 ClipToScreen(const DirectX::XMFLOAT4& position, float viewportWidth, float viewportHeight);
+
+	/**
+	 * \brief : Inverse of ClipToScreen, for a position in front of the near plane
+	 */
+	DirectX::XMFLOAT4 ScreenToClip(const DirectX::XMFLOAT4& position, float viewportWidth, float viewportHeight);
+
+	/**
+	 * \brief : Sutherland-Hodgman clipping of the convex polygon, in place, against the planes of outcodeMask & CLIP_OUTCODE.\n
+	 * Geometry setup passes every clip plane, cutting along the near plane can move a vertex out of the guard band
+	 * \param pvertices : MAX_POLYGON_VERTICES entries, the first vCount filled
+	 * \return : Vertex count of the clipped polygon, below 3 when nothing is left
+	 */
+	uint32_t ClipPolygon(ClipVertex* pvertices, uint32_t vCount, uint32_t outcodeMask, float viewportWidth, float viewportHeight, float guardBandPixels = GUARD_BAND_PIXELS);
+};
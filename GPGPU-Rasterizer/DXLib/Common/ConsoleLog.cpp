@@ -0,0 +1,17 @@
+#include "pch.h"
+#include "ConsoleLog.h"
+
+namespace
+{
+	thread_local std::wostream* pthreadStream{ nullptr };
+}
+
+std::wostream& ConsoleLog::GetStream()
+{
+	return pthreadStream ? *pthreadStream : std::wcout;
+}
+
+void ConsoleLog::SetThreadStream(std::wostream* pstream)
+{
+	pthreadStream = pstream;
+}
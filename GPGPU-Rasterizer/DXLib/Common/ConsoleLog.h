@@ -0,0 +1,16 @@
+#pragma once
+#include <iostream>
+
+/**
+ * \brief : Stream the portable parts of the library (Common/) report to, std::wcout unless the calling thread redirected it.\n
+ * A tool running them on several threads gives each thread its own buffer and prints it whole, so the reports do not interleave.
+ */
+namespace ConsoleLog
+{
+	std::wostream& GetStream();
+
+	/**
+	 * \brief : Redirects GetStream on the calling thread to pstream, nullptr goes back to std::wcout
+	 */
+	void SetThreadStream(std::wostream* pstream);
+};
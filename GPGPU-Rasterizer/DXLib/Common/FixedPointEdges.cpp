@@ -0,0 +1,46 @@
+#include "pch.h"
+#include "FixedPointEdges.h"
+
+#include <algorithm>
+#include <cmath>
+
+int32_t FixedPointEdges::SnapCoordinate(float coordinate)
+{
+	const float clamped{ std::clamp(coordinate, -static_cast<float>(MAX_COORDINATE), static_cast<float>(MAX_COORDINATE)) };
+	return static_cast<int32_t>(std::nearbyint(clamped * static_cast<float>(SUBPIXEL_SCALE)));
+}
+
+bool FixedPointEdges::IsTopLeft(int32_t a, int32_t b)
+{
+	return a > 0 || (a == 0 && b > 0);
+}
+
+int32_t FixedPointEdges::GetThreshold(int32_t a, int32_t b, int32_t startX, int32_t startY)
+{
+	// E = 256 * F - subpixel with F the function of the pixel steps, so E > 0 <=> F > floor(subpixel / 256) and E >= 0 <=> F > ceil(subpixel / 256) - 1
+	const int32_t subpixel{ a * (startX & (SUBPIXEL_SCALE - 1)) + b * (startY & (SUBPIXEL_SCALE - 1)) };
+	return IsTopLeft(a, b) ? -(-subpixel >> SUBPIXEL_BITS) - 1 : subpixel >> SUBPIXEL_BITS;
+}
+
+float FixedPointEdges::EstimateEdge(int32_t a, int32_t b, int32_t startX, int32_t startY, int32_t threshold, int32_t pixelX, int32_t pixelY)
+{
+	const int32_t dx{ pixelX - (startX >> SUBPIXEL_BITS) };
+	const int32_t dy{ pixelY - (startY >> SUBPIXEL_BITS) };
+	return static_cast<float>(a) * static_cast<float>(dx) + static_cast<float>(b) * static_cast<float>(dy) - static_cast<float>(threshold);
+}
+
+int32_t FixedPointEdges::EvaluateEdge(int32_t a, int32_t b, int32_t startX, int32_t startY, int32_t threshold, int32_t pixelX, int32_t pixelY)
+{
+	const int32_t dx{ pixelX - (startX >> SUBPIXEL_BITS) };
+	const int32_t dy{ pixelY - (startY >> SUBPIXEL_BITS) };
+
+	// The float estimate is off by far less than EDGE_CLAMP, below it the wrapping 32 bit result is the exact value
+	const float estimate{ EstimateEdge(a, b, startX, startY, threshold, pixelX, pixelY) };
+	if (estimate >= static_cast<float>(EDGE_CLAMP))
+		return EDGE_CLAMP;
+	if (estimate <= -static_cast<float>(EDGE_CLAMP))
+		return -EDGE_CLAMP;
+
+	const uint32_t wrapped{ static_cast<uint32_t>(a) * static_cast<uint32_t>(dx) + static_cast<uint32_t>(b) * static_cast<uint32_t>(dy) - static_cast<uint32_t>(threshold) };
+	return static_cast<int32_t>(wrapped);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+
+// How geometry setup builds the edge functions and how the fine stage tests them
+enum class ERasterMode
+{
+	Float, // float edge equations of the raw screen positions, a pixel is drawn when strictly inside every edge
+	FixedPoint // FixedPointEdges, watertight
+};
+
+/**
+ * \brief : Integer edge functions of triangles snapped to 1/256 pixel, with the top-left fill rule.\n
+ * A pixel is sampled at its integer coordinates. It is covered when E > 0 for every edge, or E == 0 on a top or left edge,
+ * so a pixel on an edge shared by two triangles is drawn exactly once.\n
+ * E(p) = a * (256 * p.x - start.x) + b * (256 * p.y - start.y) needs 44 bits, EvaluateEdge tests it with 32 bit integers:
+ * the 256 factor is taken out by rounding the sub pixel part of start into the threshold,
+ * and values too large for a tile to change their sign are clamped to EDGE_CLAMP.
+ * Stepping from an evaluated pixel by a and b over up to MAX_STEP_PIXELS pixels stays exact.
+ * A clamped value only keeps the sign for the coverage test, the weights of its pixels come from EstimateEdge.\n
+ * This is the CPU reference of FixedPointEdges.hlsli.
+ */
+namespace FixedPointEdges
+{
+	constexpr uint32_t SUBPIXEL_BITS{ 8 };
+	constexpr int32_t SUBPIXEL_SCALE{ 1 << SUBPIXEL_BITS };
+	// Snapped coordinates are clamped to +-MAX_COORDINATE pixels, enough for a 4K viewport, so a and b fit in 22 bits
+	constexpr int32_t MAX_COORDINATE{ 4096 };
+	constexpr int32_t EDGE_CLAMP{ 1 << 30 };
+	constexpr int32_t MAX_STEP_PIXELS{ 16 };
+	static_assert(static_cast<int64_t>(MAX_STEP_PIXELS) * 2 * (2 * MAX_COORDINATE * SUBPIXEL_SCALE) < (1ll << 31) - EDGE_CLAMP, "Stepping from a clamped value can overflow");
+
+	/**
+	 * \brief : Nearest multiple of 1/SUBPIXEL_SCALE, in sub pixels, ties to even like round() in HLSL
+	 */
+	int32_t SnapCoordinate(float coordinate);
+
+	/**
+	 * \brief : Whether the edge with inward normal (a, b) is a left edge, or a horizontal top edge, of a y down screen
+	 */
+	bool IsTopLeft(int32_t a, int32_t b);
+
+	/**
+	 * \brief : Value subtracted from the reduced edge function, folds the sub pixel part of start and the fill rule
+	 * \param startX, startY : Snapped vertex the edge starts from
+	 */
+	int32_t GetThreshold(int32_t a, int32_t b, int32_t startX, int32_t startY);
+
+	/**
+	 * \brief : Unclamped float value of the reduced edge function at a pixel, the weight numerator where EvaluateEdge clamps
+	 */
+	float EstimateEdge(int32_t a, int32_t b, int32_t startX, int32_t startY, int32_t threshold, int32_t pixelX, int32_t pixelY);
+
+	/**
+	 * \brief : Reduced edge function at a pixel, positive when the pixel is covered by the edge
+	 */
+	int32_t EvaluateEdge(int32_t a, int32_t b, int32_t startX, int32_t startY, int32_t threshold, int32_t pixelX, int32_t pixelY);
+};
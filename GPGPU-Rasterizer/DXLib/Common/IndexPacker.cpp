@@ -0,0 +1,41 @@
+#include "pch.h"
+#include "IndexPacker.h"
+
+EIndexFormat IndexPacker::SelectFormat(uint32_t vertexCount)
+{
+	return vertexCount <= MAX_16BIT_VERTEX_COUNT ? EIndexFormat::Uint16 : EIndexFormat::Uint32;
+}
+
+std::vector<uint32_t> IndexPacker::Pack16(const uint32_t* pindices, size_t indexCount)
+{
+	std::vector<uint32_t> words((indexCount + 1) / 2, 0);
+	for (size_t indexIdx{}; indexIdx < indexCount; ++indexIdx)
+		words[indexIdx / 2] |= (pindices[indexIdx] & 0xFFFFu) << ((indexIdx & 1) * 16);
+
+	return words;
+}
+
+uint32_t IndexPacker::UnpackIndex(const uint32_t* pwords, size_t indexIdx)
+{
+	return (pwords[indexIdx / 2] >> ((indexIdx & 1) * 16)) & 0xFFFFu;
+}
+
+void IndexPacker::UnpackTriangle(const uint32_t* pwords, uint32_t triIdx, uint32_t triangle[3])
+{
+	// A triangle is 6 bytes, so it starts either on a word or in the middle of one
+	const size_t byteOffset{ static_cast<size_t>(triIdx) * 6 };
+	const uint32_t* pfirstWord{ pwords + byteOffset / 4 };
+
+	if ((byteOffset & 2) == 0)
+	{
+		triangle[0] = pfirstWord[0] & 0xFFFFu;
+		triangle[1] = pfirstWord[0] >> 16;
+		triangle[2] = pfirstWord[1] & 0xFFFFu;
+	}
+	else
+	{
+		triangle[0] = pfirstWord[0] >> 16;
+		triangle[1] = pfirstWord[1] & 0xFFFFu;
+		triangle[2] = pfirstWord[1] >> 16;
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+
+// Element size of an uploaded index buffer
+enum class EIndexFormat
+{
+	Uint32, Uint16
+};
+
+/**
+ * \brief : 16 bit index buffers, two indices per uint32 word (little endian, so the words are also a plain uint16 array).\n
+ * UnpackTriangle is the CPU reference of LoadTriangle in IndexBuffer.hlsli.
+ */
+namespace IndexPacker
+{
+	constexpr uint32_t MAX_16BIT_VERTEX_COUNT{ 65536 };
+
+	/**
+	 * \brief : Uint16 when every index of a vertexCount vertex buffer fits in 16 bits
+	 */
+	EIndexFormat SelectFormat(uint32_t vertexCount);
+
+	/**
+	 * \brief : Packs indexCount indices in pairs, the last word is zero padded for an odd count.\n
+	 * Every index must be below MAX_16BIT_VERTEX_COUNT.
+	 */
+	std::vector<uint32_t> Pack16(const uint32_t* pindices, size_t indexCount);
+
+	uint32_t UnpackIndex(const uint32_t* pwords, size_t indexIdx);
+
+	/**
+	 * \brief : Reads the 3 indices of triIdx the way the shaders do: one 8 byte load at the 4 byte aligned address below triIdx * 6
+	 */
+	void UnpackTriangle(const uint32_t* pwords, uint32_t triIdx, uint32_t triangle[3]);
+};
@@ -0,0 +1,97 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#if !defined(_WIN32)
+	#include <filesystem>
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+MappedFile::MappedFile(const std::wstring& filePath)
+	: m_pData{ nullptr }
+	, m_Size{ 0 }
+	, m_IsOpen{ false }
+	, m_FileHandle{ INVALID_HANDLE_VALUE }
+	, m_MappingHandle{ nullptr }
+{
+	m_FileHandle = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_FileHandle == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(m_FileHandle, &fileSize))
+		return;
+
+	m_IsOpen = true;
+	m_Size = static_cast<size_t>(fileSize.QuadPart);
+
+	// Mapping an empty file fails, an empty view is still a valid result
+	if (m_Size == 0)
+		return;
+
+	m_MappingHandle = CreateFileMappingW(m_FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_MappingHandle)
+	{
+		m_IsOpen = false;
+		return;
+	}
+
+	m_pData = static_cast<const char*>(MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0));
+	m_IsOpen = m_pData != nullptr;
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_pData)
+		UnmapViewOfFile(m_pData);
+
+	if (m_MappingHandle)
+		CloseHandle(m_MappingHandle);
+
+	if (m_FileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(m_FileHandle);
+}
+#else
+MappedFile::MappedFile(const std::wstring& filePath)
+	: m_pData{ nullptr }
+	, m_Size{ 0 }
+	, m_IsOpen{ false }
+	, m_FileDescriptor{ -1 }
+{
+	m_FileDescriptor = open(std::filesystem::path{ filePath }.c_str(), O_RDONLY);
+	if (m_FileDescriptor < 0)
+		return;
+
+	struct stat fileStat{};
+	if (fstat(m_FileDescriptor, &fileStat) != 0)
+		return;
+
+	m_IsOpen = true;
+	m_Size = static_cast<size_t>(fileStat.st_size);
+
+	if (m_Size == 0)
+		return;
+
+	void* pview{ mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_FileDescriptor, 0) };
+	if (pview == MAP_FAILED)
+	{
+		m_IsOpen = false;
+		return;
+	}
+
+	madvise(pview, m_Size, MADV_SEQUENTIAL);
+	m_pData = static_cast<const char*>(pview);
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_pData)
+		munmap(const_cast<char*>(m_pData), m_Size);
+
+	if (m_FileDescriptor >= 0)
+		close(m_FileDescriptor);
+}
+#endif
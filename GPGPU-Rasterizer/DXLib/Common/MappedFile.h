@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/**
+ * \brief : Read-only memory mapping of a whole file (CreateFileMapping on Windows, mmap elsewhere).\n
+ * The view stays valid until the object is destroyed.
+ */
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::wstring& filePath);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile(MappedFile&&) noexcept = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile& operator=(MappedFile&&) noexcept = delete;
+
+	bool IsOpen() const { return m_IsOpen; }
+	const char* GetData() const { return m_pData; }
+	size_t GetSize() const { return m_Size; }
+
+private:
+	const char* m_pData;
+	size_t m_Size;
+	bool m_IsOpen;
+
+#if defined(_WIN32)
+	void* m_FileHandle;
+	void* m_MappingHandle;
+#else
+	int m_FileDescriptor;
+#endif
+};
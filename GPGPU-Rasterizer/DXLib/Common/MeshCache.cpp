@@ -0,0 +1,267 @@
+#include "pch.h"
+#include "MeshCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <system_error>
+
+#include "ConsoleLog.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "ObjReader.h"
+
+namespace
+{
+	uint64_t AlignSection(uint64_t offset)
+	{
+		return (offset + MeshCache::SECTION_ALIGNMENT - 1) & ~static_cast<uint64_t>(MeshCache::SECTION_ALIGNMENT - 1);
+	}
+
+	uint64_t HashContent(const char* pdata, size_t size)
+	{
+		uint64_t hash{ 0xCBF29CE484222325ull };
+		for (size_t i{}; i < size; ++i)
+		{
+			hash ^= static_cast<uint8_t>(pdata[i]);
+			hash *= 0x100000001B3ull;
+		}
+
+		return hash;
+	}
+
+	bool GetSourceInfo(const std::wstring& sourcePath, uint64_t& sourceSize, int64_t& sourceWriteTime)
+	{
+		std::error_code error{};
+		const std::filesystem::path path{ sourcePath };
+
+		sourceSize = std::filesystem::file_size(path, error);
+		if (error)
+			return false;
+
+		const std::filesystem::file_time_type writeTime{ std::filesystem::last_write_time(path, error) };
+		if (error)
+			return false;
+
+		sourceWriteTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+		return true;
+	}
+
+	bool IsSectionInFile(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize)
+	{
+		return offset <= fileSize && count <= (fileSize - offset) / elementSize;
+	}
+
+	bool IsValidLods(const MeshCache::Header& header, const char* pfileData)
+	{
+		for (uint32_t lodIdx{}; lodIdx < header.lodCount; ++lodIdx)
+		{
+			MeshLod lod{};
+			std::memcpy(&lod, pfileData + static_cast<size_t>(header.lodsOffset) + static_cast<size_t>(lodIdx) * sizeof(MeshLod), sizeof(MeshLod));
+			if (lod.indexCount % 3 != 0 || lod.indexOffset > header.indexCount || lod.indexCount > header.indexCount - lod.indexOffset)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool IsValidHeader(const MeshCache::Header& header, uint64_t fileSize)
+	{
+		if (header.magic != MeshCache::MAGIC || header.version != MeshCache::VERSION || header.headerSize != sizeof(MeshCache::Header) || header.sectionAlignment != MeshCache::SECTION_ALIGNMENT)
+			return false;
+
+		if (header.fileSize != fileSize || header.vertexCount > (std::numeric_limits<uint32_t>::max)())
+			return false;
+
+		return IsSectionInFile(header.verticesOffset, header.vertexCount, sizeof(MeshVertex), fileSize)
+			&& IsSectionInFile(header.uvsOffset, header.vertexCount, sizeof(DirectX::XMFLOAT2), fileSize)
+			&& IsSectionInFile(header.indicesOffset, header.indexCount, sizeof(uint32_t), fileSize)
+			&& IsSectionInFile(header.lodsOffset, header.lodCount, sizeof(MeshLod), fileSize);
+	}
+
+	template<typename ELEMENT_TYPE>
+	void CopySection(const char* pfileData, uint64_t offset, uint64_t count, std::vector<ELEMENT_TYPE>& output)
+	{
+		output.resize(static_cast<size_t>(count));
+		if (count > 0)
+			std::memcpy(std::data(output), pfileData + static_cast<size_t>(offset), static_cast<size_t>(count) * sizeof(ELEMENT_TYPE));
+	}
+}
+
+std::wstring MeshCache::GetCachePath(const std::wstring& sourcePath)
+{
+	return std::filesystem::path{ sourcePath }.replace_extension(L".meshbin").wstring();
+}
+
+bool MeshCache::Write(const std::wstring& cachePath, const std::wstring& sourcePath, const MeshData& meshData, uint32_t flags)
+{
+	const uint64_t vertexCount{ std::size(meshData.vertices) };
+	if (std::size(meshData.uvs) != vertexCount)
+	{
+		ConsoleLog::GetStream() << L"Error: Mesh cache \"" << cachePath << L"\" needs one uv per vertex.\n";
+		return false;
+	}
+
+	Header header{};
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.headerSize = sizeof(Header);
+	header.sectionAlignment = SECTION_ALIGNMENT;
+	header.flags = flags;
+	header.vertexCount = vertexCount;
+	header.indexCount = std::size(meshData.indices);
+	header.lodCount = static_cast<uint32_t>(std::size(meshData.lods));
+
+	header.verticesOffset = AlignSection(sizeof(Header));
+	header.uvsOffset = AlignSection(header.verticesOffset + vertexCount * sizeof(MeshVertex));
+	header.indicesOffset = AlignSection(header.uvsOffset + vertexCount * sizeof(DirectX::XMFLOAT2));
+	header.lodsOffset = AlignSection(header.indicesOffset + header.indexCount * sizeof(uint32_t));
+	header.fileSize = AlignSection(header.lodsOffset + header.lodCount * sizeof(MeshLod));
+
+	if (!GetSourceInfo(sourcePath, header.sourceSize, header.sourceWriteTime))
+	{
+		header.sourceSize = 0;
+		header.sourceWriteTime = 0;
+	}
+
+	if (vertexCount > 0)
+	{
+		header.boundsMin = meshData.vertices[0].position;
+		header.boundsMax = meshData.vertices[0].position;
+	}
+
+	for (const MeshVertex& vertex : meshData.vertices)
+	{
+		const DirectX::XMFLOAT3& position{ vertex.position };
+		header.boundsMin = DirectX::XMFLOAT3{ (std::min)(header.boundsMin.x, position.x), (std::min)(header.boundsMin.y, position.y), (std::min)(header.boundsMin.z, position.z) };
+		header.boundsMax = DirectX::XMFLOAT3{ (std::max)(header.boundsMax.x, position.x), (std::max)(header.boundsMax.y, position.y), (std::max)(header.boundsMax.z, position.z) };
+	}
+
+	// Assemble the file in memory so the hash covers the padding bytes too
+	std::vector<char> fileData(static_cast<size_t>(header.fileSize), 0);
+	if (vertexCount > 0)
+	{
+		std::memcpy(std::data(fileData) + static_cast<size_t>(header.verticesOffset), std::data(meshData.vertices), static_cast<size_t>(vertexCount) * sizeof(MeshVertex));
+		std::memcpy(std::data(fileData) + static_cast<size_t>(header.uvsOffset), std::data(meshData.uvs), static_cast<size_t>(vertexCount) * sizeof(DirectX::XMFLOAT2));
+	}
+
+	if (header.indexCount > 0)
+		std::memcpy(std::data(fileData) + static_cast<size_t>(header.indicesOffset), std::data(meshData.indices), static_cast<size_t>(header.indexCount) * sizeof(uint32_t));
+
+	if (header.lodCount > 0)
+		std::memcpy(std::data(fileData) + static_cast<size_t>(header.lodsOffset), std::data(meshData.lods), static_cast<size_t>(header.lodCount) * sizeof(MeshLod));
+
+	header.contentHash = HashContent(std::data(fileData) + sizeof(Header), std::size(fileData) - sizeof(Header));
+	std::memcpy(std::data(fileData), &header, sizeof(Header));
+
+	const std::filesystem::path finalPath{ cachePath };
+	std::filesystem::path tempPath{ finalPath };
+	tempPath += L".tmp";
+
+	{
+		std::ofstream cacheFile{ tempPath, std::ios::binary | std::ios::trunc };
+		if (!cacheFile.write(std::data(fileData), static_cast<std::streamsize>(std::size(fileData))))
+		{
+			ConsoleLog::GetStream() << L"Error: Could not write mesh cache \"" << cachePath << L"\".\n";
+			return false;
+		}
+	}
+
+	std::error_code error{};
+	std::filesystem::rename(tempPath, finalPath, error);
+	if (error)
+	{
+		std::filesystem::remove(tempPath, error);
+		ConsoleLog::GetStream() << L"Error: Could not replace mesh cache \"" << cachePath << L"\".\n";
+		return false;
+	}
+
+	return true;
+}
+
+bool MeshCache::Load(const std::wstring& cachePath, MeshData& meshData, bool verifyContentHash)
+{
+	const MappedFile cacheFile{ cachePath };
+	if (!cacheFile.IsOpen() || cacheFile.GetSize() < sizeof(Header))
+		return false;
+
+	Header header{};
+	std::memcpy(&header, cacheFile.GetData(), sizeof(Header));
+	if (!IsValidHeader(header, cacheFile.GetSize()) || !IsValidLods(header, cacheFile.GetData()))
+	{
+		ConsoleLog::GetStream() << L"Error: Mesh cache \"" << cachePath << L"\" is invalid or from another version.\n";
+		return false;
+	}
+
+	if (verifyContentHash && HashContent(cacheFile.GetData() + sizeof(Header), cacheFile.GetSize() - sizeof(Header)) != header.contentHash)
+	{
+		ConsoleLog::GetStream() << L"Error: Mesh cache \"" << cachePath << L"\" is corrupt.\n";
+		return false;
+	}
+
+	CopySection(cacheFile.GetData(), header.verticesOffset, header.vertexCount, meshData.vertices);
+	CopySection(cacheFile.GetData(), header.uvsOffset, header.vertexCount, meshData.uvs);
+	CopySection(cacheFile.GetData(), header.indicesOffset, header.indexCount, meshData.indices);
+	CopySection(cacheFile.GetData(), header.lodsOffset, header.lodCount, meshData.lods);
+
+	return true;
+}
+
+bool MeshCache::IsFresh(const std::wstring& cachePath, const std::wstring& sourcePath, uint32_t requiredFlags)
+{
+	std::error_code error{};
+	const uint64_t cacheSize{ std::filesystem::file_size(std::filesystem::path{ cachePath }, error) };
+	if (error || cacheSize < sizeof(Header))
+		return false;
+
+	Header header{};
+	{
+		std::ifstream cacheFile{ std::filesystem::path{ cachePath }, std::ios::binary };
+		if (!cacheFile.read(reinterpret_cast<char*>(&header), sizeof(Header)))
+			return false;
+	}
+
+	if (!IsValidHeader(header, cacheSize) || (header.flags & requiredFlags) != requiredFlags)
+		return false;
+
+	uint64_t sourceSize{};
+	int64_t sourceWriteTime{};
+	if (!GetSourceInfo(sourcePath, sourceSize, sourceWriteTime))
+		return !std::filesystem::exists(std::filesystem::path{ sourcePath }, error);
+
+	return header.sourceSize == sourceSize && header.sourceWriteTime == sourceWriteTime;
+}
+
+bool MeshCache::LoadModel(const std::wstring& objPath, MeshData& meshData, uint32_t flags)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	const std::wstring cachePath{ GetCachePath(objPath) };
+	if (IsFresh(cachePath, objPath, flags))
+	{
+		const Clock::time_point startTime{ Clock::now() };
+		if (Load(cachePath, meshData))
+		{
+			ConsoleLog::GetStream() << L"Loaded \"" << cachePath << L"\": " << meshData.GetVertexCount() << L" vertices, " << meshData.GetIndexCount() << L" indices in "
+				<< std::chrono::duration<double, std::milli>(Clock::now() - startTime).count() << L" ms.\n";
+			return true;
+		}
+	}
+
+	if (!ObjReader::LoadModel(objPath, meshData))
+		return false;
+
+	if (flags & FLAG_OPTIMIZED)
+		MeshOptimizer::Optimize(meshData);
+
+	// After the optimizer, which only knows about a single index range
+	if (flags & FLAG_LODS)
+		MeshSimplifier::GenerateLods(meshData);
+
+	// A failed write only costs the next startup another parse
+	Write(cachePath, objPath, meshData, flags);
+	return true;
+}
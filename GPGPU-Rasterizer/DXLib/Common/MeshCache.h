@@ -0,0 +1,88 @@
+#pragma once
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+
+#include "MeshData.h"
+
+/**
+ * \brief : Versioned binary container for the final, deduplicated MeshData produced by ObjReader.\n
+ * Layout: Header | vertices (MeshVertex) | uvs | indices | lods (MeshLod), every section starting on a SECTION_ALIGNMENT boundary.\n
+ * Loading maps the file once and copies the sections out, nothing is parsed.
+ */
+namespace MeshCache
+{
+	constexpr uint32_t MAGIC{ 0x4843534Du }; // "MSCH"
+	constexpr uint32_t VERSION{ 2 };
+	constexpr uint32_t SECTION_ALIGNMENT{ 64 };
+
+	// Header::flags bits
+	constexpr uint32_t FLAG_OPTIMIZED{ 1u << 0 }; // Buffers went through MeshOptimizer::Optimize
+	constexpr uint32_t FLAG_LODS{ 1u << 1 }; // indices holds the levels of MeshSimplifier::GenerateLods
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t headerSize;
+		uint32_t sectionAlignment;
+
+		uint64_t fileSize;
+		uint64_t vertexCount;
+		uint64_t indexCount;
+
+		uint64_t verticesOffset;
+		uint64_t uvsOffset;
+		uint64_t indicesOffset;
+
+		// Size and last write time of the source file, used to detect a stale cache
+		uint64_t sourceSize;
+		int64_t sourceWriteTime;
+
+		// FNV-1a 64 of every byte following the header
+		uint64_t contentHash;
+
+		DirectX::XMFLOAT3 boundsMin;
+		DirectX::XMFLOAT3 boundsMax;
+
+		uint32_t flags;
+		// Written as 0 by caches without levels of detail, no VERSION bump needed
+		uint32_t lodCount;
+		uint64_t lodsOffset;
+	};
+	static_assert(sizeof(Header) == 128, "MeshCache::Header must stay 128 bytes, bump VERSION when changing the layout");
+
+	/**
+	 * \brief : Path of the cache belonging to a source model, stored next to it with the ".meshbin" extension
+	 */
+	std::wstring GetCachePath(const std::wstring& sourcePath);
+
+	/**
+	 * \brief : Writes meshData to cachePath (through a temporary file, so a partially written cache is never picked up).
+	 * \param sourcePath : Model the buffers were built from, its size and write time are recorded for IsFresh
+	 * \param flags : FLAG_* bits describing how the buffers were processed
+	 * \return : false if the file could not be written
+	 */
+	bool Write(const std::wstring& cachePath, const std::wstring& sourcePath, const MeshData& meshData, uint32_t flags = 0);
+
+	/**
+	 * \brief : Loads a cache written by Write.
+	 * \param verifyContentHash : Rehashes the payload and rejects the file on mismatch, costs a full pass over the data
+	 * \return : false if the file is missing, truncated, from another version or corrupt
+	 */
+	bool Load(const std::wstring& cachePath, MeshData& meshData, bool verifyContentHash = false);
+
+	/**
+	 * \brief : True if cachePath holds a valid cache of the current VERSION whose recorded source size and write time match sourcePath.\n
+	 * A cache whose source file is missing is considered fresh, so caches can be shipped without the models.
+	 * \param requiredFlags : FLAG_* bits the cache must have been written with
+	 */
+	bool IsFresh(const std::wstring& cachePath, const std::wstring& sourcePath, uint32_t requiredFlags = 0);
+
+	/**
+	 * \brief : Loads the model from its cache when it is fresh, otherwise parses it with ObjReader and (re)writes the cache.
+	 * \param flags : FLAG_OPTIMIZED runs MeshOptimizer::Optimize, FLAG_LODS runs MeshSimplifier::GenerateLods before writing the cache.
+	 * A cache missing one of the flags is rebuilt
+	 */
+	bool LoadModel(const std::wstring& objPath, MeshData& meshData, uint32_t flags = 0);
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+/**
+ * \brief : One vertex in the layout the GPU consumes (Vertex_In in the compute shaders, MeshVertex input layout in the hardware path).\n
+ * Position and normal are each padded to 16 bytes so the structured buffer has the HLSL packing.
+ */
+struct MeshVertex
+{
+	DirectX::XMFLOAT3 position;
+	float pad1;
+	DirectX::XMFLOAT3 normal;
+	float pad2;
+};
+static_assert(sizeof(MeshVertex) == 32, "MeshVertex must match Vertex_In");
+
+/**
+ * \brief : Range of MeshData::indices holding one level of detail, all levels share the vertex buffer.
+ */
+struct MeshLod
+{
+	uint32_t indexOffset;
+	uint32_t indexCount;
+	// Quadric error of the level expressed as a distance to the full detail surface, in object space units
+	float error;
+};
+static_assert(sizeof(MeshLod) == 12, "MeshLod is stored as-is in the mesh cache");
+
+/**
+ * \brief : Welded mesh as produced by ObjReader / MeshCache and adopted by the meshes through a move.\n
+ * vertices can be uploaded as-is, uvs are kept in a separate stream (one per vertex) since no shader reads them yet.\n
+ * indices holds every level of detail back to back, described by lods (LOD 0 first). Without lods the whole buffer is LOD 0.
+ */
+struct MeshData
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<DirectX::XMFLOAT2> uvs;
+	std::vector<uint32_t> indices;
+	std::vector<MeshLod> lods;
+
+	uint32_t GetVertexCount() const { return static_cast<uint32_t>(std::size(vertices)); }
+	uint32_t GetIndexCount() const { return static_cast<uint32_t>(std::size(indices)); }
+	uint32_t GetLodCount() const { return std::empty(lods) ? 1u : static_cast<uint32_t>(std::size(lods)); }
+	MeshLod GetLod(uint32_t lodIdx) const { return std::empty(lods) ? MeshLod{ 0, GetIndexCount(), 0.f } : lods[lodIdx]; }
+
+	/**
+	 * \brief : Frees the CPU-side buffers, only the counts of an uploaded mesh are still needed afterwards
+	 */
+	void Release()
+	{
+		std::vector<MeshVertex>{}.swap(vertices);
+		std::vector<DirectX::XMFLOAT2>{}.swap(uvs);
+		std::vector<uint32_t>{}.swap(indices);
+		std::vector<MeshLod>{}.swap(lods);
+	}
+};
@@ -0,0 +1,505 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "ConsoleLog.h"
+
+namespace
+{
+	constexpr uint32_t INVALID_INDEX{ 0xFFFFFFFFu };
+
+	// Forsyth's tuning, the cache is simulated as an LRU larger than the real FIFO so scores stay smooth
+	constexpr uint32_t FORSYTH_CACHE_SIZE{ 32 };
+	constexpr float FORSYTH_CACHE_DECAY_POWER{ 1.5f };
+	constexpr float FORSYTH_LAST_TRI_SCORE{ 0.75f };
+	constexpr float FORSYTH_VALENCE_BOOST_SCALE{ 2.f };
+	constexpr float FORSYTH_VALENCE_BOOST_POWER{ 0.5f };
+
+	float ForsythVertexScore(int32_t cachePos, uint32_t remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+			return -1.f;
+
+		float score{ 0.f };
+		if (cachePos >= 0)
+		{
+			// The 3 vertices of the last triangle get a fixed score so the next triangle does not just reuse the same edge
+			if (cachePos < 3)
+				score = FORSYTH_LAST_TRI_SCORE;
+			else
+			{
+				const float scaler{ 1.f / (FORSYTH_CACHE_SIZE - 3) };
+				score = std::pow(1.f - static_cast<float>(cachePos - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+			}
+		}
+
+		// Boost vertices with few triangles left so lone triangles are not left behind
+		return score + FORSYTH_VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -FORSYTH_VALENCE_BOOST_POWER);
+	}
+
+	// FIFO cache simulated with insertion timestamps, a vertex is cached while fewer than cacheSize vertices were inserted after it
+	class FifoCache
+	{
+	public:
+		FifoCache(uint32_t vertexCount, uint32_t cacheSize)
+			: m_Timestamps(vertexCount, 0)
+			, m_CacheSize{ cacheSize }
+			, m_Time{ cacheSize + 1 }
+		{}
+
+		uint32_t Access(uint32_t vIdx)
+		{
+			if (m_Time - m_Timestamps[vIdx] > m_CacheSize)
+			{
+				m_Timestamps[vIdx] = m_Time++;
+				return 1;
+			}
+
+			return 0;
+		}
+
+		void Reset() { m_Time += m_CacheSize + 1; }
+
+	private:
+		std::vector<uint32_t> m_Timestamps;
+		uint32_t m_CacheSize;
+		uint32_t m_Time;
+	};
+
+	DirectX::XMFLOAT3 Subtract(const DirectX::XMFLOAT3& lhs, const DirectX::XMFLOAT3& rhs)
+	{
+		return DirectX::XMFLOAT3{ lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z };
+	}
+
+	DirectX::XMFLOAT3 Cross(const DirectX::XMFLOAT3& lhs, const DirectX::XMFLOAT3& rhs)
+	{
+		return DirectX::XMFLOAT3{ lhs.y * rhs.z - lhs.z * rhs.y, lhs.z * rhs.x - lhs.x * rhs.z, lhs.x * rhs.y - lhs.y * rhs.x };
+	}
+
+	float Dot(const DirectX::XMFLOAT3& lhs, const DirectX::XMFLOAT3& rhs)
+	{
+		return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+	}
+
+	float Component(const DirectX::XMFLOAT3& vector, uint32_t axis)
+	{
+		return axis == 0 ? vector.x : (axis == 1 ? vector.y : vector.z);
+	}
+
+	void RasterizeOverdraw(const float* px, const float* py, const float* pz, std::vector<float>& depthBuffer, uint64_t& shadedPixels)
+	{
+		const float area{ (px[1] - px[0]) * (py[2] - py[0]) - (py[1] - py[0]) * (px[2] - px[0]) };
+		// Back facing or degenerate from this side
+		if (area <= 0.f)
+			return;
+
+		const int32_t gridSize{ static_cast<int32_t>(MeshOptimizer::OVERDRAW_GRID_SIZE) };
+		const int32_t minX{ (std::max)(0, static_cast<int32_t>(std::floor((std::min)({ px[0], px[1], px[2] })))) };
+		const int32_t maxX{ (std::min)(gridSize - 1, static_cast<int32_t>(std::ceil((std::max)({ px[0], px[1], px[2] })))) };
+		const int32_t minY{ (std::max)(0, static_cast<int32_t>(std::floor((std::min)({ py[0], py[1], py[2] })))) };
+		const int32_t maxY{ (std::min)(gridSize - 1, static_cast<int32_t>(std::ceil((std::max)({ py[0], py[1], py[2] })))) };
+
+		const float invArea{ 1.f / area };
+		for (int32_t y{ minY }; y <= maxY; ++y)
+		{
+			const float sampleY{ static_cast<float>(y) + 0.5f };
+			for (int32_t x{ minX }; x <= maxX; ++x)
+			{
+				const float sampleX{ static_cast<float>(x) + 0.5f };
+				const float w0{ (px[2] - px[1]) * (sampleY - py[1]) - (py[2] - py[1]) * (sampleX - px[1]) };
+				const float w1{ (px[0] - px[2]) * (sampleY - py[2]) - (py[0] - py[2]) * (sampleX - px[2]) };
+				const float w2{ (px[1] - px[0]) * (sampleY - py[0]) - (py[1] - py[0]) * (sampleX - px[0]) };
+				if (w0 < 0.f || w1 < 0.f || w2 < 0.f)
+					continue;
+
+				const float depth{ (w0 * pz[0] + w1 * pz[1] + w2 * pz[2]) * invArea };
+				float& storedDepth{ depthBuffer[static_cast<size_t>(y) * gridSize + x] };
+				if (depth < storedDepth)
+				{
+					storedDepth = depth;
+					++shadedPixels;
+				}
+			}
+		}
+	}
+}
+
+float MeshOptimizer::ComputeACMR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+	const size_t triangleCount{ std::size(indices) / 3 };
+	if (triangleCount == 0)
+		return 0.f;
+
+	FifoCache cache{ vertexCount, cacheSize };
+	uint64_t misses{};
+	for (size_t idx{}; idx < triangleCount * 3; ++idx)
+		misses += cache.Access(indices[idx]);
+
+	return static_cast<float>(misses) / static_cast<float>(triangleCount);
+}
+
+float MeshOptimizer::EstimateOverdraw(const std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices)
+{
+	const size_t triangleCount{ std::size(indices) / 3 };
+	if (triangleCount == 0 || std::empty(vertices))
+		return 1.f;
+
+	DirectX::XMFLOAT3 boundsMin{ vertices[0].position };
+	DirectX::XMFLOAT3 boundsMax{ vertices[0].position };
+	for (const MeshVertex& vertex : vertices)
+	{
+		boundsMin = DirectX::XMFLOAT3{ (std::min)(boundsMin.x, vertex.position.x), (std::min)(boundsMin.y, vertex.position.y), (std::min)(boundsMin.z, vertex.position.z) };
+		boundsMax = DirectX::XMFLOAT3{ (std::max)(boundsMax.x, vertex.position.x), (std::max)(boundsMax.y, vertex.position.y), (std::max)(boundsMax.z, vertex.position.z) };
+	}
+
+	const DirectX::XMFLOAT3 extents{ Subtract(boundsMax, boundsMin) };
+	const float maxExtent{ (std::max)({ extents.x, extents.y, extents.z }) };
+	if (maxExtent <= 0.f)
+		return 1.f;
+
+	const float toGrid{ (OVERDRAW_GRID_SIZE - 1) / maxExtent };
+
+	std::vector<float> depthBuffer(static_cast<size_t>(OVERDRAW_GRID_SIZE) * OVERDRAW_GRID_SIZE);
+	uint64_t shadedPixels{};
+	uint64_t coveredPixels{};
+
+	for (uint32_t axis{}; axis < 3; ++axis)
+	{
+		const uint32_t axisU{ (axis + 1) % 3 };
+		const uint32_t axisV{ (axis + 2) % 3 };
+
+		// Counter-clockwise (u, v) triangles face +axis, so the first view looks down -axis from the + side.
+		// The second view mirrors u, which flips the winding, and looks down +axis from the - side.
+		for (uint32_t side{}; side < 2; ++side)
+		{
+			const float direction{ side == 0 ? -1.f : 1.f };
+			std::fill(std::begin(depthBuffer), std::end(depthBuffer), (std::numeric_limits<float>::max)());
+
+			for (size_t triIdx{}; triIdx < triangleCount; ++triIdx)
+			{
+				float px[3], py[3], pz[3];
+				for (int corner{}; corner < 3; ++corner)
+				{
+					const DirectX::XMFLOAT3& position{ vertices[indices[triIdx * 3 + corner]].position };
+					const float u{ (Component(position, axisU) - Component(boundsMin, axisU)) * toGrid };
+					px[corner] = side == 0 ? u : (OVERDRAW_GRID_SIZE - 1) - u;
+					py[corner] = (Component(position, axisV) - Component(boundsMin, axisV)) * toGrid;
+					pz[corner] = direction * Component(position, axis);
+				}
+
+				RasterizeOverdraw(px, py, pz, depthBuffer, shadedPixels);
+			}
+
+			coveredPixels += std::count_if(std::cbegin(depthBuffer), std::cend(depthBuffer), [](float depth) { return depth != (std::numeric_limits<float>::max)(); });
+		}
+	}
+
+	return coveredPixels > 0 ? static_cast<float>(shadedPixels) / static_cast<float>(coveredPixels) : 1.f;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+	const uint32_t triangleCount{ static_cast<uint32_t>(std::size(indices) / 3) };
+	if (triangleCount == 0)
+		return;
+
+	// Vertex -> triangles adjacency, the live part of each list shrinks as triangles are emitted
+	std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+	for (uint32_t idx{}; idx < triangleCount * 3; ++idx)
+		++remainingTriangles[indices[idx]];
+
+	std::vector<uint32_t> adjacencyOffsets(static_cast<size_t>(vertexCount) + 1, 0);
+	for (uint32_t vIdx{}; vIdx < vertexCount; ++vIdx)
+		adjacencyOffsets[vIdx + 1] = adjacencyOffsets[vIdx] + remainingTriangles[vIdx];
+
+	std::vector<uint32_t> adjacency(static_cast<size_t>(triangleCount) * 3);
+	{
+		std::vector<uint32_t> fillCounts(vertexCount, 0);
+		for (uint32_t idx{}; idx < triangleCount * 3; ++idx)
+		{
+			const uint32_t vIdx{ indices[idx] };
+			adjacency[adjacencyOffsets[vIdx] + fillCounts[vIdx]++] = idx / 3;
+		}
+	}
+
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (uint32_t vIdx{}; vIdx < vertexCount; ++vIdx)
+		vertexScores[vIdx] = ForsythVertexScore(-1, remainingTriangles[vIdx]);
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<uint8_t> isEmitted(triangleCount, 0);
+	uint32_t bestTriangle{ 0 };
+	for (uint32_t triIdx{}; triIdx < triangleCount; ++triIdx)
+	{
+		triangleScores[triIdx] = vertexScores[indices[triIdx * 3]] + vertexScores[indices[triIdx * 3 + 1]] + vertexScores[indices[triIdx * 3 + 2]];
+		if (triangleScores[triIdx] > triangleScores[bestTriangle])
+			bestTriangle = triIdx;
+	}
+
+	std::vector<uint32_t> output{};
+	output.reserve(static_cast<size_t>(triangleCount) * 3);
+
+	std::vector<uint32_t> cache{};
+	std::vector<uint32_t> newCache{};
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+	uint32_t nextUnemitted{ 0 };
+	for (uint32_t emittedCount{}; emittedCount < triangleCount; ++emittedCount)
+	{
+		// No candidate around the cache, continue with the next triangle in input order
+		if (bestTriangle == INVALID_INDEX)
+		{
+			while (isEmitted[nextUnemitted])
+				++nextUnemitted;
+
+			bestTriangle = nextUnemitted;
+		}
+
+		const uint32_t triVertices[3]{ indices[bestTriangle * 3], indices[bestTriangle * 3 + 1], indices[bestTriangle * 3 + 2] };
+		output.insert(std::end(output), std::begin(triVertices), std::end(triVertices));
+		isEmitted[bestTriangle] = 1;
+
+		for (uint32_t vIdx : triVertices)
+		{
+			uint32_t* padjacency{ &adjacency[adjacencyOffsets[vIdx]] };
+			uint32_t& remaining{ remainingTriangles[vIdx] };
+			for (uint32_t adjIdx{}; adjIdx < remaining; ++adjIdx)
+			{
+				if (padjacency[adjIdx] == bestTriangle)
+				{
+					padjacency[adjIdx] = padjacency[remaining - 1];
+					--remaining;
+					break;
+				}
+			}
+		}
+
+		// Move the triangle's vertices to the front of the LRU cache
+		newCache.clear();
+		for (uint32_t vIdx : triVertices)
+			if (std::find(std::begin(newCache), std::end(newCache), vIdx) == std::end(newCache))
+				newCache.push_back(vIdx);
+
+		for (uint32_t vIdx : cache)
+			if (vIdx != triVertices[0] && vIdx != triVertices[1] && vIdx != triVertices[2])
+				newCache.push_back(vIdx);
+
+		for (size_t cacheIdx{}; cacheIdx < std::size(newCache); ++cacheIdx)
+		{
+			const uint32_t vIdx{ newCache[cacheIdx] };
+			cachePositions[vIdx] = cacheIdx < FORSYTH_CACHE_SIZE ? static_cast<int32_t>(cacheIdx) : -1;
+			vertexScores[vIdx] = ForsythVertexScore(cachePositions[vIdx], remainingTriangles[vIdx]);
+		}
+
+		// Rescore the triangles touching the cache (and the vertices that just fell out of it), the best one is emitted next
+		bestTriangle = INVALID_INDEX;
+		float bestScore{ -1.f };
+		for (size_t cacheIdx{}; cacheIdx < std::size(newCache); ++cacheIdx)
+		{
+			const uint32_t vIdx{ newCache[cacheIdx] };
+			const uint32_t* padjacency{ &adjacency[adjacencyOffsets[vIdx]] };
+			for (uint32_t adjIdx{}; adjIdx < remainingTriangles[vIdx]; ++adjIdx)
+			{
+				const uint32_t triIdx{ padjacency[adjIdx] };
+				const float score{ vertexScores[indices[triIdx * 3]] + vertexScores[indices[triIdx * 3 + 1]] + vertexScores[indices[triIdx * 3 + 2]] };
+				triangleScores[triIdx] = score;
+
+				if (cacheIdx < FORSYTH_CACHE_SIZE && score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = triIdx;
+				}
+			}
+		}
+
+		if (std::size(newCache) > FORSYTH_CACHE_SIZE)
+			newCache.resize(FORSYTH_CACHE_SIZE);
+
+		std::swap(cache, newCache);
+	}
+
+	indices = std::move(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, float threshold)
+{
+	const uint32_t triangleCount{ static_cast<uint32_t>(std::size(indices) / 3) };
+	const uint32_t vertexCount{ static_cast<uint32_t>(std::size(vertices)) };
+	if (triangleCount == 0)
+		return;
+
+	const auto triangleMisses{ [&indices](FifoCache& cache, uint32_t triIdx)
+		{
+			return cache.Access(indices[triIdx * 3]) + cache.Access(indices[triIdx * 3 + 1]) + cache.Access(indices[triIdx * 3 + 2]);
+		} };
+
+	// Hard boundaries: triangles missing all of their vertices start a new strip of reuse anyway
+	std::vector<uint32_t> hardClusters{};
+	{
+		FifoCache cache{ vertexCount, ACMR_CACHE_SIZE };
+		for (uint32_t triIdx{}; triIdx < triangleCount; ++triIdx)
+			if (triangleMisses(cache, triIdx) == 3 || triIdx == 0)
+				hardClusters.push_back(triIdx);
+	}
+	hardClusters.push_back(triangleCount);
+
+	// Soft boundaries: split a cluster again wherever its ACMR so far stays within threshold of the whole cluster's ACMR
+	std::vector<uint32_t> clusters{};
+	{
+		FifoCache cache{ vertexCount, ACMR_CACHE_SIZE };
+		for (size_t clusterIdx{}; clusterIdx + 1 < std::size(hardClusters); ++clusterIdx)
+		{
+			const uint32_t start{ hardClusters[clusterIdx] };
+			const uint32_t end{ hardClusters[clusterIdx + 1] };
+
+			cache.Reset();
+			uint32_t clusterMisses{};
+			for (uint32_t triIdx{ start }; triIdx < end; ++triIdx)
+				clusterMisses += triangleMisses(cache, triIdx);
+
+			const float clusterThreshold{ threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start) };
+
+			cache.Reset();
+			clusters.push_back(start);
+			uint32_t subStart{ start };
+			uint32_t subMisses{};
+			for (uint32_t triIdx{ start }; triIdx < end; ++triIdx)
+			{
+				subMisses += triangleMisses(cache, triIdx);
+				if (triIdx + 1 < end && static_cast<float>(subMisses) / static_cast<float>(triIdx + 1 - subStart) <= clusterThreshold)
+				{
+					clusters.push_back(triIdx + 1);
+					subStart = triIdx + 1;
+					subMisses = 0;
+					cache.Reset();
+				}
+			}
+		}
+	}
+	clusters.push_back(triangleCount);
+
+	// Sort key: how much the cluster faces away from the mesh center, outer shells are drawn first and occlude the rest
+	const size_t clusterCount{ std::size(clusters) - 1 };
+	std::vector<DirectX::XMFLOAT3> clusterCentroids(clusterCount);
+	std::vector<DirectX::XMFLOAT3> clusterNormals(clusterCount);
+	DirectX::XMFLOAT3 meshCentroid{};
+	float meshArea{};
+
+	for (size_t clusterIdx{}; clusterIdx < clusterCount; ++clusterIdx)
+	{
+		DirectX::XMFLOAT3 centroid{};
+		DirectX::XMFLOAT3 normal{};
+		float clusterArea{};
+
+		for (uint32_t triIdx{ clusters[clusterIdx] }; triIdx < clusters[clusterIdx + 1]; ++triIdx)
+		{
+			const DirectX::XMFLOAT3& p0{ vertices[indices[triIdx * 3]].position };
+			const DirectX::XMFLOAT3& p1{ vertices[indices[triIdx * 3 + 1]].position };
+			const DirectX::XMFLOAT3& p2{ vertices[indices[triIdx * 3 + 2]].position };
+
+			const DirectX::XMFLOAT3 faceNormal{ Cross(Subtract(p1, p0), Subtract(p2, p0)) };
+			const float area{ std::sqrt(Dot(faceNormal, faceNormal)) };
+
+			centroid.x += (p0.x + p1.x + p2.x) * area;
+			centroid.y += (p0.y + p1.y + p2.y) * area;
+			centroid.z += (p0.z + p1.z + p2.z) * area;
+			normal.x += faceNormal.x;
+			normal.y += faceNormal.y;
+			normal.z += faceNormal.z;
+			clusterArea += area;
+		}
+
+		meshCentroid.x += centroid.x;
+		meshCentroid.y += centroid.y;
+		meshCentroid.z += centroid.z;
+		meshArea += clusterArea;
+
+		const float invClusterArea{ clusterArea > 0.f ? 1.f / (3.f * clusterArea) : 0.f };
+		clusterCentroids[clusterIdx] = DirectX::XMFLOAT3{ centroid.x * invClusterArea, centroid.y * invClusterArea, centroid.z * invClusterArea };
+
+		const float normalLength{ std::sqrt(Dot(normal, normal)) };
+		const float invNormalLength{ normalLength > 0.f ? 1.f / normalLength : 0.f };
+		clusterNormals[clusterIdx] = DirectX::XMFLOAT3{ normal.x * invNormalLength, normal.y * invNormalLength, normal.z * invNormalLength };
+	}
+
+	const float invMeshArea{ meshArea > 0.f ? 1.f / (3.f * meshArea) : 0.f };
+	meshCentroid = DirectX::XMFLOAT3{ meshCentroid.x * invMeshArea, meshCentroid.y * invMeshArea, meshCentroid.z * invMeshArea };
+
+	std::vector<float> sortKeys(clusterCount);
+	for (size_t clusterIdx{}; clusterIdx < clusterCount; ++clusterIdx)
+		sortKeys[clusterIdx] = Dot(Subtract(clusterCentroids[clusterIdx], meshCentroid), clusterNormals[clusterIdx]);
+
+	std::vector<uint32_t> clusterOrder(clusterCount);
+	std::iota(std::begin(clusterOrder), std::end(clusterOrder), 0u);
+	std::stable_sort(std::begin(clusterOrder), std::end(clusterOrder), [&sortKeys](uint32_t lhs, uint32_t rhs) { return sortKeys[lhs] > sortKeys[rhs]; });
+
+	std::vector<uint32_t> output{};
+	output.reserve(std::size(indices));
+	for (uint32_t clusterIdx : clusterOrder)
+		output.insert(std::end(output), std::begin(indices) + static_cast<size_t>(clusters[clusterIdx]) * 3, std::begin(indices) + static_cast<size_t>(clusters[clusterIdx + 1]) * 3);
+
+	indices = std::move(output);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(MeshData& meshData)
+{
+	const uint32_t vertexCount{ meshData.GetVertexCount() };
+	const bool hasUvs{ std::size(meshData.uvs) == vertexCount };
+
+	std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+	std::vector<MeshVertex> vertices{};
+	std::vector<DirectX::XMFLOAT2> uvs{};
+	vertices.reserve(vertexCount);
+	if (hasUvs)
+		uvs.reserve(vertexCount);
+
+	// Vertices no triangle references are dropped
+	for (uint32_t& index : meshData.indices)
+	{
+		if (remap[index] == INVALID_INDEX)
+		{
+			remap[index] = static_cast<uint32_t>(std::size(vertices));
+			vertices.push_back(meshData.vertices[index]);
+			if (hasUvs)
+				uvs.push_back(meshData.uvs[index]);
+		}
+
+		index = remap[index];
+	}
+
+	meshData.vertices = std::move(vertices);
+	if (hasUvs)
+		meshData.uvs = std::move(uvs);
+}
+
+MeshOptimizer::OptimizeStats MeshOptimizer::Optimize(MeshData& meshData, float overdrawThreshold)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	OptimizeStats stats{};
+	stats.acmrBefore = ComputeACMR(meshData.indices, meshData.GetVertexCount());
+	stats.overdrawBefore = EstimateOverdraw(meshData.indices, meshData.vertices);
+
+	const Clock::time_point startTime{ Clock::now() };
+
+	OptimizeVertexCache(meshData.indices, meshData.GetVertexCount());
+	OptimizeOverdraw(meshData.indices, meshData.vertices, overdrawThreshold);
+	OptimizeVertexFetch(meshData);
+
+	stats.optimizeMs = std::chrono::duration<double, std::milli>(Clock::now() - startTime).count();
+
+	stats.acmrAfter = ComputeACMR(meshData.indices, meshData.GetVertexCount());
+	stats.overdrawAfter = EstimateOverdraw(meshData.indices, meshData.vertices);
+
+	ConsoleLog::GetStream() << L"Optimized mesh in " << stats.optimizeMs << L" ms: ACMR " << stats.acmrBefore << L" -> " << stats.acmrAfter
+		<< L", overdraw " << stats.overdrawBefore << L" -> " << stats.overdrawAfter << L".\n";
+
+	return stats;
+}
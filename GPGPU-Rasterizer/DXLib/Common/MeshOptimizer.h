@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+
+#include "MeshData.h"
+
+/**
+ * \brief : Load-time reordering of a triangle list for the post-transform vertex cache, overdraw and vertex fetch locality.\n
+ * None of the passes changes the rendered surface, only the order in which triangles and vertices are stored.
+ */
+namespace MeshOptimizer
+{
+	// FIFO size used to measure ACMR, close to the post-transform cache of current GPUs
+	constexpr uint32_t ACMR_CACHE_SIZE{ 16 };
+	// Resolution of the orthographic views used to estimate overdraw
+	constexpr uint32_t OVERDRAW_GRID_SIZE{ 256 };
+
+	struct OptimizeStats
+	{
+		float acmrBefore{};
+		float acmrAfter{};
+		float overdrawBefore{};
+		float overdrawAfter{};
+		double optimizeMs{};
+	};
+
+	/**
+	 * \brief : Average cache miss ratio, the number of vertex transforms per triangle with a FIFO cache of cacheSize entries (0.5 is ideal, 3 is worst)
+	 */
+	float ComputeACMR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = ACMR_CACHE_SIZE);
+
+	/**
+	 * \brief : Shaded pixels divided by visible pixels, rasterizing the mesh in index order from the 6 axis directions with a depth test (1 is no overdraw)
+	 */
+	float EstimateOverdraw(const std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices);
+
+	/**
+	 * \brief : Reorders the triangles for vertex reuse with Forsyth's linear-speed vertex cache optimization
+	 */
+	void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+	/**
+	 * \brief : Splits a vertex cache optimized triangle list into clusters and sorts them front to back from a view independent point of view (Sander et al. 2007).
+	 * \param threshold : Maximum ACMR degradation allowed to create smaller clusters, 1.05 allows 5% more cache misses
+	 */
+	void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, float threshold = 1.05f);
+
+	/**
+	 * \brief : Stores the vertices (and uvs) in the order the index buffer first references them and remaps the indices
+	 */
+	void OptimizeVertexFetch(MeshData& meshData);
+
+	/**
+	 * \brief : Runs the vertex cache, overdraw and vertex fetch passes in that order and prints ACMR and overdraw before and after.
+	 */
+	OptimizeStats Optimize(MeshData& meshData, float overdrawThreshold = 1.05f);
+};
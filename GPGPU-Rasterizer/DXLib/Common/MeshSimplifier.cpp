@@ -0,0 +1,504 @@
+#include "pch.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "ConsoleLog.h"
+#include "MeshOptimizer.h"
+
+namespace
+{
+	// Open borders get a plane perpendicular to their face, weighted higher than the faces so they do not shrink
+	constexpr double BORDER_WEIGHT{ 10.0 };
+	// A collapse is refused when it rotates a neighbouring triangle by more than ~75 degrees (cos = 0.25)
+	constexpr double MAX_NORMAL_ROTATION_COS{ 0.25 };
+	// Collapses of a pass may cost this much more than the cheapest collapseGoal ones (squared distances)
+	constexpr double PASS_COST_SLACK{ 2.25 };
+	// A level is dropped when it keeps more than 90% of the previous one
+	constexpr uint32_t MIN_LOD_REDUCTION_PERCENT{ 10 };
+
+	struct Vector3
+	{
+		double x, y, z;
+	};
+
+	Vector3 ToVector3(const DirectX::XMFLOAT3& vector)
+	{
+		return Vector3{ vector.x, vector.y, vector.z };
+	}
+
+	Vector3 Subtract(const Vector3& lhs, const Vector3& rhs)
+	{
+		return Vector3{ lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z };
+	}
+
+	Vector3 Cross(const Vector3& lhs, const Vector3& rhs)
+	{
+		return Vector3{ lhs.y * rhs.z - lhs.z * rhs.y, lhs.z * rhs.x - lhs.x * rhs.z, lhs.x * rhs.y - lhs.y * rhs.x };
+	}
+
+	double Dot(const Vector3& lhs, const Vector3& rhs)
+	{
+		return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+	}
+
+	// Sum of squared distances to a set of planes, each plane weighted (by area for faces)
+	struct Quadric
+	{
+		double a2, b2, c2, d2, ab, ac, ad, bc, bd, cd;
+		double weight;
+
+		static Quadric FromPlane(const Vector3& normal, double d, double weight)
+		{
+			return Quadric{ normal.x * normal.x * weight, normal.y * normal.y * weight, normal.z * normal.z * weight, d * d * weight
+				, normal.x * normal.y * weight, normal.x * normal.z * weight, normal.x * d * weight
+				, normal.y * normal.z * weight, normal.y * d * weight, normal.z * d * weight, weight };
+		}
+
+		void Add(const Quadric& other)
+		{
+			a2 += other.a2; b2 += other.b2; c2 += other.c2; d2 += other.d2;
+			ab += other.ab; ac += other.ac; ad += other.ad;
+			bc += other.bc; bd += other.bd; cd += other.cd;
+			weight += other.weight;
+		}
+
+		double Evaluate(const Vector3& p) const
+		{
+			const double error{ a2 * p.x * p.x + b2 * p.y * p.y + c2 * p.z * p.z + d2
+				+ 2.0 * (ab * p.x * p.y + ac * p.x * p.z + ad * p.x + bc * p.y * p.z + bd * p.y + cd * p.z) };
+			return (std::max)(error, 0.0);
+		}
+	};
+
+	struct Collapse
+	{
+		double cost;
+		uint32_t from;
+		uint32_t to;
+	};
+
+	/**
+	 * Progressive edge collapse on LOD 0 of a mesh. Vertices sharing a position are welded into one "canonical" vertex for the topology,
+	 * corners keep a real vertex of the target position whose normal and uv are the closest to what they had, so hard edges and uv seams survive.
+	 */
+	class Simplifier
+	{
+	public:
+		explicit Simplifier(const MeshData& meshData)
+			: m_MeshData{ meshData }
+			, m_Canonical(meshData.GetVertexCount())
+			, m_GroupOffsets(static_cast<size_t>(meshData.GetVertexCount()) + 1, 0)
+			, m_GroupVertices(meshData.GetVertexCount())
+			, m_Quadrics(meshData.GetVertexCount(), Quadric{})
+			, m_Corners{}
+			, m_Locked(meshData.GetVertexCount(), 0)
+			, m_MaxError{ 0.0 }
+		{
+			const MeshLod baseLod{ meshData.GetLod(0) };
+			m_Corners.assign(std::begin(meshData.indices) + baseLod.indexOffset, std::begin(meshData.indices) + baseLod.indexOffset + baseLod.indexCount);
+
+			WeldPositions();
+			InitQuadrics();
+		}
+
+		Simplifier(const Simplifier&) = delete;
+		Simplifier(Simplifier&&) noexcept = delete;
+		Simplifier& operator=(const Simplifier&) = delete;
+		Simplifier& operator=(Simplifier&&) noexcept = delete;
+
+		uint32_t GetTriangleCount() const { return static_cast<uint32_t>(std::size(m_Corners) / 3); }
+		float GetError() const { return static_cast<float>(m_MaxError); }
+		const std::vector<uint32_t>& GetIndices() const { return m_Corners; }
+
+		// Collapses the cheapest edges in passes until at most targetTriangleCount triangles remain or nothing can collapse anymore
+		void Simplify(uint32_t targetTriangleCount)
+		{
+			while (GetTriangleCount() > targetTriangleCount)
+			{
+				BuildAdjacency();
+				const std::vector<Collapse> collapses{ RankCollapses() };
+
+				// Every collapse removes about 2 triangles, do not overshoot the target in one pass
+				const uint32_t collapseGoal{ (GetTriangleCount() - targetTriangleCount) / 2 + 1 };
+				uint32_t collapseCount{ 0 };
+
+				// Locked vertices skip many cheap collapses, so without a limit the pass would reach its goal with far worse ones.
+				// Leave those for a later pass, once the cheaper neighbourhood has been simplified
+				const double costLimit{ collapseGoal < std::size(collapses) ? PASS_COST_SLACK * collapses[collapseGoal].cost : (std::numeric_limits<double>::max)() };
+
+				std::fill(std::begin(m_Locked), std::end(m_Locked), static_cast<uint8_t>(0));
+				for (const Collapse& collapse : collapses)
+				{
+					if (collapseCount >= collapseGoal || collapse.cost > costLimit)
+						break;
+
+					if (m_Locked[collapse.from] || m_Locked[collapse.to] || FlipsTriangle(collapse.from, collapse.to))
+						continue;
+
+					ApplyCollapse(collapse);
+					++collapseCount;
+				}
+
+				if (collapseCount == 0)
+					break;
+
+				RemoveDegenerateTriangles();
+			}
+		}
+
+	private:
+		const MeshData& m_MeshData;
+
+		// Vertex -> lowest vertex with the same position, the canonical vertices carry the quadrics and topology
+		std::vector<uint32_t> m_Canonical;
+		// Canonical vertex -> every vertex at its position
+		std::vector<uint32_t> m_GroupOffsets;
+		std::vector<uint32_t> m_GroupVertices;
+
+		std::vector<Quadric> m_Quadrics;
+		std::vector<uint32_t> m_Corners;
+
+		// Canonical vertex -> live triangles, rebuilt every pass
+		std::vector<uint32_t> m_AdjacencyOffsets;
+		std::vector<uint32_t> m_AdjacencyTriangles;
+		std::vector<uint8_t> m_Locked;
+
+		double m_MaxError;
+
+		uint32_t Canonical(size_t cornerIdx) const { return m_Canonical[m_Corners[cornerIdx]]; }
+		Vector3 Position(uint32_t vIdx) const { return ToVector3(m_MeshData.vertices[vIdx].position); }
+
+		void WeldPositions()
+		{
+			const uint32_t vertexCount{ m_MeshData.GetVertexCount() };
+			std::vector<uint32_t> sorted(vertexCount);
+			std::iota(std::begin(sorted), std::end(sorted), 0u);
+
+			const auto lessPosition{ [this](uint32_t lhs, uint32_t rhs)
+				{
+					const DirectX::XMFLOAT3& lhsPos{ m_MeshData.vertices[lhs].position };
+					const DirectX::XMFLOAT3& rhsPos{ m_MeshData.vertices[rhs].position };
+					if (lhsPos.x != rhsPos.x)
+						return lhsPos.x < rhsPos.x;
+					if (lhsPos.y != rhsPos.y)
+						return lhsPos.y < rhsPos.y;
+					if (lhsPos.z != rhsPos.z)
+						return lhsPos.z < rhsPos.z;
+					return lhs < rhs;
+				} };
+			std::sort(std::begin(sorted), std::end(sorted), lessPosition);
+
+			for (uint32_t sortedIdx{}; sortedIdx < vertexCount; ++sortedIdx)
+			{
+				const uint32_t vIdx{ sorted[sortedIdx] };
+				const bool isSamePosition{ sortedIdx > 0
+					&& m_MeshData.vertices[sorted[sortedIdx - 1]].position.x == m_MeshData.vertices[vIdx].position.x
+					&& m_MeshData.vertices[sorted[sortedIdx - 1]].position.y == m_MeshData.vertices[vIdx].position.y
+					&& m_MeshData.vertices[sorted[sortedIdx - 1]].position.z == m_MeshData.vertices[vIdx].position.z };
+				m_Canonical[vIdx] = isSamePosition ? m_Canonical[sorted[sortedIdx - 1]] : vIdx;
+			}
+
+			for (uint32_t vIdx{}; vIdx < vertexCount; ++vIdx)
+				++m_GroupOffsets[m_Canonical[vIdx] + 1];
+
+			std::partial_sum(std::begin(m_GroupOffsets), std::end(m_GroupOffsets), std::begin(m_GroupOffsets));
+
+			std::vector<uint32_t> groupFill(std::begin(m_GroupOffsets), std::end(m_GroupOffsets) - 1);
+			for (uint32_t vIdx{}; vIdx < vertexCount; ++vIdx)
+				m_GroupVertices[groupFill[m_Canonical[vIdx]]++] = vIdx;
+		}
+
+		void InitQuadrics()
+		{
+			const size_t triangleCount{ std::size(m_Corners) / 3 };
+
+			// Undirected canonical edges, an edge used by a single triangle is on an open border
+			struct Edge
+			{
+				uint64_t key;
+				uint32_t triIdx;
+				uint32_t corner;
+			};
+			std::vector<Edge> edges{};
+			edges.reserve(triangleCount * 3);
+
+			for (size_t triIdx{}; triIdx < triangleCount; ++triIdx)
+			{
+				const uint32_t c0{ Canonical(triIdx * 3) }, c1{ Canonical(triIdx * 3 + 1) }, c2{ Canonical(triIdx * 3 + 2) };
+				const Vector3 p0{ Position(c0) };
+				const Vector3 normal{ Cross(Subtract(Position(c1), p0), Subtract(Position(c2), p0)) };
+				const double length{ std::sqrt(Dot(normal, normal)) };
+				if (length <= 0.0)
+					continue;
+
+				const Vector3 unitNormal{ normal.x / length, normal.y / length, normal.z / length };
+				const Quadric quadric{ Quadric::FromPlane(unitNormal, -Dot(unitNormal, p0), length * 0.5) };
+				m_Quadrics[c0].Add(quadric);
+				m_Quadrics[c1].Add(quadric);
+				m_Quadrics[c2].Add(quadric);
+
+				for (uint32_t corner{}; corner < 3; ++corner)
+				{
+					const uint32_t a{ Canonical(triIdx * 3 + corner) }, b{ Canonical(triIdx * 3 + (corner + 1) % 3) };
+					edges.push_back(Edge{ (static_cast<uint64_t>((std::min)(a, b)) << 32) | (std::max)(a, b), static_cast<uint32_t>(triIdx), corner });
+				}
+			}
+
+			std::sort(std::begin(edges), std::end(edges), [](const Edge& lhs, const Edge& rhs) { return lhs.key < rhs.key; });
+
+			for (size_t edgeIdx{}; edgeIdx < std::size(edges); ++edgeIdx)
+			{
+				const bool isShared{ (edgeIdx > 0 && edges[edgeIdx - 1].key == edges[edgeIdx].key) || (edgeIdx + 1 < std::size(edges) && edges[edgeIdx + 1].key == edges[edgeIdx].key) };
+				if (isShared)
+					continue;
+
+				const Edge& edge{ edges[edgeIdx] };
+				const uint32_t a{ Canonical(static_cast<size_t>(edge.triIdx) * 3 + edge.corner) };
+				const uint32_t b{ Canonical(static_cast<size_t>(edge.triIdx) * 3 + (edge.corner + 1) % 3) };
+				const uint32_t c{ Canonical(static_cast<size_t>(edge.triIdx) * 3 + (edge.corner + 2) % 3) };
+
+				const Vector3 pa{ Position(a) };
+				const Vector3 edgeDir{ Subtract(Position(b), pa) };
+				const Vector3 faceNormal{ Cross(edgeDir, Subtract(Position(c), pa)) };
+				const Vector3 borderNormal{ Cross(edgeDir, faceNormal) };
+				const double length{ std::sqrt(Dot(borderNormal, borderNormal)) };
+				if (length <= 0.0)
+					continue;
+
+				const Vector3 unitNormal{ borderNormal.x / length, borderNormal.y / length, borderNormal.z / length };
+				const Quadric quadric{ Quadric::FromPlane(unitNormal, -Dot(unitNormal, pa), Dot(edgeDir, edgeDir) * BORDER_WEIGHT) };
+				m_Quadrics[a].Add(quadric);
+				m_Quadrics[b].Add(quadric);
+			}
+		}
+
+		void BuildAdjacency()
+		{
+			const size_t triangleCount{ std::size(m_Corners) / 3 };
+			m_AdjacencyOffsets.assign(static_cast<size_t>(m_MeshData.GetVertexCount()) + 1, 0);
+			for (size_t cornerIdx{}; cornerIdx < std::size(m_Corners); ++cornerIdx)
+				++m_AdjacencyOffsets[Canonical(cornerIdx) + 1];
+
+			std::partial_sum(std::begin(m_AdjacencyOffsets), std::end(m_AdjacencyOffsets), std::begin(m_AdjacencyOffsets));
+
+			m_AdjacencyTriangles.resize(std::size(m_Corners));
+			std::vector<uint32_t> fill(std::begin(m_AdjacencyOffsets), std::end(m_AdjacencyOffsets) - 1);
+			for (size_t triIdx{}; triIdx < triangleCount; ++triIdx)
+				for (size_t corner{}; corner < 3; ++corner)
+					m_AdjacencyTriangles[fill[Canonical(triIdx * 3 + corner)]++] = static_cast<uint32_t>(triIdx);
+		}
+
+		std::vector<Collapse> RankCollapses() const
+		{
+			std::vector<uint64_t> edgeKeys{};
+			edgeKeys.reserve(std::size(m_Corners));
+			for (size_t triIdx{}; triIdx < std::size(m_Corners) / 3; ++triIdx)
+			{
+				for (size_t corner{}; corner < 3; ++corner)
+				{
+					const uint32_t a{ Canonical(triIdx * 3 + corner) }, b{ Canonical(triIdx * 3 + (corner + 1) % 3) };
+					edgeKeys.push_back((static_cast<uint64_t>((std::min)(a, b)) << 32) | (std::max)(a, b));
+				}
+			}
+
+			std::sort(std::begin(edgeKeys), std::end(edgeKeys));
+			edgeKeys.erase(std::unique(std::begin(edgeKeys), std::end(edgeKeys)), std::end(edgeKeys));
+
+			std::vector<Collapse> collapses{};
+			collapses.reserve(std::size(edgeKeys));
+			for (uint64_t key : edgeKeys)
+			{
+				const uint32_t a{ static_cast<uint32_t>(key >> 32) }, b{ static_cast<uint32_t>(key & 0xFFFFFFFFu) };
+				Quadric quadric{ m_Quadrics[a] };
+				quadric.Add(m_Quadrics[b]);
+
+				// Normalized by the area the quadric covers, so the cost is a squared distance comparable across the mesh
+				const double weight{ (std::max)(quadric.weight, (std::numeric_limits<double>::min)()) };
+				const double costToA{ quadric.Evaluate(Position(a)) / weight };
+				const double costToB{ quadric.Evaluate(Position(b)) / weight };
+				collapses.push_back(costToA < costToB ? Collapse{ costToA, b, a } : Collapse{ costToB, a, b });
+			}
+
+			std::sort(std::begin(collapses), std::end(collapses), [](const Collapse& lhs, const Collapse& rhs) { return lhs.cost < rhs.cost; });
+			return collapses;
+		}
+
+		bool FlipsTriangle(uint32_t from, uint32_t to) const
+		{
+			const Vector3 target{ Position(to) };
+			for (uint32_t adjIdx{ m_AdjacencyOffsets[from] }; adjIdx < m_AdjacencyOffsets[from + 1]; ++adjIdx)
+			{
+				const size_t triIdx{ m_AdjacencyTriangles[adjIdx] };
+				const uint32_t c[3]{ Canonical(triIdx * 3), Canonical(triIdx * 3 + 1), Canonical(triIdx * 3 + 2) };
+
+				// Triangles on the collapsed edge disappear
+				if (c[0] == to || c[1] == to || c[2] == to)
+					continue;
+
+				Vector3 before[3]{ Position(c[0]), Position(c[1]), Position(c[2]) };
+				Vector3 after[3]{ before[0], before[1], before[2] };
+				for (uint32_t corner{}; corner < 3; ++corner)
+					if (c[corner] == from)
+						after[corner] = target;
+
+				const Vector3 normalBefore{ Cross(Subtract(before[1], before[0]), Subtract(before[2], before[0])) };
+				const Vector3 normalAfter{ Cross(Subtract(after[1], after[0]), Subtract(after[2], after[0])) };
+				if (Dot(normalBefore, normalAfter) <= MAX_NORMAL_ROTATION_COS * std::sqrt(Dot(normalBefore, normalBefore) * Dot(normalAfter, normalAfter)))
+					return true;
+			}
+
+			return false;
+		}
+
+		// Vertex at the canonical position whose attributes are the closest to vIdx
+		uint32_t PickVertex(uint32_t canonical, uint32_t vIdx) const
+		{
+			const bool hasUvs{ std::size(m_MeshData.uvs) == std::size(m_MeshData.vertices) };
+			const DirectX::XMFLOAT3& normal{ m_MeshData.vertices[vIdx].normal };
+
+			uint32_t best{ canonical };
+			float bestDistance{ (std::numeric_limits<float>::max)() };
+			for (uint32_t groupIdx{ m_GroupOffsets[canonical] }; groupIdx < m_GroupOffsets[canonical + 1]; ++groupIdx)
+			{
+				const uint32_t candidate{ m_GroupVertices[groupIdx] };
+				const DirectX::XMFLOAT3& candidateNormal{ m_MeshData.vertices[candidate].normal };
+				float distance{ (normal.x - candidateNormal.x) * (normal.x - candidateNormal.x) + (normal.y - candidateNormal.y) * (normal.y - candidateNormal.y)
+					+ (normal.z - candidateNormal.z) * (normal.z - candidateNormal.z) };
+				if (hasUvs)
+				{
+					const DirectX::XMFLOAT2& uv{ m_MeshData.uvs[vIdx] };
+					const DirectX::XMFLOAT2& candidateUv{ m_MeshData.uvs[candidate] };
+					distance += (uv.x - candidateUv.x) * (uv.x - candidateUv.x) + (uv.y - candidateUv.y) * (uv.y - candidateUv.y);
+				}
+
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = candidate;
+				}
+			}
+
+			return best;
+		}
+
+		void ApplyCollapse(const Collapse& collapse)
+		{
+			// Every triangle around from changes shape, lock their vertices for the rest of the pass so the flip test stays valid
+			for (uint32_t adjIdx{ m_AdjacencyOffsets[collapse.from] }; adjIdx < m_AdjacencyOffsets[collapse.from + 1]; ++adjIdx)
+			{
+				const size_t triIdx{ m_AdjacencyTriangles[adjIdx] };
+				for (size_t corner{}; corner < 3; ++corner)
+				{
+					const size_t cornerIdx{ triIdx * 3 + corner };
+					m_Locked[Canonical(cornerIdx)] = 1;
+					if (Canonical(cornerIdx) == collapse.from)
+						m_Corners[cornerIdx] = PickVertex(collapse.to, m_Corners[cornerIdx]);
+				}
+			}
+
+			m_Quadrics[collapse.to].Add(m_Quadrics[collapse.from]);
+			m_MaxError = (std::max)(m_MaxError, std::sqrt(collapse.cost));
+		}
+
+		void RemoveDegenerateTriangles()
+		{
+			size_t writeIdx{ 0 };
+			for (size_t triIdx{}; triIdx < std::size(m_Corners) / 3; ++triIdx)
+			{
+				const uint32_t c0{ Canonical(triIdx * 3) }, c1{ Canonical(triIdx * 3 + 1) }, c2{ Canonical(triIdx * 3 + 2) };
+				if (c0 == c1 || c1 == c2 || c0 == c2)
+					continue;
+
+				for (size_t corner{}; corner < 3; ++corner)
+					m_Corners[writeIdx * 3 + corner] = m_Corners[triIdx * 3 + corner];
+				++writeIdx;
+			}
+
+			m_Corners.resize(writeIdx * 3);
+		}
+	};
+}
+
+void MeshSimplifier::GenerateLods(MeshData& meshData)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	// Regenerate from LOD 0 only
+	const MeshLod baseLod{ meshData.GetLod(0) };
+	if (baseLod.indexOffset != 0)
+		return;
+
+	meshData.indices.resize(baseLod.indexCount);
+	meshData.lods.assign(1, MeshLod{ 0, baseLod.indexCount, 0.f });
+
+	const uint32_t baseTriangleCount{ baseLod.indexCount / 3 };
+	if (baseTriangleCount == 0)
+		return;
+
+	const Clock::time_point startTime{ Clock::now() };
+
+	Simplifier simplifier{ meshData };
+	uint32_t previousTriangleCount{ baseTriangleCount };
+	for (float ratio : LOD_RATIOS)
+	{
+		simplifier.Simplify(static_cast<uint32_t>(static_cast<float>(baseTriangleCount) * ratio));
+
+		const uint32_t triangleCount{ simplifier.GetTriangleCount() };
+		if (triangleCount == 0 || static_cast<uint64_t>(triangleCount) * 100 > static_cast<uint64_t>(previousTriangleCount) * (100 - MIN_LOD_REDUCTION_PERCENT))
+			break;
+
+		std::vector<uint32_t> lodIndices{ simplifier.GetIndices() };
+		MeshOptimizer::OptimizeVertexCache(lodIndices, meshData.GetVertexCount());
+
+		meshData.lods.push_back(MeshLod{ meshData.GetIndexCount(), static_cast<uint32_t>(std::size(lodIndices)), simplifier.GetError() });
+		meshData.indices.insert(std::end(meshData.indices), std::begin(lodIndices), std::end(lodIndices));
+		previousTriangleCount = triangleCount;
+	}
+
+	ConsoleLog::GetStream() << L"Generated " << std::size(meshData.lods) - 1 << L" LODs in " << std::chrono::duration<double, std::milli>(Clock::now() - startTime).count() << L" ms:";
+	for (const MeshLod& lod : meshData.lods)
+		ConsoleLog::GetStream() << L" " << lod.indexCount / 3 << L" triangles (error " << lod.error << L")";
+	ConsoleLog::GetStream() << L".\n";
+}
+
+uint32_t MeshSimplifier::SelectLod(const std::vector<MeshLod>& lods, float distance, float fovY, float viewportHeight, float maxPixelError)
+{
+	if (distance <= 0.f || std::size(lods) < 2)
+		return 0;
+
+	// Size in pixels of one object space unit at that distance
+	const float pixelsPerUnit{ viewportHeight / (2.f * std::tan(fovY * 0.5f) * distance) };
+
+	uint32_t lodIdx{ 0 };
+	while (lodIdx + 1 < std::size(lods) && lods[lodIdx + 1].error * pixelsPerUnit <= maxPixelError)
+		++lodIdx;
+
+	return lodIdx;
+}
+
+void MeshSimplifier::ComputeBoundingSphere(const std::vector<MeshVertex>& vertices, DirectX::XMFLOAT3& center, float& radius)
+{
+	center = DirectX::XMFLOAT3{};
+	radius = 0.f;
+	if (std::empty(vertices))
+		return;
+
+	DirectX::XMFLOAT3 boundsMin{ vertices[0].position }, boundsMax{ boundsMin };
+	for (const MeshVertex& vertex : vertices)
+	{
+		boundsMin = DirectX::XMFLOAT3{ (std::min)(boundsMin.x, vertex.position.x), (std::min)(boundsMin.y, vertex.position.y), (std::min)(boundsMin.z, vertex.position.z) };
+		boundsMax = DirectX::XMFLOAT3{ (std::max)(boundsMax.x, vertex.position.x), (std::max)(boundsMax.y, vertex.position.y), (std::max)(boundsMax.z, vertex.position.z) };
+	}
+
+	center = DirectX::XMFLOAT3{ (boundsMin.x + boundsMax.x) * 0.5f, (boundsMin.y + boundsMax.y) * 0.5f, (boundsMin.z + boundsMax.z) * 0.5f };
+	for (const MeshVertex& vertex : vertices)
+	{
+		const DirectX::XMFLOAT3 offset{ vertex.position.x - center.x, vertex.position.y - center.y, vertex.position.z - center.z };
+		radius = (std::max)(radius, std::sqrt(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z));
+	}
+}
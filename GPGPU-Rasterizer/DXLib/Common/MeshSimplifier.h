@@ -0,0 +1,36 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+#include "MeshData.h"
+
+/**
+ * \brief : Quadric error metric simplification (Garland & Heckbert 1997) building a chain of index-only levels of detail.\n
+ * Edges collapse onto one of their vertices, so every level reuses the full detail vertex buffer.
+ */
+namespace MeshSimplifier
+{
+	// Triangle count of each generated level relative to the full detail mesh
+	constexpr float LOD_RATIOS[]{ 0.5f, 0.25f, 0.125f };
+	// A level is selected while its error projects to at most this many pixels
+	constexpr float MAX_LOD_PIXEL_ERROR{ 1.f };
+
+	/**
+	 * \brief : Simplifies LOD 0 towards every LOD_RATIOS target and appends the levels to meshData.indices / meshData.lods.\n
+	 * Stops early when the mesh cannot be reduced any further, so a mesh may end up with fewer levels.
+	 */
+	void GenerateLods(MeshData& meshData);
+
+	/**
+	 * \brief : Coarsest level whose error, seen at distance, stays below maxPixelError pixels.
+	 * \param distance : Distance from the camera to the closest point of the mesh bounds
+	 * \param fovY : Vertical field of view in radians
+	 * \param viewportHeight : Height of the render target in pixels
+	 */
+	uint32_t SelectLod(const std::vector<MeshLod>& lods, float distance, float fovY, float viewportHeight, float maxPixelError = MAX_LOD_PIXEL_ERROR);
+
+	/**
+	 * \brief : Sphere around the box of the vertex positions, used to measure the LOD distance.
+	 */
+	void ComputeBoundingSphere(const std::vector<MeshVertex>& vertices, DirectX::XMFLOAT3& center, float& radius);
+};
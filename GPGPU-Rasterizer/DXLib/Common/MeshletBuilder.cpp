@@ -0,0 +1,162 @@
+#include "pch.h"
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	constexpr uint32_t INVALID_MESHLET{ 0xFFFFFFFFu };
+
+	// Below this spread the cone only culls when seen almost exactly from behind, not worth the test
+	constexpr float MIN_CONE_SPREAD{ 0.1f };
+
+	DirectX::XMFLOAT3 Subtract(const DirectX::XMFLOAT3& lhs, const DirectX::XMFLOAT3& rhs)
+	{
+		return DirectX::XMFLOAT3{ lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z };
+	}
+
+	DirectX::XMFLOAT3 Cross(const DirectX::XMFLOAT3& lhs, const DirectX::XMFLOAT3& rhs)
+	{
+		return DirectX::XMFLOAT3{ lhs.y * rhs.z - lhs.z * rhs.y, lhs.z * rhs.x - lhs.x * rhs.z, lhs.x * rhs.y - lhs.y * rhs.x };
+	}
+
+	float Dot(const DirectX::XMFLOAT3& lhs, const DirectX::XMFLOAT3& rhs)
+	{
+		return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+	}
+
+	float Length(const DirectX::XMFLOAT3& vector)
+	{
+		return std::sqrt(Dot(vector, vector));
+	}
+
+	void ComputeBounds(MeshletBuilder::Meshlet& meshlet, const MeshData& meshData)
+	{
+		const std::vector<MeshVertex>& vertices{ meshData.vertices };
+		const uint32_t* pindices{ std::data(meshData.indices) + static_cast<size_t>(meshlet.triangleOffset) * 3 };
+		const uint32_t meshletIndexCount{ meshlet.triangleCount * 3 };
+
+		// Sphere around the box center, a few percent looser than the minimal sphere but good enough for culling
+		DirectX::XMFLOAT3 boundsMin{ vertices[pindices[0]].position }, boundsMax{ boundsMin };
+		for (uint32_t i{ 1 }; i < meshletIndexCount; ++i)
+		{
+			const DirectX::XMFLOAT3& position{ vertices[pindices[i]].position };
+			boundsMin = DirectX::XMFLOAT3{ (std::min)(boundsMin.x, position.x), (std::min)(boundsMin.y, position.y), (std::min)(boundsMin.z, position.z) };
+			boundsMax = DirectX::XMFLOAT3{ (std::max)(boundsMax.x, position.x), (std::max)(boundsMax.y, position.y), (std::max)(boundsMax.z, position.z) };
+		}
+
+		meshlet.center = DirectX::XMFLOAT3{ (boundsMin.x + boundsMax.x) * 0.5f, (boundsMin.y + boundsMax.y) * 0.5f, (boundsMin.z + boundsMax.z) * 0.5f };
+		meshlet.radius = 0.f;
+		for (uint32_t i{}; i < meshletIndexCount; ++i)
+			meshlet.radius = (std::max)(meshlet.radius, Length(Subtract(vertices[pindices[i]].position, meshlet.center)));
+
+		// Normal cone (Shebanow / meshoptimizer): average facing, widest deviation from it, and an apex behind every triangle plane
+		DirectX::XMFLOAT3 normals[MeshletBuilder::MAX_MESHLET_TRIANGLES]{};
+		DirectX::XMFLOAT3 axis{};
+		for (uint32_t triIdx{}; triIdx < meshlet.triangleCount; ++triIdx)
+		{
+			const DirectX::XMFLOAT3& p0{ vertices[pindices[triIdx * 3]].position };
+			const DirectX::XMFLOAT3 normal{ Cross(Subtract(vertices[pindices[triIdx * 3 + 1]].position, p0), Subtract(vertices[pindices[triIdx * 3 + 2]].position, p0)) };
+			const float length{ Length(normal) };
+			if (length <= 0.f)
+				continue;
+
+			normals[triIdx] = DirectX::XMFLOAT3{ normal.x / length, normal.y / length, normal.z / length };
+			axis = DirectX::XMFLOAT3{ axis.x + normals[triIdx].x, axis.y + normals[triIdx].y, axis.z + normals[triIdx].z };
+		}
+
+		meshlet.coneApex = meshlet.center;
+		meshlet.coneAxis = DirectX::XMFLOAT3{};
+		meshlet.coneCutoff = 1.f;
+
+		const float axisLength{ Length(axis) };
+		if (axisLength <= 0.f)
+			return;
+
+		axis = DirectX::XMFLOAT3{ axis.x / axisLength, axis.y / axisLength, axis.z / axisLength };
+
+		float minDot{ 1.f };
+		for (uint32_t triIdx{}; triIdx < meshlet.triangleCount; ++triIdx)
+			if (Dot(normals[triIdx], normals[triIdx]) > 0.f)
+				minDot = (std::min)(minDot, Dot(normals[triIdx], axis));
+
+		if (minDot <= MIN_CONE_SPREAD)
+			return;
+
+		// Move the apex back along the axis until it is behind every triangle plane, so the test is exact for a camera close to the cluster
+		float maxOffset{ 0.f };
+		for (uint32_t triIdx{}; triIdx < meshlet.triangleCount; ++triIdx)
+		{
+			if (Dot(normals[triIdx], normals[triIdx]) <= 0.f)
+				continue;
+
+			const DirectX::XMFLOAT3& p0{ vertices[pindices[triIdx * 3]].position };
+			maxOffset = (std::max)(maxOffset, Dot(Subtract(meshlet.center, p0), normals[triIdx]) / Dot(axis, normals[triIdx]));
+		}
+
+		meshlet.coneApex = DirectX::XMFLOAT3{ meshlet.center.x - axis.x * maxOffset, meshlet.center.y - axis.y * maxOffset, meshlet.center.z - axis.z * maxOffset };
+		meshlet.coneAxis = axis;
+		meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+	}
+}
+
+std::vector<MeshletBuilder::Meshlet> MeshletBuilder::Build(const MeshData& meshData, const MeshLod& lod)
+{
+	const uint32_t firstTriangle{ lod.indexOffset / 3 };
+	const uint32_t triangleCount{ lod.indexCount / 3 };
+	std::vector<Meshlet> meshlets{};
+	if (triangleCount == 0)
+		return meshlets;
+
+	meshlets.reserve(triangleCount / MAX_MESHLET_TRIANGLES + 1);
+
+	// Id of the last meshlet that referenced each vertex, avoids clearing a set between meshlets
+	std::vector<uint32_t> vertexMeshlet(meshData.GetVertexCount(), INVALID_MESHLET);
+
+	Meshlet current{};
+	current.triangleOffset = firstTriangle;
+	uint32_t currentId{ 0 };
+
+	const auto countNewVertices{ [&vertexMeshlet, &currentId](const uint32_t* ptri)
+		{
+			// A degenerate triangle may repeat a vertex, only count it once
+			uint32_t count{ 0 };
+			for (uint32_t corner{}; corner < 3; ++corner)
+			{
+				const bool isRepeated{ (corner > 0 && ptri[corner] == ptri[0]) || (corner > 1 && ptri[corner] == ptri[1]) };
+				if (!isRepeated && vertexMeshlet[ptri[corner]] != currentId)
+					++count;
+			}
+
+			return count;
+		} };
+
+	for (uint32_t triIdx{ firstTriangle }; triIdx < firstTriangle + triangleCount; ++triIdx)
+	{
+		const uint32_t* ptri{ std::data(meshData.indices) + static_cast<size_t>(triIdx) * 3 };
+
+		uint32_t newVertexCount{ countNewVertices(ptri) };
+		if (current.triangleCount > 0 && (current.vertexCount + newVertexCount > MAX_MESHLET_VERTICES || current.triangleCount == MAX_MESHLET_TRIANGLES))
+		{
+			ComputeBounds(current, meshData);
+			meshlets.push_back(current);
+
+			current = Meshlet{};
+			current.triangleOffset = triIdx;
+			++currentId;
+			newVertexCount = countNewVertices(ptri);
+		}
+
+		for (uint32_t corner{}; corner < 3; ++corner)
+			vertexMeshlet[ptri[corner]] = currentId;
+
+		current.vertexCount += newVertexCount;
+		++current.triangleCount;
+	}
+
+	ComputeBounds(current, meshData);
+	meshlets.push_back(current);
+
+	return meshlets;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+#include "MeshData.h"
+
+/**
+ * \brief : Partitions a triangle list into meshlets, runs of consecutive triangles referencing at most MAX_MESHLET_VERTICES vertices.\n
+ * Triangles are not reordered, so a meshlet is a range of the index buffer. Build after MeshOptimizer to get tight, well filled meshlets.
+ */
+namespace MeshletBuilder
+{
+	constexpr uint32_t MAX_MESHLET_VERTICES{ 64 };
+	constexpr uint32_t MAX_MESHLET_TRIANGLES{ 124 };
+
+	/**
+	 * \brief : One cluster as read by ClusterCulling.hlsl (same layout as its Meshlet struct).\n
+	 * The cone is disabled (coneAxis = 0, coneCutoff = 1) when the triangle normals spread too much for it to ever cull.
+	 */
+	struct Meshlet
+	{
+		DirectX::XMFLOAT3 center;
+		float radius;
+
+		// Backfacing if dot(normalize(coneApex - cameraPosition), coneAxis) >= coneCutoff
+		DirectX::XMFLOAT3 coneApex;
+		float coneCutoff;
+		DirectX::XMFLOAT3 coneAxis;
+
+		uint32_t triangleOffset;
+		uint32_t triangleCount;
+		uint32_t vertexCount;
+		uint32_t pad[2];
+	};
+	static_assert(sizeof(Meshlet) == 64, "Meshlet must match the ClusterCulling.hlsl layout");
+
+	/**
+	 * \brief : Splits the index range of lod into meshlets and computes their bounding spheres and normal cones.\n
+	 * triangleOffset is relative to the start of meshData.indices, not to the level.
+	 */
+	std::vector<Meshlet> Build(const MeshData& meshData, const MeshLod& lod);
+};
@@ -1,104 +1,392 @@
 #include "pch.h"
 #include "ObjReader.h"
 
-void ObjReader::LoadModel(const std::wstring& objPath, std::vector<DirectX::XMFLOAT3>& positions, std::vector<DirectX::XMFLOAT3>& normals, std::vector<DirectX::XMFLOAT2>&, std::vector<uint32_t>& indexBuffer)
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "ConsoleLog.h"
+#include "MappedFile.h"
+#include "VertexWelder.h"
+
+namespace
 {
-	using namespace DirectX;
+	// Zero-based attribute indices of a face corner, -1 when the attribute is absent
+	struct FaceCorner
+	{
+		int32_t v, t, n;
+	};
+
+	// Corner using negative OBJ indices, resolved against the attribute counts of its own chunk only
+	struct RelativeCorner
+	{
+		uint32_t cornerIdx;
+		uint32_t relativeMask;
+	};
+
+	constexpr uint32_t RELATIVE_V{ 1 << 0 };
+	constexpr uint32_t RELATIVE_T{ 1 << 1 };
+	constexpr uint32_t RELATIVE_N{ 1 << 2 };
+
+	struct ObjRecords
+	{
+		std::vector<DirectX::XMFLOAT3> vertices;
+		std::vector<DirectX::XMFLOAT3> normals;
+		std::vector<DirectX::XMFLOAT2> uvs;
+		std::vector<FaceCorner> corners;
+		std::vector<RelativeCorner> relativeCorners;
+	};
+
+	// Files smaller than this are parsed on the calling thread, spinning up workers costs more than it saves
+	constexpr size_t PARALLEL_MIN_FILE_SIZE{ 4 * 1024 * 1024 };
+	constexpr size_t PARALLEL_MIN_CHUNK_SIZE{ 1024 * 1024 };
+	constexpr size_t PARALLEL_CHUNKS_PER_THREAD{ 4 };
+
+	inline const char* SkipBlanks(const char* it, const char* end)
+	{
+		while (it < end && (*it == ' ' || *it == '\t'))
+			++it;
+
+		return it;
+	}
+
+	inline const char* ParseFloat(const char* it, const char* end, float& value)
+	{
+		it = SkipBlanks(it, end);
+		if (it < end && *it == '+')
+			++it;
+
+		const std::from_chars_result res{ std::from_chars(it, end, value) };
+		if (res.ec != std::errc{})
+			value = 0.f;
+
+		return res.ptr;
+	}
+
+	// nullptr when no index could be parsed at it
+	inline const char* ParseIndex(const char* it, const char* end, int32_t& value)
+	{
+		const std::from_chars_result res{ std::from_chars(it, end, value) };
+		if (res.ec != std::errc{})
+			return nullptr;
+
+		return res.ptr;
+	}
 
-	std::ifstream objStream{ objPath, std::ios::in | std::ios::ate };
+	// OBJ indices are 1-based, negative values are relative to the current end of the attribute list
+	inline int32_t ResolveIndex(int32_t objIndex, size_t count)
+	{
+		if (objIndex > 0)
+			return objIndex - 1;
+
+		return objIndex < 0 ? static_cast<int32_t>(count) + objIndex : -1;
+	}
 
-	if (!objStream.is_open())
+	// nullptr when an index of the corner cannot be parsed or its position index is 0, the rest of the face is dropped
+	const char* ParseFaceCorner(const char* it, const char* end, const ObjRecords& records, FaceCorner& corner, uint32_t& relativeMask)
 	{
-		std::wcout << L"Error: Could not open obj file \"" << objPath << "\".";
-		return;
+		int32_t iV{}, iT{}, iN{};
+		it = ParseIndex(it, end, iV);
+		if (!it || iV == 0)
+			return nullptr;
+
+		if (it < end && *it == '/')
+		{
+			++it;
+			if (it < end && *it != '/')
+				it = ParseIndex(it, end, iT);
+
+			if (it && it < end && *it == '/')
+				it = ParseIndex(it + 1, end, iN);
+
+			if (!it)
+				return nullptr;
+		}
+
+		corner = FaceCorner{ ResolveIndex(iV, records.vertices.size()), ResolveIndex(iT, records.uvs.size()), ResolveIndex(iN, records.normals.size()) };
+		relativeMask = (iV < 0 ? RELATIVE_V : 0u) | (iT < 0 ? RELATIVE_T : 0u) | (iN < 0 ? RELATIVE_N : 0u);
+		return it;
 	}
 
-	constexpr size_t default_start_size{ 10000 };
-
-	std::string line{};
-	std::vector<XMFLOAT3> tmpVertices;
-	tmpVertices.reserve(default_start_size);
-	std::vector<XMFLOAT3> tmpVNormals;
-	tmpVNormals.reserve(default_start_size);
-	std::vector<XMFLOAT2> tmpUVs;
-	tmpUVs.reserve(default_start_size);
-	std::vector<std::string> tmpFaces;
-	tmpFaces.reserve(default_start_size);
-
-	//Parse all data in temporary arrays
-	objStream.seekg(0, std::ios::beg);
-	while (!objStream.eof())
+	void ParseFace(const char* it, const char* lineEnd, ObjRecords& records)
 	{
-		std::getline(objStream, line, '\n');
+		FaceCorner first{}, previous{}, current{};
+		uint32_t firstMask{}, previousMask{}, currentMask{};
+		uint32_t cornerCount{};
 
-		if (line._Starts_with("f "))
+		for (;;)
 		{
-			tmpFaces.push_back(line);
+			it = SkipBlanks(it, lineEnd);
+			if (it >= lineEnd || !(*it == '-' || (*it >= '0' && *it <= '9')))
+				break;
+
+			it = ParseFaceCorner(it, lineEnd, records, current, currentMask);
+			if (!it)
+				break;
+
+			// Fan triangulation, so quads and n-gons keep all their surface
+			if (cornerCount == 0)
+			{
+				first = current;
+				firstMask = currentMask;
+			}
+			else if (cornerCount >= 2)
+			{
+				const FaceCorner triangle[]{ first, previous, current };
+				const uint32_t triangleMasks[]{ firstMask, previousMask, currentMask };
+				for (int idx{}; idx < 3; ++idx)
+				{
+					if (triangleMasks[idx])
+						records.relativeCorners.push_back({ static_cast<uint32_t>(std::size(records.corners)), triangleMasks[idx] });
+
+					records.corners.push_back(triangle[idx]);
+				}
+			}
+
+			previous = current;
+			previousMask = currentMask;
+			++cornerCount;
 		}
-		else
+	}
+
+	void ParseRecords(const char* it, const char* end, ObjRecords& records)
+	{
+		using namespace DirectX;
+
+		while (it < end)
 		{
-			float f0, f1, f2;
-			[[maybe_unused]] int ret = sscanf_s(line.c_str(), "%*s %f %f %f", &f0, &f1, &f2);
+			const char* lineEnd{ static_cast<const char*>(memchr(it, '\n', static_cast<size_t>(end - it))) };
+			if (!lineEnd)
+				lineEnd = end;
 
-			if (line._Starts_with("v "))
+			const size_t lineSize{ static_cast<size_t>(lineEnd - it) };
+			if (lineSize >= 2 && it[0] == 'f' && (it[1] == ' ' || it[1] == '\t'))
+			{
+				ParseFace(it + 2, lineEnd, records);
+			}
+			else if (lineSize >= 2 && it[0] == 'v' && (it[1] == ' ' || it[1] == '\t'))
 			{
-				tmpVertices.push_back({ f0, f1, f2 });
+				XMFLOAT3 position{};
+				const char* cursor{ ParseFloat(it + 2, lineEnd, position.x) };
+				cursor = ParseFloat(cursor, lineEnd, position.y);
+				ParseFloat(cursor, lineEnd, position.z);
+				records.vertices.push_back(position);
 			}
-			else if (line._Starts_with("vn "))
+			else if (lineSize >= 3 && it[0] == 'v' && it[1] == 'n' && (it[2] == ' ' || it[2] == '\t'))
 			{
-				tmpVNormals.push_back({ f0, f1, f2 });
+				XMFLOAT3 normal{};
+				const char* cursor{ ParseFloat(it + 3, lineEnd, normal.x) };
+				cursor = ParseFloat(cursor, lineEnd, normal.y);
+				ParseFloat(cursor, lineEnd, normal.z);
+				records.normals.push_back(normal);
 			}
-			else if (line._Starts_with("vt "))
+			else if (lineSize >= 3 && it[0] == 'v' && it[1] == 't' && (it[2] == ' ' || it[2] == '\t'))
 			{
-				tmpUVs.push_back({ f0, 1 - f1 });
+				XMFLOAT2 uv{};
+				const char* cursor{ ParseFloat(it + 3, lineEnd, uv.x) };
+				ParseFloat(cursor, lineEnd, uv.y);
+				records.uvs.push_back({ uv.x, 1 - uv.y });
 			}
+
+			it = lineEnd < end ? lineEnd + 1 : end;
 		}
 	}
 
-	indexBuffer.reserve(tmpFaces.size());
-	positions.reserve(tmpFaces.size());
-	normals.reserve(tmpFaces.size());
-	constexpr UINT vFaceCount{ 3 };
-
-	//construct vertex and index buffer based on faces information
-	for (const std::string& faceStr : tmpFaces)
+	std::vector<const char*> SplitChunks(const char* data, size_t size, size_t chunkCount)
 	{
-		int iVs[vFaceCount]{}, iNs[vFaceCount]{};
-		[[maybe_unused]] int ret = sscanf_s(faceStr.c_str(), "f %d/%*d/%d %d/%*d/%d %d/%*d/%d", &iVs[0], &iNs[0], &iVs[1], &iNs[1], &iVs[2], &iNs[2]);
+		std::vector<const char*> boundaries{ data };
+		const char* end{ data + size };
 
-		for (int idx{}; idx < vFaceCount; ++idx)
+		for (size_t chunkIdx{ 1 }; chunkIdx < chunkCount; ++chunkIdx)
 		{
-			const XMFLOAT3& position{ tmpVertices[iVs[idx] - 1] };
-			XMFLOAT3 normal{};
-			if (!tmpVNormals.empty())
-				normal = tmpVNormals[iNs[idx] - 1];
+			const char* it{ (std::max)(data + size * chunkIdx / chunkCount, boundaries.back()) };
+			const char* newLine{ it < end ? static_cast<const char*>(memchr(it, '\n', static_cast<size_t>(end - it))) : nullptr };
+			if (!newLine)
+				break;
 
-			int64_t vIdx{ GetVertexIdx(position, positions) };
+			boundaries.push_back(newLine + 1);
+		}
+
+		boundaries.push_back(end);
+		return boundaries;
+	}
 
-			if (vIdx == -1
-				|| XMVector3NotEqual(XMLoadFloat3(&normal), XMLoadFloat3(&normals[static_cast<uint32_t>(vIdx)])))
+	// Parses newline-aligned chunks on a worker pool and concatenates them in file order.
+	// Exclusive prefix sums over the per-chunk counts rebase relative indices, so the result matches a sequential ParseRecords.
+	void ParseRecordsParallel(const char* data, size_t size, uint32_t threadCount, ObjRecords& records)
+	{
+		const size_t chunkCount{ (std::max)(size_t{ 1 }, (std::min)(threadCount * PARALLEL_CHUNKS_PER_THREAD, size / PARALLEL_MIN_CHUNK_SIZE)) };
+		const std::vector<const char*> boundaries{ SplitChunks(data, size, chunkCount) };
+		const size_t splitCount{ std::size(boundaries) - 1 };
+
+		std::vector<ObjRecords> chunkRecords(splitCount);
+		std::atomic<size_t> nextChunk{ 0 };
+
+		auto runWorkers = [threadCount, splitCount, &nextChunk](auto&& task)
+		{
+			nextChunk = 0;
+			std::vector<std::thread> workers{};
+			workers.reserve(threadCount);
+			for (uint32_t threadIdx{}; threadIdx < threadCount; ++threadIdx)
 			{
-				vIdx = positions.size();
-				positions.push_back(position);
-				normals.push_back(normal);
+				workers.emplace_back([splitCount, &nextChunk, &task]()
+					{
+						for (size_t chunkIdx{ nextChunk++ }; chunkIdx < splitCount; chunkIdx = nextChunk++)
+							task(chunkIdx);
+					});
 			}
 
-			indexBuffer.push_back(static_cast<uint32_t>(vIdx));
+			for (std::thread& worker : workers)
+				worker.join();
+		};
+
+		runWorkers([&boundaries, &chunkRecords](size_t chunkIdx)
+			{
+				const size_t chunkSize{ static_cast<size_t>(boundaries[chunkIdx + 1] - boundaries[chunkIdx]) };
+				ObjRecords& chunk{ chunkRecords[chunkIdx] };
+				chunk.vertices.reserve(chunkSize / 128);
+				chunk.normals.reserve(chunkSize / 128);
+				chunk.uvs.reserve(chunkSize / 128);
+				chunk.corners.reserve(chunkSize / 32);
+
+				ParseRecords(boundaries[chunkIdx], boundaries[chunkIdx + 1], chunk);
+			});
+
+		// Each chunk's prefix offsets are both its slot in the merged arrays and the base of its relative indices
+		struct ChunkOffsets
+		{
+			size_t v, t, n, corner;
+		};
+
+		std::vector<ChunkOffsets> offsets(splitCount + 1, ChunkOffsets{});
+		for (size_t chunkIdx{}; chunkIdx < splitCount; ++chunkIdx)
+		{
+			const ObjRecords& chunk{ chunkRecords[chunkIdx] };
+			offsets[chunkIdx + 1].v = offsets[chunkIdx].v + std::size(chunk.vertices);
+			offsets[chunkIdx + 1].t = offsets[chunkIdx].t + std::size(chunk.uvs);
+			offsets[chunkIdx + 1].n = offsets[chunkIdx].n + std::size(chunk.normals);
+			offsets[chunkIdx + 1].corner = offsets[chunkIdx].corner + std::size(chunk.corners);
 		}
+
+		records.vertices.resize(offsets[splitCount].v);
+		records.uvs.resize(offsets[splitCount].t);
+		records.normals.resize(offsets[splitCount].n);
+		records.corners.resize(offsets[splitCount].corner);
+
+		runWorkers([&offsets, &chunkRecords, &records](size_t chunkIdx)
+			{
+				const ObjRecords& chunk{ chunkRecords[chunkIdx] };
+				const ChunkOffsets& offset{ offsets[chunkIdx] };
+
+				std::copy(std::cbegin(chunk.vertices), std::cend(chunk.vertices), std::begin(records.vertices) + offset.v);
+				std::copy(std::cbegin(chunk.uvs), std::cend(chunk.uvs), std::begin(records.uvs) + offset.t);
+				std::copy(std::cbegin(chunk.normals), std::cend(chunk.normals), std::begin(records.normals) + offset.n);
+				std::copy(std::cbegin(chunk.corners), std::cend(chunk.corners), std::begin(records.corners) + offset.corner);
+
+				for (const RelativeCorner& relative : chunk.relativeCorners)
+				{
+					FaceCorner& corner{ records.corners[offset.corner + relative.cornerIdx] };
+					if (relative.relativeMask & RELATIVE_V)
+						corner.v += static_cast<int32_t>(offset.v);
+					if (relative.relativeMask & RELATIVE_T)
+						corner.t += static_cast<int32_t>(offset.t);
+					if (relative.relativeMask & RELATIVE_N)
+						corner.n += static_cast<int32_t>(offset.n);
+				}
+			});
 	}
 
-	indexBuffer.shrink_to_fit();
-	positions.shrink_to_fit();
-	normals.shrink_to_fit();
+	void BuildBuffers(const ObjRecords& records, MeshData& meshData)
+	{
+		using namespace DirectX;
+
+		const size_t cornerCount{ std::size(records.corners) };
+		meshData.indices.reserve(cornerCount);
+		meshData.vertices.reserve(std::size(records.vertices));
+		meshData.uvs.reserve(std::size(records.vertices));
+
+		const int32_t vCount{ static_cast<int32_t>(std::size(records.vertices)) };
+		const int32_t tCount{ static_cast<int32_t>(std::size(records.uvs)) };
+		const int32_t nCount{ static_cast<int32_t>(std::size(records.normals)) };
+
+		VertexWelder welder{ meshData, std::size(records.vertices) };
+
+		for (size_t cornerIdx{}; cornerIdx + 2 < cornerCount; cornerIdx += 3)
+		{
+			const FaceCorner* pcorners{ &records.corners[cornerIdx] };
+			if (pcorners[0].v < 0 || pcorners[0].v >= vCount
+				|| pcorners[1].v < 0 || pcorners[1].v >= vCount
+				|| pcorners[2].v < 0 || pcorners[2].v >= vCount)
+				continue;
+
+			for (int idx{}; idx < 3; ++idx)
+			{
+				const FaceCorner& corner{ pcorners[idx] };
+				const XMFLOAT3 normal{ corner.n >= 0 && corner.n < nCount ? records.normals[corner.n] : XMFLOAT3{} };
+				const XMFLOAT2 uv{ corner.t >= 0 && corner.t < tCount ? records.uvs[corner.t] : XMFLOAT2{} };
+
+				meshData.indices.push_back(welder.Weld(records.vertices[corner.v], normal, uv));
+			}
+		}
+
+		meshData.indices.shrink_to_fit();
+		meshData.vertices.shrink_to_fit();
+		meshData.uvs.shrink_to_fit();
+	}
 }
 
-int64_t ObjReader::GetVertexIdx(const DirectX::XMFLOAT3& vertexPos, const std::vector<DirectX::XMFLOAT3>& vertexPositions)
+bool ObjReader::LoadModel(const std::wstring& objPath, MeshData& meshData, LoadStats* pstats, uint32_t maxThreadCount)
 {
-	std::vector<DirectX::XMFLOAT3>::const_iterator cIt{ std::find_if(std::cbegin(vertexPositions), std::cend(vertexPositions), [&vertexPos](const DirectX::XMFLOAT3& pos)
-		{
-			return DirectX::XMVector3NotEqual(XMLoadFloat3(&vertexPos), XMLoadFloat3(&pos));
-		})
-	};
+	using Clock = std::chrono::high_resolution_clock;
+
+	const Clock::time_point startTime{ Clock::now() };
+
+	const MappedFile objFile{ objPath };
+	if (!objFile.IsOpen())
+	{
+		ConsoleLog::GetStream() << L"Error: Could not open obj file \"" << objPath << "\".\n";
+		return false;
+	}
+
+	const size_t fileSize{ objFile.GetSize() };
+	ObjRecords records{};
+	// Rough estimates from typical OBJ line lengths, the vectors still grow if needed
+	if (fileSize < PARALLEL_MIN_FILE_SIZE)
+	{
+		records.vertices.reserve(fileSize / 128);
+		records.normals.reserve(fileSize / 128);
+		records.uvs.reserve(fileSize / 128);
+		records.corners.reserve(fileSize / 32);
+	}
+
+	const uint32_t hardwareThreadCount{ (std::max)(1u, std::thread::hardware_concurrency()) };
+	const uint32_t threadCount{ fileSize >= PARALLEL_MIN_FILE_SIZE ? (maxThreadCount != 0 ? (std::min)(maxThreadCount, hardwareThreadCount) : hardwareThreadCount) : 1u };
+	if (threadCount > 1)
+		ParseRecordsParallel(objFile.GetData(), fileSize, threadCount, records);
+	else
+		ParseRecords(objFile.GetData(), objFile.GetData() + fileSize, records);
+
+	const Clock::time_point parseTime{ Clock::now() };
 
-	return cIt == vertexPositions.cend() ? -1 : std::distance(vertexPositions.cbegin(), cIt);
-}
\ No newline at end of file
+	BuildBuffers(records, meshData);
+
+	const Clock::time_point weldTime{ Clock::now() };
+
+	LoadStats stats{};
+	stats.fileSize = fileSize;
+	stats.threadCount = threadCount;
+	stats.parseMs = std::chrono::duration<double, std::milli>(parseTime - startTime).count();
+	stats.weldMs = std::chrono::duration<double, std::milli>(weldTime - parseTime).count();
+	stats.vertexCount = std::size(meshData.vertices);
+	stats.indexCount = std::size(meshData.indices);
+
+	ConsoleLog::GetStream() << L"Loaded \"" << objPath << L"\": " << stats.vertexCount << L" vertices, " << stats.indexCount << L" indices in "
+		<< stats.parseMs + stats.weldMs << L" ms (" << stats.GetThroughputMBs() << L" MB/s).\n";
+
+	if (pstats)
+		*pstats = stats;
+
+	return true;
+}
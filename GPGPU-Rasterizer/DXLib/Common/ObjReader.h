@@ -1,7 +1,28 @@
 #pragma once
+#include "MeshData.h"
+
 namespace ObjReader
 {
-	void LoadModel(const std::wstring& objPath, std::vector<DirectX::XMFLOAT3>& positions, std::vector<DirectX::XMFLOAT3>& normals, std::vector<DirectX::XMFLOAT2>& uvs, std::vector<uint32_t>& indexBuffer);
-	int64_t GetVertexIdx(const DirectX::XMFLOAT3& vertexPos, const std::vector<DirectX::XMFLOAT3>& vertexPositions);
-};
+	struct LoadStats
+	{
+		size_t fileSize{};
+		double parseMs{};
+		double weldMs{};
+		size_t vertexCount{};
+		size_t indexCount{};
+		uint32_t threadCount{};
 
+		double GetThroughputMBs() const { return (parseMs + weldMs) > 0.0 ? (fileSize / (1024.0 * 1024.0)) / ((parseMs + weldMs) / 1000.0) : 0.0; }
+	};
+
+	/**
+	 * \brief : Loads a Wavefront OBJ file into deduplicated vertices and a triangle list index buffer.\n
+	 * The vertices are welded straight into the interleaved MeshVertex layout, so meshData can be handed to a mesh without conversion.\n
+	 * The file is memory mapped and tokenized in place, polygons are fan triangulated.\n
+	 * Large files are split in newline-aligned chunks parsed on all hardware threads, the result is identical to a sequential parse.
+	 * \param pstats : Optional output for the file size, timings and resulting buffer sizes
+	 * \param maxThreadCount : Cap on the threads parsing a large file, 0 for all hardware threads
+	 * \return : false if the file could not be opened
+	 */
+	bool LoadModel(const std::wstring& objPath, MeshData& meshData, LoadStats* pstats = nullptr, uint32_t maxThreadCount = 0);
+};
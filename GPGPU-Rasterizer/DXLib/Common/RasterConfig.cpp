@@ -0,0 +1,45 @@
+#include "pch.h"
+#include "RasterConfig.h"
+
+#include <algorithm>
+
+namespace
+{
+	// A triangle inside the band has twice its area below (width + 2 * band) * (height + 2 * band) pixels, see Clipping
+	bool IsBandExact(const RasterConfig& config, int64_t guardBand)
+	{
+		return (config.viewportWidth + 2 * guardBand) * (config.viewportHeight + 2 * guardBand) * FixedPointEdges::SUBPIXEL_SCALE < FixedPointEdges::EDGE_CLAMP;
+	}
+}
+
+float RasterConfig::GetGuardBandPixels(ERasterMode rasterMode) const
+{
+	int64_t guardBand{ static_cast<int64_t>(Clipping::GUARD_BAND_PIXELS) };
+	if (rasterMode != ERasterMode::FixedPoint)
+		return static_cast<float>(guardBand);
+
+	guardBand = (std::min)(guardBand, static_cast<int64_t>(FixedPointEdges::MAX_COORDINATE) - (std::max)(viewportWidth, viewportHeight));
+	while (guardBand > 0 && !IsBandExact(*this, guardBand))
+		--guardBand;
+
+	return static_cast<float>((std::max)(guardBand, int64_t{ 0 }));
+}
+
+bool RasterConfig::IsFixedPointExact() const
+{
+	return IsBandExact(*this, static_cast<int64_t>(GetGuardBandPixels(ERasterMode::FixedPoint)));
+}
+
+std::vector<std::pair<std::string, std::string>> RasterConfig::GetShaderDefines(ERasterMode rasterMode) const
+{
+	return {
+		{ "RASTER_VIEWPORT_WIDTH", std::to_string(viewportWidth) },
+		{ "RASTER_VIEWPORT_HEIGHT", std::to_string(viewportHeight) },
+		{ "RASTER_TILE_SIZE", std::to_string(tileSize) },
+		{ "RASTER_BIN_SIZE", std::to_string(binSize) },
+		{ "RASTER_QUEUE_COUNT", std::to_string(queueCount) },
+		{ "MICRO_TILE_CAPACITY", std::to_string(MICRO_TILE_CAPACITY) },
+		// Whole pixels, written as a float literal like the default of Clipping.hlsli
+		{ "GUARD_BAND_PIXELS", std::to_string(static_cast<uint32_t>(GetGuardBandPixels(rasterMode))) + ".f" }
+	};
+}
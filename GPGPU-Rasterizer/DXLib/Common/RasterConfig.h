@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Clipping.h"
+#include "FixedPointEdges.h"
+
+/**
+ * \brief : Resolution and tiling of the compute pipeline, owned by the C++ side.\n
+ * CompuRaster::Pipeline sizes its buffers and dispatches from the getters below and compiles every stage with GetShaderDefines,
+ * RasterConfig.hlsli derives the same bin and tile dimensions from those defines.\n
+ * Tiles are tileSize pixels square and bins binSize tiles square. The viewport is cut into GetBinningDimsX * GetBinningDimsY bins,
+ * the tiles of the last bin row and column past the viewport included, the Hi-Z only keeps the tiles of the viewport.\n
+ * This is the CPU reference of RasterConfig.hlsli.
+ */
+struct RasterConfig
+{
+	// The fine stage shades a tile with one thread per pixel, in rows of FINE_GROUP_X threads
+	static constexpr uint32_t FINE_GROUP_X{ 32 };
+	// D3D11_CS_THREAD_GROUP_MAX_THREADS_PER_GROUP
+	static constexpr uint32_t MAX_GROUP_THREADS{ 1024 };
+	// D3D11_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION, binning dispatches a group per queue
+	static constexpr uint32_t MAX_QUEUE_COUNT{ 65535 };
+	// BinData keeps a 64 bit mask of the tiles of a bin
+	static constexpr uint32_t MAX_BIN_TILE_COUNT{ 64 };
+	// Micro triangles a tile lists for the point sampled path of the fine stage, one per fine thread, the ones past it are binned
+	static constexpr uint32_t MICRO_TILE_CAPACITY{ 64 };
+
+	uint32_t viewportWidth{ 1280 };
+	uint32_t viewportHeight{ 720 };
+	// Pixels per tile side, one fine stage group shades a tile
+	uint32_t tileSize{ 8 };
+	// Tiles per bin side
+	uint32_t binSize{ 8 };
+	// Triangle batches binned independently, one binning group each
+	uint32_t queueCount{ 16 };
+
+	constexpr uint32_t GetBinPixelSize() const { return binSize * tileSize; }
+	constexpr uint32_t GetBinTileCount() const { return binSize * binSize; }
+	constexpr uint32_t GetBinningDimsX() const { return (viewportWidth + GetBinPixelSize() - 1) / GetBinPixelSize(); }
+	constexpr uint32_t GetBinningDimsY() const { return (viewportHeight + GetBinPixelSize() - 1) / GetBinPixelSize(); }
+	constexpr uint32_t GetBinCount() const { return GetBinningDimsX() * GetBinningDimsY(); }
+	// TILE_COUNT of the shaders, bin by bin
+	constexpr uint32_t GetTileCount() const { return GetBinCount() * GetBinTileCount(); }
+	// Screen tiles of the Hi-Z, row by row
+	constexpr uint32_t GetHiZDimsX() const { return viewportWidth / tileSize; }
+	constexpr uint32_t GetHiZDimsY() const { return viewportHeight / tileSize; }
+	constexpr uint32_t GetHiZTileCount() const { return GetHiZDimsX() * GetHiZDimsY(); }
+
+	/**
+	 * \brief : Why the stages cannot run with this config, nullptr when they can
+	 */
+	constexpr const wchar_t* GetError() const
+	{
+		if (viewportWidth == 0 || viewportHeight == 0 || viewportWidth > static_cast<uint32_t>(FixedPointEdges::MAX_COORDINATE) || viewportHeight > static_cast<uint32_t>(FixedPointEdges::MAX_COORDINATE))
+			return L"The viewport must be 1 to 4096 pixels wide and high, the range of the snapped positions";
+		if (tileSize == 0 || (tileSize * tileSize) % FINE_GROUP_X != 0 || tileSize * tileSize > MAX_GROUP_THREADS || tileSize > static_cast<uint32_t>(FixedPointEdges::MAX_STEP_PIXELS))
+			return L"The tile size must fill the fine stage groups with rows of 32 threads and be stepped exactly, 8 or 16 pixels";
+		if (viewportWidth % tileSize != 0 || viewportHeight % tileSize != 0)
+			return L"The viewport must be a multiple of the tile size, tiles are either fully inside it or fully outside";
+		if (tileSize * tileSize < MICRO_TILE_CAPACITY)
+			return L"A tile must have a fine stage thread per micro triangle it lists";
+		if (binSize == 0 || GetBinTileCount() > MAX_BIN_TILE_COUNT)
+			return L"A bin holds up to 64 tiles, the bits of its coverage masks";
+		if (queueCount == 0 || queueCount > MAX_QUEUE_COUNT)
+			return L"Binning needs 1 to 65535 queues, one dispatched group each";
+		return nullptr;
+	}
+
+	/**
+	 * \brief : Clipping::GUARD_BAND_PIXELS, shrunk with ERasterMode::FixedPoint so the snapped positions inside the band stay below
+	 * FixedPointEdges::MAX_COORDINATE and, when the viewport allows it, the edge functions of the triangles inside it below EDGE_CLAMP
+	 */
+	float GetGuardBandPixels(ERasterMode rasterMode) const;
+
+	/**
+	 * \brief : Whether the FixedPointEdges functions of any triangle inside the guard band stay exact at its covered pixels.\n
+	 * Above 1440p it cannot hold, the edge functions of the largest triangles are clamped. Their coverage keeps the sign of the exact value,
+	 * their weights are computed from the unclamped float estimate and keep float precision
+	 */
+	bool IsFixedPointExact() const;
+
+	/**
+	 * \brief : Name and value of the macros RasterConfig.hlsli reads, every stage of the pipeline is compiled with them
+	 */
+	std::vector<std::pair<std::string, std::string>> GetShaderDefines(ERasterMode rasterMode) const;
+};
+
+static_assert(RasterConfig{}.GetError() == nullptr, "The default config must be valid");
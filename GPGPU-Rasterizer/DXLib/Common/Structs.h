@@ -19,6 +19,22 @@ namespace HelperStruct
 		UINT vertexCount{};
 		UINT triangleCount{};
 		UINT indexCount{};
+		UINT pad{};
+		// VertexQuantizer::Dequantization, position = positionOffset + quantized * positionScale. Unused by float vertices
+		DirectX::XMFLOAT3 positionOffset{};
+		float pad2{};
+		DirectX::XMFLOAT3 positionScale{};
+	};
+
+	// Object space frustum planes (xyz normal pointing inwards, w distance) and camera position for ClusterCulling.hlsl
+	struct ClusterCullInfo
+	{
+		DirectX::XMFLOAT4 frustumPlanes[6]{};
+		DirectX::XMFLOAT3 cameraPosition{};
+		UINT meshletCount{};
+		// First meshlet of the selected level of detail
+		UINT meshletOffset{};
+		UINT pad[3]{};
 	};
 
 	struct LightInfoBuffer
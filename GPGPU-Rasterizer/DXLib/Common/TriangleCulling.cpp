@@ -0,0 +1,20 @@
+#include "pch.h"
+#include "TriangleCulling.h"
+
+#include <cmath>
+
+bool TriangleCulling::IsDegenerate(float doubleArea)
+{
+	// Also true for a NaN area, from a vertex at infinity
+	return !(std::abs(doubleArea) > 0.f);
+}
+
+bool TriangleCulling::IsCulled(float doubleArea, ECullMode cullMode)
+{
+	switch (cullMode)
+	{
+	case ECullMode::Back: return doubleArea < 0.f;
+	case ECullMode::Front: return doubleArea > 0.f;
+	default: return false;
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// Which faces geometry setup drops
+enum class ECullMode
+{
+	None, // draws both faces
+	Back, // drops back faces, which were never covering a pixel anyway, and lets cluster culling drop back facing meshlets
+	Front // drops front faces and draws the back ones
+};
+
+/**
+ * \brief : Face and degenerate tests of geometry setup, on twice the signed screen area cross2d(v0 - v2, v1 - v2).\n
+ * Front faces have a positive area, the edge functions of their vertices are positive inside.
+ * An area that is 0, or rounds to 0 from a sliver, leaves the weights undefined: the triangle is degenerate and dropped in every mode.\n
+ * A back face that is drawn is set up with vertices 1 and 2 swapped so its edge functions are positive inside like a front face,
+ * it keeps the negative inverse area of its own winding and the stages interpolating it swap the weights of vertices 1 and 2 back.\n
+ * This is the CPU reference of TriangleCulling.hlsli.
+ */
+namespace TriangleCulling
+{
+	bool IsDegenerate(float doubleArea);
+
+	/**
+	 * \brief : Whether cullMode drops a non degenerate triangle with this area
+	 */
+	bool IsCulled(float doubleArea, ECullMode cullMode);
+};
@@ -0,0 +1,153 @@
+#include "pch.h"
+#include "VertexQuantizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	constexpr float POSITION_RANGE{ 65535.f };
+	constexpr float NORMAL_RANGE{ 127.f };
+
+	float SignNotZero(float value)
+	{
+		return value >= 0.f ? 1.f : -1.f;
+	}
+
+	// Same steps as OctDecode in VertexShader.hlsl
+	DirectX::XMFLOAT3 OctDecode(int8_t x, int8_t y)
+	{
+		const float ex{ (std::max)(static_cast<float>(x) / NORMAL_RANGE, -1.f) };
+		const float ey{ (std::max)(static_cast<float>(y) / NORMAL_RANGE, -1.f) };
+
+		DirectX::XMFLOAT3 normal{ ex, ey, 1.f - std::abs(ex) - std::abs(ey) };
+		const float t{ (std::max)(-normal.z, 0.f) };
+		normal.x += normal.x >= 0.f ? -t : t;
+		normal.y += normal.y >= 0.f ? -t : t;
+
+		const float length{ std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z) };
+		return DirectX::XMFLOAT3{ normal.x / length, normal.y / length, normal.z / length };
+	}
+
+	float Dot(const DirectX::XMFLOAT3& lhs, const DirectX::XMFLOAT3& rhs)
+	{
+		return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+	}
+
+	void OctEncode(const DirectX::XMFLOAT3& normal, int8_t& x, int8_t& y)
+	{
+		x = 0;
+		y = 0;
+
+		const float length{ std::sqrt(Dot(normal, normal)) };
+		const float l1{ std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z) };
+		if (length <= 0.f || l1 <= 0.f)
+			return;
+
+		// Project onto the octahedron, the lower half folds over the diagonals
+		float ex{ normal.x / l1 };
+		float ey{ normal.y / l1 };
+		if (normal.z < 0.f)
+		{
+			const float foldedX{ (1.f - std::abs(ey)) * SignNotZero(ex) };
+			const float foldedY{ (1.f - std::abs(ex)) * SignNotZero(ey) };
+			ex = foldedX;
+			ey = foldedY;
+		}
+
+		// Plain rounding can be off by more than half a step once decoded, keep the best of the 4 surrounding codes
+		const DirectX::XMFLOAT3 unitNormal{ normal.x / length, normal.y / length, normal.z / length };
+		const float baseX{ std::floor(ex * NORMAL_RANGE) }, baseY{ std::floor(ey * NORMAL_RANGE) };
+		float bestDot{ -2.f };
+		for (int offsetY{}; offsetY < 2; ++offsetY)
+		{
+			for (int offsetX{}; offsetX < 2; ++offsetX)
+			{
+				const int8_t candidateX{ static_cast<int8_t>(std::clamp(baseX + static_cast<float>(offsetX), -NORMAL_RANGE, NORMAL_RANGE)) };
+				const int8_t candidateY{ static_cast<int8_t>(std::clamp(baseY + static_cast<float>(offsetY), -NORMAL_RANGE, NORMAL_RANGE)) };
+				const float dot{ Dot(OctDecode(candidateX, candidateY), unitNormal) };
+				if (dot > bestDot)
+				{
+					bestDot = dot;
+					x = candidateX;
+					y = candidateY;
+				}
+			}
+		}
+	}
+
+	uint16_t QuantizePosition(float value, float offset, float scale)
+	{
+		if (scale <= 0.f)
+			return 0;
+
+		return static_cast<uint16_t>(std::clamp(std::round((value - offset) / scale), 0.f, POSITION_RANGE));
+	}
+}
+
+VertexQuantizer::Dequantization VertexQuantizer::ComputeDequantization(const std::vector<MeshVertex>& vertices)
+{
+	if (std::empty(vertices))
+		return Dequantization{};
+
+	DirectX::XMFLOAT3 boundsMin{ vertices[0].position }, boundsMax{ boundsMin };
+	for (const MeshVertex& vertex : vertices)
+	{
+		boundsMin = DirectX::XMFLOAT3{ (std::min)(boundsMin.x, vertex.position.x), (std::min)(boundsMin.y, vertex.position.y), (std::min)(boundsMin.z, vertex.position.z) };
+		boundsMax = DirectX::XMFLOAT3{ (std::max)(boundsMax.x, vertex.position.x), (std::max)(boundsMax.y, vertex.position.y), (std::max)(boundsMax.z, vertex.position.z) };
+	}
+
+	return Dequantization{ boundsMin, DirectX::XMFLOAT3{ (boundsMax.x - boundsMin.x) / POSITION_RANGE, (boundsMax.y - boundsMin.y) / POSITION_RANGE, (boundsMax.z - boundsMin.z) / POSITION_RANGE } };
+}
+
+VertexQuantizer::QuantizedVertex VertexQuantizer::Encode(const MeshVertex& vertex, const Dequantization& dequantization)
+{
+	QuantizedVertex quantized{};
+	quantized.position[0] = QuantizePosition(vertex.position.x, dequantization.offset.x, dequantization.scale.x);
+	quantized.position[1] = QuantizePosition(vertex.position.y, dequantization.offset.y, dequantization.scale.y);
+	quantized.position[2] = QuantizePosition(vertex.position.z, dequantization.offset.z, dequantization.scale.z);
+	OctEncode(vertex.normal, quantized.normal[0], quantized.normal[1]);
+
+	return quantized;
+}
+
+MeshVertex VertexQuantizer::Decode(const QuantizedVertex& vertex, const Dequantization& dequantization)
+{
+	MeshVertex decoded{};
+	decoded.position = DirectX::XMFLOAT3{ dequantization.offset.x + static_cast<float>(vertex.position[0]) * dequantization.scale.x
+		, dequantization.offset.y + static_cast<float>(vertex.position[1]) * dequantization.scale.y
+		, dequantization.offset.z + static_cast<float>(vertex.position[2]) * dequantization.scale.z };
+	decoded.normal = OctDecode(vertex.normal[0], vertex.normal[1]);
+
+	return decoded;
+}
+
+std::vector<VertexQuantizer::QuantizedVertex> VertexQuantizer::Encode(const std::vector<MeshVertex>& vertices, const Dequantization& dequantization)
+{
+	std::vector<QuantizedVertex> quantized(std::size(vertices));
+	std::transform(std::begin(vertices), std::end(vertices), std::begin(quantized), [&dequantization](const MeshVertex& vertex) { return Encode(vertex, dequantization); });
+	return quantized;
+}
+
+VertexQuantizer::RoundTripError VertexQuantizer::MeasureRoundTripError(const std::vector<MeshVertex>& vertices, const std::vector<QuantizedVertex>& quantized, const Dequantization& dequantization)
+{
+	RoundTripError error{};
+	float minNormalDot{ 1.f };
+
+	const size_t vertexCount{ (std::min)(std::size(vertices), std::size(quantized)) };
+	for (size_t vIdx{}; vIdx < vertexCount; ++vIdx)
+	{
+		const MeshVertex& source{ vertices[vIdx] };
+		const MeshVertex decoded{ Decode(quantized[vIdx], dequantization) };
+
+		const DirectX::XMFLOAT3 offset{ decoded.position.x - source.position.x, decoded.position.y - source.position.y, decoded.position.z - source.position.z };
+		error.maxPositionError = (std::max)(error.maxPositionError, std::sqrt(Dot(offset, offset)));
+
+		const float length{ std::sqrt(Dot(source.normal, source.normal)) };
+		if (length > 0.f)
+			minNormalDot = (std::min)(minNormalDot, Dot(decoded.normal, source.normal) / length);
+	}
+
+	error.maxNormalErrorDeg = DirectX::XMConvertToDegrees(std::acos(std::clamp(minNormalDot, -1.f, 1.f)));
+	return error;
+}
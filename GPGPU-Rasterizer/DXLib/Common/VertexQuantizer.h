@@ -0,0 +1,49 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+#include "MeshData.h"
+
+/**
+ * \brief : Compact 8 byte vertex for the compute pipeline, read by VertexShader.hlsl when compiled with QUANTIZED_VERTICES.\n
+ * Positions are 16 bit unorm against the mesh bounds, normals are octahedral encoded in 2 x 8 bit snorm.
+ */
+namespace VertexQuantizer
+{
+	struct QuantizedVertex
+	{
+		uint16_t position[3];
+		int8_t normal[2];
+	};
+	static_assert(sizeof(QuantizedVertex) == 8, "QuantizedVertex must match the uint2 read in VertexShader.hlsl");
+
+	/**
+	 * \brief : position = offset + quantized * scale, passed to the vertex stage through the ObjectInfo buffer
+	 */
+	struct Dequantization
+	{
+		DirectX::XMFLOAT3 offset;
+		DirectX::XMFLOAT3 scale;
+	};
+
+	struct RoundTripError
+	{
+		// Object space units
+		float maxPositionError;
+		float maxNormalErrorDeg;
+	};
+
+	/**
+	 * \brief : Maps the bounds of vertices onto the full 16 bit range
+	 */
+	Dequantization ComputeDequantization(const std::vector<MeshVertex>& vertices);
+
+	QuantizedVertex Encode(const MeshVertex& vertex, const Dequantization& dequantization);
+	MeshVertex Decode(const QuantizedVertex& vertex, const Dequantization& dequantization);
+	std::vector<QuantizedVertex> Encode(const std::vector<MeshVertex>& vertices, const Dequantization& dequantization);
+
+	/**
+	 * \brief : Decodes every quantized vertex and measures the worst position and normal error against the source vertices
+	 */
+	RoundTripError MeasureRoundTripError(const std::vector<MeshVertex>& vertices, const std::vector<QuantizedVertex>& quantized, const Dequantization& dequantization);
+};
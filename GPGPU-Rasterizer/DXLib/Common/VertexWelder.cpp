@@ -0,0 +1,100 @@
+#include "pch.h"
+#include "VertexWelder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	inline uint32_t FloatBits(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof bits);
+		return bits;
+	}
+
+	inline uint64_t MixBits(uint64_t hash, uint32_t bits)
+	{
+		hash ^= bits;
+		hash *= 0x9E3779B97F4A7C15ull;
+		return hash ^ (hash >> 29);
+	}
+
+	size_t NextPowerOfTwo(size_t value)
+	{
+		size_t pow2{ 16 };
+		while (pow2 < value)
+			pow2 <<= 1;
+
+		return pow2;
+	}
+}
+
+VertexWelder::VertexWelder(MeshData& meshData, size_t expectedVertexCount)
+	: m_Vertices{ meshData.vertices }
+	, m_Uvs{ meshData.uvs }
+	, m_Slots{}
+	, m_SlotMask{}
+{
+	// Keep the load factor under 0.5 so probe chains stay short
+	Rehash(NextPowerOfTwo((std::max)(expectedVertexCount, m_Vertices.size()) * 2));
+}
+
+uint32_t VertexWelder::Weld(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& normal, const DirectX::XMFLOAT2& uv)
+{
+	if ((m_Vertices.size() + 1) * 2 > m_Slots.size())
+		Rehash(m_Slots.size() * 2);
+
+	size_t slot{ static_cast<size_t>(Hash(position, normal, uv)) & m_SlotMask };
+	while (m_Slots[slot] != EMPTY_SLOT)
+	{
+		if (IsSameVertex(m_Slots[slot], position, normal, uv))
+			return m_Slots[slot];
+
+		slot = (slot + 1) & m_SlotMask;
+	}
+
+	const uint32_t vIdx{ static_cast<uint32_t>(m_Vertices.size()) };
+	m_Slots[slot] = vIdx;
+	m_Vertices.push_back(MeshVertex{ position, 0.f, normal, 0.f });
+	m_Uvs.push_back(uv);
+
+	return vIdx;
+}
+
+uint64_t VertexWelder::Hash(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& normal, const DirectX::XMFLOAT2& uv)
+{
+	uint64_t hash{ 0xCBF29CE484222325ull };
+	hash = MixBits(hash, FloatBits(position.x));
+	hash = MixBits(hash, FloatBits(position.y));
+	hash = MixBits(hash, FloatBits(position.z));
+	hash = MixBits(hash, FloatBits(normal.x));
+	hash = MixBits(hash, FloatBits(normal.y));
+	hash = MixBits(hash, FloatBits(normal.z));
+	hash = MixBits(hash, FloatBits(uv.x));
+	hash = MixBits(hash, FloatBits(uv.y));
+	return hash;
+}
+
+bool VertexWelder::IsSameVertex(uint32_t vIdx, const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& normal, const DirectX::XMFLOAT2& uv) const
+{
+	return memcmp(&m_Vertices[vIdx].position, &position, sizeof position) == 0
+		&& memcmp(&m_Vertices[vIdx].normal, &normal, sizeof normal) == 0
+		&& memcmp(&m_Uvs[vIdx], &uv, sizeof uv) == 0;
+}
+
+void VertexWelder::Rehash(size_t slotCount)
+{
+	m_Slots.assign(slotCount, EMPTY_SLOT);
+	m_SlotMask = m_Slots.size() - 1;
+
+	const uint32_t vCount{ static_cast<uint32_t>(m_Vertices.size()) };
+	for (uint32_t vIdx{}; vIdx < vCount; ++vIdx)
+	{
+		size_t slot{ static_cast<size_t>(Hash(m_Vertices[vIdx].position, m_Vertices[vIdx].normal, m_Uvs[vIdx])) & m_SlotMask };
+		while (m_Slots[slot] != EMPTY_SLOT)
+			slot = (slot + 1) & m_SlotMask;
+
+		m_Slots[slot] = vIdx;
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+#include "MeshData.h"
+
+/**
+ * \brief : Deduplicates (position, normal, uv) tuples while emitting them in first-occurrence order.\n
+ * Uses an open-addressing table (linear probing) hashed on the raw float bits, so two corners are welded only if they are bit-exact.
+ */
+class VertexWelder
+{
+public:
+	explicit VertexWelder(MeshData& meshData, size_t expectedVertexCount = 0);
+
+	VertexWelder(const VertexWelder&) = delete;
+	VertexWelder(VertexWelder&&) noexcept = delete;
+	VertexWelder& operator=(const VertexWelder&) = delete;
+	VertexWelder& operator=(VertexWelder&&) noexcept = delete;
+
+	/**
+	 * \brief : Returns the index of the vertex matching the tuple, appending it to the mesh vertices if it was not seen before.
+	 */
+	uint32_t Weld(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& normal, const DirectX::XMFLOAT2& uv);
+
+private:
+	static constexpr uint32_t EMPTY_SLOT{ 0xFFFFFFFFu };
+
+	std::vector<MeshVertex>& m_Vertices;
+	std::vector<DirectX::XMFLOAT2>& m_Uvs;
+
+	std::vector<uint32_t> m_Slots;
+	size_t m_SlotMask;
+
+	static uint64_t Hash(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& normal, const DirectX::XMFLOAT2& uv);
+	bool IsSameVertex(uint32_t vIdx, const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& normal, const DirectX::XMFLOAT2& uv) const;
+	void Rehash(size_t slotCount);
+};
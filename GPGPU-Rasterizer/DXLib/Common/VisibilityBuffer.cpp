@@ -0,0 +1,17 @@
+#include "pch.h"
+#include "VisibilityBuffer.h"
+
+uint32_t VisibilityBuffer::Pack(uint32_t triIdx, uint32_t instanceIdx)
+{
+	return instanceIdx << TRIANGLE_BITS | triIdx;
+}
+
+uint32_t VisibilityBuffer::GetTriangle(uint32_t id)
+{
+	return id & (MAX_TRIANGLE_COUNT - 1);
+}
+
+uint32_t VisibilityBuffer::GetInstance(uint32_t id)
+{
+	return id >> TRIANGLE_BITS;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+
+// What the fine stage writes for a pixel passing the depth test
+enum class EShadingMode
+{
+	Forward, // shades the fragment right away, once per passing fragment
+	VisibilityBuffer // writes depth and a VisibilityBuffer id, a full screen pass then shades every visible pixel once
+};
+
+/**
+ * \brief : Ids of the visibility buffer, the triangle in the low TRIANGLE_BITS and the instance in the bits above.\n
+ * The last triangle of the last instance would be EMPTY, so an instance holds up to MAX_TRIANGLE_COUNT - 1 triangles.\n
+ * This is the CPU reference of VisibilityBuffer.hlsli.
+ */
+namespace VisibilityBuffer
+{
+	constexpr uint32_t TRIANGLE_BITS{ 25 };
+	constexpr uint32_t MAX_TRIANGLE_COUNT{ 1u << TRIANGLE_BITS };
+	constexpr uint32_t MAX_INSTANCE_COUNT{ 1u << (32 - TRIANGLE_BITS) };
+	// Cleared value, no triangle was drawn to the pixel
+	constexpr uint32_t EMPTY{ 0xFFFFFFFF };
+
+	uint32_t Pack(uint32_t triIdx, uint32_t instanceIdx);
+	uint32_t GetTriangle(uint32_t id);
+	uint32_t GetInstance(uint32_t id);
+};
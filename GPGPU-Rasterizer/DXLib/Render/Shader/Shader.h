@@ -15,7 +15,11 @@ class Shader
 {
 	using ShaderCreationFnc = HRESULT(__stdcall ID3D11Device::*)(const void*, SIZE_T, ID3D11ClassLinkage*, SHADER_TYPE**);
 public:
-	explicit Shader(ID3D11Device* pdevice, const wchar_t* filePath, const char* entryPoint = "main");
+	/**
+	 * \brief : Compiles and creates the shader.
+	 * \param pdefines : Optional macros, terminated by a { nullptr, nullptr } entry
+	 */
+	explicit Shader(ID3D11Device* pdevice, const wchar_t* filePath, const char* entryPoint = "main", const D3D_SHADER_MACRO* pdefines = nullptr);
 	~Shader();
 
 	Shader(const Shader&) = delete;
@@ -32,15 +36,15 @@ private:
 	ID3DBlob* m_pShaderBlob;
 	ID3D11ClassLinkage* m_ShaderLinkage;
 
-	HRESULT Init(ID3D11Device* pdevice, const wchar_t* filePath, const char* entryPoint);
+	HRESULT Init(ID3D11Device* pdevice, const wchar_t* filePath, const char* entryPoint, const D3D_SHADER_MACRO* pdefines);
 };
 
 template<typename SHADER_TYPE>
-Shader<SHADER_TYPE>::Shader(ID3D11Device* pdevice, const wchar_t* filePath, const char* entryPoint)
+Shader<SHADER_TYPE>::Shader(ID3D11Device* pdevice, const wchar_t* filePath, const char* entryPoint, const D3D_SHADER_MACRO* pdefines)
 	: m_pShader{ nullptr }
 {
 	APP_LOG_IF_WARNING(SUCCEEDED(pdevice->CreateClassLinkage(&m_ShaderLinkage)), L"Class Linkage object could not be created for '" + std::wstring(filePath) + L"' !");
-	APP_LOG_IF_WARNING(SUCCEEDED(Init(pdevice, filePath, entryPoint)), L"Shader '" + std::wstring(filePath) + L"' could not be loaded !");
+	APP_LOG_IF_WARNING(SUCCEEDED(Init(pdevice, filePath, entryPoint, pdefines)), L"Shader '" + std::wstring(filePath) + L"' could not be loaded !");
 }
 
 template<typename SHADER_TYPE>
@@ -52,7 +56,7 @@ Shader<SHADER_TYPE>::~Shader()
 }
 
 template<typename SHADER_TYPE>
-HRESULT Shader<SHADER_TYPE>::Init(ID3D11Device* pdevice, const wchar_t* filePath, const char* entryPoint)
+HRESULT Shader<SHADER_TYPE>::Init(ID3D11Device* pdevice, const wchar_t* filePath, const char* entryPoint, const D3D_SHADER_MACRO* pdefines)
 {
 	ID3DBlob* perrorBlob{ nullptr };
 
@@ -103,7 +107,7 @@ HRESULT Shader<SHADER_TYPE>::Init(ID3D11Device* pdevice, const wchar_t* filePath
 		return res;
 	}
 
-	res = D3DCompileFromFile(filePath, nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, target.c_str(), flags, 0, &m_pShaderBlob, &perrorBlob);
+	res = D3DCompileFromFile(filePath, pdefines, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, target.c_str(), flags, 0, &m_pShaderBlob, &perrorBlob);
 
 	if (FAILED(res))
 	{
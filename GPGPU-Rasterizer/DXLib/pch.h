@@ -8,22 +8,27 @@
 #define PCH_H
 
 // add headers that you want to pre-compile here
-#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#include <Windows.h>
+#endif
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <cstdint>
+#include <string>
 #include <vector>
 #include <DirectXMath.h>
 
-//Include DX11
-#include <dxgi.h>
-#pragma comment(lib, "dxgi.lib")
-#include <d3d11.h>
-#pragma comment(lib, "d3d11.lib")
-#include <d3dcompiler.h>
-#pragma comment(lib, "d3dcompiler.lib")
-#pragma comment(lib, "dxguid.lib")
+//Include DX11, the portable parts of the library (Common/) build without it
+#if defined(_WIN32)
+	#include <dxgi.h>
+	#pragma comment(lib, "dxgi.lib")
+	#include <d3d11.h>
+	#pragma comment(lib, "d3d11.lib")
+	#include <d3dcompiler.h>
+	#pragma comment(lib, "d3dcompiler.lib")
+	#pragma comment(lib, "dxguid.lib")
+#endif
 
 #endif //PCH_H
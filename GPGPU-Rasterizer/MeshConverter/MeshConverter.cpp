@@ -0,0 +1,176 @@
+#include "pch.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cwctype>
+#include <filesystem>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include "Common/ConsoleLog.h"
+#include "Common/MeshCache.h"
+#include "Common/MeshOptimizer.h"
+#include "Common/MeshSimplifier.h"
+#include "Common/ObjReader.h"
+
+// Converts every .obj file of a directory into a MeshCache (.meshbin) stored next to it, one file per worker thread.
+// Usage: MeshConverter <directory> [-r (recurse into subdirectories)] [-f (rebuild caches that are still fresh)] [-o (run MeshOptimizer before writing)] [-l (generate levels of detail)]
+
+namespace
+{
+	enum class ConvertResult
+	{
+		Converted, Skipped, Failed
+	};
+
+	bool IsObjFile(const std::filesystem::path& filePath)
+	{
+		std::wstring extension{ filePath.extension().wstring() };
+		std::transform(std::begin(extension), std::end(extension), std::begin(extension), [](wchar_t c) { return static_cast<wchar_t>(std::towlower(c)); });
+		return extension == L".obj";
+	}
+
+	std::vector<std::wstring> CollectObjFiles(const std::filesystem::path& directory, bool recursive)
+	{
+		std::vector<std::wstring> objPaths{};
+		std::error_code error{};
+
+		if (recursive)
+		{
+			for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator{ directory, error })
+				if (entry.is_regular_file(error) && IsObjFile(entry.path()))
+					objPaths.push_back(entry.path().wstring());
+		}
+		else
+		{
+			for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator{ directory, error })
+				if (entry.is_regular_file(error) && IsObjFile(entry.path()))
+					objPaths.push_back(entry.path().wstring());
+		}
+
+		// Biggest files first so a large model does not end up alone on the last worker
+		std::sort(std::begin(objPaths), std::end(objPaths), [](const std::wstring& lhs, const std::wstring& rhs)
+			{
+				std::error_code sizeError{};
+				return std::filesystem::file_size(lhs, sizeError) > std::filesystem::file_size(rhs, sizeError);
+			});
+
+		return objPaths;
+	}
+
+	// parseThreadCount caps the threads ObjReader parses a large file on, the other workers convert files at the same time
+	ConvertResult ConvertFile(const std::wstring& objPath, bool force, uint32_t flags, uint32_t parseThreadCount)
+	{
+		const std::wstring cachePath{ MeshCache::GetCachePath(objPath) };
+		if (!force && MeshCache::IsFresh(cachePath, objPath, flags))
+			return ConvertResult::Skipped;
+
+		MeshData meshData{};
+		if (!ObjReader::LoadModel(objPath, meshData, nullptr, parseThreadCount))
+			return ConvertResult::Failed;
+
+		if (flags & MeshCache::FLAG_OPTIMIZED)
+			MeshOptimizer::Optimize(meshData);
+
+		if (flags & MeshCache::FLAG_LODS)
+			MeshSimplifier::GenerateLods(meshData);
+
+		return MeshCache::Write(cachePath, objPath, meshData, flags) ? ConvertResult::Converted : ConvertResult::Failed;
+	}
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	if (argc < 2)
+	{
+		std::wcout << L"Usage: MeshConverter <directory> [-r] [-f] [-o] [-l]\n"
+			<< L"\t-r : also convert the models of every subdirectory\n"
+			<< L"\t-f : rebuild caches that are still up to date\n"
+			<< L"\t-o : optimize vertex cache, overdraw and vertex fetch order before writing\n"
+			<< L"\t-l : append quadric simplified levels of detail to the index buffer\n";
+		return 1;
+	}
+
+	bool recursive{ false };
+	bool force{ false };
+	uint32_t flags{ 0 };
+	for (int argIdx{ 2 }; argIdx < argc; ++argIdx)
+	{
+		const std::wstring arg{ argv[argIdx] };
+		if (arg == L"-r")
+			recursive = true;
+		else if (arg == L"-f")
+			force = true;
+		else if (arg == L"-o")
+			flags |= MeshCache::FLAG_OPTIMIZED;
+		else if (arg == L"-l")
+			flags |= MeshCache::FLAG_LODS;
+		else
+		{
+			std::wcout << L"Error: Unknown option \"" << arg << L"\".\n";
+			return 1;
+		}
+	}
+
+	const std::filesystem::path directory{ argv[1] };
+	std::error_code error{};
+	if (!std::filesystem::is_directory(directory, error))
+	{
+		std::wcout << L"Error: \"" << directory.wstring() << L"\" is not a directory.\n";
+		return 1;
+	}
+
+	const Clock::time_point startTime{ Clock::now() };
+	const std::vector<std::wstring> objPaths{ CollectObjFiles(directory, recursive) };
+
+	// ObjReader splits a large file over the hardware threads the pool leaves it, so the two levels together stay at one thread per core
+	const uint32_t hardwareThreadCount{ (std::max)(1u, std::thread::hardware_concurrency()) };
+	const size_t workerCount{ (std::min)(std::size(objPaths), static_cast<size_t>(hardwareThreadCount)) };
+	const uint32_t parseThreadCount{ (std::max)(1u, hardwareThreadCount / static_cast<uint32_t>((std::max)(workerCount, size_t{ 1 }))) };
+	std::atomic<size_t> nextFile{ 0 };
+	std::atomic<uint32_t> convertedCount{ 0 }, skippedCount{ 0 }, failedCount{ 0 };
+	std::mutex logMutex{};
+
+	const auto worker{ [&]()
+		{
+			// The reports of a file are buffered and printed whole, under logMutex
+			std::wostringstream fileLog{};
+			ConsoleLog::SetThreadStream(&fileLog);
+			for (size_t fileIdx{ nextFile++ }; fileIdx < std::size(objPaths); fileIdx = nextFile++)
+			{
+				fileLog.str(L"");
+				switch (ConvertFile(objPaths[fileIdx], force, flags, parseThreadCount))
+				{
+				case ConvertResult::Converted: ++convertedCount; break;
+				case ConvertResult::Skipped: ++skippedCount; break;
+				case ConvertResult::Failed:
+					++failedCount;
+					fileLog << L"Error: Failed to convert \"" << objPaths[fileIdx] << L"\".\n";
+					break;
+				}
+
+				const std::wstring report{ fileLog.str() };
+				if (!std::empty(report))
+				{
+					std::lock_guard<std::mutex> lock{ logMutex };
+					std::wcout << report;
+				}
+			}
+			ConsoleLog::SetThreadStream(nullptr);
+		} };
+
+	std::vector<std::thread> workers{};
+	workers.reserve(workerCount);
+	for (size_t workerIdx{}; workerIdx < workerCount; ++workerIdx)
+		workers.emplace_back(worker);
+
+	for (std::thread& workerThread : workers)
+		workerThread.join();
+
+	std::wcout << L"Converted " << convertedCount << L", up to date " << skippedCount << L", failed " << failedCount << L" of " << std::size(objPaths)
+		<< L" models on " << workerCount << L" threads in " << std::chrono::duration<double, std::milli>(Clock::now() - startTime).count() << L" ms.\n";
+
+	return failedCount > 0 ? 1 : 0;
+}
@@ -0,0 +1,79 @@
+#include "pch.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include "Common/VertexQuantizer.h"
+
+// Encodes random vertices and the axis aligned normals, then checks the round trip stays within half a quantization step of every position axis
+// and within one code step of the octahedral normals, 90 / 127 deg along the edge of a face of the octahedron.
+// Returns non zero on failure, run by ctest.
+
+namespace
+{
+	constexpr float MAX_NORMAL_ERROR_DEG{ 90.f / 127.f };
+
+	// Half a step of the 16 bit grid, plus the float rounding of offset + quantized * scale at the magnitude of the bounds
+	float GetPositionTolerance(float offset, float scale)
+	{
+		const float magnitude{ (std::max)(std::abs(offset), std::abs(offset + scale * 65535.f)) };
+		return 0.5f * scale + 4.f * std::numeric_limits<float>::epsilon() * magnitude;
+	}
+
+	bool CheckRoundTrip(const wchar_t* pname, const std::vector<MeshVertex>& vertices)
+	{
+		const VertexQuantizer::Dequantization dequantization{ VertexQuantizer::ComputeDequantization(vertices) };
+		const std::vector<VertexQuantizer::QuantizedVertex> quantized{ VertexQuantizer::Encode(vertices, dequantization) };
+		const DirectX::XMFLOAT3 tolerance{ GetPositionTolerance(dequantization.offset.x, dequantization.scale.x), GetPositionTolerance(dequantization.offset.y, dequantization.scale.y),
+			GetPositionTolerance(dequantization.offset.z, dequantization.scale.z) };
+
+		bool isValid{ true };
+		for (size_t vIdx{}; vIdx < std::size(vertices) && isValid; ++vIdx)
+		{
+			const DirectX::XMFLOAT3& source{ vertices[vIdx].position };
+			const DirectX::XMFLOAT3 decoded{ VertexQuantizer::Decode(quantized[vIdx], dequantization).position };
+			isValid = std::abs(decoded.x - source.x) <= tolerance.x && std::abs(decoded.y - source.y) <= tolerance.y && std::abs(decoded.z - source.z) <= tolerance.z;
+			if (!isValid)
+				std::wcout << L"Error: " << pname << L" vertex " << vIdx << L" is more than half a quantization step away once decoded.\n";
+		}
+
+		const VertexQuantizer::RoundTripError error{ VertexQuantizer::MeasureRoundTripError(vertices, quantized, dequantization) };
+		const float maxPositionError{ std::sqrt(tolerance.x * tolerance.x + tolerance.y * tolerance.y + tolerance.z * tolerance.z) };
+		if (error.maxPositionError > maxPositionError)
+		{
+			std::wcout << L"Error: " << pname << L" max position error " << error.maxPositionError << L" past half a quantization step, " << maxPositionError << L".\n";
+			isValid = false;
+		}
+		if (error.maxNormalErrorDeg > MAX_NORMAL_ERROR_DEG)
+		{
+			std::wcout << L"Error: " << pname << L" max normal error " << error.maxNormalErrorDeg << L" deg past one octahedral code step, " << MAX_NORMAL_ERROR_DEG << L" deg.\n";
+			isValid = false;
+		}
+
+		std::wcout << pname << L": " << std::size(vertices) << L" vertices, max position error " << error.maxPositionError << L", max normal error " << error.maxNormalErrorDeg << L" deg.\n";
+		return isValid;
+	}
+}
+
+int main()
+{
+	// Bounds of very different extents per axis and away from the origin, the flat one quantizes to a single value
+	std::mt19937 generator{ 7 };
+	std::uniform_real_distribution<float> distribution{ -1.f, 1.f };
+	std::vector<MeshVertex> randomVertices(100000);
+	for (MeshVertex& vertex : randomVertices)
+	{
+		vertex.position = DirectX::XMFLOAT3{ distribution(generator) * 40.f, 10.f + distribution(generator) * 3.f, distribution(generator) * 0.01f };
+		vertex.normal = DirectX::XMFLOAT3{ distribution(generator), distribution(generator), distribution(generator) };
+	}
+
+	std::vector<MeshVertex> axisVertices{};
+	const DirectX::XMFLOAT3 axes[]{ { 1.f, 0.f, 0.f }, { -1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, -1.f, 0.f }, { 0.f, 0.f, 1.f }, { 0.f, 0.f, -1.f } };
+	for (const DirectX::XMFLOAT3& axis : axes)
+		axisVertices.push_back(MeshVertex{ DirectX::XMFLOAT3{ axis.x * 100.f, axis.y * 100.f, 5.f }, 0.f, axis, 0.f });
+
+	// Both run whatever the first one finds
+	const bool isRandomValid{ CheckRoundTrip(L"random", randomVertices) };
+	const bool isAxisValid{ CheckRoundTrip(L"axes", axisVertices) };
+	return isRandomValid && isAxisValid ? 0 : 1;
+}